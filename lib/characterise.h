@@ -9,9 +9,41 @@
 #include "error_models/error_models.h"
 #include "decoders/decoders.h"
 #include "circuits/error_probabilities.h"
+#include "circuits/truncation_policy.h"
+#include "error_models/poly.h"
 #include "errors.h"
+#include "misc/thread_pool.h"
 
 
+// Data shared by the pool workers in characterise_code
+typedef struct {
+	const sym* code;
+	const sym* logicals;
+	error_model* noise_model;
+	decoder* decoding_operation;
+	uint64_t n_logical_errors;
+	double* worker_probabilities; // One table of logical error probabilities for each worker
+	pthread_mutex_t* model_lock; // Held around each call of an error model that is not thread safe, otherwise NULL
+} characterise_code_task_t;
+
+void characterise_code_error(const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						const sym* physical_error,
+						double* p_error_probabilities);
+uint64_t characterise_code_logical_error(const sym* code, 
+						const sym* logicals, 
+						decoder* decoding_operation,
+						const sym* physical_error);
+void characterise_code_parallel(thread_pool* pool,
+						const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						double* p_error_probabilities);
+void characterise_code_task(void* data, const uint64_t start, const uint64_t end, const uint32_t worker);
+
 /* 
 	characterise_code:
 	Given an error model, calculates the physical and logical krauss operators for a given code
@@ -30,55 +62,327 @@ double* characterise_code(const sym* code,
 {
 	// Setup our array of logical error probabilities
 	double* p_error_probabilities = error_probabilities_m(logicals->length);
+
+	// Every physical error is visited, so the errors can be split between the workers of the pool
+	// A single thread keeps the iterator below, which sums in the same order as before
+	thread_pool* pool = thread_pool_default();
+	if (thread_pool_n_threads(pool) > 1)
+	{
+		characterise_code_parallel(pool, code, logicals, noise_model, decoding_operation, p_error_probabilities);
+		return p_error_probabilities;
+	}
 	
 	// Iterate through errors and map back to the code-space
-	#ifdef CHARACTERISE_MAX_DEPTH
-		sym_iter* physical_error = sym_iter_create_range(code->length, 0, 2 * CHARACTERISE_MAX_DEPTH + 1);
-	#else
-		sym_iter* physical_error = sym_iter_create(code->length);
-	#endif
+	sym_iter* physical_error = sym_iter_create(code->length);
 	while (sym_iter_next(physical_error))
 	{
-		// Calculate the syndrome
-		sym* syndrome = sym_syndrome(code, physical_error->state);
-			
-		// Get the recovery operator
-		sym* recovery = decoder_call(decoding_operation, syndrome);
-		
-		// Determine the state after correction
-		sym* corrected = sym_add(recovery, physical_error->state);
+		characterise_code_error(code, logicals, noise_model, decoding_operation, physical_error->state, p_error_probabilities);
+	}
+	sym_iter_free(physical_error);
+
+	return p_error_probabilities;
+}
 
-		// Determine the overall logical state
-		sym* logical_state = logical_error(logicals, corrected);
+/* 
+	characterise_code_error:
+	Decodes a single physical error and adds its probability to the logical error it leaves behind
+	:: const sym* code :: A sym* object containing the stabiliser code
+	:: const sym* logicals :: A sym* object containing the logical operators
+	:: error_model* noise_model :: The error model
+	:: decoder* decoding_operation :: The decoder
+	:: const sym* physical_error :: The physical error
+	:: double* p_error_probabilities :: The logical error probabilities that are added to
+	Returns nothing
+*/
+void characterise_code_error(const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						const sym* physical_error,
+						double* p_error_probabilities)
+{
+	// Store the probability
+	p_error_probabilities[characterise_code_logical_error(code, logicals, decoding_operation, physical_error)] += error_model_call(noise_model, physical_error);
+	return;
+}
 
-		// Store the probability
-		p_error_probabilities[sym_to_ll(logical_state)] += error_model_call(noise_model, physical_error->state);
+/* 
+	characterise_code_logical_error:
+	Decodes a single physical error and finds the logical error it leaves behind
+	:: const sym* code :: A sym* object containing the stabiliser code
+	:: const sym* logicals :: A sym* object containing the logical operators
+	:: decoder* decoding_operation :: The decoder
+	:: const sym* physical_error :: The physical error
+	Returns the sym_to_ll value of the logical error
+*/
+uint64_t characterise_code_logical_error(const sym* code, 
+						const sym* logicals, 
+						decoder* decoding_operation,
+						const sym* physical_error)
+{
+	// Calculate the syndrome
+	sym* syndrome = sym_syndrome(code, physical_error);
 		
-		// Free our memory
-		sym_free(logical_state);
-		sym_free(corrected);
-		sym_free(recovery);
-		sym_free(syndrome);
+	// Get the recovery operator
+	sym* recovery = decoder_call(decoding_operation, syndrome);
+	
+	// Determine the state after correction
+	sym* corrected = sym_add(recovery, physical_error);
+
+	// Determine the overall logical state
+	sym* logical_state = logical_error(logicals, corrected);
+	uint64_t logical_index = sym_to_ll(logical_state);
+	
+	// Free our memory
+	sym_free(logical_state);
+	sym_free(corrected);
+	sym_free(recovery);
+	sym_free(syndrome);
+	return logical_index;
+}
+
+/* 
+	characterise_code_parallel:
+	Splits the physical errors of characterise_code between the workers of a pool
+	Each worker sums into its own table of logical error probabilities, and these are added together at the end
+	The decoder is called from every worker, so it must not modify itself when called, none of the decoders in decoders/ do
+	The error model is shared between the workers when it is thread safe, such as the iid, biased, asymmetric and lookup models
+	Calls to a model that is not thread safe, such as a cached model or a batch holding one, are made under a lock
+	:: thread_pool* pool :: The pool
+	:: const sym* code :: A sym* object containing the stabiliser code
+	:: const sym* logicals :: A sym* object containing the logical operators
+	:: error_model* noise_model :: The error model
+	:: decoder* decoding_operation :: The decoder
+	:: double* p_error_probabilities :: The logical error probabilities that are added to
+	Returns nothing
+*/
+void characterise_code_parallel(thread_pool* pool,
+						const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						double* p_error_probabilities)
+{
+	uint32_t n_threads = thread_pool_n_threads(pool);
+	uint64_t n_logical_errors = 1ull << logicals->length;
+
+	characterise_code_task_t task_data;
+	task_data.code = code;
+	task_data.logicals = logicals;
+	task_data.noise_model = noise_model;
+	task_data.decoding_operation = decoding_operation;
+	task_data.n_logical_errors = n_logical_errors;
+	task_data.worker_probabilities = (double*)calloc(n_threads * n_logical_errors, sizeof(double));
+
+	// Workers still decode in parallel, only the model calls are serialised
+	pthread_mutex_t model_lock;
+	task_data.model_lock = NULL;
+	if (!noise_model->thread_safe)
+	{
+		pthread_mutex_init(&model_lock, NULL);
+		task_data.model_lock = &model_lock;
+	}
+
+	thread_pool_parallel_for(pool, 1ull << code->length, characterise_code_task, &task_data);
+
+	if (NULL != task_data.model_lock)
+	{
+		pthread_mutex_destroy(&model_lock);
+	}
+
+	for (uint32_t worker = 0; worker < n_threads; worker++)
+	{
+		for (uint64_t i = 0; i < n_logical_errors; i++)
+		{
+			p_error_probabilities[i] += task_data.worker_probabilities[worker * n_logical_errors + i];
+		}
+	}
+	free(task_data.worker_probabilities);
+	return;
+}
+
+// Pool task, characterises a range of physical errors into the table of this worker
+void characterise_code_task(void* data, const uint64_t start, const uint64_t end, const uint32_t worker)
+{
+	characterise_code_task_t* task_data = (characterise_code_task_t*)data;
+	double* p_error_probabilities = task_data->worker_probabilities + worker * task_data->n_logical_errors;
+
+	for (uint64_t i = start; i < end; i++)
+	{
+		sym* physical_error = ll_to_sym(i, 1, task_data->code->length);
+		uint64_t logical_index = characterise_code_logical_error(task_data->code, 
+			task_data->logicals, 
+			task_data->decoding_operation, 
+			physical_error);
+
+		if (NULL != task_data->model_lock)
+		{
+			pthread_mutex_lock(task_data->model_lock);
+		}
+		double prob = error_model_call(task_data->noise_model, physical_error);
+		if (NULL != task_data->model_lock)
+		{
+			pthread_mutex_unlock(task_data->model_lock);
+		}
+
+		p_error_probabilities[logical_index] += prob;
+		sym_free(physical_error);
+	}
+	return;
+}
+
+/* 
+	characterise_code_truncated:
+	As characterise_code, but physical errors that the truncation policy would drop are neither decoded nor counted
+	Errors above the maximum weight are never visited, so the probability of every dropped error is taken as one minus
+	the probability of the errors that are kept, this is exact for a normalised error model
+	The support limit of the policy does not apply to characterisation and is ignored
+	:: const sym* code :: A sym* object containing the stabiliser code
+	:: const sym* logicals :: A sym* object containing the logical operators
+	:: error_model* noise_model :: The error model
+	:: decoder* decoding_operation :: The decoder
+	:: truncation_policy* policy :: The policy, the probability dropped is added to its discarded probability, NULL drops nothing
+	Returns the logical error probabilities, these sum to one less the probability dropped
+*/
+double* characterise_code_truncated(const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						truncation_policy* policy)
+{
+	double* p_error_probabilities = error_probabilities_m(logicals->length);
+	uint32_t n_qubits = code->length / 2;
+	uint32_t max_weight = (NULL != policy && policy->max_weight < n_qubits) ? policy->max_weight : n_qubits;
+
+	double kept = 0;
+	sym_iter* physical_error = sym_iter_create_n_qubits_range(n_qubits, 0, max_weight);
+	while (sym_iter_next(physical_error))
+	{
+		// The iterator works in bits, so some errors above the maximum weight are reached and dropped here
+		double prob = error_model_call(noise_model, physical_error->state);
+		if (!truncation_policy_keeps(policy, sym_weight(physical_error->state), prob))
+		{
+			continue;
+		}
+
+		p_error_probabilities[characterise_code_logical_error(code, logicals, decoding_operation, physical_error->state)] += prob;
+		kept += prob;
 	}
 	sym_iter_free(physical_error);
 
+	if (NULL != policy)
+	{
+		policy->discarded_last = 1 - kept;
+		policy->discarded += policy->discarded_last;
+	}
 	return p_error_probabilities;
 }
 
+/* 
+	characterise_code_poly:
+	As characterise_code, but accumulates each logical error probability as a polynomial in the physical error rate
+	A single pass can then be evaluated at any number of error rates using characterise_poly_eval
+	:: const sym* code :: A sym* object containing the stabiliser code
+	:: const sym* logicals :: A sym* object containing the logical operators
+	:: error_model* noise_model :: An error model with a polynomial form, the error rate of the model is ignored
+	:: decoder* decoding_operation :: The decoder
+	:: const uint32_t max_weight :: Physical errors above this weight are dropped, truncating the polynomials
+	Returns an array with n_qubits + 1 coefficients for each logical error, or NULL if the model has no polynomial form
+*/
+double* characterise_code_poly(const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						const uint32_t max_weight)
+{
+	if (NULL == noise_model->poly_call)
+	{
+		printf("Error model has no polynomial form\n");
+		return NULL;
+	}
+
+	uint32_t n_qubits = code->length / 2;
+	double* p_error_polys = error_poly_zeros(n_qubits, 1ull << logicals->length);
+
+	sym_iter* physical_error = sym_iter_create_n_qubits_range(n_qubits, 0, max_weight);
+	while (sym_iter_next(physical_error))
+	{
+		// The iterator works in bits, so some errors above the maximum weight are reached
+		if (sym_weight(physical_error->state) > max_weight)
+		{
+			continue;
+		}
+
+		// Store the polynomial
+		uint64_t logical_index = characterise_code_logical_error(code, logicals, decoding_operation, physical_error->state);
+		error_model_poly_call(noise_model, physical_error->state, p_error_polys + logical_index * ERROR_POLY_LENGTH(n_qubits));
+	}
+	sym_iter_free(physical_error);
+
+	return p_error_polys;
+}
+
+/* 
+	characterise_poly_eval:
+	Evaluates the output of characterise_code_poly at a given physical error rate
+	:: const double* polys :: The polynomials returned by characterise_code_poly
+	:: const sym* code :: The stabiliser code
+	:: const sym* logicals :: The logical operators
+	:: const double p :: The physical error rate
+	Returns the same array of logical error probabilities that characterise_code would have for this error rate
+*/
+double* characterise_poly_eval(const double* polys, const sym* code, const sym* logicals, const double p)
+{
+	return error_poly_eval_array(polys, code->length / 2, 1ull << logicals->length, p);
+}
+
+/* 
+	characterise_code_batch:
+	As characterise_code, but for every lane of a batched error model in a single pass
+	The syndrome, decoding and logical lookups are shared by all lanes
+	:: const sym* code :: A sym* object containing the stabiliser code
+	:: const sym* logicals :: A sym* object containing the logical operators
+	:: error_model* noise_model :: The error model, a batched model gives each lane its own probabilities
+	:: decoder* decoding_operation :: The decoder
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	Returns a batch table of logical error probabilities, entry [logical error * n_lanes + lane]
+*/
+double* characterise_code_batch(const sym* code, 
+						const sym* logicals, 
+						error_model* noise_model, 
+						decoder* decoding_operation,
+						const uint32_t n_lanes)
+{
+	double* p_error_probabilities = (double*)calloc((1ull << logicals->length) * n_lanes, sizeof(double));
+	double* p_lanes = (double*)malloc(sizeof(double) * n_lanes);
+
+	sym_iter* physical_error = sym_iter_create(code->length);
+	while (sym_iter_next(physical_error))
+	{
+		// Store the probability for every lane
+		uint64_t logical_index = characterise_code_logical_error(code, logicals, decoding_operation, physical_error->state);
+		error_model_batch_call(noise_model, physical_error->state, n_lanes, p_lanes);
+		double* p_logical = p_error_probabilities + logical_index * n_lanes;
+		for (uint32_t i = 0; i < n_lanes; i++)
+		{
+			p_logical[i] += p_lanes[i];
+		}
+	}
+	sym_iter_free(physical_error);
+	free(p_lanes);
+
+	return p_error_probabilities;
+}
 
 double* characterise_code_corrected(const sym* code, 
 						const sym* logicals, 
-						double* error_rates)
+						error_probability_t* error_rates)
 {
 	// Setup our array of logical error probabilities
 	double* p_error_probabilities = error_probabilities_m(logicals->length);
 
 	// Iterate through errors and map back to the code-space
-	#ifdef CHARACTERISE_MAX_DEPTH
-		sym_iter* physical_error = sym_iter_create_range(code->length, 0, 2 * CHARACTERISE_MAX_DEPTH + 1);
-	#else
-		sym_iter* physical_error = sym_iter_create_n_qubits(code->n_qubits);
-	#endif
+	sym_iter* physical_error = sym_iter_create_n_qubits(code->n_qubits);
 	while (sym_iter_next(physical_error))
 	{
 		if (error_rates[sym_iter_ll_from_state(physical_error)] > 0)
@@ -104,7 +408,7 @@ double* characterise_code_corrected(const sym* code,
 	return p_error_probabilities;
 }
 
-void characterise_save(const double* probabilities, const size_t n_qubits, const char* filename)
+void characterise_save(const error_probability_t* probabilities, const size_t n_qubits, const char* filename)
 {	
 	FILE *f;
 	f = fopen(filename, "w");
@@ -114,11 +418,7 @@ void characterise_save(const double* probabilities, const size_t n_qubits, const
 		return;
 	}
 	double s = 0;
-	#ifdef CHARACTERISE_MAX_DEPTH
-		sym_iter* physical_error = sym_iter_create_n_qubits_range(n_qubits, 0, CHARACTERISE_MAX_DEPTH);
-	#else
-		sym_iter* physical_error = sym_iter_create_n_qubits(n_qubits);
-	#endif	
+	sym_iter* physical_error = sym_iter_create_n_qubits(n_qubits);
 	while (sym_iter_next(physical_error))
 	{
 		char* error_string = error_sym_to_str(physical_error->state);
@@ -131,14 +431,10 @@ void characterise_save(const double* probabilities, const size_t n_qubits, const
 	return;
 }
 
-void characterise_print(const double* probabilities, const size_t n_qubits)
+void characterise_print(const error_probability_t* probabilities, const size_t n_qubits)
 {	
 	double s = 0;
-	#ifdef CHARACTERISE_MAX_DEPTH
-		sym_iter* physical_error = sym_iter_create_n_qubits_range(n_qubits, 0, CHARACTERISE_MAX_DEPTH);
-	#else
-		sym_iter* physical_error = sym_iter_create_n_qubits(n_qubits);
-	#endif	
+	sym_iter* physical_error = sym_iter_create_n_qubits(n_qubits);
 	while (sym_iter_next(physical_error))
 	{
 		char* error_string = error_sym_to_str(physical_error->state);
@@ -151,14 +447,10 @@ void characterise_print(const double* probabilities, const size_t n_qubits)
 	return;
 }
 
-double characterise_test(const double* probabilities, const size_t n_qubits)
+double characterise_test(const error_probability_t* probabilities, const size_t n_qubits)
 {	
 	double total = 0;
-	#ifdef CHARACTERISE_MAX_DEPTH
-		sym_iter* physical_error = sym_iter_create_n_qubits_range(n_qubits, 0, CHARACTERISE_MAX_DEPTH);
-	#else
-		sym_iter* physical_error = sym_iter_create_n_qubits(n_qubits);
-	#endif	
+	sym_iter* physical_error = sym_iter_create_n_qubits(n_qubits);
 	while (sym_iter_next(physical_error))
 	{
 		total += probabilities[sym_to_ll(physical_error->state)];
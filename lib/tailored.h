@@ -6,6 +6,22 @@
 #include "decoders/destabiliser.h"
 #include "logical.h"
 #include "error_models/error_models.h"
+#include "error_models/poly.h"
+
+/*
+	tailored_poly_t:
+	Polynomial form of the probabilities used when tailoring a decoder
+	:: uint32_t n_qubits :: The number of physical qubits
+	:: uint64_t n_syndromes :: The number of syndromes
+	:: uint64_t n_logical_operations :: The number of logical errors that may follow a destabiliser correction
+	:: double* coefficients :: n_qubits + 1 coefficients for each syndrome and logical error pair
+*/
+typedef struct {
+	uint32_t n_qubits;
+	uint64_t n_syndromes;
+	uint64_t n_logical_operations;
+	double* coefficients;
+} tailored_poly_t;
 
 
 // FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
@@ -37,4 +53,184 @@ double tailored_prob(const sym* code,
 				const sym* logicals, 
 				error_model* error_model);
 
+/* 
+	tailored_prob_poly:
+	Accumulates the probabilities used by tailored_prob as polynomials in the physical error rate
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: error_model* error_model :: An error model with a polynomial form, the error rate of the model is ignored
+	:: const uint32_t max_weight :: Physical errors above this weight are dropped, truncating the polynomials
+	Returns a heap pointer to the polynomials, or NULL if the model has no polynomial form
+*/
+tailored_poly_t* tailored_prob_poly(const sym* code, 
+				const sym* logicals, 
+				error_model* error_model,
+				const uint32_t max_weight);
+
+/* 
+	tailored_poly_eval:
+	Evaluates the probability of the best possible decoding at a given physical error rate
+	:: const tailored_poly_t* tp :: The polynomials from tailored_prob_poly
+	:: const double p :: The physical error rate
+	Returns the same probability that tailored_prob would for this error rate
+*/
+double tailored_poly_eval(const tailored_poly_t* tp, const double p);
+
+/* 
+	tailored_poly_free:
+	Frees the polynomials from tailored_prob_poly
+	:: tailored_poly_t* tp :: The object to be freed
+	Returns nothing
+*/
+void tailored_poly_free(tailored_poly_t* tp);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/* 
+	tailor_decoder_prob_only:
+	Returns just the probability associated with the best possible decoding of a given QECC and error model
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: double (*error_model)(const sym*, void*) :: The error model
+	:: void* model_data :: The data associated with the error model
+	Returns a double containing the probability
+*/
+double tailored_prob(const sym* code, 
+				const sym* logicals, 
+				error_model* error_model)
+{
+	uint64_t n_syndromes = (1ull << (code->height));
+	uint64_t n_logical_operations = (1ull << (logicals->length));
+
+	double* p_options = (double*)calloc(n_syndromes * n_logical_operations, sizeof(double));
+
+	decoder* destabilisers = decoder_create_destabiliser(code, logicals);
+
+	sym_iter* physical_error = sym_iter_create(code->length);
+	while (sym_iter_next(physical_error))
+	{
+		sym* syndrome = sym_syndrome(code, physical_error->state);
+		sym* recovery = decoder_call(destabilisers, syndrome);
+		sym* corrected = sym_add(recovery, physical_error->state);
+		sym* logical_state = logical_error(logicals, corrected);
+
+		p_options[sym_to_ll(syndrome) * n_logical_operations + sym_to_ll(logical_state)] += error_model_call(error_model, physical_error->state);
+
+		sym_free(logical_state);
+		sym_free(corrected);
+		sym_free(recovery);
+		sym_free(syndrome);
+	}
+	sym_iter_free(physical_error);
+
+	// The best decoder picks the most likely logical correction for each syndrome
+	double p_total = 0;
+	for (uint64_t i = 0; i < n_syndromes; i++)
+	{
+		double p_correction = 0;
+		for (uint64_t j = 0; j < n_logical_operations; j++)
+		{
+			p_correction = fmax(p_correction, p_options[i * n_logical_operations + j]);
+		}
+		p_total += p_correction;
+	}
+
+	decoder_free(destabilisers);
+	free(p_options);
+	return p_total;
+}
+
+/* 
+	tailored_prob_poly:
+	Accumulates the probabilities used by tailored_prob as polynomials in the physical error rate
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: error_model* error_model :: An error model with a polynomial form, the error rate of the model is ignored
+	:: const uint32_t max_weight :: Physical errors above this weight are dropped, truncating the polynomials
+	Returns a heap pointer to the polynomials, or NULL if the model has no polynomial form
+*/
+tailored_poly_t* tailored_prob_poly(const sym* code, 
+				const sym* logicals, 
+				error_model* error_model,
+				const uint32_t max_weight)
+{
+	if (NULL == error_model->poly_call)
+	{
+		printf("Error model has no polynomial form\n");
+		return NULL;
+	}
+
+	tailored_poly_t* tp = (tailored_poly_t*)malloc(sizeof(tailored_poly_t));
+	tp->n_qubits = code->length / 2;
+	tp->n_syndromes = (1ull << (code->height));
+	tp->n_logical_operations = (1ull << (logicals->length));
+	tp->coefficients = error_poly_zeros(tp->n_qubits, tp->n_syndromes * tp->n_logical_operations);
+
+	decoder* destabilisers = decoder_create_destabiliser(code, logicals);
+
+	sym_iter* physical_error = sym_iter_create_n_qubits_range(tp->n_qubits, 0, max_weight);
+	while (sym_iter_next(physical_error))
+	{
+		// The iterator works in bits, so some errors above the maximum weight are reached
+		if (sym_weight(physical_error->state) > max_weight)
+		{
+			continue;
+		}
+
+		sym* syndrome = sym_syndrome(code, physical_error->state);
+		sym* recovery = decoder_call(destabilisers, syndrome);
+		sym* corrected = sym_add(recovery, physical_error->state);
+		sym* logical_state = logical_error(logicals, corrected);
+
+		uint64_t index = sym_to_ll(syndrome) * tp->n_logical_operations + sym_to_ll(logical_state);
+		error_model_poly_call(error_model, physical_error->state, tp->coefficients + index * ERROR_POLY_LENGTH(tp->n_qubits));
+
+		sym_free(logical_state);
+		sym_free(corrected);
+		sym_free(recovery);
+		sym_free(syndrome);
+	}
+	sym_iter_free(physical_error);
+
+	decoder_free(destabilisers);
+	return tp;
+}
+
+/* 
+	tailored_poly_eval:
+	Evaluates the probability of the best possible decoding at a given physical error rate
+	:: const tailored_poly_t* tp :: The polynomials from tailored_prob_poly
+	:: const double p :: The physical error rate
+	Returns the same probability that tailored_prob would for this error rate
+*/
+double tailored_poly_eval(const tailored_poly_t* tp, const double p)
+{
+	// The best logical correction can change with p, so the maximum is taken after evaluation
+	double p_total = 0;
+	for (uint64_t i = 0; i < tp->n_syndromes; i++)
+	{
+		double p_correction = 0;
+		for (uint64_t j = 0; j < tp->n_logical_operations; j++)
+		{
+			uint64_t index = i * tp->n_logical_operations + j;
+			p_correction = fmax(p_correction, error_poly_eval(tp->coefficients + index * ERROR_POLY_LENGTH(tp->n_qubits), tp->n_qubits, p));
+		}
+		p_total += p_correction;
+	}
+	return p_total;
+}
+
+/* 
+	tailored_poly_free:
+	Frees the polynomials from tailored_prob_poly
+	:: tailored_poly_t* tp :: The object to be freed
+	Returns nothing
+*/
+void tailored_poly_free(tailored_poly_t* tp)
+{
+	free(tp->coefficients);
+	free(tp);
+	return;
+}
+
 #endif
\ No newline at end of file
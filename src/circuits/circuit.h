@@ -3,6 +3,7 @@
 #include "../sym.h" 
 #include "../gates/gates.h"
 #include "error_probabilities.h"
+#include "truncation_policy.h"
 
 // ----------------------------------------------------------------------------------------
 // STRUCT OBJECTS 
@@ -12,7 +13,7 @@
 struct circuit;
 
 // Circuit run struct
-typedef double* (*circuit_run_f)(struct circuit*, double*, gate*);
+typedef error_probability_t* (*circuit_run_f)(struct circuit*, error_probability_t*, gate*);
 
 // Circuit free struct
 typedef void (*circuit_param_free_f)(void*);
@@ -23,12 +24,14 @@ typedef void (*circuit_param_free_f)(void*);
  *   :: gate* gate_operation :: The gate being applied
  *   :: unsigned* target_qubits :: The qubits this gate is to be applied to
  *   :: struct circuit_element* next :: The next circuit element
+ *   :: void (*gate_free)(gate*) :: Frees the gate with the circuit, NULL when the gate belongs to the caller
  */
 struct circuit_element
 {
     gate* gate_operation; // The gate object to be applied
     unsigned* target_qubits; // An array containing the target qubits
     struct circuit_element* next; // The next gate to be applied
+    void (*gate_free)(gate*); // Set for gates created by the circuit itself, such as fused gates
 };
 typedef struct circuit_element circuit_element;
 
@@ -50,6 +53,32 @@ typedef struct circuit
     void* circuit_data; // Any other data that the circuit might require
 } circuit;
 
+/*
+ *  circuit_compiled:
+ *  A flat copy of a circuit, the gates and their targets are held in contiguous arrays rather than a list
+ *  Gates are kept in program order, and are also grouped into moments, see circuit_compile
+ *  The object is a single allocation that is only read once created, so one copy may be shared between threads
+ *  :: unsigned n_qubits :: The number of qubits in the circuit
+ *  :: unsigned n_gates :: The number of gates in the circuit
+ *  :: gate** gates :: The gate applied at each step, these still belong to the circuit
+ *  :: uint32_t* target_start :: Where the targets of each gate start in target_qubits, n_gates + 1 entries
+ *  :: unsigned* target_qubits :: The targets of every gate, one gate after another
+ *  :: uint32_t n_moments :: The number of moments
+ *  :: uint32_t* moment_start :: Where each moment starts in moment_gates, n_moments + 1 entries
+ *  :: uint32_t* moment_gates :: The index of each gate, ordered by moment and then by program order
+ */
+typedef struct circuit_compiled
+{
+    unsigned n_qubits;
+    unsigned n_gates;
+    gate** gates;
+    uint32_t* target_start;
+    unsigned* target_qubits;
+    uint32_t n_moments;
+    uint32_t* moment_start;
+    uint32_t* moment_gates;
+} circuit_compiled;
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DECLARATIONS
 // ----------------------------------------------------------------------------------------
@@ -106,11 +135,11 @@ void circuit_add_gate_start(circuit* c, gate* g, ...);
  * circuit_run
  * Dispatch method to call the run operation of the circuit
  * :: circuit* c :: The circuit to be run
- * :: double* initial_error_rates :: The initial error rates passed to the circuit
+ * :: error_probability_t* initial_error_rates :: The initial error rates passed to the circuit
  * :: gate* noise :: The noise model to be applied at each point on the circuit
  * Returns a new error rate object
  */
-double* circuit_run(circuit* c, double* initial_error_rates, gate* noise);
+error_probability_t* circuit_run(circuit* c, error_probability_t* initial_error_rates, gate* noise);
 
 /*
  * circuit_param_free
@@ -123,12 +152,12 @@ void circuit_param_free(circuit* c);
 /* 
     circuit_run_default:
     Applies a circuit to an existing set of error probabilities
-    :: double* initial_error_rates :: The error rates before the circuit is applied
+    :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
     :: circuit* c :: The circuit the gate is being added to
     :: error_model* noise :: The noise to be applied
     Returns a heap pointer to the new set of error rates
 */
-double* circuit_run_default(circuit* c, double* initial_error_rates, gate* noise);
+error_probability_t* circuit_run_default(circuit* c, error_probability_t* initial_error_rates, gate* noise);
 
 /*
  *  circuit_param_free_default:
@@ -141,12 +170,91 @@ void circuit_param_free_default(void* params);
 /* 
     circuit_run_noiseless:
     Applies a circuit to an existing set of error probabilities
-    :: double* initial_error_rates :: The error rates before the circuit is applied
+    :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
     :: circuit* c :: The circuit the gate is being added to
     Returns a heap pointer to the new set of error rates
 */
-double* circuit_run_noiseless(circuit* c, double* initial_error_rates);
+error_probability_t* circuit_run_noiseless(circuit* c, error_probability_t* initial_error_rates);
+
+/* 
+    circuit_run_batch:
+    Applies a circuit to a batch table of error probabilities, see error_probabilities_batch_zeros
+    Follows the same schedule as circuit_run_default, with each gate traversed once for every lane
+    :: circuit* c :: The circuit to be run
+    :: const uint32_t n_lanes :: The number of lanes in the batch
+    :: double* initial_error_rates :: The batch of error rates before the circuit is applied
+    :: gate* noise :: The environmental noise, a batched error model gives each lane its own noise
+    Returns a heap pointer to the new batch of error rates
+*/
+double* circuit_run_batch(circuit* c, const uint32_t n_lanes, double* initial_error_rates, gate* noise);
+
+/* 
+    circuit_run_truncated:
+    Applies a circuit to an existing set of error probabilities, following the same schedule as circuit_run_default
+    The run uses the sparse engine holding the policy, see circuit_sparse.h, so strings the policy drops are never visited
+    :: circuit* c :: The circuit to be run
+    :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied, these are not truncated
+    :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+    :: truncation_policy* policy :: The policy, the probability dropped by the run is added to its discarded probability
+    :: double* gate_discarded :: Written with the probability dropped by each gate and its environmental noise, c->n_gates entries, or NULL
+    Returns a heap pointer to the new set of error rates, or NULL if the circuit covers more qubits than a sparse table
+*/
+error_probability_t* circuit_run_truncated(circuit* c, error_probability_t* initial_error_rates, gate* noise, truncation_policy* policy, double* gate_discarded);
+
+/* 
+    circuit_run_moments:
+    Applies a circuit to an existing set of error probabilities, grouping the gates into moments
+    Each gate is placed in the earliest moment after every earlier gate that shares one of its qubits
+    The environmental noise is applied once per moment to the qubits that are idle in that moment,
+    rather than once per gate as in circuit_run_default
+    This is opt in, either call it directly or set c->circuit_operation to circuit_run_moments
+    :: circuit* c :: The circuit to be run
+    :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
+    :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+    Returns a heap pointer to the new set of error rates
+*/
+error_probability_t* circuit_run_moments(circuit* c, error_probability_t* initial_error_rates, gate* noise);
+
+/* 
+    circuit_idle_noise:
+    Applies environmental noise to every qubit that is not busy, see gate_apply_buffers
+    :: const unsigned n_qubits :: The number of qubits in the circuit
+    :: error_probability_t** error_rate :: The error rates, this may be swapped with the scratch table
+    :: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+    :: gate* noise :: The environmental noise, this should act on a single qubit
+    :: const uint8_t* busy :: One flag per qubit, set if the qubit participated in a gate
+    Returns nothing
+*/
+void circuit_idle_noise(const unsigned n_qubits, error_probability_t** error_rate, error_probability_t** scratch, gate* noise, const uint8_t* busy);
+
+/* 
+    circuit_run_buffers:
+    Applies a circuit to a table in place, following the same schedule as circuit_run_default
+    No tables are allocated, each gate either updates the table in place or writes to the scratch table
+    and the two are swapped, so this may be called repeatedly with the same pair of tables
+    :: circuit* c :: The circuit to be run
+    :: error_probability_t** error_rate :: The error rates before the circuit is applied, holds the error rates after the circuit
+    :: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+    :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+    Returns nothing
+*/
+void circuit_run_buffers(circuit* c, error_probability_t** error_rate, error_probability_t** scratch, gate* noise);
+
+
+/* 
+ *  circuit_fuse_clifford:
+ *  Replaces each run of consecutive noiseless Clifford and Pauli gates with a single fused gate, see fused_clifford.h
+ *  A run is extended while it covers at most GATE_FUSED_MAX_QUBITS qubits, and the fused gates are freed with the circuit
+ *  The circuit then applies the same operation with one table pass per run rather than one per gate
+ *  Environmental noise in circuit_run_default and circuit_run_moments is applied around each fused gate as if it were a single gate,
+ *  so fusion should be used on noiseless circuits, or where a run of gates is meant to be a single time step
+ *  :: circuit* c :: The circuit
+ *  Returns the number of gates removed from the circuit
+ */
+unsigned circuit_fuse_clifford(circuit* c);
 
+// Replaces the elements from first to last with a single fused gate, returns the new element
+circuit_element* circuit_fuse_clifford_run(circuit* c, circuit_element* previous, circuit_element* first, circuit_element* last, const unsigned n_fused_qubits, const unsigned* fused_qubits);
 
 /*
     circuit_free:
@@ -156,6 +264,43 @@ double* circuit_run_noiseless(circuit* c, double* initial_error_rates);
 */
 void circuit_free_default(circuit* c);
 
+// Allocates an element with space for the targets of its gate, the element is not added to the circuit
+circuit_element* circuit_element_create(gate* g);
+
+/*
+ *  circuit_compile:
+ *  Copies a circuit into a flat compiled circuit
+ *  Each gate is placed in the earliest moment after every earlier gate that shares one of its qubits
+ *  :: const circuit* c :: The circuit to be compiled, changes to it are not seen by the compiled circuit
+ *  Returns a heap pointer to the compiled circuit, free it with circuit_compiled_free
+ */
+circuit_compiled* circuit_compile(const circuit* c);
+
+// The targets of a gate in a compiled circuit
+const unsigned* circuit_compiled_targets(const circuit_compiled* cc, const uint32_t gate_idx);
+
+// Flags the qubits a gate in a compiled circuit acts on
+void circuit_compiled_mark_busy(const circuit_compiled* cc, const uint32_t gate_idx, uint8_t* busy);
+
+/*
+ *  circuit_compiled_run_buffers:
+ *  Applies a compiled circuit to a table in place, see circuit_run_buffers
+ *  :: const circuit_compiled* cc :: The compiled circuit to be run
+ *  :: error_probability_t** error_rate :: The error rates before the circuit is applied, holds the error rates after the circuit
+ *  :: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+ *  :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ *  Returns nothing
+ */
+void circuit_compiled_run_buffers(const circuit_compiled* cc, error_probability_t** error_rate, error_probability_t** scratch, gate* noise);
+
+/*
+ *  circuit_compiled_free:
+ *  Frees a compiled circuit, the gates are left alone
+ *  :: circuit_compiled* cc :: The compiled circuit
+ *  Returns nothing
+ */
+void circuit_compiled_free(circuit_compiled* cc);
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DEFINITIONS 
 // ----------------------------------------------------------------------------------------
@@ -174,10 +319,11 @@ circuit* circuit_create(const unsigned n_qubits)
     c->n_gates = 0;
     c->start = NULL;
     c->end = NULL;
+    c->circuit_data = NULL;
     return c;
 }
 
-double* circuit_run(circuit* c, double* initial_error_rates, gate* noise)
+error_probability_t* circuit_run(circuit* c, error_probability_t* initial_error_rates, gate* noise)
 {
     return c->circuit_operation(c, initial_error_rates, noise);
 }
@@ -207,20 +353,26 @@ void circuit_add_gate(circuit* c, gate* g, ...)
     va_list args;
     va_start(args, g);
 
-    // Allocate memory for the target qubit array
-    unsigned* target_qubits = (unsigned*)malloc(sizeof(unsigned) * g->n_qubits);
+    circuit_element* ce = circuit_element_create(g);
 
-    // For each qubit that we are expecting, take the next variadic argument and copy it to the array
+    // For each qubit that we are expecting, take the next variadic argument and copy it to the element
     for (unsigned i = 0; i < g->n_qubits; i++)
     {
-        target_qubits[i] = va_arg(args, unsigned);
+        ce->target_qubits[i] = va_arg(args, unsigned);
     }
     va_end(args);
-    
-    // Add the new gate using the regular function
-    circuit_add_non_varg(c, g, target_qubits);
 
-    free(target_qubits);
+    if (NULL != c->start)
+    {
+        c->end->next = ce;
+        c->end = ce;
+    }
+    else
+    {
+        c->start = ce;
+        c->end = ce;
+    }
+    c->n_gates++;
     return;
 }
 
@@ -234,11 +386,8 @@ void circuit_add_gate(circuit* c, gate* g, ...)
 */
 void circuit_add_non_varg(circuit* c, gate* g, unsigned* target_qubits)
 {
-    circuit_element* ce = (circuit_element*)malloc(sizeof(circuit_element));
-    ce->gate_operation = g;
-    ce->target_qubits = (unsigned*)malloc(sizeof(unsigned) * g->n_qubits);
+    circuit_element* ce = circuit_element_create(g);
     memcpy(ce->target_qubits, target_qubits, g->n_qubits * sizeof(unsigned));
-    ce->next = NULL;
     
     if (NULL != c->start)
     {
@@ -269,20 +418,23 @@ void circuit_add_gate_start(circuit* c, gate* g, ...)
     va_list args;
     va_start(args, g);
 
-    // Allocate memory for the target qubit array
-    unsigned* target_qubits = (unsigned*)malloc(sizeof(unsigned) * g->n_qubits);
+    circuit_element* ce = circuit_element_create(g);
 
-    // For each qubit that we are expecting, take the next variadic argument and copy it to the array
+    // For each qubit that we are expecting, take the next variadic argument and copy it to the element
     for (unsigned i = 0; i < g->n_qubits; i++)
     {
-        target_qubits[i] = va_arg(args, unsigned);
+        ce->target_qubits[i] = va_arg(args, unsigned);
     }
     va_end(args);
-    
-    // Add the new gate using the regular function
-    circuit_add_non_varg_start(c, g, target_qubits);
 
-    free(target_qubits);
+    // Add to the start of the list
+    ce->next = c->start;
+    c->start = ce;
+    if (NULL == c->end)
+    {
+        c->end = ce;
+    }
+    c->n_gates++;
     return;
 }
 
@@ -296,43 +448,49 @@ void circuit_add_gate_start(circuit* c, gate* g, ...)
 */
 void circuit_add_non_varg_start(circuit* c, gate* g, unsigned* target_qubits)
 {
-    circuit_element* ce = (circuit_element*)malloc(sizeof(circuit_element));
-    ce->gate_operation = g;
-    ce->target_qubits = (unsigned*)malloc(sizeof(unsigned) * g->n_qubits);
+    circuit_element* ce = circuit_element_create(g);
     memcpy(ce->target_qubits, target_qubits, g->n_qubits * sizeof(unsigned));
     
     // Add to the start of the list
     ce->next = c->start;
     c->start = ce;
+    if (NULL == c->end)
+    {
+        c->end = ce;
+    }
     c->n_gates++;
     return;
 }
 
 
+// Allocates an element with space for the targets of its gate, the element is not added to the circuit
+// The targets share the allocation of the element, so freeing the element frees them
+circuit_element* circuit_element_create(gate* g)
+{
+    circuit_element* ce = (circuit_element*)malloc(sizeof(circuit_element) + sizeof(unsigned) * g->n_qubits);
+    ce->gate_operation = g;
+    ce->target_qubits = (unsigned*)(ce + 1);
+    ce->next = NULL;
+    ce->gate_free = NULL;
+    return ce;
+}
+
 /* 
  *  circuit_run_noiseless:
  *  Applies a circuit to an existing set of error probabilities
- *  :: double* initial_error_rates :: The error rates before the circuit is applied
+ *  :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
  *  :: circuit* c :: The circuit the gate is being added to
  *  :: const unsigned n_qubits :: The number of qubits
  *  Returns a heap pointer to the new set of error rates
  */
-double* circuit_run_noiseless(circuit* c, double* initial_error_rates)
+error_probability_t* circuit_run_noiseless(circuit* c, error_probability_t* initial_error_rates)
 {
-    double* error_rate = error_probabilities_copy(c->n_qubits, initial_error_rates);
-
-    unsigned long n_bytes = sizeof(double) * (1 << (c->n_qubits * 2));
-    circuit_element* ce = c->start;
-
-    while(ce != NULL)
-    {
-        double* tmp_error_rate = gate_apply(c->n_qubits, error_rate, ce->gate_operation, ce->target_qubits);
-        memcpy(error_rate, tmp_error_rate, n_bytes);
-        free(tmp_error_rate);
+    error_probability_t* error_rate = error_probabilities_copy(c->n_qubits, initial_error_rates);
+    error_probability_t* scratch = (error_probability_t*)malloc(error_probabilities_bytes_in_table(c->n_qubits));
 
-        ce = ce->next;
-    }
+    circuit_run_buffers(c, &error_rate, &scratch, NULL);
 
+    free(scratch);
     return error_rate;
 }
 
@@ -340,12 +498,12 @@ double* circuit_run_noiseless(circuit* c, double* initial_error_rates)
 /* 
  *  circuit_run_default:
  *  Applies a circuit to an existing set of error probabilities
- *  :: double* initial_error_rates :: The error rates before the circuit is applied
+ *  :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
  *  :: circuit* c :: The circuit the gate is being added to
  *  :: error_model* noise :: The noise to be applied
  *  Returns a heap pointer to the new set of error rates
  */
-double* circuit_run_default(circuit* c, double* initial_error_rates, gate* noise)
+error_probability_t* circuit_run_default(circuit* c, error_probability_t* initial_error_rates, gate* noise)
 {
 
     if (NULL == noise)
@@ -360,46 +518,464 @@ double* circuit_run_default(circuit* c, double* initial_error_rates, gate* noise
         return NULL;
     }
 
-    double* error_rate = error_probabilities_copy(c->n_qubits, initial_error_rates);
-    unsigned long n_bytes = (1ull << (c->n_qubits * 2)) * sizeof(double);
+    error_probability_t* error_rate = error_probabilities_copy(c->n_qubits, initial_error_rates);
+    error_probability_t* scratch = (error_probability_t*)malloc(error_probabilities_bytes_in_table(c->n_qubits));
 
-    circuit_element* ce = c->start;
+    circuit_run_buffers(c, &error_rate, &scratch, noise);
 
-    while (NULL != ce)
+    free(scratch);
+    return error_rate;
+}
+
+/* 
+ *  circuit_run_buffers:
+ *  Applies a circuit to a table in place, following the same schedule as circuit_run_default
+ *  No tables are allocated, each gate either updates the table in place or writes to the scratch table
+ *  and the two are swapped, so this may be called repeatedly with the same pair of tables
+ *  :: circuit* c :: The circuit to be run
+ *  :: error_probability_t** error_rate :: The error rates before the circuit is applied, holds the error rates after the circuit
+ *  :: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+ *  :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ *  Returns nothing
+ */
+void circuit_run_buffers(circuit* c, error_probability_t** error_rate, error_probability_t** scratch, gate* noise)
+{
+    circuit_compiled* cc = circuit_compile(c);
+    circuit_compiled_run_buffers(cc, error_rate, scratch, noise);
+    circuit_compiled_free(cc);
+    return;
+}
+
+/* 
+ *  circuit_compiled_run_buffers:
+ *  Applies a compiled circuit to a table in place, see circuit_run_buffers
+ *  :: const circuit_compiled* cc :: The compiled circuit to be run
+ *  :: error_probability_t** error_rate :: The error rates before the circuit is applied, holds the error rates after the circuit
+ *  :: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+ *  :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ *  Returns nothing
+ */
+void circuit_compiled_run_buffers(const circuit_compiled* cc, error_probability_t** error_rate, error_probability_t** scratch, gate* noise)
+{
+    uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * cc->n_qubits);
+
+    for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
     {
         // Gate operation
-        double* tmp_error_rate = gate_apply(c->n_qubits, error_rate, ce->gate_operation, ce->target_qubits);
-        memcpy(error_rate, tmp_error_rate, n_bytes);
-        free(tmp_error_rate);
+        gate_apply_buffers(cc->n_qubits, error_rate, scratch, cc->gates[gate_idx], circuit_compiled_targets(cc, gate_idx));
     
+        // Environmental Noise operations, applied to every qubit that doesn't participate in the gate
+        if (NULL != noise)
+        {
+            memset(busy, 0, sizeof(uint8_t) * cc->n_qubits);
+            circuit_compiled_mark_busy(cc, gate_idx, busy);
+            circuit_idle_noise(cc->n_qubits, error_rate, scratch, noise, busy);
+        }
+    }
+
+    free(busy);
+    return;
+}
+
+/* 
+ *  circuit_run_moments:
+ *  Applies a circuit to an existing set of error probabilities, grouping the gates into moments
+ *  Each gate is placed in the earliest moment after every earlier gate that shares one of its qubits
+ *  The environmental noise is applied once per moment to the qubits that are idle in that moment,
+ *  rather than once per gate as in circuit_run_default
+ *  This is opt in, either call it directly or set c->circuit_operation to circuit_run_moments
+ *  :: circuit* c :: The circuit to be run
+ *  :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
+ *  :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ *  Returns a heap pointer to the new set of error rates
+ */
+error_probability_t* circuit_run_moments(circuit* c, error_probability_t* initial_error_rates, gate* noise)
+{
+    // Noise should act on a single qubit
+    if (NULL != noise && noise->n_qubits != 1)
+    {
+        printf("Noise should act on a single qubit!\n");
+        return NULL;
+    }
+
+    // Each gate is scheduled as soon as all of its qubits are free when the circuit is compiled
+    circuit_compiled* cc = circuit_compile(c);
+
+    error_probability_t* error_rate = error_probabilities_copy(c->n_qubits, initial_error_rates);
+    error_probability_t* scratch = (error_probability_t*)malloc(error_probabilities_bytes_in_table(c->n_qubits));
+    uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+
+    // Gates within a moment act on disjoint qubits, so they may be applied in any order
+    for (uint32_t moment = 0; moment < cc->n_moments; moment++)
+    {
+        memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+
+        for (uint32_t m = cc->moment_start[moment]; m < cc->moment_start[moment + 1]; m++)
+        {
+            uint32_t gate_idx = cc->moment_gates[m];
+            gate_apply_buffers(c->n_qubits, &error_rate, &scratch, cc->gates[gate_idx], circuit_compiled_targets(cc, gate_idx));
+            circuit_compiled_mark_busy(cc, gate_idx, busy);
+        }
+
+        circuit_idle_noise(c->n_qubits, &error_rate, &scratch, noise, busy);
+    }
+
+    free(scratch);
+    free(busy);
+    circuit_compiled_free(cc);
+    return error_rate;
+}
+
+/* 
+ *  circuit_idle_noise:
+ *  Applies environmental noise to every qubit that is not busy, see gate_apply_buffers
+ *  Local noise is a single strided pass over the table for each idle qubit that updates its blocks in place
+ *  :: const unsigned n_qubits :: The number of qubits in the circuit
+ *  :: error_probability_t** error_rate :: The error rates, this may be swapped with the scratch table
+ *  :: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+ *  :: gate* noise :: The environmental noise, this should act on a single qubit
+ *  :: const uint8_t* busy :: One flag per qubit, set if the qubit participated in a gate
+ *  Returns nothing
+ */
+void circuit_idle_noise(const unsigned n_qubits, error_probability_t** error_rate, error_probability_t** scratch, gate* noise, const uint8_t* busy)
+{
+    if (NULL == noise)
+    {
+        return;
+    }
+
+    for (unsigned i = 0; i < n_qubits; i++)
+    {
+        if (!busy[i])
+        {
+            gate_apply_buffers(n_qubits, error_rate, scratch, noise, &i);
+        }
+    }
+    return;
+}
+
+
+/* 
+ *  circuit_run_batch:
+ *  Applies a circuit to a batch table of error probabilities, see error_probabilities_batch_zeros
+ *  Follows the same schedule as circuit_run_default, with each gate traversed once for every lane
+ *  :: circuit* c :: The circuit to be run
+ *  :: const uint32_t n_lanes :: The number of lanes in the batch
+ *  :: double* initial_error_rates :: The batch of error rates before the circuit is applied
+ *  :: gate* noise :: The environmental noise, a batched error model gives each lane its own noise
+ *  Returns a heap pointer to the new batch of error rates
+ */
+double* circuit_run_batch(circuit* c, const uint32_t n_lanes, double* initial_error_rates, gate* noise)
+{
+    // Noise should act on a single qubit
+    if (NULL != noise && noise->n_qubits != 1)
+    {
+        printf("Noise should act on a single qubit!\n");
+        return NULL;
+    }
+
+    uint64_t n_bytes = error_probabilities_batch_bytes_in_table(c->n_qubits, n_lanes);
+    double* error_rate = error_probabilities_batch_zeros(c->n_qubits, n_lanes);
+    memcpy(error_rate, initial_error_rates, n_bytes);
+
+    circuit_compiled* cc = circuit_compile(c);
+    uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+
+    for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+    {
+        // Gate operation
+        double* tmp_error_rate = gate_apply_batch(c->n_qubits, n_lanes, error_rate, cc->gates[gate_idx], circuit_compiled_targets(cc, gate_idx));
+        free(error_rate);
+        error_rate = tmp_error_rate;
+
         // Environmental Noise operations
-        for (unsigned i = 0; i < c->n_qubits; i++)
+        memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+        circuit_compiled_mark_busy(cc, gate_idx, busy);
+        for (unsigned i = 0; i < c->n_qubits && NULL != noise; i++)
+        {
+            if (!busy[i]) 
+            {
+                tmp_error_rate = gate_apply_batch(c->n_qubits, n_lanes, error_rate, noise, &i);
+                free(error_rate);
+                error_rate = tmp_error_rate;
+            }
+        }
+    }
+
+    free(busy);
+    circuit_compiled_free(cc);
+    return error_rate;
+}
+
+/* 
+ *  circuit_fuse_clifford:
+ *  Replaces each run of consecutive noiseless Clifford and Pauli gates with a single fused gate, see fused_clifford.h
+ *  A run is extended while it covers at most GATE_FUSED_MAX_QUBITS qubits, and the fused gates are freed with the circuit
+ *  The circuit then applies the same operation with one table pass per run rather than one per gate
+ *  Environmental noise in circuit_run_default and circuit_run_moments is applied around each fused gate as if it were a single gate,
+ *  so fusion should be used on noiseless circuits, or where a run of gates is meant to be a single time step
+ *  :: circuit* c :: The circuit
+ *  Returns the number of gates removed from the circuit
+ */
+unsigned circuit_fuse_clifford(circuit* c)
+{
+    unsigned n_removed = 0;
+
+    // The current run
+    circuit_element* previous = NULL; // The element before the run, NULL if the run starts the circuit
+    circuit_element* first = NULL;
+    circuit_element* last = NULL;
+    unsigned n_run = 0;
+    unsigned n_fused_qubits = 0;
+    unsigned fused_qubits[GATE_FUSED_MAX_QUBITS];
+
+    circuit_element* before = NULL; // The element before ce
+    circuit_element* ce = c->start;
+    while (NULL != ce)
+    {
+        circuit_element* ce_next = ce->next;
+        uint8_t fusible = gate_fused_clifford_fusible(ce->gate_operation);
+
+        // The qubits covered by the run if this gate were added
+        unsigned n_union = n_fused_qubits;
+        unsigned union_qubits[2 * GATE_FUSED_MAX_QUBITS];
+        memcpy(union_qubits, fused_qubits, sizeof(unsigned) * n_fused_qubits);
+        for (uint32_t i = 0; fusible && i < ce->gate_operation->n_qubits && n_union <= GATE_FUSED_MAX_QUBITS; i++)
+        {
+            uint8_t found = 0;
+            for (uint32_t j = 0; j < n_union; j++)
+            {
+                found |= (union_qubits[j] == ce->target_qubits[i]);
+            }
+            if (!found)
+            {
+                union_qubits[n_union++] = ce->target_qubits[i];
+            }
+        }
+
+        if (fusible && n_run > 0 && n_union <= GATE_FUSED_MAX_QUBITS)
+        {
+            // Extend the run
+            last = ce;
+            n_run++;
+            n_fused_qubits = n_union;
+            memcpy(fused_qubits, union_qubits, sizeof(unsigned) * n_fused_qubits);
+        }
+        else
         {
-            uint8_t participant = 0;
-            // Check that the qubit doesn't participate
-            for (uint32_t j = 0; j < ce->gate_operation->n_qubits && !participant; j++)
+            // Close the current run, a single gate is left as it is
+            if (n_run > 1)
             {
-                if (i == ce->target_qubits[j])
+                before = circuit_fuse_clifford_run(c, previous, first, last, n_fused_qubits, fused_qubits);
+                n_removed += n_run - 1;
+            }
+            n_run = 0;
+            n_fused_qubits = 0;
+
+            // Start a new run
+            if (fusible && ce->gate_operation->n_qubits <= GATE_FUSED_MAX_QUBITS)
+            {
+                previous = before;
+                first = ce;
+                last = ce;
+                n_run = 1;
+                n_fused_qubits = 0;
+                for (uint32_t i = 0; i < ce->gate_operation->n_qubits; i++)
                 {
-                    participant = 1;
+                    uint8_t found = 0;
+                    for (uint32_t j = 0; j < n_fused_qubits; j++)
+                    {
+                        found |= (fused_qubits[j] == ce->target_qubits[i]);
+                    }
+                    if (!found)
+                    {
+                        fused_qubits[n_fused_qubits++] = ce->target_qubits[i];
+                    }
                 }
             }
+        }
 
-            // If the qubit hasn't participated in the gate, apply the environmental noise
-            if (!participant) 
+        before = ce;
+        ce = ce_next;
+    }
+
+    if (n_run > 1)
+    {
+        circuit_fuse_clifford_run(c, previous, first, last, n_fused_qubits, fused_qubits);
+        n_removed += n_run - 1;
+    }
+    return n_removed;
+}
+
+// Replaces the elements from first to last with a single fused gate, returns the new element
+circuit_element* circuit_fuse_clifford_run(circuit* c, circuit_element* previous, circuit_element* first, circuit_element* last, const unsigned n_fused_qubits, const unsigned* fused_qubits)
+{
+    gate* fused = gate_create_fused_clifford(n_fused_qubits);
+    circuit_element* after = last->next;
+
+    circuit_element* ce = first;
+    while (after != ce)
+    {
+        // Number the targets of this gate within the fused gate
+        unsigned local_targets[GATE_FUSED_MAX_QUBITS];
+        for (uint32_t i = 0; i < ce->gate_operation->n_qubits; i++)
+        {
+            for (uint32_t j = 0; j < n_fused_qubits; j++)
             {
-                double* tmp_error_rate = gate_apply(c->n_qubits, error_rate, noise, &i);
-                memcpy(error_rate, tmp_error_rate, n_bytes);
-                free(tmp_error_rate);   
+                if (fused_qubits[j] == ce->target_qubits[i])
+                {
+                    local_targets[i] = j;
+                }
             }
         }
+        gate_fused_clifford_append(fused, ce->gate_operation, local_targets);
 
-        ce = ce->next;
+        circuit_element* ce_next = ce->next;
+        if (NULL != ce->gate_free)
+        {
+            ce->gate_free(ce->gate_operation);
+        }
+        free(ce);
+        c->n_gates--;
+        ce = ce_next;
     }
 
-    return error_rate;
+    circuit_element* fused_element = circuit_element_create(fused);
+    memcpy(fused_element->target_qubits, fused_qubits, sizeof(unsigned) * n_fused_qubits);
+    fused_element->next = after;
+    fused_element->gate_free = gate_fused_clifford_free;
+
+    if (NULL == previous)
+    {
+        c->start = fused_element;
+    }
+    else
+    {
+        previous->next = fused_element;
+    }
+    if (NULL == after)
+    {
+        c->end = fused_element;
+    }
+    c->n_gates++;
+    return fused_element;
 }
 
+/*
+ *  circuit_compile:
+ *  Copies a circuit into a flat compiled circuit
+ *  Each gate is placed in the earliest moment after every earlier gate that shares one of its qubits
+ *  :: const circuit* c :: The circuit to be compiled, changes to it are not seen by the compiled circuit
+ *  Returns a heap pointer to the compiled circuit, free it with circuit_compiled_free
+ */
+circuit_compiled* circuit_compile(const circuit* c)
+{
+    uint32_t n_targets = 0;
+    uint32_t n_gates = 0;
+    for (circuit_element* ce = c->start; NULL != ce; ce = ce->next)
+    {
+        n_targets += ce->gate_operation->n_qubits;
+        n_gates++;
+    }
+
+    // A single allocation, the pointer array comes first so every array is aligned
+    size_t n_bytes = sizeof(circuit_compiled)
+        + sizeof(gate*) * n_gates
+        + sizeof(uint32_t) * (n_gates + 1)
+        + sizeof(unsigned) * n_targets
+        + sizeof(uint32_t) * (n_gates + 1)
+        + sizeof(uint32_t) * n_gates;
+    circuit_compiled* cc = (circuit_compiled*)malloc(n_bytes);
+    cc->n_qubits = c->n_qubits;
+    cc->n_gates = n_gates;
+    cc->gates = (gate**)(cc + 1);
+    cc->target_start = (uint32_t*)(cc->gates + n_gates);
+    cc->target_qubits = (unsigned*)(cc->target_start + n_gates + 1);
+    cc->moment_start = (uint32_t*)(cc->target_qubits + n_targets);
+    cc->moment_gates = cc->moment_start + n_gates + 1;
+
+    // Flatten the list, and schedule each gate as soon as all of its qubits are free
+    uint32_t* gate_moment = (uint32_t*)malloc(sizeof(uint32_t) * (n_gates + 1));
+    uint32_t* qubit_moment = (uint32_t*)calloc(c->n_qubits, sizeof(uint32_t));
+    cc->n_moments = 0;
+    cc->target_start[0] = 0;
+
+    uint32_t gate_idx = 0;
+    for (circuit_element* ce = c->start; NULL != ce; ce = ce->next, gate_idx++)
+    {
+        unsigned n_gate_qubits = ce->gate_operation->n_qubits;
+        cc->gates[gate_idx] = ce->gate_operation;
+        memcpy(cc->target_qubits + cc->target_start[gate_idx], ce->target_qubits, sizeof(unsigned) * n_gate_qubits);
+        cc->target_start[gate_idx + 1] = cc->target_start[gate_idx] + n_gate_qubits;
+
+        uint32_t moment = 0;
+        for (uint32_t j = 0; j < n_gate_qubits; j++)
+        {
+            if (qubit_moment[ce->target_qubits[j]] > moment)
+            {
+                moment = qubit_moment[ce->target_qubits[j]];
+            }
+        }
+        for (uint32_t j = 0; j < n_gate_qubits; j++)
+        {
+            qubit_moment[ce->target_qubits[j]] = moment + 1;
+        }
+        gate_moment[gate_idx] = moment;
+        if (moment + 1 > cc->n_moments)
+        {
+            cc->n_moments = moment + 1;
+        }
+    }
+    free(qubit_moment);
+
+    // Counting sort of the gates by moment, this keeps program order within a moment
+    // There are at most as many moments as gates, so the moment offsets fit in the space set aside for them
+    memset(cc->moment_start, 0, sizeof(uint32_t) * (cc->n_moments + 1));
+    for (gate_idx = 0; gate_idx < n_gates; gate_idx++)
+    {
+        cc->moment_start[gate_moment[gate_idx] + 1]++;
+    }
+    for (uint32_t moment = 0; moment < cc->n_moments; moment++)
+    {
+        cc->moment_start[moment + 1] += cc->moment_start[moment];
+    }
+    uint32_t* moment_fill = (uint32_t*)malloc(sizeof(uint32_t) * (cc->n_moments + 1));
+    memcpy(moment_fill, cc->moment_start, sizeof(uint32_t) * (cc->n_moments + 1));
+    for (gate_idx = 0; gate_idx < n_gates; gate_idx++)
+    {
+        cc->moment_gates[moment_fill[gate_moment[gate_idx]]++] = gate_idx;
+    }
+
+    free(moment_fill);
+    free(gate_moment);
+    return cc;
+}
+
+// The targets of a gate in a compiled circuit
+const unsigned* circuit_compiled_targets(const circuit_compiled* cc, const uint32_t gate_idx)
+{
+    return cc->target_qubits + cc->target_start[gate_idx];
+}
+
+// Flags the qubits a gate in a compiled circuit acts on
+void circuit_compiled_mark_busy(const circuit_compiled* cc, const uint32_t gate_idx, uint8_t* busy)
+{
+    for (uint32_t j = cc->target_start[gate_idx]; j < cc->target_start[gate_idx + 1]; j++)
+    {
+        busy[cc->target_qubits[j]] = 1;
+    }
+}
+
+/*
+ *  circuit_compiled_free:
+ *  Frees a compiled circuit, the gates are left alone
+ *  :: circuit_compiled* cc :: The compiled circuit
+ *  Returns nothing
+ */
+void circuit_compiled_free(circuit_compiled* cc)
+{
+    free(cc);
+}
 
 /*
  *  circuit_param_free_default:
@@ -429,7 +1005,10 @@ void circuit_free(circuit* c)
     while(ce != NULL)
     {
         circuit_element* ce_next = ce->next;
-        free(ce->target_qubits);
+        if (NULL != ce->gate_free)
+        {
+            ce->gate_free(ce->gate_operation);
+        }
         free(ce);
         ce = ce_next;
     }
@@ -437,4 +1016,8 @@ void circuit_free(circuit* c)
     free(c);
 }
 
+// SPARSE ENGINE ----------------------------------------------------------------------------------------
+// circuit_run_truncated is defined with the sparse engine
+#include "circuit_sparse.h"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,272 @@
+#ifndef CIRCUIT_LIGHT_CONE
+#define CIRCUIT_LIGHT_CONE
+
+#include "circuit.h"
+#include "error_probabilities.h"
+#include "../gates/gates.h"
+
+// ----------------------------------------------------------------------------------------
+// LIGHT CONE RUNS
+// A qubit that no gate has touched yet has no error, and a qubit that no later gate touches can no longer
+// change the error on any other qubit, so the table only needs to cover the qubits between those two points
+// circuit_run_light_cone adds each qubit to the table when a gate first touches it, and traces it out after
+// the last gate that touches it unless its error is part of the requested output
+//
+// A circuit that measures its ancillas one after another, keeping only the code block, then needs a table over
+// the code block and a single ancilla rather than every ancilla at once
+//
+// Environmental noise is applied after each gate to the idle qubits that are in the table, qubits before their
+// first gate or after their last gate receive no noise, as with the inactive ancillas of the sequential
+// syndrome measurement
+// ----------------------------------------------------------------------------------------
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * circuit_run_light_cone
+ * Applies a circuit to an existing set of error probabilities, tracking only the qubits in the light cone of the output
+ * :: circuit* c :: The circuit to be run
+ * :: error_probability_t* initial_error_rates :: The error rates of the first n_initial_qubits qubits of the circuit, the rest start with no error
+ * :: const uint32_t n_initial_qubits :: The number of qubits covered by the initial error rates
+ * :: const uint8_t* kept :: One flag per qubit of the circuit, set for the qubits in the output
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the error rates of the kept qubits, in the order of the circuit
+ */
+error_probability_t* circuit_run_light_cone(circuit* c,
+	error_probability_t* initial_error_rates,
+	const uint32_t n_initial_qubits,
+	const uint8_t* kept,
+	gate* noise);
+
+/*
+ * circuit_light_cone_peak
+ * Finds the largest number of qubits a table covers during circuit_run_light_cone, without running the circuit
+ * :: circuit* c :: The circuit
+ * :: const uint32_t n_initial_qubits :: The number of qubits covered by the initial error rates
+ * :: const uint8_t* kept :: One flag per qubit of the circuit, set for the qubits in the output
+ * Returns the number of qubits
+ */
+uint32_t circuit_light_cone_peak(circuit* c, const uint32_t n_initial_qubits, const uint8_t* kept);
+
+// One past the index of the last gate that touches each qubit, zero for qubits that are never touched
+uint32_t* circuit_light_cone_last_use(const circuit_compiled* cc);
+
+// The position of a qubit in the table, the number of qubits in the table that come before it
+unsigned circuit_light_cone_position(const uint8_t* active, const unsigned qubit);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * circuit_run_light_cone
+ * Applies a circuit to an existing set of error probabilities, tracking only the qubits in the light cone of the output
+ * :: circuit* c :: The circuit to be run
+ * :: error_probability_t* initial_error_rates :: The error rates of the first n_initial_qubits qubits of the circuit, the rest start with no error
+ * :: const uint32_t n_initial_qubits :: The number of qubits covered by the initial error rates
+ * :: const uint8_t* kept :: One flag per qubit of the circuit, set for the qubits in the output
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the error rates of the kept qubits, in the order of the circuit
+ */
+error_probability_t* circuit_run_light_cone(circuit* c,
+	error_probability_t* initial_error_rates,
+	const uint32_t n_initial_qubits,
+	const uint8_t* kept,
+	gate* noise)
+{
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return NULL;
+	}
+
+	circuit_compiled* cc = circuit_compile(c);
+	uint32_t* last_use = circuit_light_cone_last_use(cc);
+	uint8_t* active = (uint8_t*)calloc(c->n_qubits, sizeof(uint8_t));
+	unsigned* positions = (unsigned*)malloc(sizeof(unsigned) * c->n_qubits);
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+
+	error_probability_t* error_rate = error_probabilities_copy(n_initial_qubits, initial_error_rates);
+	uint32_t n_active = n_initial_qubits;
+	memset(active, 1, sizeof(uint8_t) * n_initial_qubits);
+
+	// Initial qubits that are neither used nor kept
+	uint32_t n_retired = 0;
+	for (unsigned q = 0; q < n_initial_qubits; q++)
+	{
+		if (!kept[q] && 0 == last_use[q])
+		{
+			positions[n_retired++] = q;
+			active[q] = 0;
+		}
+	}
+	if (n_retired > 0)
+	{
+		error_rate = error_probabilities_trace_out(error_rate, n_active, positions, n_retired);
+		n_active -= n_retired;
+	}
+	error_probability_t* scratch = (error_probability_t*)malloc(error_probabilities_bytes_in_table(n_active));
+
+	for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+	{
+		gate* g = cc->gates[gate_idx];
+		const unsigned* targets = circuit_compiled_targets(cc, gate_idx);
+
+		// Qubits enter the table when a gate first touches them
+		uint8_t grown = 0;
+		for (uint32_t j = 0; j < g->n_qubits; j++)
+		{
+			if (!active[targets[j]])
+			{
+				error_rate = error_probabilities_insert_qubit(error_rate, n_active, circuit_light_cone_position(active, targets[j]));
+				active[targets[j]] = 1;
+				n_active++;
+				grown = 1;
+			}
+		}
+		if (grown)
+		{
+			scratch = (error_probability_t*)realloc(scratch, error_probabilities_bytes_in_table(n_active));
+		}
+
+		for (uint32_t j = 0; j < g->n_qubits; j++)
+		{
+			positions[j] = circuit_light_cone_position(active, targets[j]);
+		}
+		gate_apply_buffers(n_active, &error_rate, &scratch, g, positions);
+
+		// Environmental Noise operations, applied to every qubit in the table that doesn't participate in the gate
+		if (NULL != noise)
+		{
+			memset(busy, 0, sizeof(uint8_t) * n_active);
+			for (uint32_t j = 0; j < g->n_qubits; j++)
+			{
+				busy[positions[j]] = 1;
+			}
+			circuit_idle_noise(n_active, &error_rate, &scratch, noise, busy);
+		}
+
+		// Qubits leave the table after the last gate that touches them
+		n_retired = 0;
+		for (uint32_t j = 0; j < g->n_qubits; j++)
+		{
+			if (!kept[targets[j]] && gate_idx + 1 == last_use[targets[j]])
+			{
+				positions[n_retired++] = circuit_light_cone_position(active, targets[j]);
+			}
+		}
+		if (n_retired > 0)
+		{
+			error_rate = error_probabilities_trace_out(error_rate, n_active, positions, n_retired);
+			n_active -= n_retired;
+			for (uint32_t j = 0; j < g->n_qubits; j++)
+			{
+				if (!kept[targets[j]] && gate_idx + 1 == last_use[targets[j]])
+				{
+					active[targets[j]] = 0;
+				}
+			}
+		}
+	}
+
+	// Kept qubits that no gate touched
+	for (unsigned q = 0; q < c->n_qubits; q++)
+	{
+		if (kept[q] && !active[q])
+		{
+			error_rate = error_probabilities_insert_qubit(error_rate, n_active, circuit_light_cone_position(active, q));
+			active[q] = 1;
+			n_active++;
+		}
+	}
+
+	free(scratch);
+	free(busy);
+	free(positions);
+	free(active);
+	free(last_use);
+	circuit_compiled_free(cc);
+	return error_rate;
+}
+
+/*
+ * circuit_light_cone_peak
+ * Finds the largest number of qubits a table covers during circuit_run_light_cone, without running the circuit
+ * :: circuit* c :: The circuit
+ * :: const uint32_t n_initial_qubits :: The number of qubits covered by the initial error rates
+ * :: const uint8_t* kept :: One flag per qubit of the circuit, set for the qubits in the output
+ * Returns the number of qubits
+ */
+uint32_t circuit_light_cone_peak(circuit* c, const uint32_t n_initial_qubits, const uint8_t* kept)
+{
+	circuit_compiled* cc = circuit_compile(c);
+	uint32_t* last_use = circuit_light_cone_last_use(cc);
+	uint8_t* active = (uint8_t*)calloc(c->n_qubits, sizeof(uint8_t));
+
+	uint32_t n_active = 0;
+	for (unsigned q = 0; q < n_initial_qubits; q++)
+	{
+		active[q] = kept[q] || 0 != last_use[q];
+		n_active += active[q];
+	}
+	uint32_t peak = n_active;
+
+	for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+	{
+		const unsigned* targets = circuit_compiled_targets(cc, gate_idx);
+		for (uint32_t j = 0; j < cc->gates[gate_idx]->n_qubits; j++)
+		{
+			n_active += !active[targets[j]];
+			active[targets[j]] = 1;
+		}
+		peak = (n_active > peak) ? n_active : peak;
+
+		for (uint32_t j = 0; j < cc->gates[gate_idx]->n_qubits; j++)
+		{
+			if (active[targets[j]] && !kept[targets[j]] && gate_idx + 1 == last_use[targets[j]])
+			{
+				active[targets[j]] = 0;
+				n_active--;
+			}
+		}
+	}
+
+	// Kept qubits that no gate touched are added at the end
+	for (unsigned q = 0; q < c->n_qubits; q++)
+	{
+		n_active += (kept[q] && !active[q]);
+	}
+	peak = (n_active > peak) ? n_active : peak;
+
+	free(active);
+	free(last_use);
+	circuit_compiled_free(cc);
+	return peak;
+}
+
+// One past the index of the last gate that touches each qubit, zero for qubits that are never touched
+uint32_t* circuit_light_cone_last_use(const circuit_compiled* cc)
+{
+	uint32_t* last_use = (uint32_t*)calloc(cc->n_qubits, sizeof(uint32_t));
+	for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+	{
+		const unsigned* targets = circuit_compiled_targets(cc, gate_idx);
+		for (uint32_t j = 0; j < cc->gates[gate_idx]->n_qubits; j++)
+		{
+			last_use[targets[j]] = gate_idx + 1;
+		}
+	}
+	return last_use;
+}
+
+// The position of a qubit in the table, the number of qubits in the table that come before it
+unsigned circuit_light_cone_position(const uint8_t* active, const unsigned qubit)
+{
+	unsigned position = 0;
+	for (unsigned q = 0; q < qubit; q++)
+	{
+		position += active[q];
+	}
+	return position;
+}
+
+#endif
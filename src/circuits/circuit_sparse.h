@@ -0,0 +1,777 @@
+#ifndef CIRCUIT_SPARSE
+#define CIRCUIT_SPARSE
+
+#include "circuit.h"
+#include "error_probabilities.h"
+#include "../gates/gates.h"
+
+// ----------------------------------------------------------------------------------------
+// SPARSE ENGINE
+// At low physical error rates almost every entry of a dense table is zero or vanishingly small,
+// yet every dense kernel touches all 4^n entries
+// A sparse table keeps only the support, as a list of (index, probability) pairs sorted by index,
+// where the index is the sym_to_ll value of the pauli string as in a dense table
+//
+// Each gate pushes every entry through its emit form, see gate_emit.h, and each error of its noise is an XOR
+// of the index, the new entries are then sorted and entries with the same index are merged
+// Entries that fall below the threshold of the table are dropped and their mass is recorded in discarded,
+// so the total probability of the table plus the discarded mass stays at one
+// A table may also hold a truncation policy, see truncation_policy.h, whose weight, probability and support limits
+// are applied each time the support is rebuilt, so strings the policy drops are never visited by a later gate
+//
+// Indices are 64 bits wide, so sparse tables cover at most 32 qubits
+// ----------------------------------------------------------------------------------------
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+// A single entry of a sparse table
+typedef struct
+{
+	uint64_t index;
+	double prob;
+} error_probabilities_sparse_entry_t;
+
+/*
+ * error_probabilities_sparse
+ * A sparse table of pauli error probabilities
+ * :: uint32_t n_qubits :: The number of qubits covered by the table
+ * :: uint64_t n_entries :: The number of entries in the support
+ * :: error_probabilities_sparse_entry_t* entries :: The support, sorted by index with no repeated indices
+ * :: double threshold :: Entries with a smaller probability are dropped, 0 only drops entries that are exactly zero
+ * :: double discarded :: The total probability of every dropped entry
+ * :: truncation_policy* policy :: Further limits on the support, NULL for none, this is referenced and not owned
+ * This object should be freed using the 'error_probabilities_sparse_free' function
+ */
+typedef struct
+{
+	uint32_t n_qubits;
+	uint64_t n_entries;
+	uint64_t capacity;
+	error_probabilities_sparse_entry_t* entries;
+
+	// New entries are pushed here by each gate, and are then merged back into the support
+	uint64_t n_pending;
+	uint64_t pending_capacity;
+	error_probabilities_sparse_entry_t* pending;
+
+	double threshold;
+	double discarded;
+	truncation_policy* policy;
+} error_probabilities_sparse;
+
+// Data for the emit callback used by gate_sparse_operator
+typedef struct
+{
+	error_probabilities_sparse* sp;
+	double initial_prob;
+} gate_sparse_emit_t;
+
+// Data for the emit callback used by gate_sparse_measure
+typedef struct
+{
+	double* outcome_probabilities;
+	double initial_prob;
+} gate_sparse_measure_emit_t;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * error_probabilities_sparse_create
+ * Creates an empty sparse table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table, at most 32
+ * :: const double threshold :: Entries with a smaller probability are dropped
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_create(const uint32_t n_qubits, const double threshold);
+
+/*
+ * error_probabilities_sparse_identity
+ * Creates a sparse table with the identity given a probability of 1
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table, at most 32
+ * :: const double threshold :: Entries with a smaller probability are dropped
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_identity(const uint32_t n_qubits, const double threshold);
+
+/*
+ * error_probabilities_sparse_from_dense
+ * Creates a sparse table from the entries of a dense table that are at least the threshold
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * :: const error_probability_t* error_probs :: The dense table
+ * :: const double threshold :: Entries with a smaller probability are dropped
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_from_dense(const uint32_t n_qubits, const error_probability_t* error_probs, const double threshold);
+
+/*
+ * error_probabilities_sparse_to_dense
+ * Expands a sparse table into a dense table
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * Returns a heap pointer to the new dense table
+ */
+error_probability_t* error_probabilities_sparse_to_dense(const error_probabilities_sparse* sp);
+
+/*
+ * error_probabilities_sparse_copy
+ * Copies a sparse table, including its threshold, policy and discarded mass
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_copy(const error_probabilities_sparse* sp);
+
+/*
+ * error_probabilities_sparse_get
+ * Looks up the probability of a pauli string
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * :: const uint64_t index :: The table index of the pauli string
+ * Returns the probability, or 0 if the string is not in the support
+ */
+double error_probabilities_sparse_get(const error_probabilities_sparse* sp, const uint64_t index);
+
+/*
+ * error_probabilities_sparse_sum
+ * Sums the probabilities in the support
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * Returns the total probability
+ */
+double error_probabilities_sparse_sum(const error_probabilities_sparse* sp);
+
+/*
+ * error_probabilities_sparse_push
+ * Adds a new entry to the pending list, this is merged into the support by error_probabilities_sparse_merge
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const double prob :: The probability
+ * Returns nothing
+ */
+void error_probabilities_sparse_push(error_probabilities_sparse* sp, const uint64_t index, const double prob);
+
+/*
+ * error_probabilities_sparse_merge
+ * Replaces the support with the pending entries, summing repeated indices and dropping entries below the threshold
+ * or that the policy of the table drops, the identity is only dropped by the threshold
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * Returns nothing
+ */
+void error_probabilities_sparse_merge(error_probabilities_sparse* sp);
+
+/*
+ * error_probabilities_sparse_free
+ * Frees a sparse table
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * Returns nothing
+ */
+void error_probabilities_sparse_free(error_probabilities_sparse* sp);
+
+// Orders entries by index for qsort
+int error_probabilities_sparse_compare(const void* v_a, const void* v_b);
+
+/*
+ * gate_sparse_operator
+ * Applies the operation of a gate to a sparse table
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void gate_sparse_operator(error_probabilities_sparse* sp, const gate* g, const unsigned* target_qubits);
+
+/*
+ * gate_sparse_noise
+ * Applies the error model of a gate to a sparse table
+ * The error model is called once for each local error, errors with no probability are skipped
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void gate_sparse_noise(error_probabilities_sparse* sp, const gate* g, const unsigned* target_qubits);
+
+/*
+ * gate_sparse_apply
+ * Applies the operation and then the error model of a gate to a sparse table
+ * The discarded_last of the policy of the table is the probability dropped by both
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void gate_sparse_apply(error_probabilities_sparse* sp, const gate* g, const unsigned* target_qubits);
+
+/*
+ * gate_sparse_measure
+ * Finds the distribution of the outcomes of a measurement gate over a sparse table
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* measure :: The measurement gate, such as gate_measure_Z
+ * :: const unsigned* target_qubits :: The qubits being measured
+ * Returns a heap pointer to 2^n_bits probabilities, indexed as by sym_to_ll on the outcome
+ */
+double* gate_sparse_measure(const error_probabilities_sparse* sp, const gate* measure, const unsigned* target_qubits);
+
+// Emit callback for gate_sparse_operator, pushes the outcome onto the pending list
+void gate_sparse_emit(const uint64_t index, const double prob, void* ctx);
+
+// Emit callback for gate_sparse_measure, adds the outcome to a dense table of outcomes
+void gate_sparse_measure_emit(const uint64_t index, const double prob, void* ctx);
+
+/*
+ * circuit_run_sparse
+ * Applies a circuit to a sparse table, following the same schedule as circuit_run_default
+ * Only the gates of the circuit are run, circuits that replace their circuit_operation are not supported
+ * :: circuit* c :: The circuit to be run
+ * :: const error_probabilities_sparse* initial_error_rates :: The error rates before the circuit is applied
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the new sparse table, its discarded mass includes that of the initial table
+ */
+error_probabilities_sparse* circuit_run_sparse(circuit* c, const error_probabilities_sparse* initial_error_rates, gate* noise);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * error_probabilities_sparse_create
+ * Creates an empty sparse table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table, at most 32
+ * :: const double threshold :: Entries with a smaller probability are dropped
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_create(const uint32_t n_qubits, const double threshold)
+{
+	if (n_qubits > 32)
+	{
+		printf("Sparse tables may cover at most 32 qubits\n");
+		return NULL;
+	}
+
+	error_probabilities_sparse* sp = (error_probabilities_sparse*)malloc(sizeof(error_probabilities_sparse));
+	sp->n_qubits = n_qubits;
+	sp->n_entries = 0;
+	sp->capacity = 16;
+	sp->entries = (error_probabilities_sparse_entry_t*)malloc(sizeof(error_probabilities_sparse_entry_t) * sp->capacity);
+	sp->n_pending = 0;
+	sp->pending_capacity = 16;
+	sp->pending = (error_probabilities_sparse_entry_t*)malloc(sizeof(error_probabilities_sparse_entry_t) * sp->pending_capacity);
+	sp->threshold = threshold;
+	sp->discarded = 0;
+	sp->policy = NULL;
+	return sp;
+}
+
+/*
+ * error_probabilities_sparse_identity
+ * Creates a sparse table with the identity given a probability of 1
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table, at most 32
+ * :: const double threshold :: Entries with a smaller probability are dropped
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_identity(const uint32_t n_qubits, const double threshold)
+{
+	error_probabilities_sparse* sp = error_probabilities_sparse_create(n_qubits, threshold);
+	if (NULL != sp)
+	{
+		sp->entries[0].index = 0;
+		sp->entries[0].prob = 1;
+		sp->n_entries = 1;
+	}
+	return sp;
+}
+
+/*
+ * error_probabilities_sparse_from_dense
+ * Creates a sparse table from the entries of a dense table that are at least the threshold
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * :: const error_probability_t* error_probs :: The dense table
+ * :: const double threshold :: Entries with a smaller probability are dropped
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_from_dense(const uint32_t n_qubits, const error_probability_t* error_probs, const double threshold)
+{
+	error_probabilities_sparse* sp = error_probabilities_sparse_create(n_qubits, threshold);
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	for (uint64_t index = 0; index < n_entries; index++)
+	{
+		if (0 != error_probs[index])
+		{
+			error_probabilities_sparse_push(sp, index, error_probs[index]);
+		}
+	}
+	// The pending entries are already sorted, so this only applies the threshold
+	error_probabilities_sparse_merge(sp);
+	return sp;
+}
+
+/*
+ * error_probabilities_sparse_to_dense
+ * Expands a sparse table into a dense table
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * Returns a heap pointer to the new dense table
+ */
+error_probability_t* error_probabilities_sparse_to_dense(const error_probabilities_sparse* sp)
+{
+	error_probability_t* error_probs = error_probabilities_zeros(sp->n_qubits);
+	for (uint64_t i = 0; i < sp->n_entries; i++)
+	{
+		error_probs[sp->entries[i].index] = sp->entries[i].prob;
+	}
+	return error_probs;
+}
+
+/*
+ * error_probabilities_sparse_copy
+ * Copies a sparse table, including its threshold, policy and discarded mass
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * Returns a heap pointer to the new table
+ */
+error_probabilities_sparse* error_probabilities_sparse_copy(const error_probabilities_sparse* sp)
+{
+	error_probabilities_sparse* copy = error_probabilities_sparse_create(sp->n_qubits, sp->threshold);
+	free(copy->entries);
+	copy->capacity = sp->n_entries ? sp->n_entries : 1;
+	copy->entries = (error_probabilities_sparse_entry_t*)malloc(sizeof(error_probabilities_sparse_entry_t) * copy->capacity);
+	memcpy(copy->entries, sp->entries, sizeof(error_probabilities_sparse_entry_t) * sp->n_entries);
+	copy->n_entries = sp->n_entries;
+	copy->discarded = sp->discarded;
+	copy->policy = sp->policy;
+	return copy;
+}
+
+/*
+ * error_probabilities_sparse_get
+ * Looks up the probability of a pauli string
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * :: const uint64_t index :: The table index of the pauli string
+ * Returns the probability, or 0 if the string is not in the support
+ */
+double error_probabilities_sparse_get(const error_probabilities_sparse* sp, const uint64_t index)
+{
+	// Binary search over the sorted support
+	uint64_t lo = 0;
+	uint64_t hi = sp->n_entries;
+	while (lo < hi)
+	{
+		uint64_t mid = lo + (hi - lo) / 2;
+		if (sp->entries[mid].index < index)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return (lo < sp->n_entries && sp->entries[lo].index == index) ? sp->entries[lo].prob : 0;
+}
+
+/*
+ * error_probabilities_sparse_sum
+ * Sums the probabilities in the support
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * Returns the total probability
+ */
+double error_probabilities_sparse_sum(const error_probabilities_sparse* sp)
+{
+	double total = 0;
+	for (uint64_t i = 0; i < sp->n_entries; i++)
+	{
+		total += sp->entries[i].prob;
+	}
+	return total;
+}
+
+/*
+ * error_probabilities_sparse_push
+ * Adds a new entry to the pending list, this is merged into the support by error_probabilities_sparse_merge
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const double prob :: The probability
+ * Returns nothing
+ */
+void error_probabilities_sparse_push(error_probabilities_sparse* sp, const uint64_t index, const double prob)
+{
+	if (sp->n_pending == sp->pending_capacity)
+	{
+		sp->pending_capacity *= 2;
+		sp->pending = (error_probabilities_sparse_entry_t*)realloc(sp->pending, sizeof(error_probabilities_sparse_entry_t) * sp->pending_capacity);
+	}
+	sp->pending[sp->n_pending].index = index;
+	sp->pending[sp->n_pending].prob = prob;
+	sp->n_pending++;
+	return;
+}
+
+// Orders entries by index for qsort
+int error_probabilities_sparse_compare(const void* v_a, const void* v_b)
+{
+	uint64_t a = ((const error_probabilities_sparse_entry_t*)v_a)->index;
+	uint64_t b = ((const error_probabilities_sparse_entry_t*)v_b)->index;
+	return (a > b) - (a < b);
+}
+
+/*
+ * error_probabilities_sparse_merge
+ * Replaces the support with the pending entries, summing repeated indices and dropping entries below the threshold
+ * or that the policy of the table drops, the identity is only dropped by the threshold
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * Returns nothing
+ */
+void error_probabilities_sparse_merge(error_probabilities_sparse* sp)
+{
+	qsort(sp->pending, sp->n_pending, sizeof(error_probabilities_sparse_entry_t), error_probabilities_sparse_compare);
+
+	// Sum runs of the same index in place
+	uint64_t n_merged = 0;
+	for (uint64_t i = 0; i < sp->n_pending; i++)
+	{
+		if (n_merged > 0 && sp->pending[n_merged - 1].index == sp->pending[i].index)
+		{
+			sp->pending[n_merged - 1].prob += sp->pending[i].prob;
+		}
+		else
+		{
+			sp->pending[n_merged++] = sp->pending[i];
+		}
+	}
+
+	// Then drop the entries below the threshold, and those above the weight or below the probability of the policy
+	truncation_policy* policy = sp->policy;
+	double discarded = 0;
+	uint64_t n_kept = 0;
+	uint64_t n_support = 0;
+	for (uint64_t i = 0; i < n_merged; i++)
+	{
+		uint64_t index = sp->pending[i].index;
+		double prob = sp->pending[i].prob;
+		if (0 == prob || prob < sp->threshold
+			|| (0 != index && !truncation_policy_keeps(policy, truncation_policy_weight(index, sp->n_qubits), prob)))
+		{
+			discarded += prob;
+		}
+		else
+		{
+			sp->pending[n_kept++] = sp->pending[i];
+			n_support += (0 != index);
+		}
+	}
+
+	// Support limit, as truncation_policy_apply the identity is counted and the most likely strings are kept
+	if (NULL != policy && TRUNCATION_NO_MAX_SUPPORT != policy->max_support && n_support + 1 > policy->max_support)
+	{
+		uint64_t n_limit = (policy->max_support > 1) ? policy->max_support - 1 : 0;
+		double* sorted = (double*)malloc(sizeof(double) * n_support);
+		uint64_t count = 0;
+		for (uint64_t i = 0; i < n_kept; i++)
+		{
+			if (0 != sp->pending[i].index)
+			{
+				sorted[count++] = sp->pending[i].prob;
+			}
+		}
+		uint64_t n_ties = 0;
+		double cutoff = truncation_policy_support_cutoff(sorted, n_support, n_limit, &n_ties);
+		free(sorted);
+
+		uint64_t n_limited = 0;
+		for (uint64_t i = 0; i < n_kept; i++)
+		{
+			double prob = sp->pending[i].prob;
+			uint8_t keep = (0 == sp->pending[i].index) || (prob > cutoff);
+			if (!keep && prob == cutoff && n_ties > 0)
+			{
+				n_ties--;
+				keep = 1;
+			}
+
+			if (keep)
+			{
+				sp->pending[n_limited++] = sp->pending[i];
+			}
+			else
+			{
+				discarded += prob;
+			}
+		}
+		n_kept = n_limited;
+	}
+
+	sp->discarded += discarded;
+	if (NULL != policy)
+	{
+		// A gate merges once for its operation and once for its noise, gate_sparse_apply resets this between gates
+		policy->discarded_last += discarded;
+		policy->discarded += discarded;
+	}
+
+	// The pending list becomes the support, and the old support is reused for the next gate
+	error_probabilities_sparse_entry_t* tmp = sp->entries;
+	uint64_t tmp_capacity = sp->capacity;
+	sp->entries = sp->pending;
+	sp->capacity = sp->pending_capacity;
+	sp->n_entries = n_kept;
+	sp->pending = tmp;
+	sp->pending_capacity = tmp_capacity;
+	sp->n_pending = 0;
+	return;
+}
+
+/*
+ * error_probabilities_sparse_free
+ * Frees a sparse table
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * Returns nothing
+ */
+void error_probabilities_sparse_free(error_probabilities_sparse* sp)
+{
+	free(sp->entries);
+	free(sp->pending);
+	free(sp);
+	return;
+}
+
+/*
+ * gate_sparse_operator
+ * Applies the operation of a gate to a sparse table
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void gate_sparse_operator(error_probabilities_sparse* sp, const gate* g, const unsigned* target_qubits)
+{
+	if (NULL == g->operation)
+	{
+		return;
+	}
+
+	gate_sparse_emit_t ctx;
+	ctx.sp = sp;
+	for (uint64_t i = 0; i < sp->n_entries; i++)
+	{
+		ctx.initial_prob = sp->entries[i].prob;
+		gate_emit(g, sp->entries[i].index, sp->n_qubits, target_qubits, gate_sparse_emit, &ctx);
+	}
+	error_probabilities_sparse_merge(sp);
+	return;
+}
+
+// Emit callback for gate_sparse_operator, pushes the outcome onto the pending list
+void gate_sparse_emit(const uint64_t index, const double prob, void* ctx)
+{
+	gate_sparse_emit_t* emit_data = (gate_sparse_emit_t*)ctx;
+	error_probabilities_sparse_push(emit_data->sp, index, prob * emit_data->initial_prob);
+	return;
+}
+
+/*
+ * gate_sparse_noise
+ * Applies the error model of a gate to a sparse table
+ * The error model is called once for each local error, errors with no probability are skipped
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void gate_sparse_noise(error_probabilities_sparse* sp, const gate* g, const unsigned* target_qubits)
+{
+	if (NULL == g->gate_error_model)
+	{
+		return;
+	}
+
+	uint64_t n_local = 1ull << (2 * g->n_qubits);
+	uint32_t* positions = (uint32_t*)malloc(sizeof(uint32_t) * 2 * g->n_qubits);
+	uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * n_local);
+	gate_kernel_block_layout(sp->n_qubits, g->n_qubits, target_qubits, positions, offsets);
+
+	// Keep the errors that can occur, each is an XOR of its offset
+	uint64_t n_terms = 0;
+	uint64_t* term_offsets = (uint64_t*)malloc(sizeof(uint64_t) * n_local);
+	double* term_probabilities = (double*)malloc(sizeof(double) * n_local);
+	for (uint64_t local = 0; local < n_local; local++)
+	{
+		sym* gate_error = ll_to_sym_n_qubits(local, 1, g->n_qubits);
+		double prob = error_model_call(g->gate_error_model, gate_error);
+		sym_free(gate_error);
+		if (0 != prob)
+		{
+			term_offsets[n_terms] = offsets[local];
+			term_probabilities[n_terms] = prob;
+			n_terms++;
+		}
+	}
+
+	for (uint64_t i = 0; i < sp->n_entries; i++)
+	{
+		for (uint64_t term = 0; term < n_terms; term++)
+		{
+			error_probabilities_sparse_push(sp, sp->entries[i].index ^ term_offsets[term], sp->entries[i].prob * term_probabilities[term]);
+		}
+	}
+	error_probabilities_sparse_merge(sp);
+
+	free(positions);
+	free(offsets);
+	free(term_offsets);
+	free(term_probabilities);
+	return;
+}
+
+/*
+ * gate_sparse_apply
+ * Applies the operation and then the error model of a gate to a sparse table
+ * The discarded_last of the policy of the table is the probability dropped by both
+ * :: error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void gate_sparse_apply(error_probabilities_sparse* sp, const gate* g, const unsigned* target_qubits)
+{
+	if (NULL != sp->policy)
+	{
+		sp->policy->discarded_last = 0;
+	}
+	gate_sparse_operator(sp, g, target_qubits);
+	gate_sparse_noise(sp, g, target_qubits);
+	return;
+}
+
+/*
+ * gate_sparse_measure
+ * Finds the distribution of the outcomes of a measurement gate over a sparse table
+ * :: const error_probabilities_sparse* sp :: The sparse table
+ * :: const gate* measure :: The measurement gate, such as gate_measure_Z
+ * :: const unsigned* target_qubits :: The qubits being measured
+ * Returns a heap pointer to 2^n_bits probabilities, indexed as by sym_to_ll on the outcome
+ */
+double* gate_sparse_measure(const error_probabilities_sparse* sp, const gate* measure, const unsigned* target_qubits)
+{
+	double* outcome_probs = (double*)calloc(1ull << measure->n_qubits, sizeof(double));
+
+	gate_sparse_measure_emit_t ctx;
+	ctx.outcome_probabilities = outcome_probs;
+	for (uint64_t i = 0; i < sp->n_entries; i++)
+	{
+		ctx.initial_prob = sp->entries[i].prob;
+		gate_emit(measure, sp->entries[i].index, sp->n_qubits, target_qubits, gate_sparse_measure_emit, &ctx);
+	}
+	return outcome_probs;
+}
+
+// Emit callback for gate_sparse_measure, adds the outcome to a dense table of outcomes
+void gate_sparse_measure_emit(const uint64_t index, const double prob, void* ctx)
+{
+	gate_sparse_measure_emit_t* emit_data = (gate_sparse_measure_emit_t*)ctx;
+	emit_data->outcome_probabilities[index] += prob * emit_data->initial_prob;
+	return;
+}
+
+/*
+ * circuit_run_sparse
+ * Applies a circuit to a sparse table, following the same schedule as circuit_run_default
+ * Only the gates of the circuit are run, circuits that replace their circuit_operation are not supported
+ * :: circuit* c :: The circuit to be run
+ * :: const error_probabilities_sparse* initial_error_rates :: The error rates before the circuit is applied
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the new sparse table, its discarded mass includes that of the initial table
+ */
+error_probabilities_sparse* circuit_run_sparse(circuit* c, const error_probabilities_sparse* initial_error_rates, gate* noise)
+{
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return NULL;
+	}
+
+	error_probabilities_sparse* error_rate = error_probabilities_sparse_copy(initial_error_rates);
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+	circuit_compiled* cc = circuit_compile(c);
+
+	for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+	{
+		// Gate operation
+		gate_sparse_apply(error_rate, cc->gates[gate_idx], circuit_compiled_targets(cc, gate_idx));
+
+		// Environmental Noise operations, applied to every qubit that doesn't participate in the gate
+		if (NULL != noise)
+		{
+			memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+			circuit_compiled_mark_busy(cc, gate_idx, busy);
+			for (unsigned i = 0; i < c->n_qubits; i++)
+			{
+				if (!busy[i])
+				{
+					gate_sparse_apply(error_rate, noise, &i);
+				}
+			}
+		}
+	}
+
+	circuit_compiled_free(cc);
+	free(busy);
+	return error_rate;
+}
+
+/*
+ * circuit_run_truncated
+ * Applies a circuit to an existing set of error probabilities, following the same schedule as circuit_run_default
+ * The run uses the sparse engine holding the policy, so strings the policy drops are never visited
+ * :: circuit* c :: The circuit to be run
+ * :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied, these are not truncated
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * :: truncation_policy* policy :: The policy, the probability dropped by the run is added to its discarded probability
+ * :: double* gate_discarded :: Written with the probability dropped by each gate and its environmental noise, c->n_gates entries, or NULL
+ * Returns a heap pointer to the new set of error rates, or NULL if the circuit covers more qubits than a sparse table
+ */
+error_probability_t* circuit_run_truncated(circuit* c, error_probability_t* initial_error_rates, gate* noise, truncation_policy* policy, double* gate_discarded)
+{
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return NULL;
+	}
+
+	// The policy is only given to the table once it holds the initial error rates
+	error_probabilities_sparse* error_rate = error_probabilities_sparse_from_dense(c->n_qubits, initial_error_rates, 0);
+	if (NULL == error_rate)
+	{
+		return NULL;
+	}
+	error_rate->policy = policy;
+
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+	circuit_compiled* cc = circuit_compile(c);
+
+	for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+	{
+		double discarded = error_rate->discarded;
+		gate_sparse_apply(error_rate, cc->gates[gate_idx], circuit_compiled_targets(cc, gate_idx));
+
+		// Environmental Noise operations, applied to every qubit that doesn't participate in the gate
+		if (NULL != noise)
+		{
+			memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+			circuit_compiled_mark_busy(cc, gate_idx, busy);
+			for (unsigned i = 0; i < c->n_qubits; i++)
+			{
+				if (!busy[i])
+				{
+					gate_sparse_apply(error_rate, noise, &i);
+				}
+			}
+		}
+
+		if (NULL != gate_discarded)
+		{
+			gate_discarded[gate_idx] = error_rate->discarded - discarded;
+		}
+	}
+
+	error_probability_t* error_probs = error_probabilities_sparse_to_dense(error_rate);
+	error_probabilities_sparse_free(error_rate);
+	circuit_compiled_free(cc);
+	free(busy);
+	return error_probs;
+}
+
+#endif
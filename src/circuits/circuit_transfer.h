@@ -0,0 +1,594 @@
+#ifndef CIRCUIT_TRANSFER
+#define CIRCUIT_TRANSFER
+
+#include "circuit.h"
+#include "error_probabilities.h"
+#include "../gates/gates.h"
+#include "../misc/thread_pool.h"
+
+// ----------------------------------------------------------------------------------------
+// TRANSFER MAPS
+// A block of gates that only touches k qubits acts on the table as a stochastic map between the 4^k local
+// pauli strings of those qubits, applied separately to each block of entries that share every other bit
+// circuit_transfer_create runs the block once for each local string to find this map, after which each
+// application of the block is a single pass over the table rather than a pass for every gate
+//
+// The map is kept in gather form, for each output string the input strings and the probability of reaching it,
+// so every output entry is written exactly once and the map may be applied in place
+// Environmental noise in the map only covers the qubits of the block, circuit_transfer_cache_run applies the
+// noise the other qubits receive while the block runs after the map, as the two act on different qubits this
+// gives the same table as circuit_run_default
+//
+// A cache holds the map of each distinct block, two blocks are the same if they apply the same gates in
+// the same order to the same positions within their qubits, so a block repeated over rounds or moved to
+// other qubits is only run once
+// Gates are compared by their contents rather than their address, so a gate that is freed and another created
+// in its place is not mistaken for it, a cache should be cleared if an error model it has seen is changed or freed
+// ----------------------------------------------------------------------------------------
+
+// Largest block that a transfer map is built for, the map has up to 4^(2k) terms
+#define CIRCUIT_TRANSFER_MAX_QUBITS 5
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+ * circuit_transfer
+ * The stochastic map of a block on its qubits
+ * :: uint32_t n_qubits :: The number of qubits the block touches
+ * :: uint32_t n_local :: The number of local pauli strings, 4^n_qubits
+ * :: uint32_t* term_start :: Where the terms of each output string start, n_local + 1 entries
+ * :: uint32_t* term_inputs :: The input string of each term
+ * :: double* term_probabilities :: The probability of each term
+ */
+typedef struct
+{
+	uint32_t n_qubits;
+	uint32_t n_local;
+	uint32_t* term_start;
+	uint32_t* term_inputs;
+	double* term_probabilities;
+} circuit_transfer;
+
+/*
+ * circuit_transfer_cache_entry_t
+ * A block in the cache, in terms of positions within its qubits
+ * :: uint32_t n_gates :: The number of gates in the block
+ * :: gate* gates :: Copies of the gates of the block, in order
+ * :: unsigned* local_targets :: The targets of every gate, numbered by their position within the block's qubits
+ * :: uint8_t has_noise :: Set if the map was built with environmental noise
+ * :: gate noise :: A copy of the environmental noise the map was built with
+ * :: circuit_transfer* ct :: The map
+ */
+typedef struct
+{
+	uint32_t n_gates;
+	gate* gates;
+	unsigned* local_targets;
+	uint8_t has_noise;
+	gate noise;
+	circuit_transfer* ct;
+} circuit_transfer_cache_entry_t;
+
+/*
+ * circuit_transfer_cache
+ * The maps of each distinct block seen so far
+ * :: uint32_t n_entries :: The number of blocks in the cache
+ * :: uint32_t capacity :: The number of blocks there is space for
+ * :: circuit_transfer_cache_entry_t* entries :: The blocks
+ */
+typedef struct
+{
+	uint32_t n_entries;
+	uint32_t capacity;
+	circuit_transfer_cache_entry_t* entries;
+} circuit_transfer_cache;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * circuit_transfer_support
+ * Finds the qubits a block touches
+ * :: const circuit* block :: The block
+ * :: unsigned* support :: Written with the qubits in ascending order, this should have space for block->n_qubits entries
+ * Returns the number of qubits the block touches
+ */
+uint32_t circuit_transfer_support(const circuit* block, unsigned* support);
+
+/*
+ * circuit_transfer_create
+ * Runs a block on each local pauli string of its qubits to find its stochastic map
+ * :: const circuit* block :: The block, only its gates are used
+ * :: gate* noise :: The environmental noise, applied to the block's idle qubits after each gate as in circuit_run_default, or NULL
+ * Returns a heap pointer to the map, or NULL if the block touches more than CIRCUIT_TRANSFER_MAX_QUBITS qubits
+ */
+circuit_transfer* circuit_transfer_create(const circuit* block, gate* noise);
+
+/*
+ * circuit_transfer_apply
+ * Applies a map to every block of a table, the blocks are split between the threads of the default pool
+ * :: const circuit_transfer* ct :: The map
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* support :: The qubits the map acts on, in the order they were found by circuit_transfer_support
+ * :: error_probability_t* final_probabilities :: The table written to, this may be initial_probabilities
+ * :: const error_probability_t* initial_probabilities :: The table read from
+ * Returns nothing
+ */
+void circuit_transfer_apply(const circuit_transfer* ct,
+	const unsigned n_qubits,
+	const unsigned* support,
+	error_probability_t* final_probabilities,
+	const error_probability_t* initial_probabilities);
+
+void circuit_transfer_free(circuit_transfer* ct);
+
+/*
+ * circuit_transfer_cache_create
+ * Creates an empty cache
+ * Returns a heap pointer to the cache
+ */
+circuit_transfer_cache* circuit_transfer_cache_create();
+
+/*
+ * circuit_transfer_cache_lookup
+ * Finds the map of a block, building it if the cache has not seen the block before
+ * :: circuit_transfer_cache* cache :: The cache
+ * :: const circuit* block :: The block
+ * :: gate* noise :: The environmental noise, see circuit_transfer_create
+ * Returns the map, this belongs to the cache, or NULL if the block is too large for a map
+ */
+circuit_transfer* circuit_transfer_cache_lookup(circuit_transfer_cache* cache, const circuit* block, gate* noise);
+
+/*
+ * circuit_transfer_cache_run
+ * Applies a block to a table in place through the map held in the cache
+ * :: circuit_transfer_cache* cache :: The cache
+ * :: const circuit* block :: The block, this should cover the same qubits as the table
+ * :: gate* noise :: The environmental noise, applied to every idle qubit after each gate as in circuit_run_default, or NULL
+ * :: error_probability_t* table :: The table
+ * Returns 1 if the block was applied, or 0 if it is too large for a map and the table was not changed
+ */
+uint8_t circuit_transfer_cache_run(circuit_transfer_cache* cache, const circuit* block, gate* noise, error_probability_t* table);
+
+/*
+ * circuit_transfer_cache_clear
+ * Removes every block from a cache, for when an error model used by one of its gates has been changed or freed
+ * :: circuit_transfer_cache* cache :: The cache
+ * Returns nothing
+ */
+void circuit_transfer_cache_clear(circuit_transfer_cache* cache);
+
+void circuit_transfer_cache_free(circuit_transfer_cache* cache);
+
+// Checks if two gates apply the same operation with the same noise
+uint8_t circuit_transfer_gates_match(const gate* a, const gate* b);
+
+// Numbers the targets of each gate of a block by their position within its qubits
+void circuit_transfer_local_targets(const circuit* block, const unsigned* support, const uint32_t n_support, unsigned* local_targets);
+
+// Data shared by the pool workers applying a map
+typedef struct
+{
+	const circuit_transfer* ct;
+	uint32_t n_positions;
+	const uint32_t* positions;
+	const uint64_t* offsets;
+	error_probability_t* final_probabilities;
+	const error_probability_t* initial_probabilities;
+} circuit_transfer_task_t;
+
+// Pool task, applies a map to a range of blocks
+void circuit_transfer_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * circuit_transfer_support
+ * Finds the qubits a block touches
+ * :: const circuit* block :: The block
+ * :: unsigned* support :: Written with the qubits in ascending order, this should have space for block->n_qubits entries
+ * Returns the number of qubits the block touches
+ */
+uint32_t circuit_transfer_support(const circuit* block, unsigned* support)
+{
+	uint8_t* touched = (uint8_t*)calloc(block->n_qubits, sizeof(uint8_t));
+	for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+	{
+		for (uint32_t j = 0; j < ce->gate_operation->n_qubits; j++)
+		{
+			touched[ce->target_qubits[j]] = 1;
+		}
+	}
+
+	uint32_t n_support = 0;
+	for (unsigned q = 0; q < block->n_qubits; q++)
+	{
+		if (touched[q])
+		{
+			support[n_support++] = q;
+		}
+	}
+	free(touched);
+	return n_support;
+}
+
+// Numbers the targets of each gate of a block by their position within its qubits
+void circuit_transfer_local_targets(const circuit* block, const unsigned* support, const uint32_t n_support, unsigned* local_targets)
+{
+	uint32_t n_targets = 0;
+	for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+	{
+		for (uint32_t j = 0; j < ce->gate_operation->n_qubits; j++)
+		{
+			for (uint32_t s = 0; s < n_support; s++)
+			{
+				if (support[s] == ce->target_qubits[j])
+				{
+					local_targets[n_targets] = s;
+				}
+			}
+			n_targets++;
+		}
+	}
+	return;
+}
+
+/*
+ * circuit_transfer_create
+ * Runs a block on each local pauli string of its qubits to find its stochastic map
+ * :: const circuit* block :: The block, only its gates are used
+ * :: gate* noise :: The environmental noise, applied to the block's idle qubits after each gate as in circuit_run_default, or NULL
+ * Returns a heap pointer to the map, or NULL if the block touches more than CIRCUIT_TRANSFER_MAX_QUBITS qubits
+ */
+circuit_transfer* circuit_transfer_create(const circuit* block, gate* noise)
+{
+	unsigned* support = (unsigned*)malloc(sizeof(unsigned) * (block->n_qubits + 1));
+	uint32_t n_support = circuit_transfer_support(block, support);
+	if (n_support > CIRCUIT_TRANSFER_MAX_QUBITS)
+	{
+		free(support);
+		return NULL;
+	}
+
+	// The same block on its own qubits
+	uint32_t n_targets = 0;
+	for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+	{
+		n_targets += ce->gate_operation->n_qubits;
+	}
+	unsigned* local_targets = (unsigned*)malloc(sizeof(unsigned) * (n_targets + 1));
+	circuit_transfer_local_targets(block, support, n_support, local_targets);
+
+	circuit* local_block = circuit_create(n_support);
+	n_targets = 0;
+	for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+	{
+		circuit_add_non_varg(local_block, ce->gate_operation, local_targets + n_targets);
+		n_targets += ce->gate_operation->n_qubits;
+	}
+	circuit_compiled* cc = circuit_compile(local_block);
+
+	// Run the block from each local string, column in of the map is the table that results
+	uint32_t n_local = (uint32_t)error_probabilities_entries_in_table(n_support);
+	double* columns = (double*)malloc(sizeof(double) * n_local * n_local);
+	error_probability_t* error_rate = error_probabilities_zeros(n_support);
+	error_probability_t* scratch = error_probabilities_zeros(n_support);
+	for (uint32_t in = 0; in < n_local; in++)
+	{
+		memset(error_rate, 0, error_probabilities_bytes_in_table(n_support));
+		error_rate[in] = 1;
+		circuit_compiled_run_buffers(cc, &error_rate, &scratch, noise);
+		for (uint32_t out = 0; out < n_local; out++)
+		{
+			columns[(uint64_t)in * n_local + out] = error_rate[out];
+		}
+	}
+
+	// Gather form, the terms of each output string
+	circuit_transfer* ct = (circuit_transfer*)malloc(sizeof(circuit_transfer));
+	ct->n_qubits = n_support;
+	ct->n_local = n_local;
+	ct->term_start = (uint32_t*)calloc(n_local + 1, sizeof(uint32_t));
+	for (uint32_t in = 0; in < n_local; in++)
+	{
+		for (uint32_t out = 0; out < n_local; out++)
+		{
+			ct->term_start[out + 1] += (0 != columns[(uint64_t)in * n_local + out]);
+		}
+	}
+	for (uint32_t out = 0; out < n_local; out++)
+	{
+		ct->term_start[out + 1] += ct->term_start[out];
+	}
+	ct->term_inputs = (uint32_t*)malloc(sizeof(uint32_t) * (ct->term_start[n_local] + 1));
+	ct->term_probabilities = (double*)malloc(sizeof(double) * (ct->term_start[n_local] + 1));
+	uint32_t* term_fill = (uint32_t*)malloc(sizeof(uint32_t) * n_local);
+	memcpy(term_fill, ct->term_start, sizeof(uint32_t) * n_local);
+	for (uint32_t in = 0; in < n_local; in++)
+	{
+		for (uint32_t out = 0; out < n_local; out++)
+		{
+			double prob = columns[(uint64_t)in * n_local + out];
+			if (0 != prob)
+			{
+				ct->term_inputs[term_fill[out]] = in;
+				ct->term_probabilities[term_fill[out]] = prob;
+				term_fill[out]++;
+			}
+		}
+	}
+
+	free(term_fill);
+	free(scratch);
+	free(error_rate);
+	free(columns);
+	circuit_compiled_free(cc);
+	circuit_free(local_block);
+	free(local_targets);
+	free(support);
+	return ct;
+}
+
+/*
+ * circuit_transfer_apply
+ * Applies a map to every block of a table, the blocks are split between the threads of the default pool
+ * :: const circuit_transfer* ct :: The map
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* support :: The qubits the map acts on, in the order they were found by circuit_transfer_support
+ * :: error_probability_t* final_probabilities :: The table written to, this may be initial_probabilities
+ * :: const error_probability_t* initial_probabilities :: The table read from
+ * Returns nothing
+ */
+void circuit_transfer_apply(const circuit_transfer* ct,
+	const unsigned n_qubits,
+	const unsigned* support,
+	error_probability_t* final_probabilities,
+	const error_probability_t* initial_probabilities)
+{
+	uint32_t n_positions = 2 * ct->n_qubits;
+	uint32_t positions[2 * CIRCUIT_TRANSFER_MAX_QUBITS];
+	uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * ct->n_local);
+	gate_kernel_block_layout(n_qubits, ct->n_qubits, support, positions, offsets);
+
+	// Blocks are disjoint, so each worker writes to its own entries
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> n_positions;
+	circuit_transfer_task_t task_data = {ct, n_positions, positions, offsets, final_probabilities, initial_probabilities};
+	thread_pool_parallel_for(thread_pool_default(), n_blocks, circuit_transfer_task, &task_data);
+
+	free(offsets);
+	return;
+}
+
+// Pool task, applies a map to a range of blocks
+void circuit_transfer_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker)
+{
+	circuit_transfer_task_t* task_data = (circuit_transfer_task_t*)data;
+	const circuit_transfer* ct = task_data->ct;
+	double local_probabilities[1u << (2 * CIRCUIT_TRANSFER_MAX_QUBITS)];
+
+	for (uint64_t block = block_start; block < block_end; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, task_data->positions, task_data->n_positions);
+
+		// Gather the block, empty blocks stay empty
+		uint8_t nonzero = 0;
+		for (uint32_t local = 0; local < ct->n_local; local++)
+		{
+			local_probabilities[local] = task_data->initial_probabilities[base | task_data->offsets[local]];
+			nonzero |= (local_probabilities[local] != 0);
+		}
+		if (!nonzero)
+		{
+			for (uint32_t local = 0; local < ct->n_local; local++)
+			{
+				task_data->final_probabilities[base | task_data->offsets[local]] = 0;
+			}
+			continue;
+		}
+
+		for (uint32_t out = 0; out < ct->n_local; out++)
+		{
+			double prob = 0;
+			for (uint32_t t = ct->term_start[out]; t < ct->term_start[out + 1]; t++)
+			{
+				prob += ct->term_probabilities[t] * local_probabilities[ct->term_inputs[t]];
+			}
+			task_data->final_probabilities[base | task_data->offsets[out]] = prob;
+		}
+	}
+	return;
+}
+
+void circuit_transfer_free(circuit_transfer* ct)
+{
+	free(ct->term_start);
+	free(ct->term_inputs);
+	free(ct->term_probabilities);
+	free(ct);
+	return;
+}
+
+/*
+ * circuit_transfer_cache_create
+ * Creates an empty cache
+ * Returns a heap pointer to the cache
+ */
+circuit_transfer_cache* circuit_transfer_cache_create()
+{
+	circuit_transfer_cache* cache = (circuit_transfer_cache*)malloc(sizeof(circuit_transfer_cache));
+	cache->n_entries = 0;
+	cache->capacity = 8;
+	cache->entries = (circuit_transfer_cache_entry_t*)malloc(sizeof(circuit_transfer_cache_entry_t) * cache->capacity);
+	return cache;
+}
+
+/*
+ * circuit_transfer_cache_lookup
+ * Finds the map of a block, building it if the cache has not seen the block before
+ * :: circuit_transfer_cache* cache :: The cache
+ * :: const circuit* block :: The block
+ * :: gate* noise :: The environmental noise, see circuit_transfer_create
+ * Returns the map, this belongs to the cache, or NULL if the block is too large for a map
+ */
+circuit_transfer* circuit_transfer_cache_lookup(circuit_transfer_cache* cache, const circuit* block, gate* noise)
+{
+	unsigned* support = (unsigned*)malloc(sizeof(unsigned) * (block->n_qubits + 1));
+	uint32_t n_support = circuit_transfer_support(block, support);
+	if (n_support > CIRCUIT_TRANSFER_MAX_QUBITS)
+	{
+		free(support);
+		return NULL;
+	}
+
+	// The key of the block, its gates and their targets within the block's qubits
+	uint32_t n_gates = 0;
+	uint32_t n_targets = 0;
+	for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+	{
+		n_gates++;
+		n_targets += ce->gate_operation->n_qubits;
+	}
+	gate* gates = (gate*)malloc(sizeof(gate) * (n_gates + 1));
+	unsigned* local_targets = (unsigned*)malloc(sizeof(unsigned) * (n_targets + 1));
+	n_gates = 0;
+	for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+	{
+		gates[n_gates++] = *(ce->gate_operation);
+	}
+	circuit_transfer_local_targets(block, support, n_support, local_targets);
+	free(support);
+
+	for (uint32_t e = 0; e < cache->n_entries; e++)
+	{
+		circuit_transfer_cache_entry_t* entry = cache->entries + e;
+		uint8_t match = entry->n_gates == n_gates
+			&& entry->has_noise == (NULL != noise)
+			&& (NULL == noise || circuit_transfer_gates_match(&entry->noise, noise))
+			&& 0 == memcmp(entry->local_targets, local_targets, sizeof(unsigned) * n_targets);
+		for (uint32_t g = 0; match && g < n_gates; g++)
+		{
+			match = circuit_transfer_gates_match(entry->gates + g, gates + g);
+		}
+		if (match)
+		{
+			free(gates);
+			free(local_targets);
+			return entry->ct;
+		}
+	}
+
+	// A new block
+	if (cache->n_entries == cache->capacity)
+	{
+		cache->capacity *= 2;
+		cache->entries = (circuit_transfer_cache_entry_t*)realloc(cache->entries, sizeof(circuit_transfer_cache_entry_t) * cache->capacity);
+	}
+	circuit_transfer_cache_entry_t* entry = cache->entries + cache->n_entries;
+	entry->n_gates = n_gates;
+	entry->gates = gates;
+	entry->local_targets = local_targets;
+	entry->has_noise = (NULL != noise);
+	if (NULL != noise)
+	{
+		entry->noise = *noise;
+	}
+	entry->ct = circuit_transfer_create(block, noise);
+	cache->n_entries++;
+	return entry->ct;
+}
+
+/*
+ * circuit_transfer_cache_run
+ * Applies a block to a table in place through the map held in the cache
+ * :: circuit_transfer_cache* cache :: The cache
+ * :: const circuit* block :: The block, this should cover the same qubits as the table
+ * :: gate* noise :: The environmental noise, applied to every idle qubit after each gate as in circuit_run_default, or NULL
+ * :: error_probability_t* table :: The table
+ * Returns 1 if the block was applied, or 0 if it is too large for a map and the table was not changed
+ */
+uint8_t circuit_transfer_cache_run(circuit_transfer_cache* cache, const circuit* block, gate* noise, error_probability_t* table)
+{
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return 0;
+	}
+
+	circuit_transfer* ct = circuit_transfer_cache_lookup(cache, block, noise);
+	if (NULL == ct)
+	{
+		return 0;
+	}
+
+	unsigned* support = (unsigned*)malloc(sizeof(unsigned) * (block->n_qubits + 1));
+	uint32_t n_support = circuit_transfer_support(block, support);
+	circuit_transfer_apply(ct, block->n_qubits, support, table, table);
+
+	// The qubits outside the block are idle for every gate of the block
+	if (NULL != noise && n_support < block->n_qubits)
+	{
+		uint8_t* busy = (uint8_t*)calloc(block->n_qubits, sizeof(uint8_t));
+		for (uint32_t s = 0; s < n_support; s++)
+		{
+			busy[support[s]] = 1;
+		}
+
+		error_probability_t* error_rate = table;
+		error_probability_t* scratch = (error_probability_t*)malloc(error_probabilities_bytes_in_table(block->n_qubits));
+		for (circuit_element* ce = block->start; NULL != ce; ce = ce->next)
+		{
+			circuit_idle_noise(block->n_qubits, &error_rate, &scratch, noise, busy);
+		}
+
+		// The result may have been left in the scratch table
+		if (error_rate != table)
+		{
+			memcpy(table, error_rate, error_probabilities_bytes_in_table(block->n_qubits));
+			scratch = error_rate;
+		}
+		free(scratch);
+		free(busy);
+	}
+
+	free(support);
+	return 1;
+}
+
+/*
+ * circuit_transfer_cache_clear
+ * Removes every block from a cache, for when an error model used by one of its gates has been changed or freed
+ * :: circuit_transfer_cache* cache :: The cache
+ * Returns nothing
+ */
+void circuit_transfer_cache_clear(circuit_transfer_cache* cache)
+{
+	for (uint32_t e = 0; e < cache->n_entries; e++)
+	{
+		free(cache->entries[e].gates);
+		free(cache->entries[e].local_targets);
+		circuit_transfer_free(cache->entries[e].ct);
+	}
+	cache->n_entries = 0;
+	return;
+}
+
+void circuit_transfer_cache_free(circuit_transfer_cache* cache)
+{
+	circuit_transfer_cache_clear(cache);
+	free(cache->entries);
+	free(cache);
+	return;
+}
+
+// Checks if two gates apply the same operation with the same noise
+uint8_t circuit_transfer_gates_match(const gate* a, const gate* b)
+{
+	return a->n_qubits == b->n_qubits
+		&& a->operation == b->operation
+		&& a->gate_error_model == b->gate_error_model
+		&& a->operation_data == b->operation_data
+		&& a->error_model_data == b->error_model_data
+		&& a->emit_operation == b->emit_operation;
+}
+
+#endif
@@ -0,0 +1,363 @@
+#ifndef CIRCUIT_WHT
+#define CIRCUIT_WHT
+
+#include "circuit.h"
+#include "error_probabilities.h"
+#include "../gates/gates.h"
+
+// ----------------------------------------------------------------------------------------
+// WALSH-HADAMARD ENGINE
+// Applying a pauli channel to a table is a convolution over the table index (errors combine by XOR)
+// Under the Walsh-Hadamard transform this convolution becomes a pointwise product with the transform of the channel,
+// which for a local channel only depends on the target bits of each index (the pauli fidelities of the channel)
+//
+// Clifford gates are linear maps M on the index, and act on the transformed table as the transposed map:
+//      Hadamard -> Hadamard
+//      Phase (z ^= x) -> x ^= z
+//      CNOT(c, t) -> CNOT(t, c)
+// Pauli gates translate the index, which in the transformed table is a sign flip
+//
+// circuit_run_wht keeps the table transformed for the whole circuit, so each noise layer is a single pass over
+// the table in place of a convolution, only gates without a transformed form leave the domain
+// The transform is O(n 4^n) and is performed once at each end of the run
+// The error in each entry is relative to the largest entry of the table, very small probabilities should be
+// treated with care and may be returned with small negative values
+// Single precision tables (ERROR_PROBABILITIES_FLOAT) hold the transform in single precision as well,
+// so only probabilities well above 1e-7 of the largest entry are meaningful
+// ----------------------------------------------------------------------------------------
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * error_probabilities_wht
+ * Unnormalised Walsh-Hadamard transform of a table in place
+ * :: error_probability_t* error_probs :: The table to be transformed
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns nothing
+ */
+void error_probabilities_wht(error_probability_t* error_probs, const uint32_t n_qubits);
+
+/*
+ * error_probabilities_wht_inverse
+ * Inverse of error_probabilities_wht in place
+ * :: error_probability_t* error_probs :: The transformed table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns nothing
+ */
+void error_probabilities_wht_inverse(error_probability_t* error_probs, const uint32_t n_qubits);
+
+/*
+ * gate_wht_operator
+ * Applies the operation of a gate to a transformed table in place
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: error_probability_t* transformed_probabilities :: The transformed table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns 0 on success, or -1 if the operation has no transformed form and the table was not changed
+ */
+int32_t gate_wht_operator(const unsigned n_qubits, error_probability_t* transformed_probabilities, const gate* g, const unsigned* target_qubits);
+
+/*
+ * gate_wht_noise
+ * Applies the error model of a gate to a transformed table in place
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: error_probability_t* transformed_probabilities :: The transformed table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns 0 on success, or -1 if the gate is too large for the local fidelities and the table was not changed
+ */
+int32_t gate_wht_noise(const unsigned n_qubits, error_probability_t* transformed_probabilities, const gate* g, const unsigned* target_qubits);
+
+/*
+ * gate_wht_negate
+ * Negates two entries in every block of a transformed table that has bit_lo and bit_hi clear
+ * :: error_probability_t* table :: The transformed table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const uint32_t bit_lo :: The lower of the two bit positions
+ * :: const uint32_t bit_hi :: The higher of the two bit positions
+ * :: const uint64_t offset_a :: Offset of the first entry within each block
+ * :: const uint64_t offset_b :: Offset of the second entry within each block
+ * Returns nothing
+ */
+void gate_wht_negate(error_probability_t* table,
+	const unsigned n_qubits,
+	const uint32_t bit_lo,
+	const uint32_t bit_hi,
+	const uint64_t offset_a,
+	const uint64_t offset_b);
+
+/*
+ * circuit_run_wht
+ * Applies a circuit to an existing set of error probabilities, following the same schedule as circuit_run_default
+ * The table is kept transformed between gates, see the notes at the top of circuit_wht.h
+ * This is opt in, either call it directly or set c->circuit_operation to circuit_run_wht
+ * :: circuit* c :: The circuit to be run
+ * :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the new set of error rates
+ */
+error_probability_t* circuit_run_wht(circuit* c, error_probability_t* initial_error_rates, gate* noise);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * error_probabilities_wht
+ * Unnormalised Walsh-Hadamard transform of a table in place
+ * :: error_probability_t* error_probs :: The table to be transformed
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns nothing
+ */
+void error_probabilities_wht(error_probability_t* error_probs, const uint32_t n_qubits)
+{
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	for (uint64_t stride = 1; stride < n_entries; stride <<= 1)
+	{
+		for (uint64_t block = 0; block < n_entries; block += 2 * stride)
+		{
+			error_probability_t* lo = error_probs + block;
+			error_probability_t* hi = error_probs + block + stride;
+			for (uint64_t i = 0; i < stride; i++)
+			{
+				double a = lo[i];
+				double b = hi[i];
+				lo[i] = a + b;
+				hi[i] = a - b;
+			}
+		}
+	}
+	return;
+}
+
+/*
+ * error_probabilities_wht_inverse
+ * Inverse of error_probabilities_wht in place
+ * :: error_probability_t* error_probs :: The transformed table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns nothing
+ */
+void error_probabilities_wht_inverse(error_probability_t* error_probs, const uint32_t n_qubits)
+{
+	// The transform is its own inverse up to a factor of the table size
+	error_probabilities_wht(error_probs, n_qubits);
+
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	double scale = 1.0 / (double)n_entries;
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		error_probs[i] *= scale;
+	}
+	return;
+}
+
+/*
+ * gate_wht_negate
+ * Negates two entries in every block of a transformed table that has bit_lo and bit_hi clear
+ * :: error_probability_t* table :: The transformed table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const uint32_t bit_lo :: The lower of the two bit positions
+ * :: const uint32_t bit_hi :: The higher of the two bit positions
+ * :: const uint64_t offset_a :: Offset of the first entry within each block
+ * :: const uint64_t offset_b :: Offset of the second entry within each block
+ * Returns nothing
+ */
+void gate_wht_negate(error_probability_t* table,
+	const unsigned n_qubits,
+	const uint32_t bit_lo,
+	const uint32_t bit_hi,
+	const uint64_t offset_a,
+	const uint64_t offset_b)
+{
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	uint64_t stride_lo = 1ull << bit_lo;
+	uint64_t stride_hi = 1ull << bit_hi;
+
+	for (uint64_t hi = 0; hi < n_entries; hi += 2 * stride_hi)
+	{
+		for (uint64_t mid = hi; mid < hi + stride_hi; mid += 2 * stride_lo)
+		{
+			error_probability_t* block_a = table + mid + offset_a;
+			error_probability_t* block_b = table + mid + offset_b;
+			for (uint64_t lo = 0; lo < stride_lo; lo++)
+			{
+				block_a[lo] = -block_a[lo];
+				block_b[lo] = -block_b[lo];
+			}
+		}
+	}
+	return;
+}
+
+/*
+ * gate_wht_operator
+ * Applies the operation of a gate to a transformed table in place
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: error_probability_t* transformed_probabilities :: The transformed table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns 0 on success, or -1 if the operation has no transformed form and the table was not changed
+ */
+int32_t gate_wht_operator(const unsigned n_qubits, error_probability_t* transformed_probabilities, const gate* g, const unsigned* target_qubits)
+{
+	if (NULL == g->operation || gate_identity == g->operation)
+	{
+		return 0;
+	}
+
+	uint64_t bit_x = gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint64_t bit_z = gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+
+	if (gate_hadamard == g->operation)
+	{
+		gate_kernel_hadamard(transformed_probabilities, n_qubits, target_qubits);
+	}
+	else if (gate_phase == g->operation)
+	{
+		// Transposed phase adds the Z bit to the X bit
+		gate_kernel_swap_pairs(transformed_probabilities, n_qubits, bit_z, bit_x, 1ull << bit_z, (1ull << bit_x) | (1ull << bit_z));
+	}
+	else if (gate_cnot == g->operation)
+	{
+		// Transposed CNOT swaps the roles of the control and target
+		unsigned reversed_targets[2] = {target_qubits[1], target_qubits[0]};
+		gate_kernel_cnot(transformed_probabilities, n_qubits, reversed_targets);
+	}
+	else if (gate_pauli_X == g->operation)
+	{
+		// Flips the Z bit, so negate every entry with the Z bit set
+		gate_wht_negate(transformed_probabilities, n_qubits, bit_z, bit_x, 1ull << bit_z, (1ull << bit_x) | (1ull << bit_z));
+	}
+	else if (gate_pauli_Z == g->operation)
+	{
+		gate_wht_negate(transformed_probabilities, n_qubits, bit_z, bit_x, 1ull << bit_x, (1ull << bit_x) | (1ull << bit_z));
+	}
+	else if (gate_pauli_Y == g->operation)
+	{
+		gate_wht_negate(transformed_probabilities, n_qubits, bit_z, bit_x, 1ull << bit_x, 1ull << bit_z);
+	}
+	else
+	{
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * gate_wht_noise
+ * Applies the error model of a gate to a transformed table in place
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: error_probability_t* transformed_probabilities :: The transformed table
+ * :: const gate* g :: The gate
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns 0 on success, or -1 if the gate is too large for the local fidelities and the table was not changed
+ */
+int32_t gate_wht_noise(const unsigned n_qubits, error_probability_t* transformed_probabilities, const gate* g, const unsigned* target_qubits)
+{
+	if (NULL == g->gate_error_model)
+	{
+		return 0;
+	}
+
+	gate_kernel_noise_t* kn = gate_kernel_noise_create(n_qubits, g, target_qubits);
+	if (NULL == kn)
+	{
+		return -1;
+	}
+
+	// Transform of the local channel, each local index picks out a sign for every error
+	uint32_t n_local = 1u << kn->n_positions;
+	double fidelities[1u << (2 * GATE_KERNEL_NOISE_MAX_QUBITS)];
+	for (uint32_t local = 0; local < n_local; local++)
+	{
+		fidelities[local] = 0;
+		for (uint32_t t = 0; t < kn->n_terms; t++)
+		{
+			uint32_t parity = 0;
+			for (uint32_t overlap = local & kn->term_errors[t]; overlap; overlap >>= 1)
+			{
+				parity ^= overlap & 1;
+			}
+			fidelities[local] += parity ? -kn->term_probabilities[t] : kn->term_probabilities[t];
+		}
+	}
+
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> kn->n_positions;
+	for (uint64_t block = 0; block < n_blocks; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, kn->positions, kn->n_positions);
+		for (uint32_t local = 0; local < n_local; local++)
+		{
+			transformed_probabilities[base | kn->offsets[local]] *= fidelities[local];
+		}
+	}
+
+	gate_kernel_noise_free(kn);
+	return 0;
+}
+
+/*
+ * circuit_run_wht
+ * Applies a circuit to an existing set of error probabilities, following the same schedule as circuit_run_default
+ * The table is kept transformed between gates, see the notes at the top of circuit_wht.h
+ * This is opt in, either call it directly or set c->circuit_operation to circuit_run_wht
+ * :: circuit* c :: The circuit to be run
+ * :: error_probability_t* initial_error_rates :: The error rates before the circuit is applied
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the new set of error rates
+ */
+error_probability_t* circuit_run_wht(circuit* c, error_probability_t* initial_error_rates, gate* noise)
+{
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return NULL;
+	}
+
+	error_probability_t* error_rate = error_probabilities_copy(c->n_qubits, initial_error_rates);
+	error_probabilities_wht(error_rate, c->n_qubits);
+
+	circuit_compiled* cc = circuit_compile(c);
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+
+	for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
+	{
+		gate* g = cc->gates[gate_idx];
+		const unsigned* targets = circuit_compiled_targets(cc, gate_idx);
+
+		// Leave the transformed domain for gates that do not have a transformed form
+		if (0 != gate_wht_operator(c->n_qubits, error_rate, g, targets))
+		{
+			error_probabilities_wht_inverse(error_rate, c->n_qubits);
+			error_probability_t* tmp_error_rate = gate_apply(c->n_qubits, error_rate, g, targets);
+			free(error_rate);
+			error_rate = tmp_error_rate;
+			error_probabilities_wht(error_rate, c->n_qubits);
+		}
+		else if (0 != gate_wht_noise(c->n_qubits, error_rate, g, targets))
+		{
+			error_probabilities_wht_inverse(error_rate, c->n_qubits);
+			error_probability_t* tmp_error_rate = gate_noise(c->n_qubits, error_rate, g, targets);
+			free(error_rate);
+			error_rate = tmp_error_rate;
+			error_probabilities_wht(error_rate, c->n_qubits);
+		}
+
+		// Environmental Noise operations, each idle qubit is a single pass over the table
+		memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+		circuit_compiled_mark_busy(cc, gate_idx, busy);
+		for (unsigned i = 0; i < c->n_qubits && NULL != noise; i++)
+		{
+			if (!busy[i])
+			{
+				gate_wht_noise(c->n_qubits, error_rate, noise, &i);
+			}
+		}
+	}
+
+	free(busy);
+	circuit_compiled_free(cc);
+	error_probabilities_wht_inverse(error_rate, c->n_qubits);
+	return error_rate;
+}
+
+#endif
@@ -2,6 +2,20 @@
 #define ERROR_PROBABILITIES
 
 #include "../sym_iter.h"
+#include "../misc/thread_pool.h"
+
+/* ERROR_PROBABILITIES_FLOAT
+ * Stores tables as single precision, halving their size so two more qubits fit in the same memory
+ * Kernels still accumulate sums and products in double before storing to the table
+ * Parameter batches are always double precision
+ */
+
+// The type of each entry in a table
+#ifdef ERROR_PROBABILITIES_FLOAT
+typedef float error_probability_t;
+#else
+typedef double error_probability_t;
+#endif
 
 // ----------------------------------------------------------------------------------------
 // FUNCTION DECLARATIONS
@@ -10,6 +24,7 @@
 /*
  * error_probabilities_m 
  * Allocates an array of doubles for storing a probability distribution of pauli errors
+ * Used for logical error tables, which are small and always double precision
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
  * Returns an array of zeros
  */
@@ -17,71 +32,164 @@ double* error_probabilities_m(const size_t n_qubits);
 
 /*
  * error_probabilities_zeros
- * Allocates an array of doubles for storing a probability distribution of pauli errors
+ * Allocates an array of error_probability_t for storing a probability distribution of pauli errors
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
  * Returns an array of zeros
  */
-double* error_probabilities_zeros(const size_t n_qubits);
+error_probability_t* error_probabilities_zeros(const size_t n_qubits);
 
 /*
  * error_probabilities_identity
- * Allocates an array of doubles for storing a probability distribution of pauli errors, the identity element is given a probability of 1
+ * Allocates an array of error_probability_t for storing a probability distribution of pauli errors, the identity element is given a probability of 1
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
  * Returns an array of zeros with the first element set to 1.0
  */
-double* error_probabilities_identity(const size_t n_qubits);
+error_probability_t* error_probabilities_identity(const size_t n_qubits);
 
 /*
  * error_probabilities_copy
- * Allocates an array of doubles for storing a probability distribution of pauli errors, copies the values from another array to this one
+ * Allocates an array of error_probability_t for storing a probability distribution of pauli errors, copies the values from another array to this one
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
- * :: double* error_probs :: The array to copy
+ * :: error_probability_t* error_probs :: The array to copy
  * Returns a pointer to a copy of the array passed
  */
-double* error_probabilities_copy(const size_t n_qubits, double* error_probs);
+error_probability_t* error_probabilities_copy(const size_t n_qubits, error_probability_t* error_probs);
 
 /*
  * error_probabilities_step
  * Steps an probability distribution up or down over some number of qubits while ensuring that the distribution remains normalised 
- * :: double* error_probs :: The initial distribution
+ * :: error_probability_t* error_probs :: The initial distribution
  * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
  * :: const size_t n_qubits_final :: The number of qubits in the final distribution
  * Returns an array of probabilities
  */
-double* error_probabilities_step(double* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
+error_probability_t* error_probabilities_step(error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
 
 /*
  * error_probabilities_step_up
  * Steps an probability distribution up over some number of qubits while ensuring that the distribution remains normalised 
- * :: double* error_probs :: The initial distribution
+ * :: error_probability_t* error_probs :: The initial distribution
  * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
  * :: const size_t n_qubits_final :: The number of qubits in the final distribution
  * Returns an array of probabilities
  */
-double* error_probabilities_step_up(double* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
+error_probability_t* error_probabilities_step_up(error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
+
+/*
+ * error_probabilities_step_up_into
+ * Steps a probability distribution up into an existing table, as error_probabilities_step_up
+ * :: error_probability_t* expanded_error_probs :: The final distribution, this should be all zeros
+ * :: const error_probability_t* error_probs :: The initial distribution
+ * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
+ * :: const size_t n_qubits_final :: The number of qubits in the final distribution
+ * Returns nothing
+ */
+void error_probabilities_step_up_into(error_probability_t* expanded_error_probs, const error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
 
 /*
  * error_probabilities_step_down
  * Steps an probability distribution down over some number of qubits while ensuring that the distribution remains normalised 
- * :: double* error_probs :: The initial distribution
+ * :: error_probability_t* error_probs :: The initial distribution
  * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
  * :: const size_t n_qubits_final :: The number of qubits in the final distribution
  * Returns an array of probabilities
  */
-double* error_probabilities_step_down(double* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
+error_probability_t* error_probabilities_step_down(error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
+
+/*
+ * error_probabilities_trace_out
+ * Traces qubits out of a probability distribution in place, each qubit traced out shrinks the table by a factor of four
+ * Entries are written in index order and every entry is summed from entries at or above its own index,
+ * so the smaller table is folded into the front of the larger one and the rest is released
+ * :: error_probability_t* error_probs :: The distribution, this is reallocated and should not be used afterwards
+ * :: const uint32_t n_qubits :: The number of qubits in the distribution
+ * :: const unsigned* traced_qubits :: The qubits to be traced out, in any order
+ * :: const uint32_t n_traced :: The number of qubits to be traced out
+ * Returns the distribution over the remaining qubits, which keep their order
+ */
+error_probability_t* error_probabilities_trace_out(error_probability_t* error_probs, const uint32_t n_qubits, const unsigned* traced_qubits, const uint32_t n_traced);
+
+/*
+ * error_probabilities_insert_qubit
+ * Adds a qubit with no error to a probability distribution in place, the inverse of tracing the qubit out of such a distribution
+ * Entries are moved in reverse index order and every entry moves to an index at or above its own
+ * :: error_probability_t* error_probs :: The distribution, this is reallocated and should not be used afterwards
+ * :: const uint32_t n_qubits :: The number of qubits in the distribution
+ * :: const unsigned qubit :: The index of the new qubit, qubits from this index onwards move up by one
+ * Returns the distribution over n_qubits + 1 qubits
+ */
+error_probability_t* error_probabilities_insert_qubit(error_probability_t* error_probs, const uint32_t n_qubits, const unsigned qubit);
+
+// Data shared by the pool workers in step_up and step_down
+typedef struct
+{
+	const error_probability_t* initial_probs;
+	error_probability_t* final_probs;
+	uint32_t n_qubits_initial;
+	uint32_t n_qubits_final;
+} error_probabilities_step_task_t;
+
+// Pool tasks, each covers a range of values of the X bits of the smaller table
+void error_probabilities_step_up_task(void* data, const uint64_t x_start, const uint64_t x_end, const uint32_t worker);
+void error_probabilities_step_down_task(void* data, const uint64_t x_start, const uint64_t x_end, const uint32_t worker);
 
 /*
  * error_probabilities_free 
  * Frees the array of errors
- * :: double* error_probs :: The distribution of errors to be freed
+ * :: error_probability_t* error_probs :: The distribution of errors to be freed
  * Returns nothing
  */
-void error_probabilities_free(double* error_probs);
+void error_probabilities_free(error_probability_t* error_probs);
 
 
 uint64_t error_probabilities_bytes_in_table(const uint32_t n_qubits);
 uint64_t error_probabilities_entries_in_table(const uint32_t n_qubits);
 
+
+// Parameter batches ----------------------------------------------------------------------------------------
+// A batch table holds n_lanes distributions side by side, entry [index * n_lanes + lane]
+// All lanes of a pauli string are contiguous so the same index arithmetic serves the whole batch
+
+/*
+ * error_probabilities_batch_zeros
+ * Allocates a batch table of pauli error distributions
+ * :: const size_t n_qubits :: The number of qubits that each distribution covers
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * Returns an array of zeros
+ */
+double* error_probabilities_batch_zeros(const size_t n_qubits, const uint32_t n_lanes);
+
+/*
+ * error_probabilities_batch_identity
+ * Allocates a batch table of pauli error distributions, the identity element of every lane is given a probability of 1
+ * :: const size_t n_qubits :: The number of qubits that each distribution covers
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * Returns an array of zeros with the first n_lanes elements set to 1.0
+ */
+double* error_probabilities_batch_identity(const size_t n_qubits, const uint32_t n_lanes);
+
+/*
+ * error_probabilities_batch_lane
+ * Copies a single lane out of a batch table
+ * :: const double* error_probs :: The batch table
+ * :: const size_t n_qubits :: The number of qubits that each distribution covers
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * :: const uint32_t lane :: The lane to be copied
+ * Returns a regular table of error probabilities
+ */
+error_probability_t* error_probabilities_batch_lane(const double* error_probs, const size_t n_qubits, const uint32_t n_lanes, const uint32_t lane);
+
+/*
+ * error_probabilities_batch_is_zero
+ * Checks if every lane of a single entry in a batch table is zero
+ * :: const double* entry :: The first lane of the entry
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * Returns true if every lane is zero
+ */
+uint8_t error_probabilities_batch_is_zero(const double* entry, const uint32_t n_lanes);
+
+uint64_t error_probabilities_batch_bytes_in_table(const uint32_t n_qubits, const uint32_t n_lanes);
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DEFINITIONS
 // ----------------------------------------------------------------------------------------
@@ -89,6 +197,7 @@ uint64_t error_probabilities_entries_in_table(const uint32_t n_qubits);
 /*
  * error_probabilities_m 
  * Allocates an array of doubles for storing a probability distribution of pauli errors
+ * Used for logical error tables, which are small and always double precision
  * :: const size_t n_elements :: The number of elements that this error probability distribution covers
  * Returns an array of zeros
  */
@@ -101,7 +210,7 @@ double* error_probabilities_m(const size_t n_elements)
 
 uint64_t error_probabilities_bytes_in_table(const uint32_t n_qubits)
 {
-	return error_probabilities_entries_in_table(n_qubits) * sizeof(double);
+	return error_probabilities_entries_in_table(n_qubits) * sizeof(error_probability_t);
 }
 
 uint64_t error_probabilities_entries_in_table(const uint32_t n_qubits)
@@ -111,39 +220,39 @@ uint64_t error_probabilities_entries_in_table(const uint32_t n_qubits)
 
 /*
  * error_probabilities_zeros
- * Allocates an array of doubles for storing a probability distribution of pauli errors
+ * Allocates an array of error_probability_t for storing a probability distribution of pauli errors
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
  * Returns an array of zeros
  */
-double* error_probabilities_zeros(const size_t n_qubits)
+error_probability_t* error_probabilities_zeros(const size_t n_qubits)
 {
-	double* error_probs = (double*)calloc(error_probabilities_entries_in_table(n_qubits), sizeof(double));
+	error_probability_t* error_probs = (error_probability_t*)calloc(error_probabilities_entries_in_table(n_qubits), sizeof(error_probability_t));
 	return error_probs;
 }
 
 /*
  * error_probabilities_identity
- * Allocates an array of doubles for storing a probability distribution of pauli errors, the identity element is given a probability of 1
+ * Allocates an array of error_probability_t for storing a probability distribution of pauli errors, the identity element is given a probability of 1
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
  * Returns an array of zeros with the first element set to 1.0
  */
-double* error_probabilities_identity(const size_t n_qubits)
+error_probability_t* error_probabilities_identity(const size_t n_qubits)
 {
-	double* error_probs = error_probabilities_zeros(n_qubits);
+	error_probability_t* error_probs = error_probabilities_zeros(n_qubits);
 	error_probs[0] = 1.0; // Set the identity to 1	
 	return error_probs;
 }
 
 /*
  * error_probabilities_copy
- * Allocates an array of doubles for storing a probability distribution of pauli errors, copies the values from another array to this one
+ * Allocates an array of error_probability_t for storing a probability distribution of pauli errors, copies the values from another array to this one
  * :: const size_t n_qubits :: The number of qubits that this error probability distribution covers
- * :: double* error_probs :: The array to copy
+ * :: error_probability_t* error_probs :: The array to copy
  * Returns a pointer to a copy of the array passed
  */
-double* error_probabilities_copy(const size_t n_qubits, double* error_probs)
+error_probability_t* error_probabilities_copy(const size_t n_qubits, error_probability_t* error_probs)
 {
-	double* error_probs_cpy = error_probabilities_zeros(n_qubits);
+	error_probability_t* error_probs_cpy = error_probabilities_zeros(n_qubits);
 
 	memcpy(error_probs_cpy, error_probs, error_probabilities_bytes_in_table(n_qubits));
 
@@ -153,12 +262,12 @@ double* error_probabilities_copy(const size_t n_qubits, double* error_probs)
 /*
  * error_probabilities_step
  * Steps an probability distribution up or down over some number of qubits while ensuring that the distribution remains normalised 
- * :: double* error_probs :: The initial distribution
+ * :: error_probability_t* error_probs :: The initial distribution
  * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
  * :: const size_t n_qubits_final :: The number of qubits in the final distribution
  * Returns an array of probabilities
  */
-double* error_probabilities_step(double* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
+error_probability_t* error_probabilities_step(error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
 {
 	if (n_qubits_initial > n_qubits_final)
 	{
@@ -176,89 +285,256 @@ double* error_probabilities_step(double* error_probs, const uint32_t n_qubits_in
 /*
  * error_probabilities_step_up
  * Steps an probability distribution up over some number of qubits while ensuring that the distribution remains normalised 
- * :: double* error_probs :: The initial distribution
+ * :: error_probability_t* error_probs :: The initial distribution
  * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
  * :: const size_t n_qubits_final :: The number of qubits in the final distribution
  * Returns an array of probabilities
  */
-double* error_probabilities_step_up(double* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
+error_probability_t* error_probabilities_step_up(error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
 {
-	double* expanded_error_probs = error_probabilities_zeros(n_qubits_final);
-
-	// Copy the errors from the initial buffer to our larger buffer
-	sym_iter* cpy_iter = sym_iter_create_n_qubits(n_qubits_initial);
-	sym_iter* target_buffer = sym_iter_create_n_qubits(n_qubits_final);
-	while (sym_iter_next(cpy_iter))
-	{
-		if (error_probs[sym_iter_ll_from_state(cpy_iter)] > 0)
-		{
-			// Copy the state to the target buffer
-			for (uint32_t i = 0; i < n_qubits_initial; i++)
-			{ // All other values in the target buffer should be zero
-				sym_set_X(target_buffer->state, 0, i, sym_get_X(cpy_iter->state, 0, i)); // X elements
- 				sym_set_Z(target_buffer->state, 0, i, sym_get_Z(cpy_iter->state, 0, i)); // Z elements
-			} 
-
-			// We've manually changed the iterator, need to update it
-			sym_iter_update(target_buffer);
-
-			// Set the value in the new buffer
-			expanded_error_probs[sym_iter_ll_from_state(target_buffer)] += error_probs[sym_iter_ll_from_state(cpy_iter)];
-		}
-	}
-	sym_iter_free(target_buffer);
-	sym_iter_free(cpy_iter);
-
+	// The new qubits follow the existing ones, so each index keeps its X and Z bits and gains zeros below each half
+	// The X bits of the initial table pick a row, and the row is copied out with a stride
+	error_probability_t* expanded_error_probs = error_probabilities_zeros(n_qubits_final);
+	error_probabilities_step_up_into(expanded_error_probs, error_probs, n_qubits_initial, n_qubits_final);
 	return expanded_error_probs;
 }
 
+/*
+ * error_probabilities_step_up_into
+ * Steps a probability distribution up into an existing table, as error_probabilities_step_up
+ * :: error_probability_t* expanded_error_probs :: The final distribution, this should be all zeros
+ * :: const error_probability_t* error_probs :: The initial distribution
+ * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
+ * :: const size_t n_qubits_final :: The number of qubits in the final distribution
+ * Returns nothing
+ */
+void error_probabilities_step_up_into(error_probability_t* expanded_error_probs, const error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
+{
+	error_probabilities_step_task_t task_data = {error_probs, expanded_error_probs, n_qubits_initial, n_qubits_final};
+	thread_pool_parallel_for(thread_pool_default(), 1ull << n_qubits_initial, error_probabilities_step_up_task, &task_data);
+	return;
+}
+
 /*
  * error_probabilities_step_down
  * Steps an probability distribution down over some number of qubits while ensuring that the distribution remains normalised 
- * :: double* error_probs :: The initial distribution
+ * :: error_probability_t* error_probs :: The initial distribution
  * :: const size_t n_qubits_initial :: The number of qubits in the initial distribution
  * :: const size_t n_qubits_final :: The number of qubits in the final distribution
  * Returns an array of probabilities
  */
-double* error_probabilities_step_down(double* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
+error_probability_t* error_probabilities_step_down(error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
+{
+	// The dropped qubits are the last ones, the low bits of each half of the index
+	// Each final entry is the sum of a contiguous run of the initial table in each of a strided set of rows
+	error_probability_t* contracted_error_probs = error_probabilities_zeros(n_qubits_final);
+	error_probabilities_step_task_t task_data = {error_probs, contracted_error_probs, n_qubits_initial, n_qubits_final};
+	thread_pool_parallel_for(thread_pool_default(), 1ull << n_qubits_final, error_probabilities_step_down_task, &task_data);
+	return contracted_error_probs;
+}
+
+// Pool task, copies the rows of the initial table for a range of values of its X bits
+void error_probabilities_step_up_task(void* data, const uint64_t x_start, const uint64_t x_end, const uint32_t worker)
 {
-	double* contracted_error_probs = error_probabilities_zeros(n_qubits_final);
+	error_probabilities_step_task_t* task_data = (error_probabilities_step_task_t*)data;
+	uint32_t n_added = task_data->n_qubits_final - task_data->n_qubits_initial;
+	uint64_t n_z = 1ull << task_data->n_qubits_initial;
 
-	// Copy the errors from the initial buffer to our larger buffer
-	sym_iter* cpy_iter = sym_iter_create_n_qubits(n_qubits_initial);
-	sym_iter* target_buffer = sym_iter_create_n_qubits(n_qubits_final);
-	while (sym_iter_next(cpy_iter))
+	for (uint64_t x = x_start; x < x_end; x++)
 	{
-		if (error_probs[sym_iter_ll_from_state(cpy_iter)] > 0)
+		const error_probability_t* initial_row = task_data->initial_probs + (x << task_data->n_qubits_initial);
+		error_probability_t* final_row = task_data->final_probs + (x << (task_data->n_qubits_final + n_added));
+		for (uint64_t z = 0; z < n_z; z++)
 		{
-			// Copy the state to the target buffer
-			for (uint32_t i = 0; i < n_qubits_final; i++)
-			{ // All other values in the target buffer should be zero
-				sym_set_X(target_buffer->state, 0, i, sym_get_X(cpy_iter->state, 0, i)); // X elements
- 				sym_set_Z(target_buffer->state, 0, i, sym_get_Z(cpy_iter->state, 0, i)); // Z elements
-			}
+			final_row[z << n_added] = initial_row[z];
+		}
+	}
+	return;
+}
 
-			// We've manually changed the iterator, need to update it
-			sym_iter_update(target_buffer);
+// Pool task, sums the entries of the final table for a range of values of its X bits
+void error_probabilities_step_down_task(void* data, const uint64_t x_start, const uint64_t x_end, const uint32_t worker)
+{
+	error_probabilities_step_task_t* task_data = (error_probabilities_step_task_t*)data;
+	uint32_t n_dropped = task_data->n_qubits_initial - task_data->n_qubits_final;
+	uint64_t n_z = 1ull << task_data->n_qubits_final;
+	uint64_t n_run = 1ull << n_dropped;
 
-			// Set the value in the new buffer
-			contracted_error_probs[sym_iter_ll_from_state(target_buffer)] += error_probs[sym_iter_ll_from_state(cpy_iter)];
+	for (uint64_t x = x_start; x < x_end; x++)
+	{
+		error_probability_t* final_row = task_data->final_probs + (x << task_data->n_qubits_final);
+		for (uint64_t z = 0; z < n_z; z++)
+		{
+			// Many strings are traced onto each entry, so they are summed in double precision
+			double sum = 0;
+			for (uint64_t x_dropped = 0; x_dropped < n_run; x_dropped++)
+			{
+				const error_probability_t* run = task_data->initial_probs + ((((x << n_dropped) | x_dropped) << task_data->n_qubits_initial) | (z << n_dropped));
+				for (uint64_t z_dropped = 0; z_dropped < n_run; z_dropped++)
+				{
+					sum += run[z_dropped];
+				}
+			}
+			final_row[z] = sum;
 		}
 	}
-	sym_iter_free(target_buffer);
-	sym_iter_free(cpy_iter);
+	return;
+}
 
-	return contracted_error_probs;
+/*
+ * error_probabilities_trace_out
+ * Traces qubits out of a probability distribution in place, each qubit traced out shrinks the table by a factor of four
+ * Entries are written in index order and every entry is summed from entries at or above its own index,
+ * so the smaller table is folded into the front of the larger one and the rest is released
+ * :: error_probability_t* error_probs :: The distribution, this is reallocated and should not be used afterwards
+ * :: const uint32_t n_qubits :: The number of qubits in the distribution
+ * :: const unsigned* traced_qubits :: The qubits to be traced out, in any order
+ * :: const uint32_t n_traced :: The number of qubits to be traced out
+ * Returns the distribution over the remaining qubits, which keep their order
+ */
+error_probability_t* error_probabilities_trace_out(error_probability_t* error_probs, const uint32_t n_qubits, const unsigned* traced_qubits, const uint32_t n_traced)
+{
+	// The X and Z bits of the traced qubits, every other bit of the index is kept
+	uint64_t traced_mask = 0;
+	for (uint32_t i = 0; i < n_traced; i++)
+	{
+		traced_mask |= (1ull << (2 * n_qubits - 1 - traced_qubits[i])) | (1ull << (n_qubits - 1 - traced_qubits[i]));
+	}
+	uint64_t kept_mask = (error_probabilities_entries_in_table(n_qubits) - 1) & ~traced_mask;
+
+	// Adding one through the bits outside a mask steps through the indices within the mask in order
+	// The kept index spreads the final index over the kept bits, so it is never below the final index
+	uint64_t n_final_entries = error_probabilities_entries_in_table(n_qubits - n_traced);
+	uint64_t n_traced_entries = error_probabilities_entries_in_table(n_traced);
+	uint64_t kept_index = 0;
+	for (uint64_t i = 0; i < n_final_entries; i++)
+	{
+		// Summed in double precision, as step_down
+		double sum = 0;
+		uint64_t traced_index = 0;
+		for (uint64_t j = 0; j < n_traced_entries; j++)
+		{
+			sum += error_probs[kept_index | traced_index];
+			traced_index = ((traced_index | ~traced_mask) + 1) & traced_mask;
+		}
+		error_probs[i] = sum;
+		kept_index = ((kept_index | ~kept_mask) + 1) & kept_mask;
+	}
+
+	return (error_probability_t*)realloc(error_probs, error_probabilities_bytes_in_table(n_qubits - n_traced));
+}
+
+/*
+ * error_probabilities_insert_qubit
+ * Adds a qubit with no error to a probability distribution in place, the inverse of tracing the qubit out of such a distribution
+ * Entries are moved in reverse index order and every entry moves to an index at or above its own
+ * :: error_probability_t* error_probs :: The distribution, this is reallocated and should not be used afterwards
+ * :: const uint32_t n_qubits :: The number of qubits in the distribution
+ * :: const unsigned qubit :: The index of the new qubit, qubits from this index onwards move up by one
+ * Returns the distribution over n_qubits + 1 qubits
+ */
+error_probability_t* error_probabilities_insert_qubit(error_probability_t* error_probs, const uint32_t n_qubits, const unsigned qubit)
+{
+	uint64_t n_initial_entries = error_probabilities_entries_in_table(n_qubits);
+	error_probs = (error_probability_t*)realloc(error_probs, error_probabilities_bytes_in_table(n_qubits + 1));
+	memset(error_probs + n_initial_entries, 0, error_probabilities_bytes_in_table(n_qubits + 1) - error_probabilities_bytes_in_table(n_qubits));
+
+	// A zero is placed at the new Z bit and then at the new X bit, shifting the bits above each one up
+	uint32_t z_bit = n_qubits - qubit;
+	uint32_t x_bit = 2 * n_qubits + 1 - qubit;
+	for (uint64_t i = n_initial_entries; i-- > 0;)
+	{
+		uint64_t index = ((i >> z_bit) << (z_bit + 1)) | (i & ((1ull << z_bit) - 1));
+		index = ((index >> x_bit) << (x_bit + 1)) | (index & ((1ull << x_bit) - 1));
+
+		error_probability_t prob = error_probs[i];
+		error_probs[i] = 0;
+		error_probs[index] = prob;
+	}
+	return error_probs;
+}
+
+
+/*
+ * error_probabilities_batch_zeros
+ * Allocates a batch table of pauli error distributions
+ * :: const size_t n_qubits :: The number of qubits that each distribution covers
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * Returns an array of zeros
+ */
+double* error_probabilities_batch_zeros(const size_t n_qubits, const uint32_t n_lanes)
+{
+	return (double*)calloc(error_probabilities_entries_in_table(n_qubits) * n_lanes, sizeof(double));
 }
 
+/*
+ * error_probabilities_batch_identity
+ * Allocates a batch table of pauli error distributions, the identity element of every lane is given a probability of 1
+ * :: const size_t n_qubits :: The number of qubits that each distribution covers
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * Returns an array of zeros with the first n_lanes elements set to 1.0
+ */
+double* error_probabilities_batch_identity(const size_t n_qubits, const uint32_t n_lanes)
+{
+	double* error_probs = error_probabilities_batch_zeros(n_qubits, n_lanes);
+	for (uint32_t i = 0; i < n_lanes; i++)
+	{
+		error_probs[i] = 1.0;
+	}
+	return error_probs;
+}
+
+/*
+ * error_probabilities_batch_lane
+ * Copies a single lane out of a batch table
+ * :: const double* error_probs :: The batch table
+ * :: const size_t n_qubits :: The number of qubits that each distribution covers
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * :: const uint32_t lane :: The lane to be copied
+ * Returns a regular table of error probabilities
+ */
+error_probability_t* error_probabilities_batch_lane(const double* error_probs, const size_t n_qubits, const uint32_t n_lanes, const uint32_t lane)
+{
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	error_probability_t* lane_probs = (error_probability_t*)malloc(sizeof(error_probability_t) * n_entries);
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		lane_probs[i] = error_probs[i * n_lanes + lane];
+	}
+	return lane_probs;
+}
+
+/*
+ * error_probabilities_batch_is_zero
+ * Checks if every lane of a single entry in a batch table is zero
+ * :: const double* entry :: The first lane of the entry
+ * :: const uint32_t n_lanes :: The number of distributions in the batch
+ * Returns true if every lane is zero
+ */
+uint8_t error_probabilities_batch_is_zero(const double* entry, const uint32_t n_lanes)
+{
+	for (uint32_t i = 0; i < n_lanes; i++)
+	{
+		if (entry[i] > 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t error_probabilities_batch_bytes_in_table(const uint32_t n_qubits, const uint32_t n_lanes)
+{
+	return error_probabilities_entries_in_table(n_qubits) * n_lanes * sizeof(double);
+}
 
 /*
  * error_probabilities_free 
  * Frees the array of errors
- * :: double* error_probs :: The distribution of errors to be freed
+ * :: error_probability_t* error_probs :: The distribution of errors to be freed
  * Returns nothing
  */
-void error_probabilities_free(double* error_probs)
+void error_probabilities_free(error_probability_t* error_probs)
 {
 	free(error_probs);
 }
@@ -0,0 +1,261 @@
+#ifndef ERROR_PROBABILITIES_MMAP
+#define ERROR_PROBABILITIES_MMAP
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "error_probabilities.h"
+
+// ----------------------------------------------------------------------------------------
+// FILE BACKED TABLES
+// A table of n qubits holds 4^n entries, 32 GiB at 16 qubits in double precision, which may not fit in memory
+// These tables live in a file mapped into memory, the operating system pages them in from the file as they are
+// read and writes them back as it needs the memory, so a run is limited by disk rather than memory
+//
+// The tables are plain arrays once mapped, and can be run with circuit_run_buffers (or gate_apply_buffers)
+// using a second mapped table as scratch, neither of which allocate a table of their own
+// Gate and noise kernels visit the blocks of a table in index order, with each thread of the pool taking a
+// contiguous range of blocks, so a pass over a table reads and writes 4^k sequential streams per thread for a
+// k qubit gate, the mappings are advised as sequential so pages are read ahead and dropped once passed
+//
+// Functions that reallocate a table, such as error_probabilities_trace_out, should not be given a mapped table,
+// error_probabilities_step_down reads a mapped table into a smaller table on the heap
+//
+// Each file starts with a header recording the size of its table, so a file is only reopened as the table it
+// was written as, the header is padded to a page so the table that follows it stays page aligned
+// ----------------------------------------------------------------------------------------
+
+// Identifies a table file, reads "QEPT" in a hex dump
+#define ERROR_PROBABILITIES_MMAP_MAGIC 0x54504551u
+
+// Offset from the start of a table file to the table
+#define ERROR_PROBABILITIES_MMAP_HEADER_BYTES 4096
+
+/*
+ * error_probabilities_mmap_header_t
+ * Header at the start of a table file
+ * :: uint32_t magic :: Should be ERROR_PROBABILITIES_MMAP_MAGIC
+ * :: uint32_t n_qubits :: The number of qubits covered by the table
+ * :: uint32_t element_bytes :: The size of each entry in the table, files written by a build of the other precision are rejected
+ * :: uint32_t header_bytes :: The offset from the start of the file to the table
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t n_qubits;
+	uint32_t element_bytes;
+	uint32_t header_bytes;
+} error_probabilities_mmap_header_t;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * error_probabilities_mmap_zeros
+ * Creates a file holding a table of zeros and maps it into memory
+ * The file is sparse, so disk space is only used as entries are written
+ * :: const char* filename :: The file to create, this is overwritten
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns the mapped table, or NULL if the file could not be created or mapped
+ */
+error_probability_t* error_probabilities_mmap_zeros(const char* filename, const size_t n_qubits);
+
+/*
+ * error_probabilities_mmap_scratch
+ * Maps a table of zeros backed by an unnamed file, for scratch tables that should not outlive the run
+ * The file is removed as soon as it is mapped, its space is returned when the table is unmapped
+ * :: const char* directory :: The directory to create the file in, this should be on the fast disk
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns the mapped table, or NULL if the file could not be created or mapped
+ */
+error_probability_t* error_probabilities_mmap_scratch(const char* directory, const size_t n_qubits);
+
+/*
+ * error_probabilities_mmap_open
+ * Maps an existing table file, such as one written by an earlier run
+ * The header of the file should match the number of qubits and the precision of this build, and the file should hold exactly one table
+ * :: const char* filename :: The file holding the table
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns the mapped table, or NULL if the file could not be mapped or does not hold a table of this size
+ */
+error_probability_t* error_probabilities_mmap_open(const char* filename, const size_t n_qubits);
+
+/*
+ * error_probabilities_mmap_step_up
+ * Steps a table on the heap up into a new table file, as error_probabilities_step_up
+ * :: const char* filename :: The file to create, this is overwritten
+ * :: const error_probability_t* error_probs :: The initial distribution
+ * :: const uint32_t n_qubits_initial :: The number of qubits in the initial distribution
+ * :: const uint32_t n_qubits_final :: The number of qubits in the final distribution
+ * Returns the mapped table, or NULL if the file could not be created or mapped
+ */
+error_probability_t* error_probabilities_mmap_step_up(const char* filename, const error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final);
+
+/*
+ * error_probabilities_mmap_free
+ * Unmaps a table, changes to a named file are kept
+ * :: error_probability_t* error_probs :: The mapped table
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns nothing
+ */
+void error_probabilities_mmap_free(error_probability_t* error_probs, const size_t n_qubits);
+
+// Size of a table file, including its header
+uint64_t error_probabilities_mmap_file_bytes(const size_t n_qubits);
+
+// Maps an open table file, a new file is sized and given its header, the file descriptor is closed
+error_probability_t* error_probabilities_mmap_fd(int fd, const size_t n_qubits, const uint8_t truncate);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * error_probabilities_mmap_zeros
+ * Creates a file holding a table of zeros and maps it into memory
+ * The file is sparse, so disk space is only used as entries are written
+ * :: const char* filename :: The file to create, this is overwritten
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns the mapped table, or NULL if the file could not be created or mapped
+ */
+error_probability_t* error_probabilities_mmap_zeros(const char* filename, const size_t n_qubits)
+{
+	int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		printf("Error when opening file.\n");
+		return NULL;
+	}
+	return error_probabilities_mmap_fd(fd, n_qubits, 1);
+}
+
+/*
+ * error_probabilities_mmap_scratch
+ * Maps a table of zeros backed by an unnamed file, for scratch tables that should not outlive the run
+ * The file is removed as soon as it is mapped, its space is returned when the table is unmapped
+ * :: const char* directory :: The directory to create the file in, this should be on the fast disk
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns the mapped table, or NULL if the file could not be created or mapped
+ */
+error_probability_t* error_probabilities_mmap_scratch(const char* directory, const size_t n_qubits)
+{
+	char filename[4096];
+	snprintf(filename, sizeof(filename), "%s/qecode_scratch_XXXXXX", directory);
+	int fd = mkstemp(filename);
+	if (fd < 0)
+	{
+		printf("Error when opening file.\n");
+		return NULL;
+	}
+	unlink(filename); // The mapping keeps the file alive
+	return error_probabilities_mmap_fd(fd, n_qubits, 1);
+}
+
+/*
+ * error_probabilities_mmap_open
+ * Maps an existing table file, such as one written by an earlier run
+ * The header of the file should match the number of qubits and the precision of this build, and the file should hold exactly one table
+ * :: const char* filename :: The file holding the table
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns the mapped table, or NULL if the file could not be mapped or does not hold a table of this size
+ */
+error_probability_t* error_probabilities_mmap_open(const char* filename, const size_t n_qubits)
+{
+	int fd = open(filename, O_RDWR);
+	if (fd < 0)
+	{
+		printf("Error when opening file.\n");
+		return NULL;
+	}
+
+	// The header is checked before the file is mapped
+	struct stat file_stat;
+	error_probabilities_mmap_header_t header;
+	if (fstat(fd, &file_stat) < 0
+		|| (ssize_t)sizeof(error_probabilities_mmap_header_t) != pread(fd, &header, sizeof(error_probabilities_mmap_header_t), 0)
+		|| ERROR_PROBABILITIES_MMAP_MAGIC != header.magic
+		|| n_qubits != header.n_qubits
+		|| sizeof(error_probability_t) != header.element_bytes
+		|| ERROR_PROBABILITIES_MMAP_HEADER_BYTES != header.header_bytes
+		|| (uint64_t)file_stat.st_size != error_probabilities_mmap_file_bytes(n_qubits))
+	{
+		printf("Table file does not hold a table of this size.\n");
+		close(fd);
+		return NULL;
+	}
+	return error_probabilities_mmap_fd(fd, n_qubits, 0);
+}
+
+/*
+ * error_probabilities_mmap_step_up
+ * Steps a table on the heap up into a new table file, as error_probabilities_step_up
+ * :: const char* filename :: The file to create, this is overwritten
+ * :: const error_probability_t* error_probs :: The initial distribution
+ * :: const uint32_t n_qubits_initial :: The number of qubits in the initial distribution
+ * :: const uint32_t n_qubits_final :: The number of qubits in the final distribution
+ * Returns the mapped table, or NULL if the file could not be created or mapped
+ */
+error_probability_t* error_probabilities_mmap_step_up(const char* filename, const error_probability_t* error_probs, const uint32_t n_qubits_initial, const uint32_t n_qubits_final)
+{
+	error_probability_t* expanded_error_probs = error_probabilities_mmap_zeros(filename, n_qubits_final);
+	if (NULL != expanded_error_probs)
+	{
+		error_probabilities_step_up_into(expanded_error_probs, error_probs, n_qubits_initial, n_qubits_final);
+	}
+	return expanded_error_probs;
+}
+
+/*
+ * error_probabilities_mmap_free
+ * Unmaps a table, changes to a named file are kept
+ * :: error_probability_t* error_probs :: The mapped table
+ * :: const size_t n_qubits :: The number of qubits covered by the table
+ * Returns nothing
+ */
+void error_probabilities_mmap_free(error_probability_t* error_probs, const size_t n_qubits)
+{
+	// The mapping starts at the header
+	munmap((uint8_t*)error_probs - ERROR_PROBABILITIES_MMAP_HEADER_BYTES, error_probabilities_mmap_file_bytes(n_qubits));
+	return;
+}
+
+// Size of a table file, including its header
+uint64_t error_probabilities_mmap_file_bytes(const size_t n_qubits)
+{
+	return ERROR_PROBABILITIES_MMAP_HEADER_BYTES + error_probabilities_bytes_in_table(n_qubits);
+}
+
+// Maps an open table file, a new file is sized and given its header, the file descriptor is closed
+error_probability_t* error_probabilities_mmap_fd(int fd, const size_t n_qubits, const uint8_t truncate)
+{
+	uint64_t n_bytes = error_probabilities_mmap_file_bytes(n_qubits);
+
+	// Extending the file leaves a hole that reads as zeros
+	if (truncate && ftruncate(fd, n_bytes) < 0)
+	{
+		printf("Could not size the table file.\n");
+		close(fd);
+		return NULL;
+	}
+
+	void* mapping = mmap(NULL, n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd); // The mapping holds its own reference to the file
+	if (MAP_FAILED == mapping)
+	{
+		printf("Could not map the table file.\n");
+		return NULL;
+	}
+
+	if (truncate)
+	{
+		error_probabilities_mmap_header_t* header = (error_probabilities_mmap_header_t*)mapping;
+		header->magic = ERROR_PROBABILITIES_MMAP_MAGIC;
+		header->n_qubits = n_qubits;
+		header->element_bytes = sizeof(error_probability_t);
+		header->header_bytes = ERROR_PROBABILITIES_MMAP_HEADER_BYTES;
+	}
+
+	// Kernels pass over the table in index order
+	madvise(mapping, n_bytes, MADV_SEQUENTIAL);
+	return (error_probability_t*)((uint8_t*)mapping + ERROR_PROBABILITIES_MMAP_HEADER_BYTES);
+}
+
+#endif
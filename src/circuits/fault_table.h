@@ -0,0 +1,626 @@
+#ifndef CIRCUIT_FAULT_TABLE
+#define CIRCUIT_FAULT_TABLE
+
+#include "circuit.h"
+#include "frame_simulator.h"
+#include "../logical.h"
+#include "../gates/gates.h"
+#include "../gates/gate_emit.h"
+#include "../decoders/decoders.h"
+#include "../misc/rng.h"
+#include "../misc/thread_pool.h"
+
+// ----------------------------------------------------------------------------------------
+// FAULT TABLE
+// Every gate of a circuit is a fault location, as is every idle qubit under the environmental noise
+// Each non identity error of a location is a fault, and as the gates are affine maps over the table index
+// the effect of a fault at the end of the circuit does not depend on any other fault
+//
+// The circuit is walked once from its end, keeping the image of each bit of the table index under the rest of the
+// circuit, so each fault is a few exclusive ors rather than a run of the circuit
+// The table then gives samples, syndrome and flag outcomes and leading order logical error rates without
+// running the circuit again, see syndrome_measurement_flag_ft.h for the circuits this is aimed at
+//
+// Gates are compiled with frame_simulator_map_create, so the same gates are supported as circuit_run_frames
+// Strings are held as table indices, so circuits are limited to 32 qubits
+// ----------------------------------------------------------------------------------------
+
+// Largest circuit that may be compiled into a fault table
+#define FAULT_TABLE_MAX_QUBITS 32
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+ * fault_table_entry_t
+ * A single fault
+ * :: uint64_t index :: The table index the fault leaves at the end of the circuit, this is summed with the offset
+ * :: double prob :: The probability of the fault
+ */
+typedef struct
+{
+	uint64_t index;
+	double prob;
+} fault_table_entry_t;
+
+/*
+ * fault_table
+ * The faults of a circuit, grouped by location, at most one fault occurs at each location
+ * :: uint32_t n_qubits :: The number of qubits of the circuit
+ * :: uint32_t n_locations :: The number of locations with at least one fault
+ * :: uint64_t n_faults :: The number of faults
+ * :: uint64_t offset :: The table index left at the end of the circuit without any fault
+ * :: fault_table_entry_t* faults :: The faults
+ * :: uint64_t* location_start :: The first fault of each location, with a final entry of n_faults
+ * :: double* location_prob :: The probability of any fault at each location
+ * :: uint64_t locations_capacity :: The number of locations allocated
+ * :: uint64_t faults_capacity :: The number of faults allocated
+ * This object should be freed using the 'fault_table_free' function
+ */
+typedef struct
+{
+	uint32_t n_qubits;
+	uint32_t n_locations;
+	uint64_t n_faults;
+	uint64_t offset;
+	fault_table_entry_t* faults;
+	uint64_t* location_start;
+	double* location_prob;
+	uint64_t locations_capacity;
+	uint64_t faults_capacity;
+} fault_table;
+
+// Data shared by the pool workers in fault_table_sample
+typedef struct
+{
+	const fault_table* ft;
+	pauli_frames* frames;
+	uint64_t seed;
+} fault_table_sample_task_t;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * fault_table_create
+ * Walks a circuit and records the effect of every single fault, following the same schedule as circuit_run_default
+ * Only the gates of the circuit are used, circuits that replace their circuit_operation are not supported
+ * :: circuit* c :: The circuit, this should act on at most FAULT_TABLE_MAX_QUBITS qubits
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the fault table, or NULL if a gate could not be compiled
+ */
+fault_table* fault_table_create(circuit* c, gate* noise);
+
+/*
+ * fault_table_sample
+ * Draws at most one fault from every location for each shot, the result follows the same distribution as circuit_run_frames
+ * Each block of shots has its own generator, see rng_create_stream, so the result does not depend on the number of threads
+ * :: const fault_table* ft :: The fault table
+ * :: const uint64_t n_shots :: The number of shots, this is rounded up to a whole number of blocks
+ * :: const uint64_t seed :: Seed for the generators
+ * Returns a heap pointer to the frames
+ */
+pauli_frames* fault_table_sample(const fault_table* ft, const uint64_t n_shots, const uint64_t seed);
+
+/*
+ * fault_table_outcomes
+ * Measures the string left behind by each fault, this gives the syndrome and flag bits of each fault
+ * :: const fault_table* ft :: The fault table
+ * :: const gate* measure :: A measurement gate, see measurement.h, its outcome should be deterministic
+ * :: const unsigned* target_qubits :: The qubits that are measured
+ * Returns a heap array of the outcome of each fault, or NULL if an outcome was not deterministic
+ */
+uint64_t* fault_table_outcomes(const fault_table* ft, const gate* measure, const unsigned* target_qubits);
+
+/*
+ * fault_table_logical_errors
+ * Decodes the string left behind by each fault, as pauli_frames_decode does for each shot
+ * The code covers the first code->length / 2 qubits of the circuit, any further qubits are ignored
+ * :: const fault_table* ft :: The fault table
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * Returns a heap array of the sym_to_ll value of the logical error left by each fault
+ */
+uint64_t* fault_table_logical_errors(const fault_table* ft, const sym* code, const sym* logicals, decoder* decoding_operation);
+
+/*
+ * fault_table_leading_order
+ * The logical error rates to first order in the fault probabilities, each fault is decoded alone
+ * :: const fault_table* ft :: The fault table
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * Returns a heap array of probabilities indexed by sym_to_ll of the logical error, the first entry is the remaining probability
+ */
+double* fault_table_leading_order(const fault_table* ft, const sym* code, const sym* logicals, decoder* decoding_operation);
+
+/*
+ * fault_table_free
+ * Frees a fault table
+ * :: fault_table* ft :: The fault table
+ * Returns nothing
+ */
+void fault_table_free(fault_table* ft);
+
+// Records the faults of an error model acting on some qubits, columns holds the image of each bit of the table index
+void fault_table_add_location(fault_table* ft, error_model* m, const uint32_t n_targets, const unsigned* target_qubits, const uint64_t* columns);
+
+// Composes the images of the bits of the table index with a map, so they cover the map and the rest of the circuit
+void fault_table_compose(uint64_t* columns, const uint32_t n_qubits, const frame_simulator_map_t* map, const unsigned* target_qubits);
+
+// Applies a map to a single table index
+uint64_t fault_table_map_index(const uint64_t index, const uint32_t n_qubits, const frame_simulator_map_t* map, const unsigned* target_qubits);
+
+// The bit of the table index for a single bit of the local table index of a gate, see frame_simulator_lanes
+uint32_t fault_table_global_bit(const uint32_t n_qubits, const unsigned* target_qubits, const uint32_t n_targets, const uint32_t bit);
+
+// Pool task, samples a range of blocks
+void fault_table_sample_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * fault_table_create
+ * Walks a circuit and records the effect of every single fault, following the same schedule as circuit_run_default
+ * Only the gates of the circuit are used, circuits that replace their circuit_operation are not supported
+ * :: circuit* c :: The circuit, this should act on at most FAULT_TABLE_MAX_QUBITS qubits
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * Returns a heap pointer to the fault table, or NULL if a gate could not be compiled
+ */
+fault_table* fault_table_create(circuit* c, gate* noise)
+{
+	if (c->n_qubits > FAULT_TABLE_MAX_QUBITS)
+	{
+		printf("Fault tables are limited to %d qubits!\n", FAULT_TABLE_MAX_QUBITS);
+		return NULL;
+	}
+
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return NULL;
+	}
+
+	// Each gate is compiled once, the walk runs backwards so the elements are gathered first
+	circuit_element** elements = (circuit_element**)malloc(sizeof(circuit_element*) * c->n_gates);
+	frame_simulator_map_t* maps = (frame_simulator_map_t*)malloc(sizeof(frame_simulator_map_t) * c->n_gates);
+	frame_simulator_map_t noise_map;
+
+	int32_t failed = 0;
+	uint32_t n_elements = 0;
+	for (circuit_element* ce = c->start; NULL != ce && !failed; ce = ce->next, n_elements++)
+	{
+		elements[n_elements] = ce;
+		failed = frame_simulator_map_create(ce->gate_operation, maps + n_elements);
+	}
+	if (!failed && NULL != noise)
+	{
+		failed = frame_simulator_map_create(noise, &noise_map);
+	}
+	if (failed)
+	{
+		free(maps);
+		free(elements);
+		return NULL;
+	}
+
+	fault_table* ft = (fault_table*)malloc(sizeof(fault_table));
+	ft->n_qubits = c->n_qubits;
+	ft->n_locations = 0;
+	ft->n_faults = 0;
+	ft->locations_capacity = 64;
+	ft->faults_capacity = 256;
+	ft->location_start = (uint64_t*)malloc(sizeof(uint64_t) * (ft->locations_capacity + 1));
+	ft->location_prob = (double*)malloc(sizeof(double) * ft->locations_capacity);
+	ft->faults = (fault_table_entry_t*)malloc(sizeof(fault_table_entry_t) * ft->faults_capacity);
+	ft->location_start[0] = 0;
+
+	// The image of each bit of the table index under the rest of the circuit, this starts as the identity at the end
+	uint32_t n_bits = 2 * c->n_qubits;
+	uint64_t columns[2 * FAULT_TABLE_MAX_QUBITS];
+	for (uint32_t b = 0; b < n_bits; b++)
+	{
+		columns[b] = 1ull << b;
+	}
+
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+	for (uint32_t idx = n_elements; idx-- > 0;)
+	{
+		circuit_element* ce = elements[idx];
+		gate* g = ce->gate_operation;
+
+		// Environmental noise follows the gate and its noise, so it is unwound first and in reverse order
+		if (NULL != noise)
+		{
+			memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+			for (uint32_t j = 0; j < g->n_qubits; j++)
+			{
+				busy[ce->target_qubits[j]] = 1;
+			}
+			for (unsigned i = c->n_qubits; i-- > 0;)
+			{
+				if (!busy[i])
+				{
+					if (NULL != noise->gate_error_model)
+					{
+						fault_table_add_location(ft, noise->gate_error_model, 1, &i, columns);
+					}
+					fault_table_compose(columns, c->n_qubits, &noise_map, &i);
+				}
+			}
+		}
+
+		if (NULL != g->gate_error_model)
+		{
+			fault_table_add_location(ft, g->gate_error_model, g->n_qubits, ce->target_qubits, columns);
+		}
+		fault_table_compose(columns, c->n_qubits, maps + idx, ce->target_qubits);
+	}
+
+	// The string left without any fault, from the pauli gates and preparations of the circuit
+	ft->offset = 0;
+	for (uint32_t idx = 0; idx < n_elements; idx++)
+	{
+		circuit_element* ce = elements[idx];
+		ft->offset = fault_table_map_index(ft->offset, c->n_qubits, maps + idx, ce->target_qubits);
+		if (NULL != noise && !noise_map.identity)
+		{
+			memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+			for (uint32_t j = 0; j < ce->gate_operation->n_qubits; j++)
+			{
+				busy[ce->target_qubits[j]] = 1;
+			}
+			for (unsigned i = 0; i < c->n_qubits; i++)
+			{
+				if (!busy[i])
+				{
+					ft->offset = fault_table_map_index(ft->offset, c->n_qubits, &noise_map, &i);
+				}
+			}
+		}
+	}
+
+	free(busy);
+	free(maps);
+	free(elements);
+	return ft;
+}
+
+/*
+ * fault_table_sample
+ * Draws at most one fault from every location for each shot, the result follows the same distribution as circuit_run_frames
+ * Each block of shots has its own generator, see rng_create_stream, so the result does not depend on the number of threads
+ * :: const fault_table* ft :: The fault table
+ * :: const uint64_t n_shots :: The number of shots, this is rounded up to a whole number of blocks
+ * :: const uint64_t seed :: Seed for the generators
+ * Returns a heap pointer to the frames
+ */
+pauli_frames* fault_table_sample(const fault_table* ft, const uint64_t n_shots, const uint64_t seed)
+{
+	fault_table_sample_task_t task_data;
+	task_data.ft = ft;
+	task_data.frames = pauli_frames_create(ft->n_qubits, n_shots);
+	task_data.seed = seed;
+	thread_pool_parallel_for(thread_pool_default(), task_data.frames->n_blocks, fault_table_sample_task, &task_data);
+	return task_data.frames;
+}
+
+/*
+ * fault_table_outcomes
+ * Measures the string left behind by each fault, this gives the syndrome and flag bits of each fault
+ * :: const fault_table* ft :: The fault table
+ * :: const gate* measure :: A measurement gate, see measurement.h, its outcome should be deterministic
+ * :: const unsigned* target_qubits :: The qubits that are measured
+ * Returns a heap array of the outcome of each fault, or NULL if an outcome was not deterministic
+ */
+uint64_t* fault_table_outcomes(const fault_table* ft, const gate* measure, const unsigned* target_qubits)
+{
+	uint64_t* outcomes = (uint64_t*)malloc(sizeof(uint64_t) * (ft->n_faults ? ft->n_faults : 1));
+	for (uint64_t f = 0; f < ft->n_faults; f++)
+	{
+		frame_simulator_probe_t probe = {0, 0, 1};
+		gate_emit(measure, ft->offset ^ ft->faults[f].index, ft->n_qubits, target_qubits, frame_simulator_probe_emit, &probe);
+		if (1 != probe.n_outcomes || !probe.deterministic)
+		{
+			printf("Measurement outcome is not deterministic!\n");
+			free(outcomes);
+			return NULL;
+		}
+		outcomes[f] = probe.index;
+	}
+	return outcomes;
+}
+
+/*
+ * fault_table_logical_errors
+ * Decodes the string left behind by each fault, as pauli_frames_decode does for each shot
+ * The code covers the first code->length / 2 qubits of the circuit, any further qubits are ignored
+ * :: const fault_table* ft :: The fault table
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * Returns a heap array of the sym_to_ll value of the logical error left by each fault
+ */
+uint64_t* fault_table_logical_errors(const fault_table* ft, const sym* code, const sym* logicals, decoder* decoding_operation)
+{
+	uint32_t n_code_qubits = code->length / 2;
+	uint64_t* logical_errors = (uint64_t*)malloc(sizeof(uint64_t) * (ft->n_faults ? ft->n_faults : 1));
+	sym* physical_error = sym_create(1, code->length);
+
+	for (uint64_t f = 0; f < ft->n_faults; f++)
+	{
+		uint64_t index = ft->offset ^ ft->faults[f].index;
+		for (uint32_t q = 0; q < n_code_qubits; q++)
+		{
+			sym_set(physical_error, 0, q, !!(index & gate_emit_X_bit(ft->n_qubits, q)));
+			sym_set(physical_error, 0, q + n_code_qubits, !!(index & gate_emit_Z_bit(ft->n_qubits, q)));
+		}
+		logical_errors[f] = pauli_frames_logical_error(code, logicals, decoding_operation, physical_error);
+	}
+
+	sym_free(physical_error);
+	return logical_errors;
+}
+
+/*
+ * fault_table_leading_order
+ * The logical error rates to first order in the fault probabilities, each fault is decoded alone
+ * :: const fault_table* ft :: The fault table
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * Returns a heap array of probabilities indexed by sym_to_ll of the logical error, the first entry is the remaining probability
+ */
+double* fault_table_leading_order(const fault_table* ft, const sym* code, const sym* logicals, decoder* decoding_operation)
+{
+	uint64_t n_logical_errors = 1ull << logicals->length;
+	double* logical_probs = (double*)calloc(n_logical_errors, sizeof(double));
+	uint64_t* logical_errors = fault_table_logical_errors(ft, code, logicals, decoding_operation);
+
+	for (uint64_t f = 0; f < ft->n_faults; f++)
+	{
+		logical_probs[logical_errors[f]] += ft->faults[f].prob;
+	}
+
+	// The string left without any fault may itself carry a logical error
+	sym* physical_error = sym_create(1, code->length);
+	uint32_t n_code_qubits = code->length / 2;
+	for (uint32_t q = 0; q < n_code_qubits; q++)
+	{
+		sym_set(physical_error, 0, q, !!(ft->offset & gate_emit_X_bit(ft->n_qubits, q)));
+		sym_set(physical_error, 0, q + n_code_qubits, !!(ft->offset & gate_emit_Z_bit(ft->n_qubits, q)));
+	}
+	uint64_t no_fault = pauli_frames_logical_error(code, logicals, decoding_operation, physical_error);
+	sym_free(physical_error);
+
+	double total = 0;
+	for (uint64_t l = 0; l < n_logical_errors; l++)
+	{
+		if (l != no_fault)
+		{
+			total += logical_probs[l];
+		}
+	}
+	logical_probs[no_fault] = 1 - total;
+
+	free(logical_errors);
+	return logical_probs;
+}
+
+/*
+ * fault_table_free
+ * Frees a fault table
+ * :: fault_table* ft :: The fault table
+ * Returns nothing
+ */
+void fault_table_free(fault_table* ft)
+{
+	free(ft->faults);
+	free(ft->location_start);
+	free(ft->location_prob);
+	free(ft);
+	return;
+}
+
+// Records the faults of an error model acting on some qubits, columns holds the image of each bit of the table index
+void fault_table_add_location(fault_table* ft, error_model* m, const uint32_t n_targets, const unsigned* target_qubits, const uint64_t* columns)
+{
+	uint64_t n_local = 1ull << (2 * n_targets);
+	if (ft->n_faults + n_local > ft->faults_capacity)
+	{
+		while (ft->n_faults + n_local > ft->faults_capacity)
+		{
+			ft->faults_capacity *= 2;
+		}
+		ft->faults = (fault_table_entry_t*)realloc(ft->faults, sizeof(fault_table_entry_t) * ft->faults_capacity);
+	}
+
+	// The image of each local bit, as gates.h indexes the error model
+	uint64_t local_columns[2 * FRAME_SIMULATOR_MAX_GATE_QUBITS];
+	for (uint32_t j = 0; j < 2 * n_targets; j++)
+	{
+		local_columns[j] = columns[fault_table_global_bit(ft->n_qubits, target_qubits, n_targets, j)];
+	}
+
+	double location_prob = 0;
+	uint64_t first_fault = ft->n_faults;
+	for (uint64_t local = 1; local < n_local; local++)
+	{
+		sym* gate_error = ll_to_sym_n_qubits(local, 1, n_targets);
+		double prob = error_model_call(m, gate_error);
+		sym_free(gate_error);
+		if (prob <= 0)
+		{
+			continue;
+		}
+
+		uint64_t index = 0;
+		for (uint32_t j = 0; j < 2 * n_targets; j++)
+		{
+			if ((local >> j) & 1)
+			{
+				index ^= local_columns[j];
+			}
+		}
+
+		ft->faults[ft->n_faults].index = index;
+		ft->faults[ft->n_faults].prob = prob;
+		ft->n_faults++;
+		location_prob += prob;
+	}
+
+	if (ft->n_faults == first_fault)
+	{
+		return;
+	}
+
+	if (ft->n_locations == ft->locations_capacity)
+	{
+		ft->locations_capacity *= 2;
+		ft->location_start = (uint64_t*)realloc(ft->location_start, sizeof(uint64_t) * (ft->locations_capacity + 1));
+		ft->location_prob = (double*)realloc(ft->location_prob, sizeof(double) * ft->locations_capacity);
+	}
+	ft->location_prob[ft->n_locations] = location_prob;
+	ft->n_locations++;
+	ft->location_start[ft->n_locations] = ft->n_faults;
+	return;
+}
+
+// Composes the images of the bits of the table index with a map, so they cover the map and the rest of the circuit
+void fault_table_compose(uint64_t* columns, const uint32_t n_qubits, const frame_simulator_map_t* map, const unsigned* target_qubits)
+{
+	if (map->identity)
+	{
+		return;
+	}
+
+	// Only the linear part of the map moves a fault, its offset is carried by fault_table_map_index
+	uint32_t n_targets = map->n_bits / 2;
+	uint32_t global_bits[2 * FRAME_SIMULATOR_MAX_GATE_QUBITS];
+	uint64_t target_columns[2 * FRAME_SIMULATOR_MAX_GATE_QUBITS];
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		global_bits[j] = fault_table_global_bit(n_qubits, target_qubits, n_targets, j);
+		target_columns[j] = columns[global_bits[j]];
+	}
+
+	// A bit entering the map leaves as the sum of the bits in its column
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		uint64_t image = 0;
+		for (uint32_t o = 0; o < map->n_bits; o++)
+		{
+			if ((map->columns[j] >> o) & 1)
+			{
+				image ^= target_columns[o];
+			}
+		}
+		columns[global_bits[j]] = image;
+	}
+	return;
+}
+
+// Applies a map to a single table index
+uint64_t fault_table_map_index(const uint64_t index, const uint32_t n_qubits, const frame_simulator_map_t* map, const unsigned* target_qubits)
+{
+	if (map->identity)
+	{
+		return index;
+	}
+
+	uint32_t n_targets = map->n_bits / 2;
+	uint64_t local_in = 0;
+	uint64_t cleared = index;
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		uint64_t global_bit = 1ull << fault_table_global_bit(n_qubits, target_qubits, n_targets, j);
+		local_in |= (uint64_t)!!(index & global_bit) << j;
+		cleared &= ~global_bit;
+	}
+
+	uint64_t local_out = map->offset;
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		if ((local_in >> j) & 1)
+		{
+			local_out ^= map->columns[j];
+		}
+	}
+
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		cleared |= ((local_out >> j) & 1) << fault_table_global_bit(n_qubits, target_qubits, n_targets, j);
+	}
+	return cleared;
+}
+
+// The bit of the table index for a single bit of the local table index of a gate, see frame_simulator_lanes
+uint32_t fault_table_global_bit(const uint32_t n_qubits, const unsigned* target_qubits, const uint32_t n_targets, const uint32_t bit)
+{
+	// The Z bit of qubit q is at (n_qubits - 1 - q), and its X bit is n_qubits above it
+	if (bit < n_targets)
+	{
+		return n_qubits - 1 - target_qubits[n_targets - 1 - bit];
+	}
+	return 2 * n_qubits - 1 - target_qubits[2 * n_targets - 1 - bit];
+}
+
+// Pool task, samples a range of blocks
+void fault_table_sample_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker)
+{
+	fault_table_sample_task_t* task_data = (fault_table_sample_task_t*)data;
+	const fault_table* ft = task_data->ft;
+	pauli_frames* frames = task_data->frames;
+
+	for (uint64_t block = block_start; block < block_end; block++)
+	{
+		rng r = rng_create_stream(task_data->seed, block);
+		uint64_t* x = frames->x + block * frames->n_qubits * FRAME_SIMULATOR_LANES;
+		uint64_t* z = frames->z + block * frames->n_qubits * FRAME_SIMULATOR_LANES;
+
+		// Every shot starts from the string left without any fault
+		for (uint32_t q = 0; q < frames->n_qubits; q++)
+		{
+			for (uint32_t l = 0; l < FRAME_SIMULATOR_LANES; l++)
+			{
+				x[q * FRAME_SIMULATOR_LANES + l] = (ft->offset & gate_emit_X_bit(frames->n_qubits, q)) ? ~0ull : 0;
+				z[q * FRAME_SIMULATOR_LANES + l] = (ft->offset & gate_emit_Z_bit(frames->n_qubits, q)) ? ~0ull : 0;
+			}
+		}
+
+		// Most locations have no fault in most shots, so each location skips straight to the shots where it has one
+		for (uint32_t loc = 0; loc < ft->n_locations; loc++)
+		{
+			double log_failure = log1p(-ft->location_prob[loc]);
+			uint64_t shot = rng_geometric(&r, log_failure);
+			while (shot < FRAME_SIMULATOR_SHOTS_PER_BLOCK)
+			{
+				// Walk the faults of the location, rounding may leave u past the last one
+				double u = rng_uniform(&r) * ft->location_prob[loc];
+				uint64_t f = ft->location_start[loc];
+				uint64_t last = ft->location_start[loc + 1] - 1;
+				while (f < last && u >= ft->faults[f].prob)
+				{
+					u -= ft->faults[f].prob;
+					f++;
+				}
+
+				// Flip the bits of the shot set in the index of the fault
+				uint32_t lane = shot / 64;
+				uint64_t bit = 1ull << (shot % 64);
+				uint64_t index = ft->faults[f].index;
+				for (uint32_t q = 0; q < frames->n_qubits; q++)
+				{
+					x[q * FRAME_SIMULATOR_LANES + lane] ^= (index & gate_emit_X_bit(frames->n_qubits, q)) ? bit : 0;
+					z[q * FRAME_SIMULATOR_LANES + lane] ^= (index & gate_emit_Z_bit(frames->n_qubits, q)) ? bit : 0;
+				}
+
+				uint64_t skip = rng_geometric(&r, log_failure);
+				shot = (skip < FRAME_SIMULATOR_SHOTS_PER_BLOCK) ? shot + 1 + skip : FRAME_SIMULATOR_SHOTS_PER_BLOCK;
+			}
+		}
+	}
+	return;
+}
+
+#endif
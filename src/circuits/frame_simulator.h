@@ -0,0 +1,731 @@
+#ifndef CIRCUIT_FRAME_SIMULATOR
+#define CIRCUIT_FRAME_SIMULATOR
+
+#include "circuit.h"
+#include "../logical.h"
+#include "../gates/gates.h"
+#include "../gates/gate_emit.h"
+#include "../decoders/decoders.h"
+#include "../error_models/sample.h"
+#include "../misc/rng.h"
+#include "../misc/thread_pool.h"
+
+// ----------------------------------------------------------------------------------------
+// FRAME SIMULATOR
+// A table holds the probability of every pauli string, so it grows as 4^n
+// A pauli frame is a single sampled error, which grows as n, so far larger circuits can be run
+// at the cost of sampling error in the result
+//
+// Frames are packed bitwise across shots, bit s of a word belongs to shot s, so a clifford gate is a handful
+// of word operations for 64 shots at once
+// Shots are grouped into blocks of FRAME_SIMULATOR_LANES words, the loops over the lanes of a block have no
+// dependencies between lanes so they may be vectorised, 8 lanes fill a 512 bit register
+//
+// Each gate is compiled once into an affine map over the bits of its targets by passing basis strings through
+// its emit form, see gate_emit.h, so the gates of clifford_generators.h, pauli_generators.h and preparation.h
+// and fused gates are used as they are
+// Gates whose emit form is not a single deterministic outcome, such as custom gates with several outcomes, are rejected
+// Errors are drawn from the error model of each gate, see error_models/sample.h, most shots of a block draw
+// the identity so the shots with an error are found by geometric skips and only those draw an error
+// ----------------------------------------------------------------------------------------
+
+/* FRAME_SIMULATOR_LANES #
+ *	The number of 64 bit words of shots in each block, the number of shots is rounded up to a whole number of blocks
+ */
+#ifndef FRAME_SIMULATOR_LANES
+#define FRAME_SIMULATOR_LANES 8
+#endif
+
+#define FRAME_SIMULATOR_SHOTS_PER_BLOCK (64 * FRAME_SIMULATOR_LANES)
+
+// Largest gate that may be compiled into a map
+#define FRAME_SIMULATOR_MAX_GATE_QUBITS 16
+
+// Gates up to this size have their map checked against every local pauli string
+#define FRAME_SIMULATOR_MAX_CHECKED_QUBITS 5
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+ * pauli_frames
+ * A sampled pauli error for each shot
+ * :: uint32_t n_qubits :: The number of qubits covered by each frame
+ * :: uint64_t n_shots :: The number of shots, a whole number of blocks
+ * :: uint64_t n_blocks :: The number of blocks of shots
+ * :: uint64_t* x :: The X bits, lane l of qubit q in block b is at ((b * n_qubits + q) * FRAME_SIMULATOR_LANES + l)
+ * :: uint64_t* z :: The Z bits, laid out as the X bits
+ * This object should be freed using the 'pauli_frames_free' function
+ */
+typedef struct
+{
+	uint32_t n_qubits;
+	uint64_t n_shots;
+	uint64_t n_blocks;
+	uint64_t* x;
+	uint64_t* z;
+} pauli_frames;
+
+/*
+ * frame_simulator_map_t
+ * A gate compiled into an affine map over the table index of its targets, as a table over the gate's own qubits
+ * :: uint32_t n_bits :: Twice the number of qubits of the gate
+ * :: uint8_t identity :: Set if the map leaves every string unchanged
+ * :: uint64_t offset :: The image of the identity
+ * :: uint64_t columns[] :: The image of each single bit, less the offset
+ */
+typedef struct
+{
+	uint32_t n_bits;
+	uint8_t identity;
+	uint64_t offset;
+	uint64_t columns[2 * FRAME_SIMULATOR_MAX_GATE_QUBITS];
+} frame_simulator_map_t;
+
+// Data for the emit callback used to compile a map
+typedef struct
+{
+	uint64_t index;
+	uint32_t n_outcomes;
+	uint8_t deterministic;
+} frame_simulator_probe_t;
+
+// Data shared by the pool workers in circuit_run_frames
+typedef struct
+{
+	circuit* c;
+	pauli_frames* frames;
+	frame_simulator_map_t* maps; // One for each element of the circuit
+	error_model_sampler_t** samplers; // One for each element of the circuit, NULL for noiseless gates
+	gate* noise;
+	frame_simulator_map_t noise_map;
+	error_model_sampler_t* noise_sampler;
+	uint64_t seed;
+} frame_simulator_task_t;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * pauli_frames_create
+ * Allocates a batch of frames, every frame starts as the identity
+ * :: const uint32_t n_qubits :: The number of qubits covered by each frame
+ * :: const uint64_t n_shots :: The number of shots, this is rounded up to a whole number of blocks
+ * Returns a heap pointer to the new frames
+ */
+pauli_frames* pauli_frames_create(const uint32_t n_qubits, const uint64_t n_shots);
+
+/*
+ * pauli_frames_get
+ * Copies the frame of a single shot to a sym object
+ * :: const pauli_frames* frames :: The frames
+ * :: const uint64_t shot :: The shot
+ * :: sym* out :: Height one sym object, its length sets the number of qubits copied starting from the first
+ * Returns nothing
+ */
+void pauli_frames_get(const pauli_frames* frames, const uint64_t shot, sym* out);
+
+/*
+ * pauli_frames_index
+ * The table index of the frame of a single shot, as sym_to_ll, so frames may be compared with tables
+ * :: const pauli_frames* frames :: The frames, these should cover at most 32 qubits
+ * :: const uint64_t shot :: The shot
+ * Returns the table index
+ */
+uint64_t pauli_frames_index(const pauli_frames* frames, const uint64_t shot);
+
+/*
+ * pauli_frames_decode
+ * Decodes the frame of every shot and counts the logical error left behind, as characterise_code does for each physical error
+ * The code covers the first code->length / 2 qubits of the frames, any further qubits are ignored
+ * :: const pauli_frames* frames :: The frames
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * Returns a heap array of counts indexed by sym_to_ll of the logical error, the first entry counts the shots without a logical error
+ */
+uint64_t* pauli_frames_decode(const pauli_frames* frames, const sym* code, const sym* logicals, decoder* decoding_operation);
+
+/*
+ * pauli_frames_logical_error
+ * Decodes a single physical error and finds the logical error left behind, as characterise_code does
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * :: const sym* physical_error :: Height one sym object covering the code qubits
+ * Returns the sym_to_ll value of the logical error
+ */
+uint64_t pauli_frames_logical_error(const sym* code, const sym* logicals, decoder* decoding_operation, const sym* physical_error);
+
+/*
+ * pauli_frames_free
+ * Frees a batch of frames
+ * :: pauli_frames* frames :: The frames
+ * Returns nothing
+ */
+void pauli_frames_free(pauli_frames* frames);
+
+/*
+ * frame_simulator_map_create
+ * Compiles the operation of a gate into an affine map
+ * :: const gate* g :: The gate, a gate without an operation gives the identity map
+ * :: frame_simulator_map_t* map :: Written with the map
+ * Returns 0 on success, or -1 if the operation of the gate is not a deterministic affine map
+ */
+int32_t frame_simulator_map_create(const gate* g, frame_simulator_map_t* map);
+
+/*
+ * frame_simulator_map_apply
+ * Applies a map to the frames of every shot in a block
+ * :: pauli_frames* frames :: The frames
+ * :: const uint64_t block :: The block
+ * :: const frame_simulator_map_t* map :: The map
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void frame_simulator_map_apply(pauli_frames* frames, const uint64_t block, const frame_simulator_map_t* map, const unsigned* target_qubits);
+
+/*
+ * frame_simulator_inject
+ * Draws an error for every shot in a block and applies it to the frames
+ * :: pauli_frames* frames :: The frames
+ * :: const uint64_t block :: The block
+ * :: const error_model_sampler_t* sampler :: The sampler of the error model
+ * :: const unsigned* target_qubits :: The qubits the error acts on
+ * :: rng* r :: The random number generator
+ * Returns nothing
+ */
+void frame_simulator_inject(pauli_frames* frames, const uint64_t block, const error_model_sampler_t* sampler, const unsigned* target_qubits, rng* r);
+
+/*
+ * circuit_run_frames
+ * Samples the errors of a circuit, following the same schedule as circuit_run_default
+ * Only the gates of the circuit are run, circuits that replace their circuit_operation are not supported
+ * Every frame starts as the identity, each block of shots has its own generator, see rng_create_stream,
+ * so the result does not depend on the number of threads
+ * :: circuit* c :: The circuit to be run
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * :: const uint64_t n_shots :: The number of shots, this is rounded up to a whole number of blocks
+ * :: const uint64_t seed :: Seed for the generators
+ * Returns a heap pointer to the frames, or NULL if a gate could not be compiled or its error model could not be sampled
+ */
+pauli_frames* circuit_run_frames(circuit* c, gate* noise, const uint64_t n_shots, const uint64_t seed);
+
+// Emit callback used to compile a map, records the outcome
+void frame_simulator_probe_emit(const uint64_t index, const double prob, void* ctx);
+
+// Passes a single local string through a gate, returns 0 if there was a single outcome with a probability of one
+int32_t frame_simulator_probe(const gate* g, const uint64_t index, const unsigned* local_targets, uint64_t* outcome);
+
+// Pool task, runs the circuit on a range of blocks
+void frame_simulator_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker);
+
+// The lanes of a single bit of the local table index of a gate, see frame_simulator_map_t
+uint64_t* frame_simulator_lanes(pauli_frames* frames, const uint64_t block, const unsigned* target_qubits, const uint32_t n_targets, const uint32_t bit);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * pauli_frames_create
+ * Allocates a batch of frames, every frame starts as the identity
+ * :: const uint32_t n_qubits :: The number of qubits covered by each frame
+ * :: const uint64_t n_shots :: The number of shots, this is rounded up to a whole number of blocks
+ * Returns a heap pointer to the new frames
+ */
+pauli_frames* pauli_frames_create(const uint32_t n_qubits, const uint64_t n_shots)
+{
+	pauli_frames* frames = (pauli_frames*)malloc(sizeof(pauli_frames));
+	frames->n_qubits = n_qubits;
+	frames->n_blocks = (n_shots + FRAME_SIMULATOR_SHOTS_PER_BLOCK - 1) / FRAME_SIMULATOR_SHOTS_PER_BLOCK;
+	frames->n_shots = frames->n_blocks * FRAME_SIMULATOR_SHOTS_PER_BLOCK;
+
+	uint64_t n_words = frames->n_blocks * n_qubits * FRAME_SIMULATOR_LANES;
+	frames->x = (uint64_t*)calloc(n_words, sizeof(uint64_t));
+	frames->z = (uint64_t*)calloc(n_words, sizeof(uint64_t));
+	return frames;
+}
+
+/*
+ * pauli_frames_get
+ * Copies the frame of a single shot to a sym object
+ * :: const pauli_frames* frames :: The frames
+ * :: const uint64_t shot :: The shot
+ * :: sym* out :: Height one sym object, its length sets the number of qubits copied starting from the first
+ * Returns nothing
+ */
+void pauli_frames_get(const pauli_frames* frames, const uint64_t shot, sym* out)
+{
+	uint32_t n_qubits = out->length / 2;
+	uint64_t block = shot / FRAME_SIMULATOR_SHOTS_PER_BLOCK;
+	uint64_t lane = (shot / 64) % FRAME_SIMULATOR_LANES;
+	uint64_t bit = shot % 64;
+
+	for (uint32_t q = 0; q < n_qubits; q++)
+	{
+		uint64_t word = (block * frames->n_qubits + q) * FRAME_SIMULATOR_LANES + lane;
+		sym_set(out, 0, q, (frames->x[word] >> bit) & 1);
+		sym_set(out, 0, q + n_qubits, (frames->z[word] >> bit) & 1);
+	}
+	return;
+}
+
+/*
+ * pauli_frames_index
+ * The table index of the frame of a single shot, as sym_to_ll, so frames may be compared with tables
+ * :: const pauli_frames* frames :: The frames, these should cover at most 32 qubits
+ * :: const uint64_t shot :: The shot
+ * Returns the table index
+ */
+uint64_t pauli_frames_index(const pauli_frames* frames, const uint64_t shot)
+{
+	uint64_t block = shot / FRAME_SIMULATOR_SHOTS_PER_BLOCK;
+	uint64_t lane = (shot / 64) % FRAME_SIMULATOR_LANES;
+	uint64_t bit = shot % 64;
+
+	uint64_t index = 0;
+	for (uint32_t q = 0; q < frames->n_qubits; q++)
+	{
+		uint64_t word = (block * frames->n_qubits + q) * FRAME_SIMULATOR_LANES + lane;
+		if ((frames->x[word] >> bit) & 1)
+		{
+			index |= gate_emit_X_bit(frames->n_qubits, q);
+		}
+		if ((frames->z[word] >> bit) & 1)
+		{
+			index |= gate_emit_Z_bit(frames->n_qubits, q);
+		}
+	}
+	return index;
+}
+
+/*
+ * pauli_frames_decode
+ * Decodes the frame of every shot and counts the logical error left behind, as characterise_code does for each physical error
+ * The code covers the first code->length / 2 qubits of the frames, any further qubits are ignored
+ * :: const pauli_frames* frames :: The frames
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * Returns a heap array of counts indexed by sym_to_ll of the logical error, the first entry counts the shots without a logical error
+ */
+uint64_t* pauli_frames_decode(const pauli_frames* frames, const sym* code, const sym* logicals, decoder* decoding_operation)
+{
+	uint64_t* counts = (uint64_t*)calloc(1ull << logicals->length, sizeof(uint64_t));
+	sym* physical_error = sym_create(1, code->length);
+
+	for (uint64_t shot = 0; shot < frames->n_shots; shot++)
+	{
+		pauli_frames_get(frames, shot, physical_error);
+		counts[pauli_frames_logical_error(code, logicals, decoding_operation, physical_error)]++;
+	}
+
+	sym_free(physical_error);
+	return counts;
+}
+
+/*
+ * pauli_frames_logical_error
+ * Decodes a single physical error and finds the logical error left behind, as characterise_code does
+ * :: const sym* code :: The stabiliser code
+ * :: const sym* logicals :: The logical operators
+ * :: decoder* decoding_operation :: The decoder, a syndrome without an entry is left uncorrected
+ * :: const sym* physical_error :: Height one sym object covering the code qubits
+ * Returns the sym_to_ll value of the logical error
+ */
+uint64_t pauli_frames_logical_error(const sym* code, const sym* logicals, decoder* decoding_operation, const sym* physical_error)
+{
+	sym* syndrome = sym_syndrome(code, physical_error);
+	sym* recovery = decoder_call(decoding_operation, syndrome);
+	sym* corrected = (NULL != recovery) ? sym_add(recovery, physical_error) : sym_copy(physical_error);
+	sym* logical_state = logical_error(logicals, corrected);
+
+	uint64_t logical_index = sym_to_ll(logical_state);
+
+	sym_free(logical_state);
+	sym_free(corrected);
+	if (NULL != recovery)
+	{
+		sym_free(recovery);
+	}
+	sym_free(syndrome);
+	return logical_index;
+}
+
+/*
+ * pauli_frames_free
+ * Frees a batch of frames
+ * :: pauli_frames* frames :: The frames
+ * Returns nothing
+ */
+void pauli_frames_free(pauli_frames* frames)
+{
+	free(frames->x);
+	free(frames->z);
+	free(frames);
+	return;
+}
+
+/*
+ * frame_simulator_map_create
+ * Compiles the operation of a gate into an affine map
+ * :: const gate* g :: The gate, a gate without an operation gives the identity map
+ * :: frame_simulator_map_t* map :: Written with the map
+ * Returns 0 on success, or -1 if the operation of the gate is not a deterministic affine map
+ */
+int32_t frame_simulator_map_create(const gate* g, frame_simulator_map_t* map)
+{
+	if (g->n_qubits > FRAME_SIMULATOR_MAX_GATE_QUBITS)
+	{
+		printf("Gate is too large for the frame simulator!\n");
+		return -1;
+	}
+
+	map->n_bits = 2 * g->n_qubits;
+	map->identity = 1;
+	map->offset = 0;
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		map->columns[j] = 1ull << j;
+	}
+
+	// Noise only gates
+	if (NULL == g->operation)
+	{
+		return 0;
+	}
+
+	unsigned local_targets[FRAME_SIMULATOR_MAX_GATE_QUBITS];
+	for (uint32_t i = 0; i < g->n_qubits; i++)
+	{
+		local_targets[i] = i;
+	}
+
+	// The image of the identity, then of each single bit
+	int32_t failed = frame_simulator_probe(g, 0, local_targets, &map->offset);
+	for (uint32_t j = 0; j < map->n_bits && !failed; j++)
+	{
+		failed = frame_simulator_probe(g, 1ull << j, local_targets, map->columns + j);
+		map->columns[j] ^= map->offset;
+	}
+
+	// Small gates are checked against every string, so gates that are not affine are caught
+	if (!failed && g->n_qubits <= FRAME_SIMULATOR_MAX_CHECKED_QUBITS)
+	{
+		for (uint64_t index = 0; index < (1ull << map->n_bits) && !failed; index++)
+		{
+			uint64_t expected = map->offset;
+			for (uint32_t j = 0; j < map->n_bits; j++)
+			{
+				if ((index >> j) & 1)
+				{
+					expected ^= map->columns[j];
+				}
+			}
+
+			uint64_t outcome = 0;
+			failed = frame_simulator_probe(g, index, local_targets, &outcome) || (outcome != expected);
+		}
+	}
+
+	if (failed)
+	{
+		printf("Gate operation is not a deterministic affine map, it cannot be run by the frame simulator!\n");
+		return -1;
+	}
+
+	map->identity = (0 == map->offset);
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		map->identity &= (map->columns[j] == (1ull << j));
+	}
+	return 0;
+}
+
+/*
+ * frame_simulator_map_apply
+ * Applies a map to the frames of every shot in a block
+ * :: pauli_frames* frames :: The frames
+ * :: const uint64_t block :: The block
+ * :: const frame_simulator_map_t* map :: The map
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns nothing
+ */
+void frame_simulator_map_apply(pauli_frames* frames, const uint64_t block, const frame_simulator_map_t* map, const unsigned* target_qubits)
+{
+	if (map->identity)
+	{
+		return;
+	}
+
+	uint32_t n_targets = map->n_bits / 2;
+	uint64_t bits_in[2 * FRAME_SIMULATOR_MAX_GATE_QUBITS][FRAME_SIMULATOR_LANES];
+	uint64_t bits_out[2 * FRAME_SIMULATOR_MAX_GATE_QUBITS][FRAME_SIMULATOR_LANES];
+
+	// Gather every bit of the targets, then each output bit is the offset and a sum of input bits
+	for (uint32_t j = 0; j < map->n_bits; j++)
+	{
+		uint64_t* lanes = frame_simulator_lanes(frames, block, target_qubits, n_targets, j);
+		for (uint32_t l = 0; l < FRAME_SIMULATOR_LANES; l++)
+		{
+			bits_in[j][l] = lanes[l];
+		}
+	}
+
+	for (uint32_t o = 0; o < map->n_bits; o++)
+	{
+		uint64_t offset = ((map->offset >> o) & 1) ? ~0ull : 0;
+		for (uint32_t l = 0; l < FRAME_SIMULATOR_LANES; l++)
+		{
+			bits_out[o][l] = offset;
+		}
+
+		for (uint32_t j = 0; j < map->n_bits; j++)
+		{
+			if ((map->columns[j] >> o) & 1)
+			{
+				for (uint32_t l = 0; l < FRAME_SIMULATOR_LANES; l++)
+				{
+					bits_out[o][l] ^= bits_in[j][l];
+				}
+			}
+		}
+	}
+
+	for (uint32_t o = 0; o < map->n_bits; o++)
+	{
+		uint64_t* lanes = frame_simulator_lanes(frames, block, target_qubits, n_targets, o);
+		for (uint32_t l = 0; l < FRAME_SIMULATOR_LANES; l++)
+		{
+			lanes[l] = bits_out[o][l];
+		}
+	}
+	return;
+}
+
+/*
+ * frame_simulator_inject
+ * Draws an error for every shot in a block and applies it to the frames
+ * :: pauli_frames* frames :: The frames
+ * :: const uint64_t block :: The block
+ * :: const error_model_sampler_t* sampler :: The sampler of the error model
+ * :: const unsigned* target_qubits :: The qubits the error acts on
+ * :: rng* r :: The random number generator
+ * Returns nothing
+ */
+void frame_simulator_inject(pauli_frames* frames, const uint64_t block, const error_model_sampler_t* sampler, const unsigned* target_qubits, rng* r)
+{
+	uint32_t n_targets = sampler->n_qubits;
+	uint64_t* x = frames->x + block * frames->n_qubits * FRAME_SIMULATOR_LANES;
+	uint64_t* z = frames->z + block * frames->n_qubits * FRAME_SIMULATOR_LANES;
+
+	// Factorised samplers draw each target alone, the others draw every target together
+	uint32_t n_tables = sampler->factorised ? n_targets : 1;
+	for (uint32_t t = 0; t < n_tables; t++)
+	{
+		if (0 == sampler->p_error[t])
+		{
+			continue;
+		}
+
+		// Only the shots that draw an error are visited, each flips its bit in the lane words of the targets
+		double log_failure = log1p(-sampler->p_error[t]);
+		uint64_t shot = rng_geometric(r, log_failure);
+		while (shot < FRAME_SIMULATOR_SHOTS_PER_BLOCK)
+		{
+			uint64_t error = alias_table_sample(sampler->errors[t], r) + 1;
+			uint32_t lane = shot / 64;
+			uint64_t bit = 1ull << (shot % 64);
+			if (sampler->factorised)
+			{
+				x[target_qubits[t] * FRAME_SIMULATOR_LANES + lane] ^= (error >> 1) ? bit : 0;
+				z[target_qubits[t] * FRAME_SIMULATOR_LANES + lane] ^= (error & 1) ? bit : 0;
+			}
+			else
+			{
+				// Unpacked in the same order as sym_to_ll
+				for (uint32_t i = 0; i < n_targets; i++)
+				{
+					x[target_qubits[i] * FRAME_SIMULATOR_LANES + lane] ^= ((error >> (2 * n_targets - 1 - i)) & 1) ? bit : 0;
+					z[target_qubits[i] * FRAME_SIMULATOR_LANES + lane] ^= ((error >> (n_targets - 1 - i)) & 1) ? bit : 0;
+				}
+			}
+
+			uint64_t skip = rng_geometric(r, log_failure);
+			shot = (skip < FRAME_SIMULATOR_SHOTS_PER_BLOCK) ? shot + 1 + skip : FRAME_SIMULATOR_SHOTS_PER_BLOCK;
+		}
+	}
+	return;
+}
+
+/*
+ * circuit_run_frames
+ * Samples the errors of a circuit, following the same schedule as circuit_run_default
+ * Only the gates of the circuit are run, circuits that replace their circuit_operation are not supported
+ * Every frame starts as the identity, each block of shots has its own generator, see rng_create_stream,
+ * so the result does not depend on the number of threads
+ * :: circuit* c :: The circuit to be run
+ * :: gate* noise :: The environmental noise, this should act on a single qubit, or NULL
+ * :: const uint64_t n_shots :: The number of shots, this is rounded up to a whole number of blocks
+ * :: const uint64_t seed :: Seed for the generators
+ * Returns a heap pointer to the frames, or NULL if a gate could not be compiled or its error model could not be sampled
+ */
+pauli_frames* circuit_run_frames(circuit* c, gate* noise, const uint64_t n_shots, const uint64_t seed)
+{
+	// Noise should act on a single qubit
+	if (NULL != noise && noise->n_qubits != 1)
+	{
+		printf("Noise should act on a single qubit!\n");
+		return NULL;
+	}
+
+	frame_simulator_task_t task_data;
+	task_data.c = c;
+	task_data.noise = noise;
+	task_data.noise_sampler = NULL;
+	task_data.seed = seed;
+	task_data.maps = (frame_simulator_map_t*)malloc(sizeof(frame_simulator_map_t) * c->n_gates);
+	task_data.samplers = (error_model_sampler_t**)calloc(c->n_gates, sizeof(error_model_sampler_t*));
+
+	// Each gate is compiled once, gates that share an error model and size share a sampler
+	// Samplers are built here so the workers only ever read them
+	uint8_t* owns_sampler = (uint8_t*)calloc(c->n_gates, sizeof(uint8_t));
+	int32_t failed = 0;
+	uint32_t idx = 0;
+	for (circuit_element* ce = c->start; NULL != ce && !failed; ce = ce->next, idx++)
+	{
+		gate* g = ce->gate_operation;
+		failed = frame_simulator_map_create(g, task_data.maps + idx);
+		if (failed || NULL == g->gate_error_model)
+		{
+			continue;
+		}
+
+		uint32_t prev = 0;
+		for (circuit_element* pe = c->start; prev < idx; pe = pe->next, prev++)
+		{
+			if (pe->gate_operation->gate_error_model == g->gate_error_model && pe->gate_operation->n_qubits == g->n_qubits)
+			{
+				task_data.samplers[idx] = task_data.samplers[prev];
+				break;
+			}
+		}
+
+		if (NULL == task_data.samplers[idx])
+		{
+			task_data.samplers[idx] = error_model_sampler_create(g->gate_error_model, g->n_qubits);
+			owns_sampler[idx] = 1;
+			failed = (NULL == task_data.samplers[idx]);
+		}
+	}
+
+	if (!failed && NULL != noise)
+	{
+		failed = frame_simulator_map_create(noise, &task_data.noise_map);
+		if (!failed && NULL != noise->gate_error_model)
+		{
+			task_data.noise_sampler = error_model_sampler_create(noise->gate_error_model, 1);
+			failed = (NULL == task_data.noise_sampler);
+		}
+	}
+
+	pauli_frames* frames = NULL;
+	if (!failed)
+	{
+		frames = pauli_frames_create(c->n_qubits, n_shots);
+		task_data.frames = frames;
+		thread_pool_parallel_for(thread_pool_default(), frames->n_blocks, frame_simulator_task, &task_data);
+	}
+
+	for (uint32_t i = 0; i < c->n_gates; i++)
+	{
+		if (owns_sampler[i] && NULL != task_data.samplers[i])
+		{
+			error_model_sampler_free(task_data.samplers[i]);
+		}
+	}
+	if (NULL != task_data.noise_sampler)
+	{
+		error_model_sampler_free(task_data.noise_sampler);
+	}
+	free(owns_sampler);
+	free(task_data.samplers);
+	free(task_data.maps);
+	return frames;
+}
+
+// Emit callback used to compile a map, records the outcome
+void frame_simulator_probe_emit(const uint64_t index, const double prob, void* ctx)
+{
+	frame_simulator_probe_t* probe = (frame_simulator_probe_t*)ctx;
+	probe->index = index;
+	probe->n_outcomes++;
+	probe->deterministic &= (1 == prob);
+	return;
+}
+
+// Passes a single local string through a gate, returns 0 if there was a single outcome with a probability of one
+int32_t frame_simulator_probe(const gate* g, const uint64_t index, const unsigned* local_targets, uint64_t* outcome)
+{
+	frame_simulator_probe_t probe = {0, 0, 1};
+	gate_emit(g, index, g->n_qubits, local_targets, frame_simulator_probe_emit, &probe);
+	*outcome = probe.index;
+	return (1 == probe.n_outcomes && probe.deterministic) ? 0 : -1;
+}
+
+// Pool task, runs the circuit on a range of blocks
+void frame_simulator_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker)
+{
+	frame_simulator_task_t* task_data = (frame_simulator_task_t*)data;
+	circuit* c = task_data->c;
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * c->n_qubits);
+
+	// Each block runs the whole circuit, so its frames stay in cache
+	for (uint64_t block = block_start; block < block_end; block++)
+	{
+		rng r = rng_create_stream(task_data->seed, block);
+
+		uint32_t idx = 0;
+		for (circuit_element* ce = c->start; NULL != ce; ce = ce->next, idx++)
+		{
+			// Gate operation, then its noise
+			frame_simulator_map_apply(task_data->frames, block, task_data->maps + idx, ce->target_qubits);
+			if (NULL != task_data->samplers[idx])
+			{
+				frame_simulator_inject(task_data->frames, block, task_data->samplers[idx], ce->target_qubits, &r);
+			}
+
+			// Environmental Noise operations, applied to every qubit that doesn't participate in the gate
+			if (NULL != task_data->noise)
+			{
+				memset(busy, 0, sizeof(uint8_t) * c->n_qubits);
+				for (uint32_t j = 0; j < ce->gate_operation->n_qubits; j++)
+				{
+					busy[ce->target_qubits[j]] = 1;
+				}
+				for (unsigned i = 0; i < c->n_qubits; i++)
+				{
+					if (!busy[i])
+					{
+						frame_simulator_map_apply(task_data->frames, block, &task_data->noise_map, &i);
+						if (NULL != task_data->noise_sampler)
+						{
+							frame_simulator_inject(task_data->frames, block, task_data->noise_sampler, &i, &r);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	free(busy);
+	return;
+}
+
+// The lanes of a single bit of the local table index of a gate, see frame_simulator_map_t
+uint64_t* frame_simulator_lanes(pauli_frames* frames, const uint64_t block, const unsigned* target_qubits, const uint32_t n_targets, const uint32_t bit)
+{
+	// As gate_emit_X_bit and gate_emit_Z_bit, the Z bits of the targets sit below their X bits in reverse order
+	uint64_t* bits = (bit < n_targets) ? frames->z : frames->x;
+	uint32_t local = (bit < n_targets) ? n_targets - 1 - bit : 2 * n_targets - 1 - bit;
+	return bits + (block * frames->n_qubits + target_qubits[local]) * FRAME_SIMULATOR_LANES;
+}
+
+#endif
@@ -53,13 +53,13 @@ circuit* circuit_recovery_create(
  *  circuit_recovery_run:
  *  Runs the recovery circuit, this should be referenced by the circuit.circuit_operation struct member of the circuit struct
  *  :: circuit* recovery :: The circuit object
- *  :: double* initial_error_rates ::  The initial error probabilities associated with each pauli string
+ *  :: error_probability_t* initial_error_rates ::  The initial error probabilities associated with each pauli string
  *  :: gate* noise :: Noise operation acting on the wires in the circuit
  *  Returns a heap pointer to the new matrix
  */
-double* circuit_recovery_run(
+error_probability_t* circuit_recovery_run(
 	circuit* recovery, 
-	double* initial_error_rates, 
+	error_probability_t* initial_error_rates, 
 	gate* noise);
 
 /* 
@@ -128,90 +128,83 @@ circuit* circuit_recovery_create(
  *  circuit_recovery_run:
  *  Runs the recovery circuit, this should be referenced by the circuit.circuit_operation struct member of the circuit struct
  *  :: circuit* recovery :: The circuit object
- *  :: double* initial_error_rates ::  The initial error probabilities associated with each pauli string
+ *  :: error_probability_t* initial_error_rates ::  The initial error probabilities associated with each pauli string
  *  :: gate* noise :: Noise operation acting on the wires in the circuit
  *  Returns a heap pointer to the new matrix
  */
-double* circuit_recovery_run(
+error_probability_t* circuit_recovery_run(
 	circuit* recovery, 
-	double* initial_error_rates, 
+	error_probability_t* initial_error_rates, 
 	gate* noise)
 {
 	circuit_recovery_data_t* rd = (circuit_recovery_data_t*)recovery->circuit_data;
+	uint32_t n_qubits = rd->n_code_qubits + rd->n_ancilla_qubits;
 
-	// Final error rates
-	double* recovered_error_rates = error_probabilities_zeros(rd->n_code_qubits);
+	// The table over the code qubits for each syndrome, in a single pass over the initial table
+	// Syndromes are indexed as by sym_to_ll on the measurement outcome
+	uint64_t n_code_entries = error_probabilities_entries_in_table(rd->n_code_qubits);
+	double* syndrome_tables = gate_measure_marginals(initial_error_rates, n_qubits, rd->measure, rd->measurement_targets);
 
-	// For stripping the ancilla qubits
-	sym_iter* target_buffer = sym_iter_create_n_qubits(rd->n_code_qubits);
+	// Final error rates, many strings land on each entry so they are summed in double precision
+	double* recovered_sums = (double*)calloc(n_code_entries, sizeof(double));
+	sym* syndrome = sym_create(rd->n_ancilla_qubits, 1);
 
-	// Iterate over the set of states
-	sym_iter* siter = sym_iter_create_n_qubits(rd->n_code_qubits + rd->n_ancilla_qubits);
-	while (sym_iter_next(siter))
-	{	
-		if (initial_error_rates[sym_iter_ll_from_state(siter)] > 0)
+	for (uint64_t syndrome_index = 0; syndrome_index < (1ull << rd->n_ancilla_qubits); syndrome_index++)
+	{
+		// The decoder is only called for syndromes that turn up
+		double* syndrome_table = syndrome_tables + syndrome_index * n_code_entries;
+		uint64_t first = 0;
+		while (first < n_code_entries && 0 == syndrome_table[first])
 		{
+			first++;
+		}
+		if (first == n_code_entries)
+		{
+			continue;
+		}
 
-			// Measure the syndrome bits
-			gate_result* syndrome_results = gate_operation(rd->measure, siter->state, rd->measurement_targets);
-			sym* syndrome = sym_copy(syndrome_results->state_results[0]);
-			gate_result_free(syndrome_results);
-
-
-			// Transpose the syndrome for easier reading
-			sym* syndrome_trans = sym_transpose(syndrome);
-			sym_free(syndrome);
-		
-			// Decode to determine the recovery operation required
-			sym* recovery_operator = decoder_call(rd->decoder_operation, syndrome_trans);
-
-			if (NULL == recovery_operator) // Decoder table has no entry for this syndrome
-			{ // Give a blank recovery operation
-				recovery_operator = sym_create(1, rd->n_code_qubits * 2);
-			}
-
-			sym_free(syndrome_trans);
+		// The syndrome is read as a column
+		for (uint32_t i = 0; i < rd->n_ancilla_qubits; i++)
+		{
+			sym_set(syndrome, i, 0, (syndrome_index >> (rd->n_ancilla_qubits - 1 - i)) & 1);
+		}
 
-			// Recover the state
-			sym* recovered_state = sym_copy(siter->state);
+		// Decode to determine the recovery operation required, a syndrome without an entry is left alone
+		// The pauli gates flip fixed bits of the index, so the recovery moves every string by the image of the identity
+		uint64_t recovery_index = 0;
+		sym* recovery_operator = decoder_call(rd->decoder_operation, syndrome);
+		if (NULL != recovery_operator)
+		{
 			for (uint32_t i = 0; i < recovery_operator->n_qubits; i++)
 			{
 				// Apply Z operations where required
 				if (sym_get_X(recovery_operator, 0, i))
 				{
-					gate_result* applied_result = gate_operation(rd->pauli_Z, recovered_state, &i);
-					sym_free(recovered_state);
-					recovered_state = sym_copy(applied_result->state_results[0]);
-					gate_result_free(applied_result);
+					gate_emit(rd->pauli_Z, recovery_index, rd->n_code_qubits, &i, gate_emit_single, &recovery_index);
 				}
 				// And apply X operations where required
 				if (sym_get_Z(recovery_operator, 0, i))
 				{
-					gate_result* applied_result = gate_operation(rd->pauli_X, recovered_state, &i);
-					sym_free(recovered_state);
-					recovered_state = sym_copy(applied_result->state_results[0]);
-					gate_result_free(applied_result);
+					gate_emit(rd->pauli_X, recovery_index, rd->n_code_qubits, &i, gate_emit_single, &recovery_index);
 				}
 			}
 			sym_free(recovery_operator);
+		}
 
-
-			// Copy the state to the target buffer
-			// TODO: use the pauli gates to do this
-			for (uint32_t i = 0; i < rd->n_code_qubits; i++)
-			{ // All other values in the target buffer should be zero
-				sym_set_X(target_buffer->state, 0, i, sym_get_X(recovered_state, 0, i)); // X elements
-				sym_set_Z(target_buffer->state, 0, i, sym_get_Z(recovered_state, 0, i)); // Z elements 
-			} 
-			sym_free(recovered_state);
-			sym_iter_update(target_buffer);
-			
-			// Set the value in the new buffer
-			recovered_error_rates[sym_iter_ll_from_state(target_buffer)] += initial_error_rates[sym_iter_ll_from_state(siter)];
+		for (uint64_t i = first; i < n_code_entries; i++)
+		{
+			recovered_sums[i ^ recovery_index] += syndrome_table[i];
 		}
 	}
-	sym_iter_free(siter);
-	sym_iter_free(target_buffer);
+	sym_free(syndrome);
+	free(syndrome_tables);
+
+	error_probability_t* recovered_error_rates = error_probabilities_zeros(rd->n_code_qubits);
+	for (uint64_t i = 0; i < n_code_entries; i++)
+	{
+		recovered_error_rates[i] = recovered_sums[i];
+	}
+	free(recovered_sums);
 	return recovered_error_rates;
 }
 
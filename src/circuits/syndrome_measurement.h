@@ -39,13 +39,13 @@ void syndrome_measurement_circuit_construct(
  * circuit_syndrome_measurement_run
  * 
  * :: circuit* recovery ::
- * :: double* initial_error_rates ::
+ * :: error_probability_t* initial_error_rates ::
  * :: gate* noise :: 
  * 
  */
-double* circuit_syndrome_measurement_run(
+error_probability_t* circuit_syndrome_measurement_run(
 	circuit* recovery, 
-	double* initial_error_rates, 
+	error_probability_t* initial_error_rates, 
 	gate* noise);
 
 // ----------------------------------------------------------------------------------------
@@ -158,47 +158,23 @@ void syndrome_measurement_circuit_construct(
  * circuit_syndrome_measurement_run
  * 
  * :: circuit* recovery ::
- * :: double* initial_error_rates ::
+ * :: error_probability_t* initial_error_rates ::
  * :: gate* noise :: 
  * 
  */
-double* circuit_syndrome_measurement_run(
+error_probability_t* circuit_syndrome_measurement_run(
 	circuit* recovery, 
-	double* initial_error_rates, 
+	error_probability_t* initial_error_rates, 
 	gate* noise)
 {
 	// Unpack the syndrome measurement data
 	circuit_syndrome_measurement_data_t* smd = (circuit_syndrome_measurement_data_t*)recovery->circuit_data;
 
-	// Setup the larger state space
-	double* expanded_error_probs = error_probabilities_zeros(smd->n_ancilla_qubits + smd->n_code_qubits);
-
-	// Copy the errors from the initial buffer to our larger buffer
-	sym_iter* cpy_iter = sym_iter_create_n_qubits(smd->n_code_qubits);
-	sym_iter* target_buffer = sym_iter_create_n_qubits(smd->n_ancilla_qubits + smd->n_code_qubits);
-	while (sym_iter_next(cpy_iter))
-	{
-		if (initial_error_rates[sym_iter_ll_from_state(cpy_iter)] > 0)
-		{
-			// Copy the state to the target buffer
-			for (uint32_t i = 0; i < smd->n_code_qubits; i++)
-			{ // All other values in the target buffer should be zero
-				sym_set(target_buffer->state, 0, i, sym_get(cpy_iter->state, 0, i)); // X elements
- 				sym_set(target_buffer->state, 0, i + target_buffer->state->n_qubits, sym_get(cpy_iter->state, 0, i + cpy_iter->state->n_qubits)); // Z elements
-			} 
-			
-			// Update the other values in the buffer
-			sym_iter_update(target_buffer);
-			
-			// Set the value in the new buffer
-			expanded_error_probs[sym_iter_ll_from_state(target_buffer)] += initial_error_rates[sym_iter_ll_from_state(cpy_iter)];
-		}
-	}
-	sym_iter_free(target_buffer);
-	sym_iter_free(cpy_iter);
+	// Setup the larger state space, the ancillas follow the code qubits
+	error_probability_t* expanded_error_probs = error_probabilities_step_up(initial_error_rates, smd->n_code_qubits, smd->n_code_qubits + smd->n_ancilla_qubits);
 
 	// Iterate over the gates in the circuit
-	double* output_error_rates = circuit_run_default(recovery, expanded_error_probs, noise);
+	error_probability_t* output_error_rates = circuit_run_default(recovery, expanded_error_probs, noise);
 
 	// Cleanup anything that needs to be de-allocated
 	error_probabilities_free(expanded_error_probs);
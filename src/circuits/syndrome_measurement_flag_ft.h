@@ -70,13 +70,13 @@ void syndrome_measurement_flag_ft_circuit_construct(
  * circuit_syndrome_measurement_run
  * Runs the syndrome measurement circuit, this should overload the circuit.circuit_operation member
  * :: circuit* syndrome_measurement ::
- * :: double* initial_error_rates ::
+ * :: error_probability_t* initial_error_rates ::
  * :: gate* noise :: 
  * Returns the probabilities associated with each output state
  */
-double* circuit_syndrome_measurement_flag_ft_run(
+error_probability_t* circuit_syndrome_measurement_flag_ft_run(
     circuit* syndrome_measurement, 
-    double* initial_error_rates, 
+    error_probability_t* initial_error_rates, 
     gate* noise);
 
 /*
@@ -422,35 +422,37 @@ void syndrome_measurement_flag_ft_circuit_construct(
  * circuit_syndrome_measurement_run
  * 
  * :: circuit* syndrome_measurement ::
- * :: double* initial_error_rates ::
+ * :: error_probability_t* initial_error_rates ::
  * :: gate* noise :: 
  * 
  */
-double* circuit_syndrome_measurement_flag_ft_run(
+error_probability_t* circuit_syndrome_measurement_flag_ft_run(
     circuit* syndrome_measurement, 
-    double* initial_error_rates, 
+    error_probability_t* initial_error_rates, 
     gate* noise)
 {
     // Unpack the syndrome measurement data
     circuit_syndrome_measurement_flag_ft_data_t* smd = (circuit_syndrome_measurement_flag_ft_data_t*)syndrome_measurement->circuit_data;
 
     // Setup the larger state space
-    double* syndrome_error_probs = error_probabilities_step_up(initial_error_rates, smd->n_code_qubits, smd->n_code_qubits + smd->n_ancilla_qubits);
+    error_probability_t* syndrome_error_probs = error_probabilities_step_up(initial_error_rates, smd->n_code_qubits, smd->n_code_qubits + smd->n_ancilla_qubits);
 
     unsigned long n_bytes_code = error_probabilities_bytes_in_table(smd->n_code_qubits);
     unsigned long n_bytes_ancilla = error_probabilities_bytes_in_table(smd->n_code_qubits + smd->n_ancilla_qubits);
     unsigned long n_bytes_ft = error_probabilities_bytes_in_table(smd->n_code_qubits + smd->n_ancilla_qubits + smd->n_flag_qubits);
 
+    // Each gate updates the expanded table in place or swaps it with the scratch table, rather than allocating
+    error_probability_t* scratch = error_probabilities_zeros(smd->n_code_qubits + smd->n_ancilla_qubits + smd->n_flag_qubits);
+
     // Run the sub-circuits
     // These let us track the "active" ancilla qubit while leaving the others untouched
     for (uint32_t i = 0; i < smd->n_ancilla_qubits; i++)
     {
-        circuit* c = smd->sub_circuits[i];
-        circuit_element* ce = c->start;
+        circuit_compiled* cc = circuit_compile(smd->sub_circuits[i]);
         uint32_t active_ancilla = i + smd->n_code_qubits;
 
         // Copy the errors from the initial buffer to our larger buffer
-        double* expanded_error_probs = error_probabilities_step_up(
+        error_probability_t* expanded_error_probs = error_probabilities_step_up(
             syndrome_error_probs, 
             smd->n_code_qubits + smd->n_ancilla_qubits, 
             smd->n_code_qubits + smd->n_ancilla_qubits + smd->n_flag_qubits);
@@ -460,35 +462,29 @@ double* circuit_syndrome_measurement_flag_ft_run(
         #ifdef CIRCUIT_SYNDROME_MEASUREMENT_FLAG_FT_CIRCUIT_PRINT_PROGRESS 
             char progress_bar_name[32]; // Holding our string
             sprintf( progress_bar_name, "Sub-Circuit %d", i);
-            progress_bar* ce_progress_bar = progress_bar_create(c->n_gates, progress_bar_name);
+            progress_bar* ce_progress_bar = progress_bar_create(cc->n_gates, progress_bar_name);
         #endif
 
         // Apply the operations on the measurement sub circuit
-        while (NULL != ce)
+        for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
         {
-            // Gate operation
-            double* tmp_error_rate = gate_apply(
-                c->n_qubits,
-                expanded_error_probs,
-                ce->gate_operation,
-                ce->target_qubits);
+            gate* g = cc->gates[gate_idx];
+            const unsigned* targets = circuit_compiled_targets(cc, gate_idx);
 
-            error_probabilities_free(expanded_error_probs);
-            expanded_error_probs = tmp_error_rate;
+            // Gate operation
+            gate_apply_buffers(cc->n_qubits, &expanded_error_probs, &scratch, g, targets);
 
             // Environmental Noise operations on code block qubits
             if (noise != NULL)
             {
                 for (unsigned j = 0; j < smd->n_code_qubits; j++)
                 {
-                    for (uint32_t k = 0; k < ce->gate_operation->n_qubits; k++)
+                    for (uint32_t k = 0; k < g->n_qubits; k++)
                     {   
                         // No Noise on inactive ancillas!
-                        if (j != ce->target_qubits[k])
+                        if (j != targets[k])
                         {
-                            double* tmp_error_rate = gate_apply(c->n_qubits, expanded_error_probs, noise, &j);
-                            error_probabilities_free(expanded_error_probs);
-                            expanded_error_probs = tmp_error_rate;
+                            gate_apply_buffers(cc->n_qubits, &expanded_error_probs, &scratch, noise, &j);
                         }
                     }
                 }
@@ -499,9 +495,9 @@ double* circuit_syndrome_measurement_flag_ft_run(
                     // Environmental Noise operations on ancilla qubits
                     // No noise on the inactive ancillas!
                     uint8_t ancilla_used = false;
-                    for (uint32_t k = 0; k < ce->gate_operation->n_qubits; k++)
+                    for (uint32_t k = 0; k < g->n_qubits; k++)
                     {   
-                        if (active_ancilla != ce->target_qubits[k])
+                        if (active_ancilla != targets[k])
                         {
                             ancilla_used = true;
                         }
@@ -509,15 +505,11 @@ double* circuit_syndrome_measurement_flag_ft_run(
 
                     if (false == ancilla_used)
                     {
-                        double* tmp_error_rate = gate_apply(c->n_qubits, expanded_error_probs, noise, &active_ancilla);
-                        error_probabilities_free(expanded_error_probs);
-                        expanded_error_probs = tmp_error_rate;
+                        gate_apply_buffers(cc->n_qubits, &expanded_error_probs, &scratch, noise, &active_ancilla);
                     }           
                 }
             }
 
-            // Next circuit element
-            ce = ce->next;
             #ifdef CIRCUIT_SYNDROME_MEASUREMENT_FLAG_FT_CIRCUIT_PRINT_PROGRESS
                 progress_bar_update(ce_progress_bar);
             #endif
@@ -526,6 +518,7 @@ double* circuit_syndrome_measurement_flag_ft_run(
         #ifdef CIRCUIT_SYNDROME_MEASUREMENT_FLAG_FT_CIRCUIT_PRINT_PROGRESS
             progress_bar_free(ce_progress_bar);
         #endif
+        circuit_compiled_free(cc);
 
         // Apply FT correction circuit
         if (i != smd->n_ancilla_qubits) // We don't do any flag FT correction on the cleanup sub-circuit
@@ -535,8 +528,10 @@ double* circuit_syndrome_measurement_flag_ft_run(
         }
     }
 
+    free(scratch);
+
     // Apply the final cleanup circuit
-    double* tmp = circuit_run(smd->sub_circuits[smd->n_ancilla_qubits], syndrome_error_probs, noise);
+    error_probability_t* tmp = circuit_run(smd->sub_circuits[smd->n_ancilla_qubits], syndrome_error_probs, noise);
     free(syndrome_error_probs);
     syndrome_error_probs = tmp;
 
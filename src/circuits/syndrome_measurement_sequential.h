@@ -43,13 +43,13 @@ void syndrome_measurement_sequential_circuit_construct(
  * circuit_syndrome_measurement_run
  * 
  * :: circuit* syndrome_measurement ::
- * :: double* initial_error_rates ::
+ * :: error_probability_t* initial_error_rates ::
  * :: gate* noise :: 
  * 
  */
-double* circuit_syndrome_measurement_sequential_run(
+error_probability_t* circuit_syndrome_measurement_sequential_run(
     circuit* syndrome_measurement, 
-    double* initial_error_rates, 
+    error_probability_t* initial_error_rates, 
     gate* noise);
 
 // ----------------------------------------------------------------------------------------
@@ -106,8 +106,8 @@ void syndrome_measurement_sequential_circuit_construct(
     circuit_syndrome_measurement_sequential_data_t* circuit_data = (circuit_syndrome_measurement_sequential_data_t*) syndrome_measurement->circuit_data;
 
     // Keep track of the basis transforms on the qubits, starts in Z basis
-    uint8_t* x_basis = (uint8_t*)calloc(code->height, sizeof(uint8_t));
-    uint8_t* y_basis = (uint8_t*)calloc(code->height, sizeof(uint8_t));
+    uint8_t* x_basis = (uint8_t*)calloc(code->n_qubits, sizeof(uint8_t));
+    uint8_t* y_basis = (uint8_t*)calloc(code->n_qubits, sizeof(uint8_t));
 
     // Iterate through ancillas
     for (size_t j = 0; j < code->height; j++)
@@ -220,72 +220,50 @@ void syndrome_measurement_sequential_circuit_construct(
  * circuit_syndrome_measurement_run
  * 
  * :: circuit* syndrome_measurement ::
- * :: double* initial_error_rates ::
+ * :: error_probability_t* initial_error_rates ::
  * :: gate* noise :: 
  * 
  */
-double* circuit_syndrome_measurement_sequential_run(
+error_probability_t* circuit_syndrome_measurement_sequential_run(
     circuit* syndrome_measurement, 
-    double* initial_error_rates, 
+    error_probability_t* initial_error_rates, 
     gate* noise)
 {
     // Unpack the syndrome measurement data
     circuit_syndrome_measurement_sequential_data_t* smd = (circuit_syndrome_measurement_sequential_data_t*)syndrome_measurement->circuit_data;
 
-    // Setup the larger state space
-    double* expanded_error_probs = error_probabilities_zeros(smd->n_code_qubits + smd->n_ancilla_qubits);
+    // Setup the larger state space, the ancillas start with no error
+    error_probability_t* expanded_error_probs = error_probabilities_step_up(initial_error_rates, smd->n_code_qubits, smd->n_code_qubits + smd->n_ancilla_qubits);
 
-    // Copy the errors from the initial buffer to our larger buffer
-    sym_iter* cpy_iter = sym_iter_create_n_qubits(smd->n_code_qubits);
-    sym_iter* target_buffer = sym_iter_create_n_qubits(smd->n_code_qubits + 1);
-    while (sym_iter_next(cpy_iter))
-    {
-        if (initial_error_rates[sym_iter_ll_from_state(cpy_iter)] > 0)
-        {
-            // Copy the state to the target buffer
-            for (uint32_t i = 0; i < smd->n_code_qubits; i++)
-            { // All other values in the target buffer should be zero
-                sym_set(target_buffer->state, 0, i, sym_get(cpy_iter->state, 0, i)); // X elements
-                sym_set(target_buffer->state, 0, i + target_buffer->state->n_qubits, sym_get(cpy_iter->state, 0, i + cpy_iter->state->n_qubits)); // Z elements
-            } 
-
-            // Set the value in the new buffer
-            expanded_error_probs[sym_iter_ll_from_state(target_buffer)] += initial_error_rates[sym_iter_ll_from_state(cpy_iter)];
-        }
-    }
-    sym_iter_free(target_buffer);
-    sym_iter_free(cpy_iter);
-
-    unsigned long n_bytes = (1ull << ((smd->n_code_qubits + smd->n_ancilla_qubits) * 2)) * sizeof(double);
+    // The table is updated in place or swapped with the scratch table, so each sub-circuit runs without allocating
+    error_probability_t* scratch = error_probabilities_zeros(smd->n_code_qubits + smd->n_ancilla_qubits);
 
     // Run the sub-circuits
     // These let us track the "active" ancilla qubit while leaving the others untouched
     for (uint32_t i = 0; i <= smd->n_ancilla_qubits; i++)
     {
-        circuit* c = smd->sub_circuits[i];
-        circuit_element* ce = c->start;
+        circuit_compiled* cc = circuit_compile(smd->sub_circuits[i]);
         uint32_t active_ancilla = i + smd->n_code_qubits;
 
-        while (NULL != ce)
+        for (uint32_t gate_idx = 0; gate_idx < cc->n_gates; gate_idx++)
         {
+            gate* g = cc->gates[gate_idx];
+            const unsigned* targets = circuit_compiled_targets(cc, gate_idx);
+
             // Gate operation
-            double* tmp_error_rate = gate_apply(c->n_qubits, expanded_error_probs, ce->gate_operation, ce->target_qubits);
-            memcpy(expanded_error_probs, tmp_error_rate, n_bytes);
-            free(tmp_error_rate);
+            gate_apply_buffers(cc->n_qubits, &expanded_error_probs, &scratch, g, targets);
         
             // Environmental Noise operations on code block qubits
             if (noise != NULL)
             {
                 for (unsigned j = 0; j < smd->n_code_qubits; j++)
                 {
-                    for (uint32_t k = 0; k < ce->gate_operation->n_qubits; k++)
+                    for (uint32_t k = 0; k < g->n_qubits; k++)
                     {   
                         // No Noise on inactive ancillas!
-                        if (j != ce->target_qubits[k])
+                        if (j != targets[k])
                         {
-                            double* tmp_error_rate = gate_apply(c->n_qubits, expanded_error_probs, noise, &j);
-                            memcpy(expanded_error_probs, tmp_error_rate, n_bytes);
-                            free(tmp_error_rate);
+                            gate_apply_buffers(cc->n_qubits, &expanded_error_probs, &scratch, noise, &j);
                         }
                     }
                 }
@@ -296,9 +274,9 @@ double* circuit_syndrome_measurement_sequential_run(
                     // Environmental Noise operations on ancilla qubits
                     // No noise on the inactive ancillas!
                     uint8_t ancilla_used = false;
-                    for (uint32_t k = 0; k < ce->gate_operation->n_qubits; k++)
+                    for (uint32_t k = 0; k < g->n_qubits; k++)
                     {   
-                        if (active_ancilla != ce->target_qubits[k])
+                        if (active_ancilla != targets[k])
                         {
                             ancilla_used = true;
                         }
@@ -306,16 +284,14 @@ double* circuit_syndrome_measurement_sequential_run(
 
                     if (false == ancilla_used)
                     {
-                        double* tmp_error_rate = gate_apply(c->n_qubits, expanded_error_probs, noise, &active_ancilla);
-                        memcpy(expanded_error_probs, tmp_error_rate, n_bytes);
-                        free(tmp_error_rate);  
+                        gate_apply_buffers(cc->n_qubits, &expanded_error_probs, &scratch, noise, &active_ancilla);
                     }           
                 }
             }
-            // Next circuit element
-            ce = ce->next;
         }
+        circuit_compiled_free(cc);
     }
+    free(scratch);
 
     // Cleanup anything that needs to be de-allocated
     //error_probabilities_free(expanded_error_probs);
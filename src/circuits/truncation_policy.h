@@ -0,0 +1,291 @@
+#ifndef TRUNCATION_POLICY
+#define TRUNCATION_POLICY
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "error_probabilities.h"
+#include "../gates/gates.h"
+
+// ----------------------------------------------------------------------------------------
+// TRUNCATION POLICY
+// Large tables spend most of their time on pauli strings that are too unlikely to matter
+// A truncation policy drops them at runtime, and keeps an exact account of the probability that was dropped
+// so a truncated run reports how far it is from being normalised
+//
+// A policy may limit any combination of:
+//      The pauli weight of each string
+//      The probability of each string
+//      The number of strings with a non zero probability
+// Each limit is disabled by its TRUNCATION_NO_* value
+// ----------------------------------------------------------------------------------------
+
+#define TRUNCATION_NO_MAX_WEIGHT UINT32_MAX
+#define TRUNCATION_NO_MIN_PROBABILITY 0
+#define TRUNCATION_NO_MAX_SUPPORT 0
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+ * truncation_policy
+ * The limits applied to a table, and the probability dropped by them
+ * :: uint32_t max_weight :: Strings with a greater pauli weight are dropped
+ * :: double min_probability :: Strings with a smaller probability are dropped
+ * :: uint64_t max_support :: At most this many of the most likely strings are kept
+ * :: double discarded_last :: The probability dropped by the most recent truncation, for a sparse table the most recent gate
+ * :: double discarded :: The probability dropped since the policy was created or reset
+ * This object should be freed using the 'truncation_policy_free' function
+ */
+typedef struct {
+	uint32_t max_weight;
+	double min_probability;
+	uint64_t max_support;
+	double discarded_last;
+	double discarded;
+} truncation_policy;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * truncation_policy_create
+ * Creates a truncation policy
+ * :: const uint32_t max_weight :: The largest pauli weight kept, or TRUNCATION_NO_MAX_WEIGHT
+ * :: const double min_probability :: The smallest probability kept, or TRUNCATION_NO_MIN_PROBABILITY
+ * :: const uint64_t max_support :: The largest number of strings kept, or TRUNCATION_NO_MAX_SUPPORT
+ * Returns a heap pointer to the new policy
+ */
+truncation_policy* truncation_policy_create(const uint32_t max_weight, const double min_probability, const uint64_t max_support);
+
+/*
+ * truncation_policy_reset
+ * Clears the discarded probability of a policy, so it may be reused for another run
+ * :: truncation_policy* policy :: The policy
+ * Returns nothing
+ */
+void truncation_policy_reset(truncation_policy* policy);
+
+/*
+ * truncation_policy_weight
+ * The pauli weight of a table index
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns the number of qubits with a non identity element
+ */
+uint32_t truncation_policy_weight(const uint64_t index, const uint32_t n_qubits);
+
+/*
+ * truncation_policy_keeps
+ * Checks the weight and probability limits of a policy against a single string, the support limit is not checked
+ * :: const truncation_policy* policy :: The policy, NULL keeps every string
+ * :: const uint32_t weight :: The pauli weight of the string
+ * :: const double prob :: The probability of the string
+ * Returns 1 if the string is kept, or 0 if it is dropped
+ */
+uint8_t truncation_policy_keeps(const truncation_policy* policy, const uint32_t weight, const double prob);
+
+/*
+ * truncation_policy_apply
+ * Truncates a table in place, the identity is always kept
+ * :: truncation_policy* policy :: The policy, its discarded probability is updated, NULL leaves the table unchanged
+ * :: error_probability_t* error_probs :: The table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns the probability dropped from the table
+ */
+double truncation_policy_apply(truncation_policy* policy, error_probability_t* error_probs, const uint32_t n_qubits);
+
+/*
+ * truncation_policy_free
+ * Frees a truncation policy
+ * :: truncation_policy* policy :: The policy
+ * Returns nothing
+ */
+void truncation_policy_free(truncation_policy* policy);
+
+// Orders probabilities from largest to smallest for qsort
+int truncation_policy_compare(const void* v_a, const void* v_b);
+
+// Sorts the probabilities of a support and finds the smallest kept by the support limit, and how many ties with it are kept
+double truncation_policy_support_cutoff(double* probs, const uint64_t n_support, const uint64_t n_kept, uint64_t* n_ties);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * truncation_policy_create
+ * Creates a truncation policy
+ * :: const uint32_t max_weight :: The largest pauli weight kept, or TRUNCATION_NO_MAX_WEIGHT
+ * :: const double min_probability :: The smallest probability kept, or TRUNCATION_NO_MIN_PROBABILITY
+ * :: const uint64_t max_support :: The largest number of strings kept, or TRUNCATION_NO_MAX_SUPPORT
+ * Returns a heap pointer to the new policy
+ */
+truncation_policy* truncation_policy_create(const uint32_t max_weight, const double min_probability, const uint64_t max_support)
+{
+	truncation_policy* policy = (truncation_policy*)malloc(sizeof(truncation_policy));
+	policy->max_weight = max_weight;
+	policy->min_probability = min_probability;
+	policy->max_support = max_support;
+	truncation_policy_reset(policy);
+	return policy;
+}
+
+/*
+ * truncation_policy_reset
+ * Clears the discarded probability of a policy, so it may be reused for another run
+ * :: truncation_policy* policy :: The policy
+ * Returns nothing
+ */
+void truncation_policy_reset(truncation_policy* policy)
+{
+	policy->discarded_last = 0;
+	policy->discarded = 0;
+	return;
+}
+
+/*
+ * truncation_policy_weight
+ * The pauli weight of a table index
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns the number of qubits with a non identity element
+ */
+uint32_t truncation_policy_weight(const uint64_t index, const uint32_t n_qubits)
+{
+	// The X bits sit above the Z bits, a qubit is non identity if either is set
+	uint64_t qubit_mask = (n_qubits < 64) ? (1ull << n_qubits) - 1 : ~0ull;
+	return gate_kernel_popcount(((index >> n_qubits) | index) & qubit_mask);
+}
+
+/*
+ * truncation_policy_keeps
+ * Checks the weight and probability limits of a policy against a single string, the support limit is not checked
+ * :: const truncation_policy* policy :: The policy, NULL keeps every string
+ * :: const uint32_t weight :: The pauli weight of the string
+ * :: const double prob :: The probability of the string
+ * Returns 1 if the string is kept, or 0 if it is dropped
+ */
+uint8_t truncation_policy_keeps(const truncation_policy* policy, const uint32_t weight, const double prob)
+{
+	if (NULL == policy)
+	{
+		return 1;
+	}
+	return (weight <= policy->max_weight) && (prob >= policy->min_probability);
+}
+
+/*
+ * truncation_policy_apply
+ * Truncates a table in place, the identity is always kept
+ * :: truncation_policy* policy :: The policy, its discarded probability is updated, NULL leaves the table unchanged
+ * :: error_probability_t* error_probs :: The table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns the probability dropped from the table
+ */
+double truncation_policy_apply(truncation_policy* policy, error_probability_t* error_probs, const uint32_t n_qubits)
+{
+	if (NULL == policy)
+	{
+		return 0;
+	}
+
+	double discarded = 0;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	uint64_t n_support = 0;
+
+	// Weight and probability limits
+	for (uint64_t index = 1; index < n_entries; index++)
+	{
+		if (0 == error_probs[index])
+		{
+			continue;
+		}
+
+		if (!truncation_policy_keeps(policy, truncation_policy_weight(index, n_qubits), error_probs[index]))
+		{
+			discarded += error_probs[index];
+			error_probs[index] = 0;
+		}
+		else
+		{
+			n_support++;
+		}
+	}
+
+	// Support limit, the identity is counted and the most likely strings are kept
+	if (TRUNCATION_NO_MAX_SUPPORT != policy->max_support && n_support + 1 > policy->max_support)
+	{
+		uint64_t n_kept = (policy->max_support > 1) ? policy->max_support - 1 : 0;
+
+		// Find the probability of the last string that is kept
+		double* sorted = (double*)malloc(sizeof(double) * n_support);
+		uint64_t count = 0;
+		for (uint64_t index = 1; index < n_entries; index++)
+		{
+			if (0 != error_probs[index])
+			{
+				sorted[count++] = error_probs[index];
+			}
+		}
+		uint64_t n_ties = 0;
+		double cutoff = truncation_policy_support_cutoff(sorted, n_support, n_kept, &n_ties);
+		free(sorted);
+
+		for (uint64_t index = 1; index < n_entries; index++)
+		{
+			if (0 == error_probs[index] || error_probs[index] > cutoff)
+			{
+				continue;
+			}
+			if (error_probs[index] == cutoff && n_ties > 0)
+			{
+				n_ties--;
+				continue;
+			}
+			discarded += error_probs[index];
+			error_probs[index] = 0;
+		}
+	}
+
+	policy->discarded_last = discarded;
+	policy->discarded += discarded;
+	return discarded;
+}
+
+/*
+ * truncation_policy_free
+ * Frees a truncation policy
+ * :: truncation_policy* policy :: The policy
+ * Returns nothing
+ */
+void truncation_policy_free(truncation_policy* policy)
+{
+	free(policy);
+	return;
+}
+
+// Orders probabilities from largest to smallest for qsort
+int truncation_policy_compare(const void* v_a, const void* v_b)
+{
+	double a = *(const double*)v_a;
+	double b = *(const double*)v_b;
+	return (a < b) - (a > b);
+}
+
+// Sorts the probabilities of a support and finds the smallest kept by the support limit, and how many ties with it are kept
+double truncation_policy_support_cutoff(double* probs, const uint64_t n_support, const uint64_t n_kept, uint64_t* n_ties)
+{
+	qsort(probs, n_support, sizeof(double), truncation_policy_compare);
+	double cutoff = n_kept ? probs[n_kept - 1] : INFINITY;
+
+	// Strings tied with the cutoff are kept in index order until the limit is reached
+	uint64_t n_above = 0;
+	for (uint64_t i = 0; i < n_kept && probs[i] > cutoff; i++)
+	{
+		n_above++;
+	}
+	*n_ties = n_kept - n_above;
+	return cutoff;
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "decoders.h"
 #include "destabiliser.h"
 #include "logical_destabiliser.h"
+#include "../misc/thread_pool.h"
 
 
 //----------------------------------------------------------------------------------------
@@ -33,6 +34,40 @@ sym** tailor_recovery_operators(const sym* code,
 */
 decoder* decoder_create_tailored(const sym* code, const sym* logicals, error_model* noise);
 
+/*
+	decoder_create_tailored_from_recovery_operators
+	Builds a tailored decoder from a table of recovery operators that has already been found
+	:: sym** recovery_operators :: The recovery operator for each syndrome, the decoder takes ownership of these
+	:: const unsigned n_syndrome_bits :: The number of syndrome bits that will be communicated to the decoder
+	Returns a pointer to a new decoder object on the heap
+*/
+decoder* decoder_create_tailored_from_recovery_operators(sym** recovery_operators, const unsigned n_syndrome_bits);
+
+/* 
+	tailor_recovery_operators_batch:
+	Finds the best possible tailored decoder for every lane of a batched error model in a single pass over the errors
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: error_model* noise :: The error model, a batched model gives each lane its own probabilities
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	Returns an array with a table of recovery operators for each lane
+*/
+sym*** tailor_recovery_operators_batch(const sym* code, 
+				const sym* logicals, 
+				error_model* noise,
+				const uint32_t n_lanes);
+
+/*
+	decoder_create_tailored_batch
+	Creates a tailored decoder for every lane of a batched error model
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: error_model* noise :: The error model, a batched model gives each lane its own probabilities
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	Returns an array of n_lanes decoders, each should be freed with decoder_free
+*/
+decoder** decoder_create_tailored_batch(const sym* code, const sym* logicals, error_model* noise, const uint32_t n_lanes);
+
 /*
 	decoder_call_tailored
 	Determines the correction procedure given a syndrome and a tailored decoder
@@ -60,6 +95,25 @@ typedef struct {
 	sym** recovery_operators;
 } decoder_params_tailored_t;
 
+// Data shared by the pool workers in tailor_recovery_operators
+typedef struct {
+	const sym* code;
+	const sym* logicals;
+	error_model* noise;
+	decoder* destabilisers;
+	long long n_syndromes;
+	long long n_logical_operations;
+	double* worker_p_options; // One table of probabilities for each worker, indexed by [syndrome][logical error]
+	uint8_t* worker_seen; // One flag for each syndrome for each worker
+	pthread_mutex_t* model_lock; // Held around each call of an error model that is not thread safe, otherwise NULL
+} tailor_recovery_task_t;
+
+void tailor_recovery_operators_error(const tailor_recovery_task_t* task_data,
+				const sym* physical_error,
+				double* p_options,
+				uint8_t* seen);
+void tailor_recovery_operators_task(void* data, const uint64_t start, const uint64_t end, const uint32_t worker);
+
 
 //----------------------------------------------------------------------------------------
 // Function Definitions
@@ -73,12 +127,24 @@ typedef struct {
 	Returns a pointer to a new error model object on the heap
 */
 decoder* decoder_create_tailored(const sym* code, const sym* logicals, error_model* noise)
+{
+	return decoder_create_tailored_from_recovery_operators(tailor_recovery_operators(code, logicals, noise), code->height);
+}
+
+/*
+	decoder_create_tailored_from_recovery_operators
+	Builds a tailored decoder from a table of recovery operators that has already been found
+	:: sym** recovery_operators :: The recovery operator for each syndrome, the decoder takes ownership of these
+	:: const unsigned n_syndrome_bits :: The number of syndrome bits that will be communicated to the decoder
+	Returns a pointer to a new decoder object on the heap
+*/
+decoder* decoder_create_tailored_from_recovery_operators(sym** recovery_operators, const unsigned n_syndrome_bits)
 {
 	decoder* d = decoder_create();
 	decoder_params_tailored_t* dp = (decoder_params_tailored_t*)malloc(sizeof(decoder_params_tailored_t));
 
-	dp->recovery_operators = tailor_recovery_operators(code, logicals, noise);
-	dp->n_syndrome_bits = code->height;
+	dp->recovery_operators = recovery_operators;
+	dp->n_syndrome_bits = n_syndrome_bits;
 
 	// Link the params to the decoder
 	d->params = dp;
@@ -139,6 +205,8 @@ void decoder_free_params_tailored(void* v_params)
 	:: void* model_data :: The data associated with the error model
 	Returns an array of recovery operators where the binary representation of the syndrome gives the 
 	associated recovery
+	With more than one thread the probabilities are summed in a different order, so a syndrome whose logical 
+	corrections are equally likely may settle on a different one of them
 */
 sym** tailor_recovery_operators(const sym* code, 
 				const sym* logicals, 
@@ -168,14 +236,6 @@ sym** tailor_recovery_operators(const sym* code,
 		// This will cause issues if you attempt to copy from here!
 	}
 	sym_iter_free(syndromes);
-	
-	// Initialise the probabilities and set them to 0 efficiently
-	double p_options[n_syndromes][n_logical_operations];
-
-	for (size_t i = 0; i < n_syndromes; i++)
-	{
-		memset(p_options[i], 0, sizeof(double) * n_logical_operations);
-	}
 
 	// Find the destabilisers
 	decoder* destabilisers = decoder_create_destabiliser(code, logicals);
@@ -187,42 +247,86 @@ sym** tailor_recovery_operators(const sym* code,
 	// Determine the logical errors
 	// By iterating through each possible physical error and by applying the destabilisers
 	// determine the overall logical error produced by this correction procedure 
+	// The physical errors are split between the workers of the default pool, each with its own table of 
+	// probabilities and its own record of the syndromes it has seen
 	// -----------------------------------
+	thread_pool* pool = thread_pool_default();
+	uint32_t n_threads = thread_pool_n_threads(pool);
+
+	tailor_recovery_task_t task_data;
+	task_data.code = code;
+	task_data.logicals = logicals;
+	task_data.noise = noise;
+	task_data.destabilisers = destabilisers;
+	task_data.n_syndromes = n_syndromes;
+	task_data.n_logical_operations = n_logical_operations;
+	task_data.worker_p_options = (double*)calloc(n_threads * n_syndromes * n_logical_operations, sizeof(double));
+	task_data.worker_seen = (uint8_t*)calloc(n_threads * n_syndromes, sizeof(uint8_t));
+	task_data.model_lock = NULL;
+
+	if (n_threads > 1)
+	{
+		// Models that write to themselves when called, such as cached models, are called under a lock
+		pthread_mutex_t model_lock;
+		if (!noise->thread_safe)
+		{
+			pthread_mutex_init(&model_lock, NULL);
+			task_data.model_lock = &model_lock;
+		}
 
-	// Iterate through errors and map back to the code-space
-	sym_iter* physical_error = sym_iter_create(code->length);
-	while (sym_iter_next(physical_error))
+		thread_pool_parallel_for(pool, 1ull << code->length, tailor_recovery_operators_task, &task_data);
+
+		if (NULL != task_data.model_lock)
+		{
+			pthread_mutex_destroy(&model_lock);
+			task_data.model_lock = NULL;
+		}
+	}
+	else
 	{
-		// Calculate the syndrome
-		sym* syndrome = sym_syndrome(code, physical_error->state);
-		
-		// Get the recovery operator
-		sym* recovery = decoder_call(destabilisers, syndrome);
+		// A single thread keeps the iterator, which sums in the same order as before
+		sym_iter* physical_error = sym_iter_create(code->length);
+		while (sym_iter_next(physical_error))
+		{
+			tailor_recovery_operators_error(&task_data, physical_error->state, task_data.worker_p_options, task_data.worker_seen);
+		}
+		sym_iter_free(physical_error);
+	}
 
-		// If we haven't seen this recovery operator before, we save it
-		if (0 == tailored_decoder[sym_to_ll(syndrome)]->mem_size)
+	// Sum the probabilities of every worker into the first table
+	double* p_options = task_data.worker_p_options;
+	for (uint32_t worker = 1; worker < n_threads; worker++)
+	{
+		double* worker_p_options = task_data.worker_p_options + worker * n_syndromes * n_logical_operations;
+		for (long long i = 0; i < n_syndromes * n_logical_operations; i++)
 		{
-			// Reset the mem_size and perform this copy operation in place
-			tailored_decoder[sym_to_ll(syndrome)]->mem_size = recovery->mem_size;
-			sym_copy_in_place(tailored_decoder[sym_to_ll(syndrome)], recovery);
+			p_options[i] += worker_p_options[i];
 		}
-		
-		// Determine the state after correction
-		sym* corrected = sym_add(recovery, physical_error->state);
+	}
 
-		// Determine the overall logical state
-		sym* logical_state = logical_error(logicals, corrected);
+	// Save the recovery operator of every syndrome that was seen
+	for (long long i = 0; i < n_syndromes; i++)
+	{
+		uint8_t seen = 0;
+		for (uint32_t worker = 0; worker < n_threads; worker++)
+		{
+			seen |= task_data.worker_seen[worker * n_syndromes + i];
+		}
 
-		// Calculate the probability of this particular error occurring and store it
-		p_options[sym_to_ll(syndrome)][sym_to_ll(logical_state)] += error_model_call(noise, physical_error->state);
+		if (seen)
+		{
+			sym* syndrome = ll_to_sym(i, code->height, 1);
+			sym* recovery = decoder_call(destabilisers, syndrome);
 
-		// Free our memory in order to prevent leaks and fragmentation
-		sym_free(logical_state);
-		sym_free(corrected);
-		sym_free(recovery);
-		sym_free(syndrome);
+			// Reset the mem_size and perform this copy operation in place
+			tailored_decoder[i]->mem_size = recovery->mem_size;
+			sym_copy_in_place(tailored_decoder[i], recovery);
+
+			sym_free(recovery);
+			sym_free(syndrome);
+		}
 	}
-	sym_iter_free(physical_error);
+	free(task_data.worker_seen);
 	
 	// ---------------------------------------------------
 	// Calculate and store the optimal recovery operator
@@ -237,7 +341,7 @@ sym** tailor_recovery_operators(const sym* code,
 	{
 		// Set the default logical correction to none
 		// This covers the case when that particular syndrome is never encountered
-		double p_correction = p_options[i][0];
+		double p_correction = p_options[i * n_logical_operations];
 		unsigned r_operator = 0;
 
 		// This syndrome was never encountered, we can skip searching the rest and just
@@ -252,9 +356,9 @@ sym** tailor_recovery_operators(const sym* code,
 			{
 				// If the probability of this syndrome is greater than the current 
 				// best found then change our optimal correction
-				if (p_options[i][j] > p_correction)
+				if (p_options[i * n_logical_operations + j] > p_correction)
 				{
-					p_correction = p_options[i][j];
+					p_correction = p_options[i * n_logical_operations + j];
 					r_operator = j;
 				}
 			}
@@ -276,11 +380,206 @@ sym** tailor_recovery_operators(const sym* code,
 	// ------------------------------------------
 	// Cleanup
 	// ------------------------------------------
+	free(p_options);
 	decoder_free(destabilisers);
 	decoder_free(logical_destabilisers);
 
 	return tailored_decoder;
 }
 
+// Decodes a single physical error, marking its syndrome as seen and adding its probability to the logical error left behind
+void tailor_recovery_operators_error(const tailor_recovery_task_t* task_data,
+				const sym* physical_error,
+				double* p_options,
+				uint8_t* seen)
+{
+	// Calculate the syndrome
+	sym* syndrome = sym_syndrome(task_data->code, physical_error);
+	
+	// Get the recovery operator
+	sym* recovery = decoder_call(task_data->destabilisers, syndrome);
+
+	// The recovery operator for this syndrome is saved once every worker has finished
+	seen[sym_to_ll(syndrome)] = 1;
+	
+	// Determine the state after correction
+	sym* corrected = sym_add(recovery, physical_error);
+
+	// Determine the overall logical state
+	sym* logical_state = logical_error(task_data->logicals, corrected);
+
+	// Calculate the probability of this particular error occurring and store it
+	if (NULL != task_data->model_lock)
+	{
+		pthread_mutex_lock(task_data->model_lock);
+	}
+	double prob = error_model_call(task_data->noise, physical_error);
+	if (NULL != task_data->model_lock)
+	{
+		pthread_mutex_unlock(task_data->model_lock);
+	}
+	p_options[sym_to_ll(syndrome) * task_data->n_logical_operations + sym_to_ll(logical_state)] += prob;
+
+	// Free our memory in order to prevent leaks and fragmentation
+	sym_free(logical_state);
+	sym_free(corrected);
+	sym_free(recovery);
+	sym_free(syndrome);
+	return;
+}
+
+// Pool task, decodes a range of physical errors into the tables of this worker
+void tailor_recovery_operators_task(void* data, const uint64_t start, const uint64_t end, const uint32_t worker)
+{
+	tailor_recovery_task_t* task_data = (tailor_recovery_task_t*)data;
+	double* p_options = task_data->worker_p_options + worker * task_data->n_syndromes * task_data->n_logical_operations;
+	uint8_t* seen = task_data->worker_seen + worker * task_data->n_syndromes;
+
+	for (uint64_t i = start; i < end; i++)
+	{
+		sym* physical_error = ll_to_sym(i, 1, task_data->code->length);
+		tailor_recovery_operators_error(task_data, physical_error, p_options, seen);
+		sym_free(physical_error);
+	}
+	return;
+}
+
+
+/*
+	decoder_create_tailored_batch
+	Creates a tailored decoder for every lane of a batched error model
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: error_model* noise :: The error model, a batched model gives each lane its own probabilities
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	Returns an array of n_lanes decoders, each should be freed with decoder_free
+*/
+decoder** decoder_create_tailored_batch(const sym* code, const sym* logicals, error_model* noise, const uint32_t n_lanes)
+{
+	sym*** recovery_operators = tailor_recovery_operators_batch(code, logicals, noise, n_lanes);
+	decoder** decoders = (decoder**)malloc(sizeof(decoder*) * n_lanes);
+	for (uint32_t i = 0; i < n_lanes; i++)
+	{
+		decoders[i] = decoder_create_tailored_from_recovery_operators(recovery_operators[i], code->height);
+	}
+	free(recovery_operators);
+	return decoders;
+}
+
+/* 
+	tailor_recovery_operators_batch:
+	Finds the best possible tailored decoder for every lane of a batched error model in a single pass over the errors
+	:: const sym* code :: The error correcting code
+	:: const sym* logicals :: Logical operators
+	:: error_model* noise :: The error model, a batched model gives each lane its own probabilities
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	Returns an array with a table of recovery operators for each lane
+*/
+sym*** tailor_recovery_operators_batch(const sym* code, 
+				const sym* logicals, 
+				error_model* noise,
+				const uint32_t n_lanes)
+{
+	uint64_t n_syndromes = (1ull << (code->height));
+	uint64_t n_logical_operations = (1ull << (logicals->length));
+
+	// The destabiliser correction for each syndrome is shared by every lane, NULL marks an unseen syndrome
+	sym** destabiliser_recovery = (sym**)calloc(n_syndromes, sizeof(sym*));
+
+	// Probabilities for each syndrome, logical error and lane
+	double* p_options = (double*)calloc(n_syndromes * n_logical_operations * n_lanes, sizeof(double));
+	double* p_lanes = (double*)malloc(sizeof(double) * n_lanes);
+
+	decoder* destabilisers = decoder_create_destabiliser(code, logicals);
+
+	sym_iter* physical_error = sym_iter_create(code->length);
+	while (sym_iter_next(physical_error))
+	{
+		sym* syndrome = sym_syndrome(code, physical_error->state);
+		sym* recovery = decoder_call(destabilisers, syndrome);
+		uint64_t syndrome_index = sym_to_ll(syndrome);
+
+		sym* corrected = sym_add(recovery, physical_error->state);
+		sym* logical_state = logical_error(logicals, corrected);
+
+		error_model_batch_call(noise, physical_error->state, n_lanes, p_lanes);
+		double* p_option = p_options + (syndrome_index * n_logical_operations + sym_to_ll(logical_state)) * n_lanes;
+		for (uint32_t i = 0; i < n_lanes; i++)
+		{
+			p_option[i] += p_lanes[i];
+		}
+
+		// Keep the first recovery operator seen for each syndrome
+		if (NULL == destabiliser_recovery[syndrome_index])
+		{
+			destabiliser_recovery[syndrome_index] = recovery;
+		}
+		else
+		{
+			sym_free(recovery);
+		}
+
+		sym_free(logical_state);
+		sym_free(corrected);
+		sym_free(syndrome);
+	}
+	sym_iter_free(physical_error);
+
+	// Pick the best logical correction for each syndrome separately in each lane
+	decoder* logical_destabilisers = decoder_create_logical_destabiliser(logicals);
+
+	sym*** tailored_decoders = (sym***)malloc(sizeof(sym**) * n_lanes);
+	for (uint32_t lane = 0; lane < n_lanes; lane++)
+	{
+		tailored_decoders[lane] = (sym**)malloc(sizeof(sym*) * n_syndromes);
+		for (uint64_t i = 0; i < n_syndromes; i++)
+		{
+			unsigned r_operator = 0;
+
+			if (NULL == destabiliser_recovery[i])
+			{
+				// This syndrome was never encountered, no correction
+				tailored_decoders[lane][i] = sym_create(1, code->length);
+			}
+			else
+			{
+				tailored_decoders[lane][i] = sym_copy(destabiliser_recovery[i]);
+
+				double p_correction = p_options[(i * n_logical_operations) * n_lanes + lane];
+				for (uint64_t j = 1; j < n_logical_operations; j++)
+				{
+					if (p_options[(i * n_logical_operations + j) * n_lanes + lane] > p_correction)
+					{
+						p_correction = p_options[(i * n_logical_operations + j) * n_lanes + lane];
+						r_operator = j;
+					}
+				}
+			}
+
+			sym* logical_syndrome = ll_to_sym_t(r_operator, 1, logicals->length);
+			sym* logical_recovery = decoder_call(logical_destabilisers, logical_syndrome);
+
+			sym_add_in_place(tailored_decoders[lane][i], logical_recovery);
+		
+			sym_free(logical_recovery);
+			sym_free(logical_syndrome);
+		}
+	}
+
+	for (uint64_t i = 0; i < n_syndromes; i++)
+	{
+		if (NULL != destabiliser_recovery[i])
+		{
+			sym_free(destabiliser_recovery[i]);
+		}
+	}
+	free(destabiliser_recovery);
+	free(p_options);
+	free(p_lanes);
+	decoder_free(destabilisers);
+	decoder_free(logical_destabilisers);
+
+	return tailored_decoders;
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,91 @@
+#ifndef ERROR_MODEL_BATCH
+#define ERROR_MODEL_BATCH
+
+#include "error_models.h"
+
+// Batch Model Composition -------------------------------------------------------------------------------
+// Stacks a set of error models so that each one fills a single lane of a parameter batch
+
+typedef struct {
+	uint32_t n_lanes;
+	error_model** models;
+} model_params_batch;
+
+// DECLARATIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_create_batch
+	Model constructor for a batch of arbitrary error models, lane i is given by models[i]
+	The models are referenced and not copied, they should be freed separately and only after this model
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	:: error_model** models :: The error model for each lane
+	Returns a pointer to a new error model object on the heap
+*/
+error_model* error_model_create_batch(const uint32_t n_lanes, error_model** models);
+
+// Model Callers
+double error_model_call_batch(const sym* error, void* v_model_params);
+void error_model_batch_call_batch(const sym* error, void* v_model_params, double* probabilities);
+
+// Destructor
+void error_model_free_batch(void* v_model_params);
+
+// DEFINITIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_create_batch
+	Model constructor for a batch of arbitrary error models, lane i is given by models[i]
+	The models are referenced and not copied, they should be freed separately and only after this model
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	:: error_model** models :: The error model for each lane
+	Returns a pointer to a new error model object on the heap
+*/
+error_model* error_model_create_batch(const uint32_t n_lanes, error_model** models)
+{
+	error_model* m = error_model_create(sizeof(model_params_batch));
+	model_params_batch* mp = (model_params_batch*)malloc(sizeof(model_params_batch));
+
+	mp->n_lanes = n_lanes;
+	mp->models = (error_model**)malloc(sizeof(error_model*) * n_lanes);
+	memcpy(mp->models, models, sizeof(error_model*) * n_lanes);
+
+	m->params = mp;
+	m->call = error_model_call_batch;
+	m->batch_call = error_model_batch_call_batch;
+	m->n_lanes = n_lanes;
+	m->param_free = error_model_free_batch;
+
+	// Calls are passed on to each lane
+	for (uint32_t i = 0; i < n_lanes; i++)
+	{
+		m->thread_safe &= models[i]->thread_safe;
+	}
+	return m;
+}
+
+// The single probability call uses the first lane
+double error_model_call_batch(const sym* error, void* v_model_params)
+{
+	model_params_batch* model_params = (model_params_batch*)v_model_params;
+	return error_model_call(model_params->models[0], error);
+}
+
+void error_model_batch_call_batch(const sym* error, void* v_model_params, double* probabilities)
+{
+	model_params_batch* model_params = (model_params_batch*)v_model_params;
+	for (uint32_t i = 0; i < model_params->n_lanes; i++)
+	{
+		probabilities[i] = error_model_call(model_params->models[i], error);
+	}
+	return;
+}
+
+void error_model_free_batch(void* v_model_params)
+{
+	model_params_batch* model_params = (model_params_batch*)v_model_params;
+	free(model_params->models);
+	free(model_params);
+	return;
+}
+
+#endif
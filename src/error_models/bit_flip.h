@@ -5,22 +5,44 @@
 
 // Trivial Bit flip model ------------------------------------------------------------------------------------
 // Error only occurs on the first bit
-struct model_params_bit_flip_trivial {
+typedef struct {
 	double p_error;
-};
+} model_params_bit_flip_trivial;
 
-struct {
+// Bit flip model ------------------------------------------------------------------------------------
+// Independent X errors on every qubit
+typedef struct {
 	double p_error;
-	int n_qubits;
+	unsigned int n_qubits;
 } model_params_bit_flip;
 
+// DECLARATIONS ------------------------------------------------------------------------------------------------
+
 /*
 	error_model_create_bit_flip_trivial
 	Model constructor for the trivial bit flip error model
 	:: const double p_error :: Probability of an X error on the first qubit
 	Returns a pointer to a new error model object on the heap
 */
-error_model* error_model_create_bit_flip_trivial(const double p_error)
+error_model* error_model_create_bit_flip_trivial(const double p_error);
+
+/*
+	error_model_create_bit_flip
+	Model constructor for the bit flip error model
+	:: const unsigned n_qubits :: The number of physical qubits
+	:: const double p_error :: Probability of an X error
+	Returns a pointer to a new error model object on the heap
+*/
+error_model* error_model_create_bit_flip(const unsigned n_qubits, const double p_error);
+
+// Model Callers
+double error_model_call_bit_flip_trivial(const sym* error, void* v_model_params);
+double error_model_call_bit_flip(const sym* error, void* v_model_params);
+
+// Polynomial Model Call
+void error_model_poly_call_bit_flip(const sym* error, void* v_model_params, double* coefficients);
+
+// DEFINITIONS ------------------------------------------------------------------------------------------------
 
 /*
 	error_model_create_bit_flip_trivial
@@ -31,12 +53,12 @@ error_model* error_model_create_bit_flip_trivial(const double p_error)
 error_model* error_model_create_bit_flip_trivial(const double p_error)
 {	
 	error_model* m = error_model_create(sizeof(model_params_bit_flip_trivial));
-	struct model_params_bit_flip_trivial* mp = (struct model_params_bit_flip_trivial*)malloc(sizeof(model_params_iid));
+	model_params_bit_flip_trivial* mp = (model_params_bit_flip_trivial*)malloc(sizeof(model_params_bit_flip_trivial));
 
 	mp->p_error = p_error;
 
-	m->model_call = error_model_call_bit_flip_trivial;
-	m->model_params = mp;
+	m->call = error_model_call_bit_flip_trivial;
+	m->params = mp;
 
 	return m;
 }
@@ -44,20 +66,22 @@ error_model* error_model_create_bit_flip_trivial(const double p_error)
 double error_model_call_bit_flip_trivial(const sym* error, void* v_model_params)
 {
 	// Recast
-	struct model_params_bit_flip_trivial* model_params = (struct model_params_bit_flip_trivial*)v_model_params;
+	model_params_bit_flip_trivial* model_params = (model_params_bit_flip_trivial*)v_model_params;
 	
 	// Check the error string
 	char* error_string = error_sym_to_str(error);
+	double prob = 0;
 	if (!strcmp(error_string, "II"))
 	{
-		return (1.0 - model_params->p_error);
+		prob = (1.0 - model_params->p_error);
 	}
 
 	if (!strcmp(error_string, "XI"))
 	{
-		return model_params->p_error;
+		prob = model_params->p_error;
 	}
-	return 0;
+	free(error_string);
+	return prob;
 }
 
 /*
@@ -70,22 +94,23 @@ double error_model_call_bit_flip_trivial(const sym* error, void* v_model_params)
 error_model* error_model_create_bit_flip(const unsigned n_qubits, const double p_error)
 {	
 	error_model* m = error_model_create(sizeof(model_params_bit_flip));
-	struct model_params_bit_flip_trivial* mp = (struct model_params_bit_flip_trivial*)malloc(sizeof(model_params_iid));
+	model_params_bit_flip* mp = (model_params_bit_flip*)malloc(sizeof(model_params_bit_flip));
 
 	mp->n_qubits = n_qubits;
 	mp->p_error = p_error;
 
-	m->model_call = error_model_call_bit_flip_trivial;
-	m->model_params = mp;
+	m->call = error_model_call_bit_flip;
+	m->poly_call = error_model_poly_call_bit_flip;
+	m->params = mp;
+	m->factorised = 1;
 
 	return m;
 }
 
-double error_model_bit_flip(const sym* error, void* v_model_params)
+double error_model_call_bit_flip(const sym* error, void* v_model_params)
 {
 	// Recast
-	struct bit_flip_model_params* model_params = (struct bit_flip_model_params*)v_model_params;
-	char* error_string = (char*)error;
+	model_params_bit_flip* model_params = (model_params_bit_flip*)v_model_params;
 
 	unsigned int weight = sym_weight(error);
 	unsigned int x_weight = sym_weight_X(error);
@@ -97,4 +122,15 @@ double error_model_bit_flip(const sym* error, void* v_model_params)
 	return 0;
 }
 
-#endif
\ No newline at end of file
+// Polynomial Model Call
+void error_model_poly_call_bit_flip(const sym* error, void* v_model_params, double* coefficients)
+{
+	unsigned int weight = sym_weight(error);
+	if (weight == sym_weight_X(error))
+	{
+		coefficients[weight] += 1.0;
+	}
+	return;
+}
+
+#endif
@@ -0,0 +1,286 @@
+#ifndef ERROR_MODEL_CACHED
+#define ERROR_MODEL_CACHED
+
+#include "error_models.h"
+#include "../circuits/error_probabilities.h"
+
+// Cached Model Composition -------------------------------------------------------------------------------
+// Memoises the probabilities of another error model, keyed by the packed pauli index of the error (see sym_to_ll)
+
+// Largest number of qubits that may use the dense cache, this uses 4^n doubles
+#define ERROR_MODEL_CACHE_MAX_DENSE_QUBITS 12
+
+// Largest number of qubits that may be keyed by a packed pauli index
+#define ERROR_MODEL_CACHE_MAX_QUBITS 32
+
+// Initial number of slots in the hashed cache, as a power of two
+#define ERROR_MODEL_CACHE_INITIAL_SLOT_BITS 6
+
+// Marks an empty slot in the hashed cache, no valid index sets the top bit when n_qubits <= 31
+#define ERROR_MODEL_CACHE_EMPTY_KEY UINT64_MAX
+
+/*
+	error_model_cache_policy_t
+	How the cached probabilities are stored
+	:: ERROR_MODEL_CACHE_DENSE :: A table over all 4^n errors, fastest when most errors will be seen
+	:: ERROR_MODEL_CACHE_HASHED :: An open addressed hash table, grows with the number of distinct errors seen
+*/
+typedef enum {
+	ERROR_MODEL_CACHE_DENSE,
+	ERROR_MODEL_CACHE_HASHED
+} error_model_cache_policy_t;
+
+/*
+	error_model_params_cached_t
+	:: error_model* inner :: The model being cached, this is referenced and not owned
+	:: uint32_t n_qubits :: The number of qubits the model is called with
+	:: error_model_cache_policy_t policy :: How the cache is stored
+	:: double* probabilities :: Dense: the cached probabilities. Hashed: the probability in each slot
+	:: uint8_t* filled :: Dense only, set for each entry that has been evaluated
+	:: uint64_t* keys :: Hashed only, the packed pauli index in each slot
+	:: uint64_t n_slots :: Hashed only, number of slots in the table
+	:: uint32_t slot_bits :: Hashed only, log2 of the number of slots
+	:: uint64_t n_entries :: Number of probabilities currently cached
+	:: uint64_t hits :: Number of calls answered from the cache
+	:: uint64_t misses :: Number of calls passed to the inner model
+*/
+typedef struct {
+	error_model* inner;
+	uint32_t n_qubits;
+	error_model_cache_policy_t policy;
+	double* probabilities;
+	uint8_t* filled;
+	uint64_t* keys;
+	uint64_t n_slots;
+	uint32_t slot_bits;
+	uint64_t n_entries;
+	uint64_t hits;
+	uint64_t misses;
+} error_model_params_cached_t;
+
+// DECLARATIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_create_cached
+	Wraps an error model so that each distinct error is only evaluated once
+	This is intended for expensive models (debug, composition or user models) that are called repeatedly within circuits
+	The cache is not locked and the model is marked as not thread safe, callers that share it between threads lock around each call
+	:: error_model* inner :: The model being cached, this is referenced and must outlive the cached model
+	:: const uint32_t n_qubits :: The number of qubits the model is called with
+	:: const error_model_cache_policy_t policy :: How the cache is stored
+	Returns a pointer to a new error model object on the heap, or NULL if the model is too large to be cached
+*/
+error_model* error_model_create_cached(error_model* inner, const uint32_t n_qubits, const error_model_cache_policy_t policy);
+
+/*
+	error_model_cached_stats
+	Reads the counters of a cached error model
+	:: const error_model* m :: A model created with error_model_create_cached
+	:: uint64_t* hits :: Set to the number of calls answered from the cache
+	:: uint64_t* misses :: Set to the number of calls passed to the inner model
+	Returns nothing
+*/
+void error_model_cached_stats(const error_model* m, uint64_t* hits, uint64_t* misses);
+
+// Model Call
+double error_model_call_cached(const sym* error, void* v_model_params);
+
+// Destructor
+void error_model_free_cached(void* v_model_params);
+
+// Hashed cache helpers
+uint64_t error_model_cached_slot(const error_model_params_cached_t* mp, const uint64_t key);
+void error_model_cached_grow(error_model_params_cached_t* mp);
+
+// DEFINITIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_create_cached
+	Wraps an error model so that each distinct error is only evaluated once
+	This is intended for expensive models (debug, composition or user models) that are called repeatedly within circuits
+	The cache is not locked and the model is marked as not thread safe, callers that share it between threads lock around each call
+	:: error_model* inner :: The model being cached, this is referenced and must outlive the cached model
+	:: const uint32_t n_qubits :: The number of qubits the model is called with
+	:: const error_model_cache_policy_t policy :: How the cache is stored
+	Returns a pointer to a new error model object on the heap, or NULL if the model is too large to be cached
+*/
+error_model* error_model_create_cached(error_model* inner, const uint32_t n_qubits, const error_model_cache_policy_t policy)
+{
+	if (ERROR_MODEL_CACHE_DENSE == policy && n_qubits > ERROR_MODEL_CACHE_MAX_DENSE_QUBITS)
+	{
+		printf("Too many qubits for a dense error model cache, use a hashed cache instead\n");
+		return NULL;
+	}
+	if (n_qubits >= ERROR_MODEL_CACHE_MAX_QUBITS)
+	{
+		printf("Too many qubits to key an error model cache\n");
+		return NULL;
+	}
+
+	error_model* m = error_model_create(sizeof(error_model_params_cached_t));
+	error_model_params_cached_t* mp = (error_model_params_cached_t*)malloc(sizeof(error_model_params_cached_t));
+
+	mp->inner = inner;
+	mp->n_qubits = n_qubits;
+	mp->policy = policy;
+	mp->n_entries = 0;
+	mp->hits = 0;
+	mp->misses = 0;
+
+	if (ERROR_MODEL_CACHE_DENSE == policy)
+	{
+		mp->probabilities = (double*)calloc(error_probabilities_entries_in_table(n_qubits), sizeof(double));
+		mp->filled = (uint8_t*)calloc(error_probabilities_entries_in_table(n_qubits), sizeof(uint8_t));
+		mp->keys = NULL;
+		mp->n_slots = 0;
+		mp->slot_bits = 0;
+	}
+	else
+	{
+		mp->slot_bits = ERROR_MODEL_CACHE_INITIAL_SLOT_BITS;
+		mp->n_slots = 1ull << mp->slot_bits;
+		mp->probabilities = (double*)malloc(sizeof(double) * mp->n_slots);
+		mp->keys = (uint64_t*)malloc(sizeof(uint64_t) * mp->n_slots);
+		memset(mp->keys, 0xFF, sizeof(uint64_t) * mp->n_slots);
+		mp->filled = NULL;
+	}
+
+	m->params = mp;
+	m->call = error_model_call_cached;
+	m->param_free = error_model_free_cached;
+
+	// Caching does not change the distribution
+	m->factorised = inner->factorised;
+
+	// Every call may write to the cache
+	m->thread_safe = 0;
+	return m;
+}
+
+/*
+	error_model_cached_stats
+	Reads the counters of a cached error model
+	:: const error_model* m :: A model created with error_model_create_cached
+	:: uint64_t* hits :: Set to the number of calls answered from the cache
+	:: uint64_t* misses :: Set to the number of calls passed to the inner model
+	Returns nothing
+*/
+void error_model_cached_stats(const error_model* m, uint64_t* hits, uint64_t* misses)
+{
+	error_model_params_cached_t* mp = (error_model_params_cached_t*)m->params;
+	*hits = mp->hits;
+	*misses = mp->misses;
+	return;
+}
+
+// Model Call
+double error_model_call_cached(const sym* error, void* v_model_params)
+{
+	error_model_params_cached_t* mp = (error_model_params_cached_t*)v_model_params;
+
+	// A larger error would key outside the dense cache, or collide with the empty slot marker of the hashed cache
+	if (1 != error->height || 2 * mp->n_qubits != error->length)
+	{
+		printf("Error does not match the number of qubits of the error model cache\n");
+		return 0;
+	}
+	uint64_t key = sym_to_ll(error);
+
+	if (ERROR_MODEL_CACHE_DENSE == mp->policy)
+	{
+		if (mp->filled[key])
+		{
+			mp->hits++;
+			return mp->probabilities[key];
+		}
+
+		mp->misses++;
+		mp->probabilities[key] = error_model_call(mp->inner, error);
+		mp->filled[key] = 1;
+		mp->n_entries++;
+		return mp->probabilities[key];
+	}
+
+	uint64_t slot = error_model_cached_slot(mp, key);
+	if (mp->keys[slot] == key)
+	{
+		mp->hits++;
+		return mp->probabilities[slot];
+	}
+
+	mp->misses++;
+	double prob = error_model_call(mp->inner, error);
+
+	// Keep the load factor at or below one half
+	if (2 * (mp->n_entries + 1) > mp->n_slots)
+	{
+		error_model_cached_grow(mp);
+		slot = error_model_cached_slot(mp, key);
+	}
+
+	mp->keys[slot] = key;
+	mp->probabilities[slot] = prob;
+	mp->n_entries++;
+	return prob;
+}
+
+// Finds the slot holding a key, or the empty slot it would be placed in
+uint64_t error_model_cached_slot(const error_model_params_cached_t* mp, const uint64_t key)
+{
+	// Fibonacci hashing spreads the low weight indices that dominate most distributions
+	// The high bits of the product depend on every bit of the key, the low bits only on the low bits of the key
+	uint64_t mask = mp->n_slots - 1;
+	uint64_t slot = (key * 0x9e3779b97f4a7c15ull) >> (64 - mp->slot_bits);
+	while (mp->keys[slot] != key && mp->keys[slot] != ERROR_MODEL_CACHE_EMPTY_KEY)
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+// Doubles the number of slots in the hashed cache and reinserts every entry
+void error_model_cached_grow(error_model_params_cached_t* mp)
+{
+	uint64_t n_old_slots = mp->n_slots;
+	uint64_t* old_keys = mp->keys;
+	double* old_probabilities = mp->probabilities;
+
+	mp->n_slots *= 2;
+	mp->slot_bits++;
+	mp->keys = (uint64_t*)malloc(sizeof(uint64_t) * mp->n_slots);
+	mp->probabilities = (double*)malloc(sizeof(double) * mp->n_slots);
+	memset(mp->keys, 0xFF, sizeof(uint64_t) * mp->n_slots);
+
+	for (uint64_t i = 0; i < n_old_slots; i++)
+	{
+		if (ERROR_MODEL_CACHE_EMPTY_KEY != old_keys[i])
+		{
+			uint64_t slot = error_model_cached_slot(mp, old_keys[i]);
+			mp->keys[slot] = old_keys[i];
+			mp->probabilities[slot] = old_probabilities[i];
+		}
+	}
+
+	free(old_keys);
+	free(old_probabilities);
+	return;
+}
+
+// Destructor, the inner model is not freed
+void error_model_free_cached(void* v_model_params)
+{
+	error_model_params_cached_t* mp = (error_model_params_cached_t*)v_model_params;
+	free(mp->probabilities);
+	if (NULL != mp->filled)
+	{
+		free(mp->filled);
+	}
+	if (NULL != mp->keys)
+	{
+		free(mp->keys);
+	}
+	free(mp);
+	return;
+}
+
+#endif
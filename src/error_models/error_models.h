@@ -59,6 +59,14 @@
 // The error model call function
 typedef double (*error_model_call_f)(const sym*, void*);
 
+// The error model polynomial call function
+// Adds the probability of the error to a coefficient vector, where coefficient w multiplies p^w (1 - p)^(n - w)
+typedef void (*error_model_poly_f)(const sym*, void*, double*);
+
+// The error model batch call function
+// Writes the probability of the error once for each lane of a parameter batch
+typedef void (*error_model_batch_f)(const sym*, void*, double*);
+
 // The error model paramater free function
 typedef void (*error_model_param_free_f)(void*);
 
@@ -77,6 +85,19 @@ typedef struct {
 	error_model_call_f call; // Called to calculate the error probability
 	error_model_copy_f copy; // Called to copy the error model
 	error_model_param_free_f param_free; // Called to free the model parameters
+	error_model_poly_f poly_call; // Optional, called to calculate the error probability as a polynomial in p
+	error_model_batch_f batch_call; // Optional, called to calculate the error probability for every lane of a batch
+
+	// Number of lanes filled by batch_call, zero for models that only have a single set of parameters
+	uint32_t n_lanes;
+
+	// Sampling
+	uint8_t factorised; // Set if the model is a product of independent single qubit channels, see error_model_sampler_create
+
+	// Threading
+	// Set if calls only read the parameters, so one model may be called from several threads at once
+	// Cleared for models whose calls write to their parameters, such as cached models, callers that share these between threads lock around each call
+	uint8_t thread_safe;
 } error_model;
 
 // DECLARATIONS ----------------------------------------------------------------------------------------
@@ -136,6 +157,28 @@ void error_model_param_free_default(void* params);
 */
 double error_model_call(error_model* m, const sym* error);
 
+/*
+	error_model_poly_call
+	Dispatch method to call the error model's polynomial probability function
+	:: error_model* m :: The error model object 
+	:: const sym* error :: The error
+	:: double* coefficients :: n_qubits + 1 coefficients that the probability of the error is added to
+	Returns 0 on success, or -1 if the model has no polynomial form
+*/
+int32_t error_model_poly_call(error_model* m, const sym* error, double* coefficients);
+
+/*
+	error_model_batch_call
+	Dispatch method to call the error model's batch probability function
+	Models without a batch of the right width have their single probability copied to every lane
+	:: error_model* m :: The error model object 
+	:: const sym* error :: The error
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	:: double* probabilities :: n_lanes probabilities that are written to
+	Returns nothing
+*/
+void error_model_batch_call(error_model* m, const sym* error, const uint32_t n_lanes, double* probabilities);
+
 // FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
 
 // Default constructor method for creating a new error model
@@ -152,6 +195,13 @@ error_model* error_model_create(const unsigned n_bytes)
 
 	m->n_bytes = n_bytes;
 	m->param_free = error_model_param_free_default;
+	m->poly_call = NULL;
+	m->batch_call = NULL;
+	m->n_lanes = 0;
+
+	m->factorised = 0;
+
+	m->thread_safe = 1;
 
 	return m;
 }
@@ -212,6 +262,11 @@ void* error_model_copy_default(void* v_em)
 	em_cpy->call = em->call;
 	em_cpy->copy = em->copy;
 	em_cpy->param_free = em->param_free; 
+	em_cpy->poly_call = em->poly_call;
+	em_cpy->batch_call = em->batch_call;
+	em_cpy->n_lanes = em->n_lanes;
+	em_cpy->factorised = em->factorised;
+	em_cpy->thread_safe = em->thread_safe;
 	return em;
 }
 
@@ -231,6 +286,52 @@ double error_model_call(error_model* m, const sym* error)
 	return m->call(error, m->params);
 }
 
+// Dispatch method for calling the polynomial error model probability
+/*
+	error_model_poly_call
+	Dispatch method to call the error model's polynomial probability function
+	:: error_model* m :: The error model object 
+	:: const sym* error :: The error
+	:: double* coefficients :: n_qubits + 1 coefficients that the probability of the error is added to
+	Returns 0 on success, or -1 if the model has no polynomial form
+*/
+int32_t error_model_poly_call(error_model* m, const sym* error, double* coefficients)
+{
+	if (NULL == m->poly_call)
+	{
+		return -1;
+	}
+	m->poly_call(error, m->params, coefficients);
+	return 0;
+}
+
+// Dispatch method for calling the batched error model probability
+/*
+	error_model_batch_call
+	Dispatch method to call the error model's batch probability function
+	Models without a batch of the right width have their single probability copied to every lane
+	:: error_model* m :: The error model object 
+	:: const sym* error :: The error
+	:: const uint32_t n_lanes :: The number of lanes in the batch
+	:: double* probabilities :: n_lanes probabilities that are written to
+	Returns nothing
+*/
+void error_model_batch_call(error_model* m, const sym* error, const uint32_t n_lanes, double* probabilities)
+{
+	if (NULL != m->batch_call && n_lanes == m->n_lanes)
+	{
+		m->batch_call(error, m->params, probabilities);
+		return;
+	}
+
+	double prob = m->call(error, m->params);
+	for (uint32_t i = 0; i < n_lanes; i++)
+	{
+		probabilities[i] = prob;
+	}
+	return;
+}
+
 // Dispatch method for calling copy
 /*
 	error_model_copy
@@ -15,6 +15,13 @@ typedef struct {
 	unsigned int n_qubits;
 } model_params_iid ;
 
+// Batched model params
+typedef struct {
+	unsigned int n_qubits;
+	uint32_t n_lanes;
+	double* p_errors;
+} model_params_iid_batch ;
+
 // DECLARATIONS ------------------------------------------------------------------------------------------------
 
 /*
@@ -29,6 +36,24 @@ error_model* error_model_create_iid(const unsigned int n_qubits, const double p_
 // Model Call
 double error_model_call_iid(const sym* error, void* v_model_params);
 
+// Polynomial Model Call
+void error_model_poly_call_iid(const sym* error, void* v_model_params, double* coefficients);
+
+/*
+	error_model_create_iid_batch
+	Model constructor for a batch of iid error models, lane i has an error rate of p_errors[i]
+	:: const unsigned n_qubits :: Number of physical qubits
+	:: const uint32_t n_lanes :: Number of error rates in the batch
+	:: const double* p_errors :: Probability of a physical error for each lane
+	Returns a pointer to a new error model object on the heap
+*/
+error_model* error_model_create_iid_batch(const unsigned int n_qubits, const uint32_t n_lanes, const double* p_errors);
+
+// Batched Model Calls
+double error_model_call_iid_batch(const sym* error, void* v_model_params);
+void error_model_batch_call_iid(const sym* error, void* v_model_params, double* probabilities);
+void error_model_free_iid_batch(void* v_model_params);
+
 
 // DEFINITIONS ------------------------------------------------------------------------------------------------
 
@@ -47,7 +72,9 @@ error_model* error_model_create_iid(const unsigned int n_qubits, const double p_
 	mp->p_error = p_error;
 	mp->n_qubits = n_qubits;
 	m->call = error_model_call_iid;
+	m->poly_call = error_model_poly_call_iid;
 	m->params = mp;
+	m->factorised = 1;
 	return m;
 }
 
@@ -61,4 +88,68 @@ double error_model_call_iid(const sym* error, void* v_model_params)
 	return prob;
 }
 
-#endif
\ No newline at end of file
+// Polynomial Model Call
+void error_model_poly_call_iid(const sym* error, void* v_model_params, double* coefficients)
+{
+	// The coefficients do not depend on the error rate, so the parameters are not needed
+	(void)v_model_params;
+	unsigned int weight = sym_weight(error);
+	coefficients[weight] += pow(1.0 / 3, weight);
+	return;
+}
+
+/*
+	error_model_create_iid_batch
+	Model constructor for a batch of iid error models, lane i has an error rate of p_errors[i]
+	:: const unsigned n_qubits :: Number of physical qubits
+	:: const uint32_t n_lanes :: Number of error rates in the batch
+	:: const double* p_errors :: Probability of a physical error for each lane
+	Returns a pointer to a new error model object on the heap
+*/
+error_model* error_model_create_iid_batch(const unsigned int n_qubits, const uint32_t n_lanes, const double* p_errors)
+{
+	error_model* m = error_model_create(sizeof(model_params_iid_batch));
+	model_params_iid_batch* mp = (model_params_iid_batch*)malloc(sizeof(model_params_iid_batch));
+
+	mp->n_qubits = n_qubits;
+	mp->n_lanes = n_lanes;
+	mp->p_errors = (double*)malloc(sizeof(double) * n_lanes);
+	memcpy(mp->p_errors, p_errors, sizeof(double) * n_lanes);
+
+	m->call = error_model_call_iid_batch;
+	m->batch_call = error_model_batch_call_iid;
+	m->n_lanes = n_lanes;
+	m->param_free = error_model_free_iid_batch;
+	m->params = mp;
+	return m;
+}
+
+// The single probability call uses the first lane
+double error_model_call_iid_batch(const sym* error, void* v_model_params)
+{
+	model_params_iid_batch* model_params = (model_params_iid_batch*)v_model_params;
+	unsigned int weight = sym_weight(error);
+	return pow(model_params->p_errors[0] / 3, weight) * pow(1.0 - model_params->p_errors[0], model_params->n_qubits - weight);
+}
+
+// The weight is found once and shared by every lane
+void error_model_batch_call_iid(const sym* error, void* v_model_params, double* probabilities)
+{
+	model_params_iid_batch* model_params = (model_params_iid_batch*)v_model_params;
+	unsigned int weight = sym_weight(error);
+	for (uint32_t i = 0; i < model_params->n_lanes; i++)
+	{
+		probabilities[i] = pow(model_params->p_errors[i] / 3, weight) * pow(1.0 - model_params->p_errors[i], model_params->n_qubits - weight);
+	}
+	return;
+}
+
+void error_model_free_iid_batch(void* v_model_params)
+{
+	model_params_iid_batch* model_params = (model_params_iid_batch*)v_model_params;
+	free(model_params->p_errors);
+	free(model_params);
+	return;
+}
+
+#endif
@@ -63,6 +63,12 @@ double error_model_call_iid_biased_X(const sym* error, void* v_model_params);
 double error_model_call_iid_biased_Y(const sym* error, void* v_model_params);
 double error_model_call_iid_biased_Z(const sym* error, void* v_model_params);
 
+// Polynomial Model Callers
+void error_model_poly_call_iid_biased_X(const sym* error, void* v_model_params, double* coefficients);
+void error_model_poly_call_iid_biased_Y(const sym* error, void* v_model_params, double* coefficients);
+void error_model_poly_call_iid_biased_Z(const sym* error, void* v_model_params, double* coefficients);
+void error_model_poly_call_iid_biased(const double bias, const unsigned int weight, const unsigned int biased_weight, double* coefficients);
+
 
 
 // BIASED IID ERROR MODEL FAMILY ------------------------------------------------------------------------------------------------
@@ -87,6 +93,7 @@ error_model* error_model_create_iid_biased(const unsigned int n_qubits, const do
 	mp->bias = bias;
 
 	m->params = mp;
+	m->factorised = 1;
 
 	return m;
 }
@@ -104,6 +111,7 @@ error_model* error_model_create_iid_biased_X(const unsigned int n_qubits, const
 	error_model* m = error_model_create_iid_biased(n_qubits, p_error, bias);
 
 	m->call = error_model_call_iid_biased_X;
+	m->poly_call = error_model_poly_call_iid_biased_X;
 
 	return m;
 }
@@ -121,6 +129,7 @@ error_model* error_model_create_iid_biased_Y(const unsigned int n_qubits, const
 	error_model* m = error_model_create_iid_biased(n_qubits, p_error, bias);
 
 	m->call = error_model_call_iid_biased_Y;
+	m->poly_call = error_model_poly_call_iid_biased_Y;
 
 	return m;
 }
@@ -138,6 +147,7 @@ error_model* error_model_create_iid_biased_Z(const unsigned int n_qubits, const
 	error_model* m = error_model_create_iid_biased(n_qubits, p_error, bias);
 
 	m->call = error_model_call_iid_biased_Z;
+	m->poly_call = error_model_poly_call_iid_biased_Z;
 
 	return m;
 }
@@ -193,4 +203,33 @@ double error_model_call_iid_biased_Z(const sym* error, void* v_model_params)
 		* pow(1 - model_params->p_error, model_params->n_qubits - weight)); 
 }
 
-#endif
\ No newline at end of file
+// Polynomial Model Callers
+void error_model_poly_call_iid_biased_X(const sym* error, void* v_model_params, double* coefficients)
+{
+	model_params_iid_biased* model_params = (model_params_iid_biased*)v_model_params;
+	error_model_poly_call_iid_biased(model_params->bias, sym_weight(error), sym_weight_X(error), coefficients);
+	return;
+}
+
+void error_model_poly_call_iid_biased_Y(const sym* error, void* v_model_params, double* coefficients)
+{
+	model_params_iid_biased* model_params = (model_params_iid_biased*)v_model_params;
+	error_model_poly_call_iid_biased(model_params->bias, sym_weight(error), sym_weight_Y(error), coefficients);
+	return;
+}
+
+void error_model_poly_call_iid_biased_Z(const sym* error, void* v_model_params, double* coefficients)
+{
+	model_params_iid_biased* model_params = (model_params_iid_biased*)v_model_params;
+	error_model_poly_call_iid_biased(model_params->bias, sym_weight(error), sym_weight_Z(error), coefficients);
+	return;
+}
+
+// The bias is held fixed, so p_b and p_nb are both constant multiples of p
+void error_model_poly_call_iid_biased(const double bias, const unsigned int weight, const unsigned int biased_weight, double* coefficients)
+{
+	coefficients[weight] += pow(bias / (2.0 + bias), biased_weight) * pow(1.0 / (2.0 + bias), weight - biased_weight);
+	return;
+}
+
+#endif
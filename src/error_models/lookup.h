@@ -1,30 +1,158 @@
 #ifndef ERROR_MODEL_LOOKUP
 #define ERROR_MODEL_LOOKUP
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include "error_models.h"
 #include "../circuits/error_probabilities.h"
 
 // Lookup Model Composition -------------------------------------------------------------------------------
- 
+
 typedef struct {
 	unsigned int n_qubits;
-	double* lookup_table;
+	error_probability_t* lookup_table;
+	void* mapping; // Start of the mapped file, NULL if the table lives on the heap
+	size_t mapping_bytes; // Size of the mapped region
 } error_model_params_lookup_t;
 
+// Binary lookup table files -------------------------------------------------------------------------------
+
+// Identifies a lookup table file, reads "QELT" in a hex dump
+#define ERROR_MODEL_LOOKUP_MAGIC 0x544C4551u
+
+// Largest table a file may hold, table indices are 64 bits wide
+#define ERROR_MODEL_LOOKUP_MAX_QUBITS 31
+
+// Data types that may be stored in a lookup table file
+#define ERROR_MODEL_LOOKUP_DTYPE_DOUBLE 0
+#define ERROR_MODEL_LOOKUP_DTYPE_FLOAT 1
+
+// The data type of the tables in this build, files of the other type are rejected
+#ifdef ERROR_PROBABILITIES_FLOAT
+#define ERROR_MODEL_LOOKUP_DTYPE ERROR_MODEL_LOOKUP_DTYPE_FLOAT
+#else
+#define ERROR_MODEL_LOOKUP_DTYPE ERROR_MODEL_LOOKUP_DTYPE_DOUBLE
+#endif
+
+/*
+ * error_model_lookup_header_t
+ * Header at the start of a lookup table file, the table itself immediately follows the header
+ * :: uint32_t magic :: Should be ERROR_MODEL_LOOKUP_MAGIC
+ * :: uint32_t n_qubits :: The number of qubits covered by the table
+ * :: uint32_t dtype :: The type of each entry in the table
+ * :: uint32_t header_bytes :: The offset from the start of the file to the table
+ * :: uint64_t checksum :: FNV-1a hash of the table
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t n_qubits;
+	uint32_t dtype;
+	uint32_t header_bytes;
+	uint64_t checksum;
+} error_model_lookup_header_t;
+
 
-error_model* error_model_create_lookup(unsigned int n_qubits, double* lookup_table);
+error_model* error_model_create_lookup(unsigned int n_qubits, error_probability_t* lookup_table);
+error_model* error_model_create_lookup_mmap(const char* filename, const uint8_t verify_checksum);
+int32_t error_model_lookup_save(const char* filename, const unsigned int n_qubits, const error_probability_t* lookup_table);
+uint64_t error_model_lookup_checksum(const void* data, const uint64_t n_bytes);
 double error_model_call_lookup(const sym* error, void* v_model_params);
 void error_model_free_lookup(void* v_model_params);
 
 // The lookup table is copied!
-error_model* error_model_create_lookup(unsigned int n_qubits, double* lookup_table)
+error_model* error_model_create_lookup(unsigned int n_qubits, error_probability_t* lookup_table)
 {
 	error_model* m = error_model_create(sizeof(error_model_params_lookup_t));
 	error_model_params_lookup_t* mp = (error_model_params_lookup_t*)malloc(sizeof(error_model_params_lookup_t));
 
 	mp->n_qubits = n_qubits;
-	
+
 	mp->lookup_table = error_probabilities_copy(mp->n_qubits, lookup_table);
+	mp->mapping = NULL;
+	mp->mapping_bytes = 0;
+
+	m->params = mp;
+	m->call = error_model_call_lookup;
+	m->param_free = error_model_free_lookup;
+	return m;
+}
+
+/*
+ * error_model_create_lookup_mmap
+ * Creates a lookup error model from a table saved with error_model_lookup_save
+ * The table is mapped read only rather than copied, so many models (and processes) can share the same pages
+ * :: const char* filename :: The file containing the table
+ * :: const uint8_t verify_checksum :: If set, the table is hashed and checked against the header, this touches every page
+ * Returns a new error model, or NULL if the file could not be mapped or is not a valid table
+ */
+error_model* error_model_create_lookup_mmap(const char* filename, const uint8_t verify_checksum)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+	{
+		printf("Error when opening file.\n");
+		return NULL;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) < 0 || (size_t)file_stat.st_size < sizeof(error_model_lookup_header_t))
+	{
+		printf("Lookup table file is too small to contain a header.\n");
+		close(fd);
+		return NULL;
+	}
+
+	void* mapping = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // The mapping holds its own reference to the file
+	if (MAP_FAILED == mapping)
+	{
+		printf("Could not map the lookup table file.\n");
+		return NULL;
+	}
+
+	// Validate the header before trusting any of the sizes in it
+	// The number of qubits is bounded before the table is sized, and the size of the table is checked against the
+	// space left in the file after the header so neither the shift nor the sum can overflow
+	error_model_lookup_header_t* header = (error_model_lookup_header_t*)mapping;
+	uint64_t file_bytes = (uint64_t)file_stat.st_size;
+	uint64_t table_bytes = 0;
+	uint8_t valid = ERROR_MODEL_LOOKUP_MAGIC == header->magic
+		&& ERROR_MODEL_LOOKUP_DTYPE == header->dtype
+		&& header->n_qubits <= ERROR_MODEL_LOOKUP_MAX_QUBITS
+		&& 0 == header->header_bytes % sizeof(error_probability_t)
+		&& header->header_bytes >= sizeof(error_model_lookup_header_t)
+		&& header->header_bytes <= file_bytes;
+	if (valid)
+	{
+		uint64_t n_entries = error_probabilities_entries_in_table(header->n_qubits);
+		valid = n_entries <= (file_bytes - header->header_bytes) / sizeof(error_probability_t);
+		table_bytes = n_entries * sizeof(error_probability_t);
+	}
+	if (!valid)
+	{
+		printf("Lookup table file has an invalid header.\n");
+		munmap(mapping, file_stat.st_size);
+		return NULL;
+	}
+
+	error_probability_t* lookup_table = (error_probability_t*)((BYTE*)mapping + header->header_bytes);
+	if (verify_checksum && error_model_lookup_checksum(lookup_table, table_bytes) != header->checksum)
+	{
+		printf("Lookup table checksum does not match.\n");
+		munmap(mapping, file_stat.st_size);
+		return NULL;
+	}
+
+	error_model* m = error_model_create(sizeof(error_model_params_lookup_t));
+	error_model_params_lookup_t* mp = (error_model_params_lookup_t*)malloc(sizeof(error_model_params_lookup_t));
+
+	mp->n_qubits = header->n_qubits;
+	mp->lookup_table = lookup_table;
+	mp->mapping = mapping;
+	mp->mapping_bytes = file_stat.st_size;
 
 	m->params = mp;
 	m->call = error_model_call_lookup;
@@ -32,6 +160,63 @@ error_model* error_model_create_lookup(unsigned int n_qubits, double* lookup_tab
 	return m;
 }
 
+/*
+ * error_model_lookup_save
+ * Writes a probability table to disk in the format read by error_model_create_lookup_mmap
+ * :: const char* filename :: The file to write to, this is overwritten
+ * :: const unsigned int n_qubits :: The number of qubits covered by the table
+ * :: const error_probability_t* lookup_table :: The table to be saved, for example the output of circuit_run
+ * Returns 0 on success, or -1 if the file could not be written
+ */
+int32_t error_model_lookup_save(const char* filename, const unsigned int n_qubits, const error_probability_t* lookup_table)
+{
+	FILE* f = fopen(filename, "wb");
+	if (NULL == f)
+	{
+		printf("Error when opening file.\n");
+		return -1;
+	}
+
+	uint64_t table_bytes = error_probabilities_bytes_in_table(n_qubits);
+
+	error_model_lookup_header_t header;
+	header.magic = ERROR_MODEL_LOOKUP_MAGIC;
+	header.n_qubits = n_qubits;
+	header.dtype = ERROR_MODEL_LOOKUP_DTYPE;
+	header.header_bytes = sizeof(error_model_lookup_header_t);
+	header.checksum = error_model_lookup_checksum(lookup_table, table_bytes);
+
+	if (1 != fwrite(&header, sizeof(error_model_lookup_header_t), 1, f)
+		|| table_bytes != fwrite(lookup_table, 1, table_bytes, f))
+	{
+		printf("Error when writing file.\n");
+		fclose(f);
+		return -1;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+/*
+ * error_model_lookup_checksum
+ * 64 bit FNV-1a hash used to detect corrupted or truncated table files
+ * :: const void* data :: The bytes to hash
+ * :: const uint64_t n_bytes :: The number of bytes to hash
+ * Returns the hash
+ */
+uint64_t error_model_lookup_checksum(const void* data, const uint64_t n_bytes)
+{
+	const BYTE* bytes = (const BYTE*)data;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (uint64_t i = 0; i < n_bytes; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
 double error_model_call_lookup(const sym* error, void* v_model_params)
 {
 	error_model_params_lookup_t* model_params = (error_model_params_lookup_t*)v_model_params;
@@ -41,7 +226,12 @@ double error_model_call_lookup(const sym* error, void* v_model_params)
 void error_model_free_lookup(void* v_model_params)
 {
 	error_model_params_lookup_t* model_params = (error_model_params_lookup_t*)v_model_params;
-	if (model_params->lookup_table != NULL)
+	if (model_params->mapping != NULL)
+	{
+		// Mapped tables are released with the mapping, not freed
+		munmap(model_params->mapping, model_params->mapping_bytes);
+	}
+	else if (model_params->lookup_table != NULL)
 	{
 		free(model_params->lookup_table);
 	}
@@ -53,4 +243,4 @@ void error_model_free_lookup(void* v_model_params)
 	return;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,106 @@
+#ifndef ERROR_MODEL_POLY
+#define ERROR_MODEL_POLY
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Polynomial error probabilities ------------------------------------------------------------------------------------------------
+// A probability over n qubits is stored as n + 1 coefficients c_w of p^w (1 - p)^(n - w)
+// Every coefficient is non-negative for the iid style models, so these are well conditioned even for large n
+// Dropping the high weight coefficients truncates the polynomial to leading order in p
+
+// Number of coefficients in a polynomial over n qubits
+#define ERROR_POLY_LENGTH(n_qubits) ((n_qubits) + 1)
+
+// DECLARATIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_poly_zeros
+	Allocates a zeroed array of polynomials
+	:: const uint32_t n_qubits :: The number of qubits covered by each polynomial
+	:: const uint64_t n_polys :: The number of polynomials
+	Returns a heap array of n_polys * (n_qubits + 1) zeros
+*/
+double* error_poly_zeros(const uint32_t n_qubits, const uint64_t n_polys);
+
+/*
+	error_poly_eval
+	Evaluates a polynomial at a given physical error rate
+	:: const double* coefficients :: The n_qubits + 1 coefficients
+	:: const uint32_t n_qubits :: The number of qubits covered by the polynomial
+	:: const double p :: The physical error rate
+	Returns the probability
+*/
+double error_poly_eval(const double* coefficients, const uint32_t n_qubits, const double p);
+
+/*
+	error_poly_eval_array
+	Evaluates an array of polynomials at a given physical error rate
+	:: const double* polys :: The polynomials, each of n_qubits + 1 coefficients
+	:: const uint32_t n_qubits :: The number of qubits covered by each polynomial
+	:: const uint64_t n_polys :: The number of polynomials
+	:: const double p :: The physical error rate
+	Returns a heap array of n_polys probabilities
+*/
+double* error_poly_eval_array(const double* polys, const uint32_t n_qubits, const uint64_t n_polys, const double p);
+
+// DEFINITIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_poly_zeros
+	Allocates a zeroed array of polynomials
+	:: const uint32_t n_qubits :: The number of qubits covered by each polynomial
+	:: const uint64_t n_polys :: The number of polynomials
+	Returns a heap array of n_polys * (n_qubits + 1) zeros
+*/
+double* error_poly_zeros(const uint32_t n_qubits, const uint64_t n_polys)
+{
+	return (double*)calloc(n_polys * ERROR_POLY_LENGTH(n_qubits), sizeof(double));
+}
+
+/*
+	error_poly_eval
+	Evaluates a polynomial at a given physical error rate
+	:: const double* coefficients :: The n_qubits + 1 coefficients
+	:: const uint32_t n_qubits :: The number of qubits covered by the polynomial
+	:: const double p :: The physical error rate
+	Returns the probability
+*/
+double error_poly_eval(const double* coefficients, const uint32_t n_qubits, const double p)
+{
+	if (p >= 1.0)
+	{
+		return coefficients[n_qubits];
+	}
+
+	// Horner's method in p / (1 - p), then scale by (1 - p)^n
+	double ratio = p / (1.0 - p);
+	double total = 0;
+	for (int64_t w = n_qubits; w >= 0; w--)
+	{
+		total = total * ratio + coefficients[w];
+	}
+	return total * pow(1.0 - p, n_qubits);
+}
+
+/*
+	error_poly_eval_array
+	Evaluates an array of polynomials at a given physical error rate
+	:: const double* polys :: The polynomials, each of n_qubits + 1 coefficients
+	:: const uint32_t n_qubits :: The number of qubits covered by each polynomial
+	:: const uint64_t n_polys :: The number of polynomials
+	:: const double p :: The physical error rate
+	Returns a heap array of n_polys probabilities
+*/
+double* error_poly_eval_array(const double* polys, const uint32_t n_qubits, const uint64_t n_polys, const double p)
+{
+	double* probabilities = (double*)malloc(sizeof(double) * n_polys);
+	for (uint64_t i = 0; i < n_polys; i++)
+	{
+		probabilities[i] = error_poly_eval(polys + i * ERROR_POLY_LENGTH(n_qubits), n_qubits, p);
+	}
+	return probabilities;
+}
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef ERROR_MODEL_SAMPLE
+#define ERROR_MODEL_SAMPLE
+
+#include "error_models.h"
+#include "../sym_iter.h"
+#include "../misc/rng.h"
+#include "../misc/alias_table.h"
+
+// Largest number of qubits for which a global table over all 4^n errors will be built
+#define ERROR_MODEL_SAMPLE_MAX_GLOBAL_QUBITS 14
+
+// Error model sampling ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_sampler_t:
+	Alias tables built from an error model, draws are O(1) per qubit for factorised models and O(1) overall for everything else
+	The sampler is built and freed by the caller and is not stored on the model, so building one does not write to a shared model
+	:: uint32_t n_qubits :: The number of qubits the sampler was built for
+	:: uint8_t factorised :: Set if there is one table per qubit, otherwise there is a single table over all errors
+	:: alias_table** tables :: Per qubit tables indexed by the (X, Z) bits of the pauli, or the single global table
+	:: double* p_error :: The probability that each table draws anything other than the identity
+	:: alias_table** errors :: Each table without the identity, entry i is outcome i + 1, NULL if p_error is zero
+	Drawing from p_error and then from errors lets many shots skip the identity together, see frame_simulator_inject
+*/
+typedef struct {
+	uint32_t n_qubits;
+	uint8_t factorised;
+	alias_table** tables;
+	double* p_error;
+	alias_table** errors;
+} error_model_sampler_t;
+
+// DECLARATIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_sampler_create
+	Builds the alias tables for an error model
+	This should be freed using the 'error_model_sampler_free' function
+	:: error_model* m :: The error model
+	:: const uint32_t n_qubits :: The number of qubits to build the tables for
+	Returns a heap pointer to the sampler, or NULL if no sampler could be built
+*/
+error_model_sampler_t* error_model_sampler_create(error_model* m, const uint32_t n_qubits);
+
+/*
+	error_model_sampler_draw
+	Draws an error from a sampler, the sampler is only read so many threads may draw from it at once
+	:: const error_model_sampler_t* sampler :: The sampler
+	:: rng* r :: The random number generator, each thread should own its own
+	:: sym* out :: Height one sym object that the error is written to, its length should match the sampler
+	Returns nothing
+*/
+void error_model_sampler_draw(const error_model_sampler_t* sampler, rng* r, sym* out);
+
+/*
+	error_model_sampler_free
+	Frees a sampler and its alias tables
+	:: error_model_sampler_t* sampler :: The sampler
+	Returns nothing
+*/
+void error_model_sampler_free(error_model_sampler_t* sampler);
+
+// Splits the identity from a table, the weights of the other outcomes give a table conditioned on an error
+void error_model_sampler_errors(const double* weights, const uint64_t n_entries, double* p_error, alias_table** errors);
+
+// DEFINITIONS ------------------------------------------------------------------------------------------------
+
+/*
+	error_model_sampler_create
+	Builds the alias tables for an error model
+	This should be freed using the 'error_model_sampler_free' function
+	:: error_model* m :: The error model
+	:: const uint32_t n_qubits :: The number of qubits to build the tables for
+	Returns a heap pointer to the sampler, or NULL if no sampler could be built
+*/
+error_model_sampler_t* error_model_sampler_create(error_model* m, const uint32_t n_qubits)
+{
+	error_model_sampler_t* sampler = (error_model_sampler_t*)malloc(sizeof(error_model_sampler_t));
+	sampler->n_qubits = n_qubits;
+	sampler->factorised = 0;
+	sampler->tables = NULL;
+	sampler->p_error = NULL;
+	sampler->errors = NULL;
+
+	sym* error = sym_create(1, 2 * n_qubits);
+	double p_identity = error_model_call(m, error);
+
+	if (m->factorised && p_identity > 0)
+	{
+		// Each single qubit marginal is proportional to the ratio against the identity
+		sampler->factorised = 1;
+		sampler->tables = (alias_table**)malloc(sizeof(alias_table*) * n_qubits);
+		sampler->p_error = (double*)malloc(sizeof(double) * n_qubits);
+		sampler->errors = (alias_table**)malloc(sizeof(alias_table*) * n_qubits);
+		for (uint32_t i = 0; i < n_qubits; i++)
+		{
+			double weights[4];
+			for (uint32_t pauli = 0; pauli < 4; pauli++)
+			{
+				sym_set(error, 0, i, pauli >> 1);
+				sym_set(error, 0, i + n_qubits, pauli & 1);
+				weights[pauli] = error_model_call(m, error) / p_identity;
+			}
+			sym_set(error, 0, i, 0);
+			sym_set(error, 0, i + n_qubits, 0);
+
+			sampler->tables[i] = alias_table_create(weights, 4);
+			error_model_sampler_errors(weights, 4, sampler->p_error + i, sampler->errors + i);
+		}
+	}
+	else
+	{
+		if (n_qubits > ERROR_MODEL_SAMPLE_MAX_GLOBAL_QUBITS)
+		{
+			printf("Error model is not factorised and is too large to build a global sampling table\n");
+			sym_free(error);
+			free(sampler);
+			return NULL;
+		}
+
+		uint64_t n_entries = 1ull << (2 * n_qubits);
+		double* weights = (double*)malloc(sizeof(double) * n_entries);
+
+		sym_iter* siter = sym_iter_create_n_qubits(n_qubits);
+		while (sym_iter_next(siter))
+		{
+			weights[sym_to_ll(siter->state)] = error_model_call(m, siter->state);
+		}
+		sym_iter_free(siter);
+
+		sampler->tables = (alias_table**)malloc(sizeof(alias_table*));
+		sampler->tables[0] = alias_table_create(weights, n_entries);
+
+		if (NULL == sampler->tables[0])
+		{
+			free(sampler->tables);
+			sampler->tables = NULL;
+		}
+		else
+		{
+			sampler->p_error = (double*)malloc(sizeof(double));
+			sampler->errors = (alias_table**)malloc(sizeof(alias_table*));
+			error_model_sampler_errors(weights, n_entries, sampler->p_error, sampler->errors);
+		}
+		free(weights);
+	}
+
+	sym_free(error);
+
+	if (NULL == sampler->tables)
+	{
+		free(sampler);
+		return NULL;
+	}
+	return sampler;
+}
+
+/*
+	error_model_sampler_draw
+	Draws an error from a sampler, the sampler is only read so many threads may draw from it at once
+	:: const error_model_sampler_t* sampler :: The sampler
+	:: rng* r :: The random number generator, each thread should own its own
+	:: sym* out :: Height one sym object that the error is written to, its length should match the sampler
+	Returns nothing
+*/
+void error_model_sampler_draw(const error_model_sampler_t* sampler, rng* r, sym* out)
+{
+	uint32_t n_qubits = sampler->n_qubits;
+	if (sampler->factorised)
+	{
+		for (uint32_t i = 0; i < n_qubits; i++)
+		{
+			uint64_t pauli = alias_table_sample(sampler->tables[i], r);
+			sym_set(out, 0, i, pauli >> 1);
+			sym_set(out, 0, i + n_qubits, pauli & 1);
+		}
+	}
+	else
+	{
+		// Unpack the index in the same order as sym_to_ll
+		uint64_t error = alias_table_sample(sampler->tables[0], r);
+		for (uint32_t i = 0; i < out->length; i++)
+		{
+			sym_set(out, 0, i, (error >> (out->length - 1 - i)) & 1);
+		}
+	}
+	return;
+}
+
+/*
+	error_model_sampler_free
+	Frees a sampler and its alias tables
+	:: error_model_sampler_t* sampler :: The sampler
+	Returns nothing
+*/
+void error_model_sampler_free(error_model_sampler_t* sampler)
+{
+	uint32_t n_tables = sampler->factorised ? sampler->n_qubits : 1;
+	for (uint32_t i = 0; i < n_tables; i++)
+	{
+		alias_table_free(sampler->tables[i]);
+		alias_table_free(sampler->errors[i]);
+	}
+	free(sampler->tables);
+	free(sampler->p_error);
+	free(sampler->errors);
+	free(sampler);
+	return;
+}
+
+// Splits the identity from a table, the weights of the other outcomes give a table conditioned on an error
+void error_model_sampler_errors(const double* weights, const uint64_t n_entries, double* p_error, alias_table** errors)
+{
+	double total = 0;
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		total += weights[i];
+	}
+
+	*p_error = (total > 0) ? (total - weights[0]) / total : 0;
+	*errors = (*p_error > 0) ? alias_table_create(weights + 1, n_entries - 1) : NULL;
+	if (NULL == *errors)
+	{
+		*p_error = 0;
+	}
+	return;
+}
+
+#endif
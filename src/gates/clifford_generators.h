@@ -61,6 +61,58 @@ gate_result* gate_phase(const sym* initial_state, const void* gate_data, const u
  */
 gate_result* gate_identity(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
 
+/*
+ * gate_cnot_emit
+ * Implements a cnot gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the control, [1] is the target
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_cnot_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_hadamard_emit
+ * Implements a hadamard gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_hadamard_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_phase_emit
+ * Implements a phase gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_phase_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_identity_emit
+ * Implements an identity gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_identity_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DEFINITIONS
 // ----------------------------------------------------------------------------------------
@@ -136,4 +188,91 @@ gate_result* gate_identity(const sym* initial_state, const void* gate_data, cons
 	return gate_result_create_single(1, final_state);
 }
 
+/*
+ * gate_cnot_emit
+ * Implements a cnot gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the control, [1] is the target
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_cnot_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint64_t control_X = gate_emit_X_bit(n_qubits, target_qubits[0]);
+    uint64_t control_Z = gate_emit_Z_bit(n_qubits, target_qubits[0]);
+    uint64_t target_X = gate_emit_X_bit(n_qubits, target_qubits[1]);
+    uint64_t target_Z = gate_emit_Z_bit(n_qubits, target_qubits[1]);
+
+    uint64_t final_state = index;
+    if (index & control_X) final_state ^= target_X;
+    if (index & target_Z) final_state ^= control_Z;
+
+    emit(final_state, 1, ctx);
+    return;
+}
+
+/*
+ * gate_hadamard_emit
+ * Implements a hadamard gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_hadamard_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint64_t target_X = gate_emit_X_bit(n_qubits, target_qubits[0]);
+    uint64_t target_Z = gate_emit_Z_bit(n_qubits, target_qubits[0]);
+
+    // Swap the X and Z bits when they differ
+    uint64_t final_state = index;
+    if (!(index & target_X) != !(index & target_Z)) final_state ^= target_X | target_Z;
+
+    emit(final_state, 1, ctx);
+    return;
+}
+
+/*
+ * gate_phase_emit
+ * Implements a phase gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_phase_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint64_t final_state = index;
+    if (index & gate_emit_X_bit(n_qubits, target_qubits[0])) final_state ^= gate_emit_Z_bit(n_qubits, target_qubits[0]);
+
+    emit(final_state, 1, ctx);
+    return;
+}
+
+/*
+ * gate_identity_emit
+ * Implements an identity gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_identity_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    emit(index, 1, ctx);
+    return;
+}
+
 #endif
\ No newline at end of file
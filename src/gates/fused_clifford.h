@@ -0,0 +1,330 @@
+#ifndef GATE_FUSED_CLIFFORD
+#define GATE_FUSED_CLIFFORD
+
+#include "gates.h"
+#include "gate_result.h"
+
+#include "../sym.h"
+
+// ----------------------------------------------------------------------------------------
+// FUSED CLIFFORD GATES
+// A run of noiseless Clifford and Pauli gates on a few qubits maps each pauli string on those qubits to exactly one
+// other pauli string, so the whole run is a single permutation of the local strings
+// A fused gate stores that permutation, and the run then costs one pass over the table rather than one pass per gate
+// The fused gate is applied in place, a block at a time, as with the noise kernel
+// ----------------------------------------------------------------------------------------
+
+// Largest number of qubits covered by a fused gate, the permutation has 4^k entries
+#define GATE_FUSED_MAX_QUBITS 4
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_fused_clifford_t
+ * The permutation of a fused gate, both arrays are indexed as by sym_to_ll on the fused qubits
+ * :: uint32_t n_qubits :: The number of qubits covered by the fused gate
+ * :: uint32_t* image :: The local string that each local string is mapped to
+ * :: uint32_t* source :: The local string that is mapped onto each local string, the inverse of image
+ */
+typedef struct {
+	uint32_t n_qubits;
+	uint32_t* image;
+	uint32_t* source;
+} gate_fused_clifford_t;
+
+// Data shared by the pool workers applying a fused gate
+typedef struct
+{
+	const gate_fused_clifford_t* fused;
+	error_probability_t* table;
+	uint32_t n_positions;
+	const uint32_t* positions;
+	const uint64_t* offsets;
+} gate_fused_clifford_task_t;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_create_fused_clifford
+ * Creates a fused gate that starts as the identity, gates are added with gate_fused_clifford_append
+ * :: const unsigned n_qubits :: The number of qubits covered, at most GATE_FUSED_MAX_QUBITS
+ * Returns a heap pointer to the new gate, this should be freed with gate_fused_clifford_free
+ */
+gate* gate_create_fused_clifford(const unsigned n_qubits);
+
+/*
+ * gate_fused_clifford_fusible
+ * Checks if a gate can be added to a fused gate
+ * :: const gate* g :: The gate
+ * Returns 1 if the gate is a noiseless Clifford, Pauli or fused gate, or 0 otherwise
+ */
+uint8_t gate_fused_clifford_fusible(const gate* g);
+
+/*
+ * gate_fused_clifford_append
+ * Adds a gate to the end of a fused gate
+ * :: gate* fused :: The fused gate
+ * :: const gate* g :: The gate being added, this should be fusible
+ * :: const unsigned* local_targets :: The qubits the gate acts on, numbered within the fused gate
+ * Returns nothing
+ */
+void gate_fused_clifford_append(gate* fused, const gate* g, const unsigned* local_targets);
+
+/*
+ * gate_fused_clifford
+ * Applies a fused gate to a sym object
+ * :: const sym* initial state :: The state to apply the gate to
+ * :: const void* gate_data :: The fused gate
+ * :: const unsigned* target_qubits :: The qubits covered by the fused gate
+ * Returns a gate result object containing the new sym object as its only entry
+ */
+gate_result* gate_fused_clifford(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+
+/*
+ * gate_fused_clifford_emit
+ * Applies a fused gate to the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The fused gate
+ * :: const unsigned* target_qubits :: The qubits covered by the fused gate
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_fused_clifford_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_kernel_fused_clifford
+ * Applies the permutation of a fused gate directly to a probability table in place
+ * Each block of the table is gathered and written back permuted, the blocks are split between the threads of the default pool
+ * :: error_probability_t* table :: The table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* target_qubits :: The qubits covered by the fused gate
+ * :: const gate* g :: The fused gate
+ * Returns nothing
+ */
+void gate_kernel_fused_clifford(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits, const gate* g);
+
+// Pool task, permutes a range of blocks
+void gate_fused_clifford_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker);
+
+/*
+ * gate_fused_clifford_free
+ * Frees a fused gate and its permutation
+ * :: gate* g :: The fused gate
+ * Returns nothing
+ */
+void gate_fused_clifford_free(gate* g);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_create_fused_clifford
+ * Creates a fused gate that starts as the identity, gates are added with gate_fused_clifford_append
+ * :: const unsigned n_qubits :: The number of qubits covered, at most GATE_FUSED_MAX_QUBITS
+ * Returns a heap pointer to the new gate, this should be freed with gate_fused_clifford_free
+ */
+gate* gate_create_fused_clifford(const unsigned n_qubits)
+{
+	if (n_qubits > GATE_FUSED_MAX_QUBITS)
+	{
+		printf("Fused gates may cover at most %d qubits\n", GATE_FUSED_MAX_QUBITS);
+		return NULL;
+	}
+
+	gate_fused_clifford_t* fused = (gate_fused_clifford_t*)malloc(sizeof(gate_fused_clifford_t));
+	uint32_t n_local = 1u << (2 * n_qubits);
+
+	fused->n_qubits = n_qubits;
+	fused->image = (uint32_t*)malloc(sizeof(uint32_t) * n_local);
+	fused->source = (uint32_t*)malloc(sizeof(uint32_t) * n_local);
+	for (uint32_t local = 0; local < n_local; local++)
+	{
+		fused->image[local] = local;
+		fused->source[local] = local;
+	}
+
+	return gate_create(n_qubits, gate_fused_clifford, NULL, fused);
+}
+
+/*
+ * gate_fused_clifford_fusible
+ * Checks if a gate can be added to a fused gate
+ * :: const gate* g :: The gate
+ * Returns 1 if the gate is a noiseless Clifford, Pauli or fused gate, or 0 otherwise
+ */
+uint8_t gate_fused_clifford_fusible(const gate* g)
+{
+	if (NULL != g->gate_error_model || NULL == g->operation)
+	{
+		return 0;
+	}
+	return (gate_fused_clifford == g->operation || NULL != gate_kernel_lookup(g->operation));
+}
+
+/*
+ * gate_fused_clifford_append
+ * Adds a gate to the end of a fused gate
+ * :: gate* fused :: The fused gate
+ * :: const gate* g :: The gate being added, this should be fusible
+ * :: const unsigned* local_targets :: The qubits the gate acts on, numbered within the fused gate
+ * Returns nothing
+ */
+void gate_fused_clifford_append(gate* fused, const gate* g, const unsigned* local_targets)
+{
+	gate_fused_clifford_t* data = (gate_fused_clifford_t*)fused->operation_data;
+	uint32_t n_local = 1u << (2 * data->n_qubits);
+
+	// Label each local string with the string that currently lands on it, then let the gate move the labels
+	// The labels that land on each string after the gate are the new sources
+	error_probability_t labels[1u << (2 * GATE_FUSED_MAX_QUBITS)];
+	for (uint32_t local = 0; local < n_local; local++)
+	{
+		labels[local] = data->source[local];
+	}
+
+	gate_kernel_apply(g, labels, data->n_qubits, local_targets);
+
+	for (uint32_t local = 0; local < n_local; local++)
+	{
+		data->source[local] = (uint32_t)labels[local];
+		data->image[data->source[local]] = local;
+	}
+	return;
+}
+
+/*
+ * gate_fused_clifford
+ * Applies a fused gate to a sym object
+ * :: const sym* initial state :: The state to apply the gate to
+ * :: const void* gate_data :: The fused gate
+ * :: const unsigned* target_qubits :: The qubits covered by the fused gate
+ * Returns a gate result object containing the new sym object as its only entry
+ */
+gate_result* gate_fused_clifford(const sym* initial_state, const void* gate_data, const unsigned* target_qubits)
+{
+	const gate_fused_clifford_t* data = (const gate_fused_clifford_t*)((const gate*)gate_data)->operation_data;
+	uint32_t k = data->n_qubits;
+
+	// Local qubit j has its X bit at (2k - 1 - j) and its Z bit at (k - 1 - j) of the local index
+	uint32_t local = 0;
+	for (uint32_t j = 0; j < k; j++)
+	{
+		local |= (uint32_t)sym_get_X(initial_state, 0, target_qubits[j]) << (2 * k - 1 - j);
+		local |= (uint32_t)sym_get_Z(initial_state, 0, target_qubits[j]) << (k - 1 - j);
+	}
+
+	uint32_t mapped = data->image[local];
+
+	sym* final_state = sym_copy(initial_state);
+	for (uint32_t j = 0; j < k; j++)
+	{
+		sym_set_X(final_state, 0, target_qubits[j], (mapped >> (2 * k - 1 - j)) & 1);
+		sym_set_Z(final_state, 0, target_qubits[j], (mapped >> (k - 1 - j)) & 1);
+	}
+	return gate_result_create_single(1, final_state);
+}
+
+/*
+ * gate_fused_clifford_emit
+ * Applies a fused gate to the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The fused gate
+ * :: const unsigned* target_qubits :: The qubits covered by the fused gate
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_fused_clifford_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+	const gate_fused_clifford_t* data = (const gate_fused_clifford_t*)((const gate*)gate_data)->operation_data;
+	uint32_t k = data->n_qubits;
+
+	// Gather the local index as gate_fused_clifford does, then scatter the mapped bits back
+	uint32_t local = 0;
+	for (uint32_t j = 0; j < k; j++)
+	{
+		local |= (uint32_t)!!(index & gate_emit_X_bit(n_qubits, target_qubits[j])) << (2 * k - 1 - j);
+		local |= (uint32_t)!!(index & gate_emit_Z_bit(n_qubits, target_qubits[j])) << (k - 1 - j);
+	}
+
+	uint32_t mapped = data->image[local];
+
+	uint64_t final_state = index;
+	for (uint32_t j = 0; j < k; j++)
+	{
+		uint64_t target_X = gate_emit_X_bit(n_qubits, target_qubits[j]);
+		uint64_t target_Z = gate_emit_Z_bit(n_qubits, target_qubits[j]);
+		final_state &= ~(target_X | target_Z);
+		if ((mapped >> (2 * k - 1 - j)) & 1) final_state |= target_X;
+		if ((mapped >> (k - 1 - j)) & 1) final_state |= target_Z;
+	}
+
+	emit(final_state, 1, ctx);
+	return;
+}
+
+/*
+ * gate_kernel_fused_clifford
+ * Applies the permutation of a fused gate directly to a probability table in place
+ * Each block of the table is gathered and written back permuted, the blocks are split between the threads of the default pool
+ * :: error_probability_t* table :: The table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* target_qubits :: The qubits covered by the fused gate
+ * :: const gate* g :: The fused gate
+ * Returns nothing
+ */
+void gate_kernel_fused_clifford(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits, const gate* g)
+{
+	const gate_fused_clifford_t* fused = (const gate_fused_clifford_t*)g->operation_data;
+
+	uint32_t positions[2 * GATE_FUSED_MAX_QUBITS];
+	uint64_t offsets[1u << (2 * GATE_FUSED_MAX_QUBITS)];
+	gate_kernel_block_layout(n_qubits, fused->n_qubits, target_qubits, positions, offsets);
+
+	gate_fused_clifford_task_t task_data = {fused, table, 2 * fused->n_qubits, positions, offsets};
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> task_data.n_positions;
+	thread_pool_parallel_for(thread_pool_default(), n_blocks, gate_fused_clifford_task, &task_data);
+	return;
+}
+
+// Pool task, permutes a range of blocks
+void gate_fused_clifford_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker)
+{
+	gate_fused_clifford_task_t* task_data = (gate_fused_clifford_task_t*)data;
+	uint32_t n_local = 1u << task_data->n_positions;
+	error_probability_t local_probabilities[1u << (2 * GATE_FUSED_MAX_QUBITS)];
+
+	for (uint64_t block = block_start; block < block_end; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, task_data->positions, task_data->n_positions);
+		for (uint32_t local = 0; local < n_local; local++)
+		{
+			local_probabilities[local] = task_data->table[base | task_data->offsets[local]];
+		}
+		for (uint32_t local = 0; local < n_local; local++)
+		{
+			task_data->table[base | task_data->offsets[local]] = local_probabilities[task_data->fused->source[local]];
+		}
+	}
+	return;
+}
+
+/*
+ * gate_fused_clifford_free
+ * Frees a fused gate and its permutation
+ * :: gate* g :: The fused gate
+ * Returns nothing
+ */
+void gate_fused_clifford_free(gate* g)
+{
+	gate_fused_clifford_t* fused = (gate_fused_clifford_t*)g->operation_data;
+	free(fused->image);
+	free(fused->source);
+	free(fused);
+	free(g);
+	return;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef GATE_EMIT
+#define GATE_EMIT
+
+#include "gates.h"
+#include "gate_result.h"
+
+// ----------------------------------------------------------------------------------------
+// GATE EMIT
+// A gate_operation_f builds a gate_result, which costs several heap blocks and a sym for every outcome
+// The emit form of a gate works on table indices instead, and hands each outcome to a callback as it is found
+// Table loops then consume the outcomes without touching the allocator
+//
+// The index of a pauli string is its sym_to_ll value, for n qubits the X bit of qubit q sits at bit (2n - 1 - q)
+// and the Z bit at (n - 1 - q), as with the gate kernels
+// Measurements emit the sym_to_ll value of their outcome bits
+//
+// The built in gates have emit forms that are found by gate_create, other gates are called through an adapter
+// that converts to and from sym objects, so custom gates keep working unchanged
+// ----------------------------------------------------------------------------------------
+
+// The generators are declared here and defined in their own headers, which are included at the end of gates.h
+gate_result* gate_measure_X(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_measure_Y(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_measure_Z(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_prepare_X(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_prepare_Y(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_prepare_Z(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+
+void gate_cnot_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_hadamard_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_phase_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_identity_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_pauli_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_pauli_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_pauli_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_fused_clifford_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_measure_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_measure_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_measure_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_prepare_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_prepare_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+void gate_prepare_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_emit_lookup
+ * Finds the emit form of a gate operation
+ * :: gate_operation_f operation :: The gate operation
+ * Returns the emit form, or NULL if the operation has none
+ */
+gate_emit_operation_f gate_emit_lookup(gate_operation_f operation);
+
+/*
+ * gate_emit
+ * Applies the operation of a gate to a single pauli string, passing each outcome to a callback
+ * Gates without an emit form are called through gate_emit_adapter
+ * :: const gate* g :: The gate
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * :: gate_emit_f emit :: Called once for each outcome
+ * :: void* ctx :: Passed to every call of emit
+ * Returns nothing
+ */
+void gate_emit(const gate* g, const uint64_t index, const unsigned n_qubits, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_emit_adapter
+ * Calls the sym form of a gate and emits each entry of its result, this allocates as gate_operation does
+ * :: const gate* g :: The gate
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * :: gate_emit_f emit :: Called once for each outcome
+ * :: void* ctx :: Passed to every call of emit
+ * Returns nothing
+ */
+void gate_emit_adapter(const gate* g, const uint64_t index, const unsigned n_qubits, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+// Emit callback that keeps the last outcome, ctx is a uint64_t*
+// For gates with a single outcome, such as Paulis and measurements
+void gate_emit_single(const uint64_t index, const double prob, void* ctx);
+
+// The bit of a table index that holds the X or Z part of a qubit
+uint64_t gate_emit_X_bit(const unsigned n_qubits, const unsigned qubit);
+uint64_t gate_emit_Z_bit(const unsigned n_qubits, const unsigned qubit);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_emit_lookup
+ * Finds the emit form of a gate operation
+ * :: gate_operation_f operation :: The gate operation
+ * Returns the emit form, or NULL if the operation has none
+ */
+gate_emit_operation_f gate_emit_lookup(gate_operation_f operation)
+{
+	if (NULL == operation) return NULL;
+	if (gate_cnot == operation) return gate_cnot_emit;
+	if (gate_hadamard == operation) return gate_hadamard_emit;
+	if (gate_phase == operation) return gate_phase_emit;
+	if (gate_identity == operation) return gate_identity_emit;
+	if (gate_pauli_X == operation) return gate_pauli_X_emit;
+	if (gate_pauli_Y == operation) return gate_pauli_Y_emit;
+	if (gate_pauli_Z == operation) return gate_pauli_Z_emit;
+	if (gate_fused_clifford == operation) return gate_fused_clifford_emit;
+	if (gate_measure_X == operation) return gate_measure_X_emit;
+	if (gate_measure_Y == operation) return gate_measure_Y_emit;
+	if (gate_measure_Z == operation) return gate_measure_Z_emit;
+	if (gate_prepare_X == operation) return gate_prepare_X_emit;
+	if (gate_prepare_Y == operation) return gate_prepare_Y_emit;
+	if (gate_prepare_Z == operation) return gate_prepare_Z_emit;
+	return NULL;
+}
+
+/*
+ * gate_emit
+ * Applies the operation of a gate to a single pauli string, passing each outcome to a callback
+ * Gates without an emit form are called through gate_emit_adapter
+ * :: const gate* g :: The gate
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * :: gate_emit_f emit :: Called once for each outcome
+ * :: void* ctx :: Passed to every call of emit
+ * Returns nothing
+ */
+void gate_emit(const gate* g, const uint64_t index, const unsigned n_qubits, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+	if (NULL != g->emit_operation)
+	{
+		g->emit_operation(index, n_qubits, g, target_qubits, emit, ctx);
+	}
+	else
+	{
+		gate_emit_adapter(g, index, n_qubits, target_qubits, emit, ctx);
+	}
+	return;
+}
+
+/*
+ * gate_emit_adapter
+ * Calls the sym form of a gate and emits each entry of its result, this allocates as gate_operation does
+ * :: const gate* g :: The gate
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * :: gate_emit_f emit :: Called once for each outcome
+ * :: void* ctx :: Passed to every call of emit
+ * Returns nothing
+ */
+void gate_emit_adapter(const gate* g, const uint64_t index, const unsigned n_qubits, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+	sym* initial_state = ll_to_sym_n_qubits(index, 1, n_qubits);
+	gate_result* operation_output = g->operation(initial_state, g, target_qubits);
+
+	for (uint32_t i = 0; i < operation_output->n_results; i++)
+	{
+		emit(sym_to_ll(operation_output->state_results[i]), operation_output->prob_results[i], ctx);
+	}
+
+	gate_result_free(operation_output);
+	sym_free(initial_state);
+	return;
+}
+
+// Emit callback that keeps the last outcome, ctx is a uint64_t*
+// For gates with a single outcome, such as Paulis and measurements
+void gate_emit_single(const uint64_t index, const double prob, void* ctx)
+{
+	*(uint64_t*)ctx = index;
+	return;
+}
+
+// The bit of a table index that holds the X part of a qubit
+uint64_t gate_emit_X_bit(const unsigned n_qubits, const unsigned qubit)
+{
+	return 1ull << (2 * n_qubits - 1 - qubit);
+}
+
+// The bit of a table index that holds the Z part of a qubit
+uint64_t gate_emit_Z_bit(const unsigned n_qubits, const unsigned qubit)
+{
+	return 1ull << (n_qubits - 1 - qubit);
+}
+
+#endif
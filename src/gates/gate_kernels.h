@@ -0,0 +1,724 @@
+#ifndef GATE_KERNELS
+#define GATE_KERNELS
+
+#include "gates.h"
+#include "gate_result.h"
+#include "../misc/thread_pool.h"
+
+// The generators are declared here and included at the end of gates.h, as they include gates.h themselves
+gate_result* gate_cnot(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_hadamard(const sym* initial_state, const void* gate_data, const unsigned* target_qubit);
+gate_result* gate_phase(const sym* initial_state, const void* gate_data, const unsigned* target_qubit);
+gate_result* gate_identity(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_pauli_X(const sym* initial_state, const void* gate_data, const unsigned* target_qubit);
+gate_result* gate_pauli_Y(const sym* initial_state, const void* gate_data, const unsigned* target_qubit);
+gate_result* gate_pauli_Z(const sym* initial_state, const void* gate_data, const unsigned* target_qubit);
+
+// Fused gates carry their permutation as gate data, see fused_clifford.h
+gate_result* gate_fused_clifford(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+void gate_kernel_fused_clifford(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits, const gate* g);
+
+// Preparations carry their prepared state as gate data, see preparation.h
+gate_result* gate_prepare_X(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_prepare_Y(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+gate_result* gate_prepare_Z(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
+
+// ----------------------------------------------------------------------------------------
+// GATE KERNELS
+// Clifford and Pauli gates map each pauli string to exactly one other pauli string, so their effect on a
+// probability table is a fixed permutation of the table index
+// The kernels here apply that permutation directly to the table rather than calling the gate for every string
+// Each of these permutations is an involution, so the table is updated in place with swaps
+//
+// For a table over n qubits the X bit of qubit q sits at bit (2n - 1 - q) of the index and the Z bit at (n - 1 - q)
+// This matches sym_to_ll
+// ----------------------------------------------------------------------------------------
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_kernel_lookup
+ * Finds the table kernel for a gate operation
+ * :: gate_operation_f operation :: The gate operation
+ * Returns the kernel, or NULL if the operation has no kernel
+ */
+gate_kernel_f gate_kernel_lookup(gate_operation_f operation);
+
+/*
+ * gate_kernel_apply
+ * Applies the table kernel of a gate in place, this includes fused gates
+ * :: const gate* g :: The gate, only its operation is applied
+ * :: error_probability_t* table :: The table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns 1 if the gate was applied, or 0 if the gate has no kernel and the table was not changed
+ */
+uint8_t gate_kernel_apply(const gate* g, error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+
+/*
+ * gate_kernel_available
+ * Checks whether gate_kernel_apply would apply a gate, without touching a table
+ * :: const gate* g :: The gate, only its operation is checked
+ * Returns 1 if the gate has a kernel, or 0 otherwise
+ */
+uint8_t gate_kernel_available(const gate* g);
+
+/*
+ * gate_kernel_X_bit / gate_kernel_Z_bit
+ * Position of the X or Z bit of a qubit in a table index
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned qubit :: The qubit
+ * Returns the bit position
+ */
+uint32_t gate_kernel_X_bit(const unsigned n_qubits, const unsigned qubit);
+uint32_t gate_kernel_Z_bit(const unsigned n_qubits, const unsigned qubit);
+
+/*
+ * gate_kernel_deposit_zeros
+ * Spreads the bits of a counter around a set of fixed bit positions, which are left as zero
+ * Iterating the counter over [0, 2^(2n - k)) then visits each block of the table that shares all bits outside the positions
+ * :: uint64_t counter :: The counter
+ * :: const uint32_t* positions :: The bit positions to be left as zero, sorted in ascending order
+ * :: const uint32_t n_positions :: The number of positions
+ * Returns the index of the base of the block
+ */
+uint64_t gate_kernel_deposit_zeros(uint64_t counter, const uint32_t* positions, const uint32_t n_positions);
+
+/*
+ * gate_kernel_swap_pairs
+ * Swaps two entries in every block of the table that has bit_lo and bit_hi clear
+ * The loops are strided, so the innermost loop runs over contiguous entries and is vectorised by the compiler
+ * :: error_probability_t* table :: The probability table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const uint32_t bit_lo :: The lower of the two bit positions
+ * :: const uint32_t bit_hi :: The higher of the two bit positions
+ * :: const uint64_t offset_a :: Offset of the first entry within each block
+ * :: const uint64_t offset_b :: Offset of the second entry within each block
+ * Returns nothing
+ */
+void gate_kernel_swap_pairs(error_probability_t* table,
+	const unsigned n_qubits,
+	const uint32_t bit_lo,
+	const uint32_t bit_hi,
+	const uint64_t offset_a,
+	const uint64_t offset_b);
+
+// Kernels for each gate, these all take the form of gate_kernel_f
+void gate_kernel_hadamard(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+void gate_kernel_phase(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+void gate_kernel_cnot(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+void gate_kernel_pauli_X(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+void gate_kernel_pauli_Y(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+void gate_kernel_pauli_Z(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+void gate_kernel_identity(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+
+// PREPARATION KERNEL ----------------------------------------------------------------------------------------
+// A preparation maps every string on its targets to the same string, so it is not a permutation
+// Each block of 4^k entries that shares every bit outside the targets is summed onto a single entry of the block,
+// in place and in a single pass over the table
+
+/*
+ * gate_kernel_prepare
+ * Applies a preparation to the table in place
+ * :: error_probability_t* table :: The probability table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* target_qubits :: The qubits that are prepared
+ * :: const gate* g :: The preparation gate, every string on its targets should be mapped to the same string
+ * Returns nothing
+ */
+void gate_kernel_prepare(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits, const gate* g);
+
+// NOISE KERNEL ----------------------------------------------------------------------------------------
+// A gate's error model only acts on its target qubits, so each entry of the output table only depends on the
+// entries of the input that differ from it on those qubits
+// The table splits into blocks of 4^k entries that share every bit outside the targets, and the channel is applied
+// to each block separately as a small dense stochastic matrix
+// Every output entry is written exactly once from values gathered out of the input, so blocks need no locking
+
+// Largest gate that the noise kernel is used for, larger gates fall back to gate_apply_noise
+#define GATE_KERNEL_NOISE_MAX_QUBITS 3
+
+/*
+ * gate_kernel_noise_t
+ * Precomputed local channel for a gate on a particular set of target qubits
+ * :: uint32_t n_positions :: Number of table bits touched by the gate, twice the number of gate qubits
+ * :: uint32_t positions[] :: Those bits, sorted in ascending order
+ * :: uint64_t* offsets :: Table offset of each local pauli string, indexed as by sym_to_ll on the gate's qubits
+ * :: uint32_t n_terms :: The number of local errors with a non zero probability
+ * :: uint32_t* term_errors :: The local index of each of those errors
+ * :: double* term_probabilities :: The probability of each of those errors
+ */
+typedef struct {
+	uint32_t n_qubits;
+	uint32_t n_positions;
+	uint32_t positions[2 * GATE_KERNEL_NOISE_MAX_QUBITS];
+	uint64_t* offsets;
+	uint32_t n_terms;
+	uint32_t* term_errors;
+	double* term_probabilities;
+} gate_kernel_noise_t;
+
+/*
+ * gate_kernel_noise_create
+ * Evaluates the error model of a gate once for every local error and lays out the offsets of its targets
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const gate* g :: The gate, this should have an error model
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns a new noise kernel, or NULL if the gate is too large for the kernel
+ */
+gate_kernel_noise_t* gate_kernel_noise_create(const unsigned n_qubits, const gate* g, const unsigned* target_qubits);
+
+/*
+ * gate_kernel_noise_blocks
+ * Applies a noise kernel to a range of blocks of the table
+ * :: const gate_kernel_noise_t* kn :: The noise kernel
+ * :: error_probability_t* final_probabilities :: The table written to, this may be initial_probabilities as each block is gathered before it is written
+ * :: const error_probability_t* initial_probabilities :: The table read from
+ * :: const uint64_t block_start :: The first block
+ * :: const uint64_t block_end :: One past the last block
+ * Returns nothing
+ */
+void gate_kernel_noise_blocks(const gate_kernel_noise_t* kn,
+	error_probability_t* final_probabilities,
+	const error_probability_t* initial_probabilities,
+	const uint64_t block_start,
+	const uint64_t block_end);
+
+/*
+ * gate_kernel_noise_apply
+ * Applies a noise kernel to every block of the table, the blocks are split between the threads of the default pool
+ * :: const gate_kernel_noise_t* kn :: The noise kernel
+ * :: error_probability_t* final_probabilities :: The table written to, this may be initial_probabilities
+ * :: const error_probability_t* initial_probabilities :: The table read from
+ * Returns nothing
+ */
+void gate_kernel_noise_apply(const gate_kernel_noise_t* kn, error_probability_t* final_probabilities, const error_probability_t* initial_probabilities);
+
+void gate_kernel_noise_free(gate_kernel_noise_t* kn);
+
+/*
+ * gate_kernel_block_layout
+ * Lays out the table bits touched by a set of target qubits, and the table offset of each local pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned n_gate_qubits :: The number of target qubits
+ * :: const unsigned* target_qubits :: The target qubits
+ * :: uint32_t* positions :: Written with the 2 * n_gate_qubits touched bits, sorted in ascending order
+ * :: uint64_t* offsets :: Written with the 4^n_gate_qubits offsets, indexed as by sym_to_ll on the target qubits
+ * Returns nothing
+ */
+void gate_kernel_block_layout(const unsigned n_qubits,
+	const unsigned n_gate_qubits,
+	const unsigned* target_qubits,
+	uint32_t* positions,
+	uint64_t* offsets);
+
+// Number of set bits in a table index, the weight of the pauli string counts X and Z separately
+uint32_t gate_kernel_popcount(uint64_t index);
+
+// Data shared by the pool workers applying a noise kernel
+typedef struct
+{
+	const gate_kernel_noise_t* kn;
+	error_probability_t* final_probabilities;
+	const error_probability_t* initial_probabilities;
+} gate_kernel_noise_task_t;
+
+// Pool task, applies a noise kernel to a range of blocks
+void gate_kernel_noise_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+ * gate_kernel_lookup
+ * Finds the table kernel for a gate operation
+ * :: gate_operation_f operation :: The gate operation
+ * Returns the kernel, or NULL if the operation has no kernel
+ */
+gate_kernel_f gate_kernel_lookup(gate_operation_f operation)
+{
+	if (gate_hadamard == operation) return gate_kernel_hadamard;
+	if (gate_phase == operation) return gate_kernel_phase;
+	if (gate_cnot == operation) return gate_kernel_cnot;
+	if (gate_pauli_X == operation) return gate_kernel_pauli_X;
+	if (gate_pauli_Y == operation) return gate_kernel_pauli_Y;
+	if (gate_pauli_Z == operation) return gate_kernel_pauli_Z;
+	if (gate_identity == operation) return gate_kernel_identity;
+	return NULL;
+}
+
+/*
+ * gate_kernel_apply
+ * Applies the table kernel of a gate in place, this includes fused gates
+ * :: const gate* g :: The gate, only its operation is applied
+ * :: error_probability_t* table :: The table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns 1 if the gate was applied, or 0 if the gate has no kernel and the table was not changed
+ */
+uint8_t gate_kernel_apply(const gate* g, error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	if (gate_fused_clifford == g->operation)
+	{
+		gate_kernel_fused_clifford(table, n_qubits, target_qubits, g);
+		return 1;
+	}
+
+	if (gate_prepare_X == g->operation || gate_prepare_Y == g->operation || gate_prepare_Z == g->operation)
+	{
+		gate_kernel_prepare(table, n_qubits, target_qubits, g);
+		return 1;
+	}
+
+	gate_kernel_f kernel = gate_kernel_lookup(g->operation);
+	if (NULL == kernel)
+	{
+		return 0;
+	}
+	kernel(table, n_qubits, target_qubits);
+	return 1;
+}
+
+/*
+ * gate_kernel_available
+ * Checks whether gate_kernel_apply would apply a gate, without touching a table
+ * :: const gate* g :: The gate, only its operation is checked
+ * Returns 1 if the gate has a kernel, or 0 otherwise
+ */
+uint8_t gate_kernel_available(const gate* g)
+{
+	return gate_fused_clifford == g->operation
+		|| gate_prepare_X == g->operation || gate_prepare_Y == g->operation || gate_prepare_Z == g->operation
+		|| NULL != gate_kernel_lookup(g->operation);
+}
+
+uint32_t gate_kernel_X_bit(const unsigned n_qubits, const unsigned qubit)
+{
+	return 2 * n_qubits - 1 - qubit;
+}
+
+uint32_t gate_kernel_Z_bit(const unsigned n_qubits, const unsigned qubit)
+{
+	return n_qubits - 1 - qubit;
+}
+
+/*
+ * gate_kernel_deposit_zeros
+ * Spreads the bits of a counter around a set of fixed bit positions, which are left as zero
+ * Iterating the counter over [0, 2^(2n - k)) then visits each block of the table that shares all bits outside the positions
+ * :: uint64_t counter :: The counter
+ * :: const uint32_t* positions :: The bit positions to be left as zero, sorted in ascending order
+ * :: const uint32_t n_positions :: The number of positions
+ * Returns the index of the base of the block
+ */
+uint64_t gate_kernel_deposit_zeros(uint64_t counter, const uint32_t* positions, const uint32_t n_positions)
+{
+	for (uint32_t i = 0; i < n_positions; i++)
+	{
+		uint64_t low_mask = (1ull << positions[i]) - 1;
+		counter = ((counter & ~low_mask) << 1) | (counter & low_mask);
+	}
+	return counter;
+}
+
+/*
+ * gate_kernel_swap_pairs
+ * Swaps two entries in every block of the table that has bit_lo and bit_hi clear
+ * The loops are strided, so the innermost loop runs over contiguous entries and is vectorised by the compiler
+ * :: error_probability_t* table :: The probability table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const uint32_t bit_lo :: The lower of the two bit positions
+ * :: const uint32_t bit_hi :: The higher of the two bit positions
+ * :: const uint64_t offset_a :: Offset of the first entry within each block
+ * :: const uint64_t offset_b :: Offset of the second entry within each block
+ * Returns nothing
+ */
+void gate_kernel_swap_pairs(error_probability_t* table,
+	const unsigned n_qubits,
+	const uint32_t bit_lo,
+	const uint32_t bit_hi,
+	const uint64_t offset_a,
+	const uint64_t offset_b)
+{
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	uint64_t stride_lo = 1ull << bit_lo;
+	uint64_t stride_hi = 1ull << bit_hi;
+
+	for (uint64_t hi = 0; hi < n_entries; hi += 2 * stride_hi)
+	{
+		for (uint64_t mid = hi; mid < hi + stride_hi; mid += 2 * stride_lo)
+		{
+			error_probability_t* block_a = table + mid + offset_a;
+			error_probability_t* block_b = table + mid + offset_b;
+			for (uint64_t lo = 0; lo < stride_lo; lo++)
+			{
+				error_probability_t tmp = block_a[lo];
+				block_a[lo] = block_b[lo];
+				block_b[lo] = tmp;
+			}
+		}
+	}
+	return;
+}
+
+// Hadamard swaps the X and Z bits of the target
+void gate_kernel_hadamard(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint32_t bit_x = gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint32_t bit_z = gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 1ull << bit_x, 1ull << bit_z);
+	return;
+}
+
+// Phase adds the X bit of the target to its Z bit
+void gate_kernel_phase(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint32_t bit_x = gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint32_t bit_z = gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 1ull << bit_x, (1ull << bit_x) | (1ull << bit_z));
+	return;
+}
+
+// CNOT adds the X bit of the control to the target, and the Z bit of the target to the control
+void gate_kernel_cnot(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint64_t x_control = 1ull << gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint64_t x_target = 1ull << gate_kernel_X_bit(n_qubits, target_qubits[1]);
+	uint64_t z_control = 1ull << gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+	uint64_t z_target = 1ull << gate_kernel_Z_bit(n_qubits, target_qubits[1]);
+
+	// Sorted ascending, every Z bit is below every X bit
+	uint32_t positions[4] = {
+		gate_kernel_Z_bit(n_qubits, target_qubits[0]),
+		gate_kernel_Z_bit(n_qubits, target_qubits[1]),
+		gate_kernel_X_bit(n_qubits, target_qubits[0]),
+		gate_kernel_X_bit(n_qubits, target_qubits[1])};
+	if (positions[0] > positions[1])
+	{
+		uint32_t tmp = positions[0];
+		positions[0] = positions[1];
+		positions[1] = tmp;
+		tmp = positions[2];
+		positions[2] = positions[3];
+		positions[3] = tmp;
+	}
+
+	// Within each block of 16 entries the four entries with both the control X and target Z bits clear are fixed
+	// Of the remaining twelve, each pair is swapped once
+	uint64_t swap_a[6];
+	uint64_t swap_b[6];
+	uint32_t n_swaps = 0;
+	uint64_t local_masks[4] = {x_control, x_target, z_control, z_target};
+	for (uint32_t local = 0; local < 16; local++)
+	{
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			offset |= (local >> i & 1) ? local_masks[i] : 0;
+		}
+
+		uint64_t image = offset;
+		image ^= (offset & x_control) ? x_target : 0;
+		image ^= (offset & z_target) ? z_control : 0;
+		if (offset < image)
+		{
+			swap_a[n_swaps] = offset;
+			swap_b[n_swaps] = image;
+			n_swaps++;
+		}
+	}
+
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> 4;
+	for (uint64_t block = 0; block < n_blocks; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, positions, 4);
+		for (uint32_t i = 0; i < n_swaps; i++)
+		{
+			error_probability_t tmp = table[base | swap_a[i]];
+			table[base | swap_a[i]] = table[base | swap_b[i]];
+			table[base | swap_b[i]] = tmp;
+		}
+	}
+	return;
+}
+
+// Pauli X flips the Z bit of the target, see gate_pauli_X
+void gate_kernel_pauli_X(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint32_t bit_x = gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint32_t bit_z = gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 0, 1ull << bit_z);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 1ull << bit_x, (1ull << bit_x) | (1ull << bit_z));
+	return;
+}
+
+// Pauli Y flips both bits of the target
+void gate_kernel_pauli_Y(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint32_t bit_x = gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint32_t bit_z = gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 0, (1ull << bit_x) | (1ull << bit_z));
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 1ull << bit_x, 1ull << bit_z);
+	return;
+}
+
+// Pauli Z flips the X bit of the target, see gate_pauli_Z
+void gate_kernel_pauli_Z(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint32_t bit_x = gate_kernel_X_bit(n_qubits, target_qubits[0]);
+	uint32_t bit_z = gate_kernel_Z_bit(n_qubits, target_qubits[0]);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 0, 1ull << bit_x);
+	gate_kernel_swap_pairs(table, n_qubits, bit_z, bit_x, 1ull << bit_z, (1ull << bit_x) | (1ull << bit_z));
+	return;
+}
+
+void gate_kernel_identity(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	return;
+}
+
+/*
+ * gate_kernel_prepare
+ * Applies a preparation to the table in place
+ * :: error_probability_t* table :: The probability table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned* target_qubits :: The qubits that are prepared
+ * :: const gate* g :: The preparation gate, every string on its targets should be mapped to the same string
+ * Returns nothing
+ */
+void gate_kernel_prepare(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits, const gate* g)
+{
+	uint32_t n_positions = 2 * g->n_qubits;
+	uint64_t n_local = 1ull << n_positions;
+	uint32_t* positions = (uint32_t*)malloc(sizeof(uint32_t) * n_positions);
+	uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * n_local);
+	gate_kernel_block_layout(n_qubits, g->n_qubits, target_qubits, positions, offsets);
+
+	// The prepared string is the image of the identity on the gate's own qubits
+	uint32_t* local_targets = target_qubits_create_range(0, g->n_qubits);
+	sym* identity = sym_create(1, n_positions);
+	gate_result* gr = g->operation(identity, g, local_targets);
+	uint64_t prepared = offsets[sym_to_ll(gr->state_results[0])];
+	gate_result_free(gr);
+	sym_free(identity);
+	target_qubits_free(local_targets);
+
+	// Each block is gathered before it is written, and sums in double precision
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> n_positions;
+	for (uint64_t block = 0; block < n_blocks; block++)
+	{
+		error_probability_t* block_table = table + gate_kernel_deposit_zeros(block, positions, n_positions);
+		double sum = 0;
+		for (uint64_t local = 0; local < n_local; local++)
+		{
+			sum += block_table[offsets[local]];
+			block_table[offsets[local]] = 0;
+		}
+		block_table[prepared] = sum;
+	}
+
+	free(offsets);
+	free(positions);
+	return;
+}
+
+/*
+ * gate_kernel_noise_create
+ * Evaluates the error model of a gate once for every local error and lays out the offsets of its targets
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const gate* g :: The gate, this should have an error model
+ * :: const unsigned* target_qubits :: The qubits the gate acts on
+ * Returns a new noise kernel, or NULL if the gate is too large for the kernel
+ */
+gate_kernel_noise_t* gate_kernel_noise_create(const unsigned n_qubits, const gate* g, const unsigned* target_qubits)
+{
+	if (g->n_qubits > GATE_KERNEL_NOISE_MAX_QUBITS)
+	{
+		return NULL;
+	}
+
+	gate_kernel_noise_t* kn = (gate_kernel_noise_t*)malloc(sizeof(gate_kernel_noise_t));
+	uint32_t n_local = 1u << (2 * g->n_qubits);
+
+	kn->n_qubits = n_qubits;
+	kn->n_positions = 2 * g->n_qubits;
+	kn->offsets = (uint64_t*)malloc(sizeof(uint64_t) * n_local);
+	kn->term_errors = (uint32_t*)malloc(sizeof(uint32_t) * n_local);
+	kn->term_probabilities = (double*)malloc(sizeof(double) * n_local);
+	kn->n_terms = 0;
+
+	gate_kernel_block_layout(n_qubits, g->n_qubits, target_qubits, kn->positions, kn->offsets);
+
+	// The error model is only called once per local error rather than once per table entry
+	sym_iter* gate_error = sym_iter_create_n_qubits(g->n_qubits);
+	while (sym_iter_next(gate_error))
+	{
+		double prob = error_model_call(g->gate_error_model, gate_error->state);
+		if (prob != 0)
+		{
+			kn->term_errors[kn->n_terms] = (uint32_t)sym_to_ll(gate_error->state);
+			kn->term_probabilities[kn->n_terms] = prob;
+			kn->n_terms++;
+		}
+	}
+	sym_iter_free(gate_error);
+
+	return kn;
+}
+
+/*
+ * gate_kernel_noise_blocks
+ * Applies a noise kernel to a range of blocks of the table
+ * :: const gate_kernel_noise_t* kn :: The noise kernel
+ * :: error_probability_t* final_probabilities :: The table written to, this may be initial_probabilities as each block is gathered before it is written
+ * :: const error_probability_t* initial_probabilities :: The table read from
+ * :: const uint64_t block_start :: The first block
+ * :: const uint64_t block_end :: One past the last block
+ * Returns nothing
+ */
+void gate_kernel_noise_blocks(const gate_kernel_noise_t* kn,
+	error_probability_t* final_probabilities,
+	const error_probability_t* initial_probabilities,
+	const uint64_t block_start,
+	const uint64_t block_end)
+{
+	uint32_t n_local = 1u << kn->n_positions;
+	double local_probabilities[1u << (2 * GATE_KERNEL_NOISE_MAX_QUBITS)];
+
+	for (uint64_t block = block_start; block < block_end; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, kn->positions, kn->n_positions);
+
+		// Gather the block
+		uint8_t nonzero = 0;
+		for (uint32_t local = 0; local < n_local; local++)
+		{
+			local_probabilities[local] = initial_probabilities[base | kn->offsets[local]];
+			nonzero |= (local_probabilities[local] != 0);
+		}
+
+		// Empty blocks stay empty
+		if (!nonzero)
+		{
+			for (uint32_t local = 0; local < n_local; local++)
+			{
+				final_probabilities[base | kn->offsets[local]] = 0;
+			}
+			continue;
+		}
+
+		// Each output entry is the sum over local errors of the entry that error maps onto it
+		for (uint32_t local = 0; local < n_local; local++)
+		{
+			double prob = 0;
+			for (uint32_t t = 0; t < kn->n_terms; t++)
+			{
+				prob += kn->term_probabilities[t] * local_probabilities[local ^ kn->term_errors[t]];
+			}
+			final_probabilities[base | kn->offsets[local]] = prob;
+		}
+	}
+	return;
+}
+
+/*
+ * gate_kernel_noise_apply
+ * Applies a noise kernel to every block of the table, the blocks are split between the threads of the default pool
+ * :: const gate_kernel_noise_t* kn :: The noise kernel
+ * :: error_probability_t* final_probabilities :: The table written to, this may be initial_probabilities
+ * :: const error_probability_t* initial_probabilities :: The table read from
+ * Returns nothing
+ */
+void gate_kernel_noise_apply(const gate_kernel_noise_t* kn, error_probability_t* final_probabilities, const error_probability_t* initial_probabilities)
+{
+	uint64_t n_blocks = error_probabilities_entries_in_table(kn->n_qubits) >> kn->n_positions;
+
+	// Blocks are disjoint, so each worker writes to its own entries
+	gate_kernel_noise_task_t task_data = {kn, final_probabilities, initial_probabilities};
+	thread_pool_parallel_for(thread_pool_default(), n_blocks, gate_kernel_noise_task, &task_data);
+	return;
+}
+
+// Pool task, applies a noise kernel to a range of blocks
+void gate_kernel_noise_task(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker)
+{
+	gate_kernel_noise_task_t* task_data = (gate_kernel_noise_task_t*)data;
+	gate_kernel_noise_blocks(task_data->kn,
+		task_data->final_probabilities,
+		task_data->initial_probabilities,
+		block_start,
+		block_end);
+	return;
+}
+
+/*
+ * gate_kernel_block_layout
+ * Lays out the table bits touched by a set of target qubits, and the table offset of each local pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const unsigned n_gate_qubits :: The number of target qubits
+ * :: const unsigned* target_qubits :: The target qubits
+ * :: uint32_t* positions :: Written with the 2 * n_gate_qubits touched bits, sorted in ascending order
+ * :: uint64_t* offsets :: Written with the 4^n_gate_qubits offsets, indexed as by sym_to_ll on the target qubits
+ * Returns nothing
+ */
+void gate_kernel_block_layout(const unsigned n_qubits,
+	const unsigned n_gate_qubits,
+	const unsigned* target_qubits,
+	uint32_t* positions,
+	uint64_t* offsets)
+{
+	uint32_t n_positions = 2 * n_gate_qubits;
+	uint64_t n_local = 1ull << n_positions;
+
+	// Local qubit j has its X bit at (2k - 1 - j) and its Z bit at (k - 1 - j) of the local index
+	// These map to the X and Z bits of target j in the table
+	for (uint32_t j = 0; j < n_gate_qubits; j++)
+	{
+		positions[2 * j] = gate_kernel_X_bit(n_qubits, target_qubits[j]);
+		positions[2 * j + 1] = gate_kernel_Z_bit(n_qubits, target_qubits[j]);
+	}
+	for (uint64_t local = 0; local < n_local; local++)
+	{
+		uint64_t offset = 0;
+		for (uint32_t j = 0; j < n_gate_qubits; j++)
+		{
+			offset |= (local >> (2 * n_gate_qubits - 1 - j) & 1) ? 1ull << positions[2 * j] : 0;
+			offset |= (local >> (n_gate_qubits - 1 - j) & 1) ? 1ull << positions[2 * j + 1] : 0;
+		}
+		offsets[local] = offset;
+	}
+
+	// Sort the positions for gate_kernel_deposit_zeros
+	for (uint32_t i = 1; i < n_positions; i++)
+	{
+		for (uint32_t j = i; j > 0 && positions[j - 1] > positions[j]; j--)
+		{
+			uint32_t tmp = positions[j];
+			positions[j] = positions[j - 1];
+			positions[j - 1] = tmp;
+		}
+	}
+	return;
+}
+
+// Number of set bits in a table index, the weight of the pauli string counts X and Z separately
+uint32_t gate_kernel_popcount(uint64_t index)
+{
+	uint32_t count = 0;
+	while (index)
+	{
+		index &= index - 1;
+		count++;
+	}
+	return count;
+}
+
+void gate_kernel_noise_free(gate_kernel_noise_t* kn)
+{
+	free(kn->offsets);
+	free(kn->term_errors);
+	free(kn->term_probabilities);
+	free(kn);
+	return;
+}
+
+#endif
@@ -14,6 +14,15 @@ typedef struct {
 	uint32_t n_results;
 } gate_result;
 
+/*
+	gate_emit_f:
+	Receives a single outcome of a gate, see gate_emit.h
+	:: const uint64_t index :: The table index of the outcome, as given by sym_to_ll
+	:: const double prob :: The probability of the outcome
+	:: void* ctx :: Data passed through by the caller
+*/
+typedef void (*gate_emit_f)(const uint64_t index, const double prob, void* ctx);
+
 // Create a new gate result object
 gate_result* gate_result_create(const uint32_t n_results)
 {
@@ -12,21 +12,13 @@
 #include "../circuits/error_probabilities.h"
 #include "../error_models/error_models.h"
 
-/* GATE_MULTITHREADING
- * Enables gate multi-threading 	
+/* Multithreading
+ * Gate noise and the gate kernels are split between the workers of the default thread pool, see misc/thread_pool.h
  */
 
-/* N_THREADS #
- *	Specifies the number of threads used when multi-threading gate operations
- */
-
-/* GATE_MAX_DEPTH #
- * Sets a maximum depth of non identity elements in pauli strings
- * Useful when looking at objects of 12 or more qubits, this will speed up computation by ignoring 
- * presumably low probability pauli strings with high pauli weights
- * As a general rule, this should be set to the number of qubits in the code block + some number of ancilla qubits
- * At which point the error is generally unrecoverable anyway
- * If you enable this, you will need to start considering that the results will not be normalised	
+/* Truncation
+ * High weight and low probability pauli strings may be dropped at runtime with a truncation_policy,
+ * which also records the probability that was dropped, see circuits/truncation_policy.h
  */
 
 // STRUCT OBJECTS ----------------------------------------------------------------------------------------
@@ -37,12 +29,22 @@
 // The second object is actually the gate object
 typedef gate_result* (*gate_operation_f)(const sym*, const void*, const unsigned* target_qubits);
 
+// Gate emit function pointer
+// Applies a gate to the table index of a pauli string and passes each outcome to emit, see gate_emit.h
+// The third object is the gate object
+typedef void (*gate_emit_operation_f)(const uint64_t index, const unsigned n_qubits, const void*, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+// Gate kernel function pointer
+// Applies the permutation of a gate directly to a probability table in place, see gate_kernels.h
+typedef void (*gate_kernel_f)(error_probability_t* table, const unsigned n_qubits, const unsigned* target_qubits);
+
 /*
  *	gate:
  *	The gate struct
  *	:: unsigned n_qubits :: Number of qubits in the gate
  *	:: error_model_f gate_error_model :: The error model to be applied when this gate is used
  *	:: void* model_data :: Data for the error model
+ *	:: gate_emit_operation_f emit_operation :: The operation on table indices, found by gate_create for the built in gates
  */
 typedef struct {
 	unsigned n_qubits; // Number of qubits the gate operates on
@@ -50,42 +52,57 @@ typedef struct {
 	error_model* gate_error_model; // The error operation performed (Any probabilistic operation)
 	void* operation_data; // Any additional data to pass to the gate
 	void* error_model_data; // Any additional data to pass to the noise
+	gate_emit_operation_f emit_operation; // The same operation on table indices, NULL gates are called through an adapter
 } gate;
 
 // MULTITHREADING ----------------------------------------------------------------------------------------
-// Enable to multithread on gate operations
-#ifdef GATE_MULTITHREADING
-	#ifdef N_THREADS
-		#define GATE_MULTITHREADING_ENABLED
-		#include <pthread.h>
-
-		// Struct to contain the data needed for the multi-threading
-		typedef struct 
-		{
-			long long start;
-			long long end;
-			const gate* operation;
-			const unsigned* target_qubits;
-			unsigned n_qubits;
-			double* initial_probabilities;
-			double* final_probabilities;
-			pthread_mutex_t* lock;
-		} mthread_gate_operation_t;
-
-		// Multithreading gate application
-		void* gate_apply_m_thread(void* data);
-
-		// Gate lock
-		pthread_mutex_t gate_lock;
-
-	#endif
-#endif
+// Gate noise is split between the workers of the default pool
+// The table is partitioned into blocks that the noise cannot move probability between, so workers never write to the same entry
+#include "../misc/thread_pool.h"
 
-// GATE_MAX_DEPTH -------------------------------------------------------------------------------------
-// Enable to limit application over pauli strings to a certain depth
-// This should be set to the value of the max depth
-#ifdef GATE_MAX_DEPTH
-#endif
+// Data shared by the pool workers applying noise one pauli string at a time
+typedef struct
+{
+	unsigned n_qubits;
+	const gate* applied_gate;
+	const unsigned* target_qubits;
+	const error_probability_t* initial_probabilities;
+	error_probability_t* final_probabilities;
+	uint32_t n_positions;
+	const uint32_t* positions;
+	const uint64_t* offsets;
+	const double* error_probabilities; // The probability of each local error, indexed as the offsets
+} gate_noise_per_string_t;
+
+// Pool task, applies noise to each pauli string in a range of blocks
+void gate_noise_per_string_blocks(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker);
+
+// Data for the emit callback in gate_operator_into
+typedef struct
+{
+	error_probability_t* final_probabilities;
+	double initial_prob;
+} gate_operator_emit_t;
+
+// Emit callback for gate_operator_into, adds the outcome to the output table
+void gate_operator_emit(const uint64_t index, const double prob, void* ctx);
+
+// Data for the emit callback in gate_operator_batch
+typedef struct
+{
+	double* final_probabilities;
+	const double* initial_prob;
+	uint32_t n_lanes;
+} gate_operator_batch_emit_t;
+
+// Emit callback for gate_operator_batch, adds the outcome to every lane of the output batch table
+void gate_operator_batch_emit(const uint64_t index, const double prob, void* ctx);
+
+// GATE KERNELS ----------------------------------------------------------------------------------------
+#include "gate_kernels.h"
+
+// GATE EMIT ----------------------------------------------------------------------------------------
+#include "gate_emit.h"
 
 // FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
 /*
@@ -117,13 +134,13 @@ gate* gate_create_noiseless(
     gate_apply:
 	Applies a gate object to an existing noise model this is comprised of both a noise operator and a gate operator
 	:: const unsigned n_qubits :: Number of qubits in the gate
-	:: const double* initial_probabilities :: The current probabilities for each noise operator
+	:: const error_probability_t* initial_probabilities :: The current probabilities for each noise operator
 	:: const void* noisy_gate :: The gate to be applied
 	Returns a heap pointer to a block of allocated memory containing the new probabilities
 */
-double* gate_apply(
+error_probability_t* gate_apply(
 	const unsigned n_qubits,
-	double* probabilities,
+	error_probability_t* probabilities,
 	const gate* g,
 	const unsigned* target_qubits);
 
@@ -131,12 +148,12 @@ double* gate_apply(
     gate_noise:
 	Applies a gate object to an existing noise model
 	:: const unsigned n_qubits :: Number of qubits in the gate
-	:: const double* initial_probabilities :: The current probabilities for each noise operator
+	:: const error_probability_t* initial_probabilities :: The current probabilities for each noise operator
 	:: const void* noisy_gate :: The gate to be applied
 	Returns a heap pointer to a block of allocated memory containing the new probabilities
 */
-double* gate_noise(const unsigned n_qubits, 
-	double* probabilities, 
+error_probability_t* gate_noise(const unsigned n_qubits, 
+	error_probability_t* probabilities, 
 	const gate* g,
 	const unsigned* target_qubits);
 
@@ -144,12 +161,61 @@ double* gate_noise(const unsigned n_qubits,
     gate_operator:
 	Applies a gate object to an existing noise model
 	:: const unsigned n_qubits :: Number of qubits in the gate
-	:: const double* initial_probabilities :: The current probabilities for each noise operator
+	:: const error_probability_t* initial_probabilities :: The current probabilities for each noise operator
 	:: const void* noisy_gate :: The gate to be applied
 	Returns a heap pointer to a block of allocated memory containing the new probabilities
 */
-double* gate_operator(const unsigned n_qubits, 
-	double* probabilities, 
+error_probability_t* gate_operator(const unsigned n_qubits, 
+	error_probability_t* probabilities, 
+	const gate* g,
+	const unsigned* target_qubits);
+
+/* 
+    gate_noise_into:
+	Applies the noise of a gate object to an existing noise model, writing into a table that has already been allocated
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: error_probability_t* final_probabilities :: The table written to, every entry is overwritten and this may not alias the input
+	:: error_probability_t* initial_probabilities :: The current probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns nothing
+*/
+void gate_noise_into(const unsigned n_qubits,
+	error_probability_t* final_probabilities,
+	error_probability_t* initial_probabilities,
+	const gate* g,
+	const unsigned* target_qubits);
+
+/* 
+    gate_operator_into:
+	Applies the operation of a gate object to an existing noise model, writing into a table that has already been allocated
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: error_probability_t* final_probabilities :: The table written to, every entry is overwritten and this may not alias the input
+	:: error_probability_t* initial_probabilities :: The current probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns nothing
+*/
+void gate_operator_into(const unsigned n_qubits,
+	error_probability_t* final_probabilities,
+	error_probability_t* initial_probabilities,
+	const gate* g,
+	const unsigned* target_qubits);
+
+/* 
+    gate_apply_buffers:
+	Applies a gate object to a table without allocating, the result is left in *probabilities
+	Kernels update the table in place, other gates write into the scratch table and the two pointers are swapped
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: error_probability_t** probabilities :: The current probabilities, this may be swapped with the scratch table
+	:: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns nothing
+*/
+void gate_apply_buffers(const unsigned n_qubits,
+	error_probability_t** probabilities,
+	error_probability_t** scratch,
 	const gate* g,
 	const unsigned* target_qubits);
 
@@ -167,6 +233,55 @@ void gate_free(gate* g);
 
 gate_result* gate_apply_noise(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
 
+/* 
+    gate_apply_batch:
+	Applies a gate object to a batch table of error probabilities, see error_probabilities_batch_zeros
+	Each pauli string is pushed through the gate once, and the result is applied to every lane
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: const uint32_t n_lanes :: Number of lanes in the batch
+	:: double* probabilities :: The current batch of probabilities for each noise operator
+	:: const gate* g :: The gate to be applied, a batched error model gives each lane its own noise
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns a heap pointer to a new batch table
+*/
+double* gate_apply_batch(const unsigned n_qubits,
+	const uint32_t n_lanes,
+	double* probabilities,
+	const gate* g,
+	const unsigned* target_qubits);
+
+/* 
+    gate_operator_batch:
+	Applies the operation of a gate object to a batch table of error probabilities
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: const uint32_t n_lanes :: Number of lanes in the batch
+	:: double* probabilities :: The current batch of probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns a heap pointer to a new batch table
+*/
+double* gate_operator_batch(const unsigned n_qubits,
+	const uint32_t n_lanes,
+	double* probabilities,
+	const gate* g,
+	const unsigned* target_qubits);
+
+/* 
+    gate_noise_batch:
+	Applies the noise of a gate object to a batch table of error probabilities
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: const uint32_t n_lanes :: Number of lanes in the batch
+	:: double* probabilities :: The current batch of probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns a heap pointer to a new batch table
+*/
+double* gate_noise_batch(const unsigned n_qubits,
+	const uint32_t n_lanes,
+	double* probabilities,
+	const gate* g,
+	const unsigned* target_qubits);
+
 // FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
 /* 
     gate_create:
@@ -188,6 +303,7 @@ gate* gate_create(
 	g->operation = operation;
 	g->gate_error_model = em;
 	g->operation_data = operation_data;
+	g->emit_operation = gate_emit_lookup(operation);
 	
 	return g;
 }
@@ -227,6 +343,7 @@ gate* gate_create_independent(
 	g->operation = operation;
 	g->gate_error_model = error_model_copy(em);
 	g->operation_data = operation_data;
+	g->emit_operation = gate_emit_lookup(operation);
 	
 	return g;
 }
@@ -240,22 +357,22 @@ gate* gate_create_iid_noise(error_model* em)
     gate_apply:
 	Applies a gate object to an existing noise model this is comprised of both a noise operator and a gate operator
 	:: const unsigned n_qubits :: Number of qubits in the gate
-	:: const double* initial_probabilities :: The current probabilities for each noise operator
+	:: const error_probability_t* initial_probabilities :: The current probabilities for each noise operator
 	:: const void* noisy_gate :: The gate to be applied
 	Returns a heap pointer to a block of allocated memory containing the new probabilities
 */
-double* gate_apply(const unsigned n_qubits,
-	double* probabilities,
+error_probability_t* gate_apply(const unsigned n_qubits,
+	error_probability_t* probabilities,
 	const gate* g,
 	const unsigned* target_qubits)
 {
 	// This ordering is slightly more computationally efficient; 
 
 	// Apply the gate operation	
-	double* gate_operator_probabilities = gate_operator(n_qubits, probabilities, g, target_qubits);
+	error_probability_t* gate_operator_probabilities = gate_operator(n_qubits, probabilities, g, target_qubits);
 	
 	// Apply the noise operation associated with that gate
-	double* gate_noise_probabilities = gate_noise(n_qubits, gate_operator_probabilities, g, target_qubits);
+	error_probability_t* gate_noise_probabilities = gate_noise(n_qubits, gate_operator_probabilities, g, target_qubits);
 
 	// Free allocated memory that is no longer required
 	free(gate_operator_probabilities);
@@ -267,354 +384,116 @@ double* gate_apply(const unsigned n_qubits,
     gate_noise:
 	Applies a noise object to an existing noise model
 	:: const unsigned n_qubits :: Number of qubits in the gate
-	:: const double* initial_probabilities :: The current probabilities for each noise operator
+	:: const error_probability_t* initial_probabilities :: The current probabilities for each noise operator
 	:: const gate* g:: The gate to be applied
 	Returns a heap pointer to a block of allocated memory containing the new probabilities
 */
-double* gate_noise(const unsigned n_qubits, 
-	double* initial_probabilities, 
+error_probability_t* gate_noise(const unsigned n_qubits, 
+	error_probability_t* initial_probabilities, 
+	const gate* applied_gate,
+	const unsigned* target_qubits)
+{
+	error_probability_t* p_state_probabilities = (error_probability_t*)malloc(error_probabilities_bytes_in_table(n_qubits));
+	gate_noise_into(n_qubits, p_state_probabilities, initial_probabilities, applied_gate, target_qubits);
+	return p_state_probabilities;
+}
+
+/* 
+    gate_noise_into:
+	Applies the noise of a gate object to an existing noise model, writing into a table that has already been allocated
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: error_probability_t* p_state_probabilities :: The table written to, every entry is overwritten and this may not alias the input
+	:: error_probability_t* initial_probabilities :: The current probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns nothing
+*/
+void gate_noise_into(const unsigned n_qubits,
+	error_probability_t* p_state_probabilities,
+	error_probability_t* initial_probabilities, 
 	const gate* applied_gate,
 	const unsigned* target_qubits)
 {
-	// Allocate memory for the new output
-	double* p_state_probabilities = error_probabilities_zeros(n_qubits);
-	
 	// Identity gate, no operation_output
 	if (NULL == applied_gate->gate_error_model)
 	{
 		memcpy(p_state_probabilities, initial_probabilities, error_probabilities_bytes_in_table(n_qubits));
-		return p_state_probabilities;
+		return;
 	}
 
-	// Check if multi threaded
-	#ifdef GATE_MULTITHREADING_ENABLED
-		int32_t threads_used = N_THREADS;
-
-		mthread_gate_operation_t thread_data[N_THREADS];
-		pthread_t threads[N_THREADS]; // Our threads
-
-		// If we've got a max gate depth
-		#ifdef GATE_MAX_DEPTH 
-
-			if (n_qubits > GATE_MAX_DEPTH)
-			{
-				// Generate an array containing the number of elements to iterate through for each weight
-				uint32_t* binom_dist = (uint32_t*)malloc(sizeof(uint32_t) * (GATE_MAX_DEPTH * 2 + 1));
-				int32_t avg = 0;
-				
-				for (uint32_t i = 0; i <= 2 * GATE_MAX_DEPTH; i++)
-				{
-					binom_dist[i] = sym_iter_binom(2 * n_qubits, i);
-					avg += binom_dist[i];
-				}
-				
-				avg /= (N_THREADS);
-
-				// Now we attempt to evenly distribute joint segments of this array over the number of threads
-				// And we're going to be greedy
-				// Start from the far end; if we're peaked it's going to distribute the work more evenly, if we're not then 
-				// It's symmetric
-				int32_t current_position = 2 * GATE_MAX_DEPTH;
-				int32_t current_delta = 0;
-				for (uint32_t i = 0; i < N_THREADS && current_position >= 0; i++)
-				{
-					int32_t total = binom_dist[current_position];
-					thread_data[i].start = 0;
-					thread_data[i].end = current_position + 1;
-
-					while (total + current_delta < avg && current_position >= 0)
-					{
-						current_position--;
-						total += binom_dist[current_position];
-
-						// If we reach the end and run out of threads
-						// This may occur due to a rounding error when calculating the average
-						if (current_position == 0)
-						{ 
-							current_position = 0;
-							total = INT_MAX;
-							current_delta = 0;
-							threads_used = i + 1;
-						}
-					}
-					
-					thread_data[i].start = current_position;
-					current_position--;
-					current_delta = avg - total;
-
-					// And the rest of the standard thread data
-					thread_data[i].operation = applied_gate;
-					thread_data[i].target_qubits = target_qubits;
-					thread_data[i].n_qubits = n_qubits; 
-					thread_data[i].initial_probabilities = initial_probabilities; 
-					thread_data[i].final_probabilities = p_state_probabilities;
-					thread_data[i].lock = &gate_lock;
-				}
-
-				free(binom_dist);
-			}
-			else // Number of qubits is smaller than the max gate depth, break up the problem evenly between the threads
-			{
-				// Chunk the blocks
-				uint64_t last_block = error_probabilities_entries_in_table(n_qubits);
-				uint64_t block_size = last_block / N_THREADS;
-
-				// Setup our thread data
-				for (uint32_t i = 0; i < N_THREADS; i++)
-				{
-					/*
-					 Struct to contain the data needed for the multi-threading
-					 Replicated here for useful shorthand
-						typedef struct 
-						{
-							long long start;
-							long long end;
-							const gate* operation;
-							const unsigned* target_qubits;
-							const unsigned n_qubits;
-							double* initial_probabilities;
-							double* final_probabilities;
-							pthread_mutex_t* lock;
-						} mthread_gate_operation_t;
-					*/
-					if (i == N_THREADS - 1) // Handle the last block separately
-					{
-						thread_data[i].start = i * block_size;
-						thread_data[i].end = last_block;
-						thread_data[i].operation = applied_gate;
-						thread_data[i].target_qubits = target_qubits;
-						thread_data[i].n_qubits = n_qubits; 
-						thread_data[i].initial_probabilities = initial_probabilities; 
-						thread_data[i].final_probabilities = p_state_probabilities;
-						thread_data[i].lock = &gate_lock;
-					}
-					else
-					{
-						thread_data[i].start = i * block_size;
-						thread_data[i].end = (i + 1) * block_size;
-						thread_data[i].operation = applied_gate;
-						thread_data[i].target_qubits = target_qubits;
-						thread_data[i].n_qubits = n_qubits; 
-						thread_data[i].initial_probabilities = initial_probabilities; 
-						thread_data[i].final_probabilities = p_state_probabilities;
-						thread_data[i].lock = &gate_lock;
-					}
-				}
-			}
-		#else
-			// Chunk the blocks
-			uint64_t last_block = error_probabilities_entries_in_table(n_qubits);
-			uint64_t block_size = last_block / N_THREADS;
-
-			// Setup our thread data
-			for (uint32_t i = 0; i < threads_used; i++)
-			{
-				/*
-				 Struct to contain the data needed for the multi-threading
-				 Replicated here for useful shorthand
-					typedef struct 
-					{
-						long long start;
-						long long end;
-						const gate* operation;
-						const unsigned* target_qubits;
-						const unsigned n_qubits;
-						double* initial_probabilities;
-						double* final_probabilities;
-						pthread_mutex_t* lock;
-					} mthread_gate_operation_t;
-				*/
-				if (i == N_THREADS - 1) // Handle the last block separately
-				{
-					thread_data[i].start = i * block_size;
-					thread_data[i].end = last_block;
-					thread_data[i].operation = applied_gate;
-					thread_data[i].target_qubits = target_qubits;
-					thread_data[i].n_qubits = n_qubits; 
-					thread_data[i].initial_probabilities = initial_probabilities; 
-					thread_data[i].final_probabilities = p_state_probabilities;
-					thread_data[i].lock = &gate_lock;
-				}
-				else
-				{
-					thread_data[i].start = i * block_size;
-					thread_data[i].end = (i + 1) * block_size;
-					thread_data[i].operation = applied_gate;
-					thread_data[i].target_qubits = target_qubits;
-					thread_data[i].n_qubits = n_qubits; 
-					thread_data[i].initial_probabilities = initial_probabilities; 
-					thread_data[i].final_probabilities = p_state_probabilities;
-					thread_data[i].lock = &gate_lock;
-				}
-			}
-		#endif
-
-		// Release the threads
-		for (uint32_t i = 0; i < threads_used; i++)
-		{
-			pthread_create(threads + i, NULL, gate_apply_m_thread, thread_data + i);
-		}
-
-		// Join the threads
-		for (uint32_t i = 0; i < threads_used; i++)
-		{
-			pthread_join(threads[i], NULL);
-		}
-	#else // If not multithreading
-		// Loop over all possible states
-		// Different behaviour for max depth set or not
-		#ifdef GATE_MAX_DEPTH
-			sym_iter* initial_state = sym_iter_create_n_qubits_range(n_qubits, 0, GATE_MAX_DEPTH);
-		#else
-			sym_iter* initial_state = sym_iter_create_n_qubits(n_qubits);
-		#endif
-		while(sym_iter_next(initial_state))
-		{
-			// Save this value as we may be needing it quite a bit
-			double initial_prob = initial_probabilities[sym_iter_ll_from_state(initial_state)];
-
-			if (initial_prob > 0)
-			{
-				// Determine the state after the error has been applied 
-				gate_result* operation_output = gate_apply_noise(initial_state->state, applied_gate, target_qubits);
+	// Small gates apply their error model to each block of the table directly, see gate_kernel_noise_t
+	gate_kernel_noise_t* noise_kernel = gate_kernel_noise_create(n_qubits, applied_gate, target_qubits);
+	if (NULL != noise_kernel)
+	{
+		gate_kernel_noise_apply(noise_kernel, p_state_probabilities, initial_probabilities);
+		gate_kernel_noise_free(noise_kernel);
+		return;
+	}
 
-				for (unsigned i = 0; i < operation_output->n_results; i++)
-				{
-					// Cumulatively determine the new probability of each state after the gate has been applied
-					p_state_probabilities[sym_to_ll(operation_output->state_results[i])] += operation_output->prob_results[i] * initial_prob; 
-				}
+	// Noise only changes the target qubits, so each string stays in the block of entries that share its other bits
+	gate_noise_per_string_t task_data;
+	task_data.n_qubits = n_qubits;
+	task_data.applied_gate = applied_gate;
+	task_data.target_qubits = target_qubits;
+	task_data.initial_probabilities = initial_probabilities;
+	task_data.final_probabilities = p_state_probabilities;
+	task_data.n_positions = 2 * applied_gate->n_qubits;
+
+	uint64_t n_local = 1ull << task_data.n_positions;
+	uint32_t* positions = (uint32_t*)malloc(sizeof(uint32_t) * task_data.n_positions);
+	uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * n_local);
+	gate_kernel_block_layout(n_qubits, applied_gate->n_qubits, target_qubits, positions, offsets);
+	task_data.positions = positions;
+	task_data.offsets = offsets;
+
+	// The error model is called once for each local error, rather than for each local error of every string
+	// Applying an error is then an XOR of its offset, so the strings need no sym objects
+	double* error_probabilities = (double*)malloc(sizeof(double) * n_local);
+	for (uint64_t local = 0; local < n_local; local++)
+	{
+		sym* gate_error = ll_to_sym_n_qubits(local, 1, applied_gate->n_qubits);
+		error_probabilities[local] = error_model_call(applied_gate->gate_error_model, gate_error);
+		sym_free(gate_error);
+	}
+	task_data.error_probabilities = error_probabilities;
 
-				// Free allocated memory
-				gate_result_free(operation_output);
-			}
-		}
-		sym_iter_free(initial_state);
-	#endif
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> task_data.n_positions;
+	thread_pool_parallel_for(thread_pool_default(), n_blocks, gate_noise_per_string_blocks, &task_data);
 
-	return p_state_probabilities;
+	free(positions);
+	free(offsets);
+	free(error_probabilities);
+	return;
 }
 
-
-// Multi-threading function for gate application
-// To enable this you should include the following headers
-// Either when you compile the code or or somewhere else
-// #define GATE_MULTITHREADING
-// #define N_THREADS #
-// Don't forget to specify the number of threads!
-#ifdef GATE_MULTITHREADING_ENABLED
-void* gate_apply_m_thread(void* data)
+// Pool task, applies noise to each pauli string in a range of blocks
+void gate_noise_per_string_blocks(void* data, const uint64_t block_start, const uint64_t block_end, const uint32_t worker)
 {
-	mthread_gate_operation_t* mthread_data = (mthread_gate_operation_t*)data;
+	gate_noise_per_string_t* task_data = (gate_noise_per_string_t*)data;
+	uint64_t n_local = 1ull << task_data->n_positions;
 
-	// If a maximum gate depth is set, change the behavior of this loop
-	#ifdef GATE_MAX_DEPTH
-		if (mthread_data->n_qubits > GATE_MAX_DEPTH)
-		{
-			// Loop over all states in the range
-			sym_iter* siter = sym_iter_create_range(mthread_data->n_qubits * 2,  mthread_data->start, mthread_data->end);
-			while (sym_iter_next(siter))
-			{
-				
-				// Save this value as we may be needing it quite a bit
-				double initial_prob = mthread_data->initial_probabilities[sym_iter_ll_from_state(siter)];
-
-				// Save ourselves some time
-				if (initial_prob > 0)
-				{	
-					gate_result* operation_output;
-					if () // Check if this is actually an IID error
-						// Determine the state after the error has been applied 
-						operation_output = gate_apply_noise(siter->state, mthread_data->operation, mthread_data->target_qubits);
-					else
-					{
-						operation_output = 
-					}
-					
-					for (unsigned i = 0; i < operation_output->n_results; i++)
-					{
-						// Cumulatively determine the new probability of each state after the gate has been applied
-						// Make sure to lock down this operation as the only write to the data
-						pthread_mutex_lock(mthread_data->lock);
-						
-						mthread_data->final_probabilities[sym_to_ll(operation_output->state_results[i])] += operation_output->prob_results[i] * initial_prob; 
-
-						pthread_mutex_unlock(mthread_data->lock);
-					}
-					// Free allocated memory
-					gate_result_free(operation_output);
-				}
-			}
-			sym_iter_free(siter);
-		}
-		else
-		{
-			// Loop over all possible states
-			for (long long ll_state = mthread_data->start; ll_state < mthread_data->end; ll_state++)
-			{
-				// Convert our long long value to state
-				sym* initial_state = ll_to_sym_n_qubits(ll_state, 1, mthread_data->n_qubits);
-				
-				// Save this value as we may be needing it quite a bit
-				double initial_prob = mthread_data->initial_probabilities[sym_to_ll(initial_state)];
-
-				// Save ourselves some time
-				if (initial_prob > 0)
-				{
-					// Determine the state after the error has been applied 
-					gate_result* operation_output = gate_apply_noise(initial_state, mthread_data->operation, mthread_data->target_qubits);
-
-					for (unsigned i = 0; i < operation_output->n_results; i++)
-					{
-						// Cumulatively determine the new probability of each state after the gate has been applied
-						// Make sure to lock down this operation as the only write to the data
-						pthread_mutex_lock(mthread_data->lock);
-
-						mthread_data->final_probabilities[sym_to_ll(operation_output->state_results[i])] += operation_output->prob_results[i] * initial_prob; 
-
-						pthread_mutex_unlock(mthread_data->lock);
-					}
-					// Free allocated memory
-					gate_result_free(operation_output);
-					sym_free(initial_state);
-				}
-			}
-		}
-	#else // No max depth set
-		// Loop over all possible states
-		for (long long ll_state = mthread_data->start; ll_state < mthread_data->end; ll_state++)
+	for (uint64_t block = block_start; block < block_end; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, task_data->positions, task_data->n_positions);
+		for (uint64_t local = 0; local < n_local; local++)
 		{
-			// Convert our long long value to state
-			sym* initial_state = ll_to_sym_n_qubits(ll_state, 1, mthread_data->n_qubits);
-
-			// Save this value as we may be needing it quite a bit
-			double initial_prob = mthread_data->initial_probabilities[sym_to_ll(initial_state)];
-
-			// Save ourselves some time
-			if (initial_prob > 0)
+			// Each string gathers the strings that an error maps onto it, every one of them lies in this block
+			// The sum is held in a double so single precision tables lose nothing while it accumulates
+			double prob = 0;
+			for (uint64_t source = 0; source < n_local; source++)
 			{
-				// Determine the state after the error has been applied 
-				gate_result* operation_output = gate_apply_noise(initial_state, mthread_data->operation, mthread_data->target_qubits);
-
-				for (unsigned i = 0; i < operation_output->n_results; i++)
+				double initial_prob = task_data->initial_probabilities[base | task_data->offsets[source]];
+				double error_prob = task_data->error_probabilities[source ^ local];
+				if (initial_prob > 0 && 0 != error_prob)
 				{
-					// Cumulatively determine the new probability of each state after the gate has been applied
-					// Make sure to lock down this operation as the only write to the data
-					pthread_mutex_lock(mthread_data->lock);
-
-					mthread_data->final_probabilities[sym_to_ll(operation_output->state_results[i])] += operation_output->prob_results[i] * initial_prob; 
-
-					pthread_mutex_unlock(mthread_data->lock);
+					prob += error_prob * initial_prob;
 				}
-				// Free allocated memory
-				gate_result_free(operation_output);
-				sym_free(initial_state);
 			}
+			task_data->final_probabilities[base | task_data->offsets[local]] = prob;
 		}
-	#endif
-	return NULL;
+	}
+	return;
 }
-#endif
-
 
 // Wrapper
 gate_result* gate_operation(const gate* g, sym* initial_state, const unsigned* target_qubits)
@@ -626,51 +505,131 @@ gate_result* gate_operation(const gate* g, sym* initial_state, const unsigned* t
     gate_operator:
 	Applies a gate object to an existing noise model
 	:: const unsigned n_qubits :: Number of qubits in the gate
-	:: const double* initial_probabilities :: The current probabilities for each noise operator
+	:: const error_probability_t* initial_probabilities :: The current probabilities for each noise operator
 	:: const void* noisy_gate :: The gate to be applied
 	Returns a heap pointer to a block of allocated memory containing the new probabilities
 */
-double* gate_operator(const unsigned n_qubits,
-	double* initial_probabilities,
+error_probability_t* gate_operator(const unsigned n_qubits,
+	error_probability_t* initial_probabilities,
 	const gate* applied_gate,
 	const unsigned* target_qubits)
 {
-	// Allocate memory for the new output
-	double* p_state_probabilities = error_probabilities_zeros(n_qubits);
+	error_probability_t* p_state_probabilities = (error_probability_t*)malloc(error_probabilities_bytes_in_table(n_qubits));
+	gate_operator_into(n_qubits, p_state_probabilities, initial_probabilities, applied_gate, target_qubits);
+	return p_state_probabilities;
+}
 
+/* 
+    gate_operator_into:
+	Applies the operation of a gate object to an existing noise model, writing into a table that has already been allocated
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: error_probability_t* p_state_probabilities :: The table written to, every entry is overwritten and this may not alias the input
+	:: error_probability_t* initial_probabilities :: The current probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns nothing
+*/
+void gate_operator_into(const unsigned n_qubits,
+	error_probability_t* p_state_probabilities,
+	error_probability_t* initial_probabilities,
+	const gate* applied_gate,
+	const unsigned* target_qubits)
+{
 	// Identity gate, no operation
 	if (NULL == applied_gate->operation)
 	{
 		memcpy(p_state_probabilities, initial_probabilities, error_probabilities_bytes_in_table(n_qubits));
-		return p_state_probabilities;
+		return;
+	}
+
+	// Clifford, Pauli and fused gates permute a copy of the table directly, other gates never need the copy
+	if (gate_kernel_available(applied_gate))
+	{
+		memcpy(p_state_probabilities, initial_probabilities, error_probabilities_bytes_in_table(n_qubits));
+		gate_kernel_apply(applied_gate, p_state_probabilities, n_qubits, target_qubits);
+		return;
 	}
 
+	memset(p_state_probabilities, 0, error_probabilities_bytes_in_table(n_qubits));
+
 	// Loop over all possible states
+	gate_operator_emit_t ctx;
+	ctx.final_probabilities = p_state_probabilities;
 	sym_iter* initial_state = sym_iter_create_n_qubits(n_qubits);
 	while(sym_iter_next(initial_state))
 	{
+		uint64_t index = sym_iter_ll_from_state(initial_state);
+
 		// Save this value as we may be needing it quite a bit
-		double initial_prob = initial_probabilities[sym_iter_ll_from_state(initial_state)];
+		ctx.initial_prob = initial_probabilities[index];
 
-		if (initial_prob > 0)
+		if (ctx.initial_prob > 0)
 		{
-			// Determine the state after the operation has been applied 
+			// Each outcome is added to the output as it is emitted
+			gate_emit(applied_gate, index, n_qubits, target_qubits, gate_operator_emit, &ctx);
+		}
+	}
 
-			gate_result* operation_output = gate_operation(applied_gate, initial_state->state, target_qubits);
+	sym_iter_free(initial_state);
+	return;
+}
 
-			for (unsigned i = 0; i < operation_output->n_results; i++)
-			{
-				// Cumulatively determine the new probability of each state after the gate has been applied
-				p_state_probabilities[sym_to_ll(operation_output->state_results[i])] += operation_output->prob_results[i] * initial_prob; 
-			}
-			// Free allocated memory
-			gate_result_free(operation_output);
+// Emit callback for gate_operator_into, adds the outcome to the output table
+void gate_operator_emit(const uint64_t index, const double prob, void* ctx)
+{
+	gate_operator_emit_t* emit_data = (gate_operator_emit_t*)ctx;
+	emit_data->final_probabilities[index] += prob * emit_data->initial_prob;
+	return;
+}
+
+/* 
+    gate_apply_buffers:
+	Applies a gate object to a table without allocating, the result is left in *probabilities
+	Kernels update the table in place, other gates write into the scratch table and the two pointers are swapped
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: error_probability_t** probabilities :: The current probabilities, this may be swapped with the scratch table
+	:: error_probability_t** scratch :: A second table of the same size, its contents are overwritten
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns nothing
+*/
+void gate_apply_buffers(const unsigned n_qubits,
+	error_probability_t** probabilities,
+	error_probability_t** scratch,
+	const gate* g,
+	const unsigned* target_qubits)
+{
+	error_probability_t* tmp;
+
+	// Gate operation
+	if (NULL != g->operation)
+	{
+		if (!gate_kernel_apply(g, *probabilities, n_qubits, target_qubits))
+		{
+			gate_operator_into(n_qubits, *scratch, *probabilities, g, target_qubits);
+			tmp = *probabilities;
+			*probabilities = *scratch;
+			*scratch = tmp;
 		}
 	}
 
-	sym_iter_free(initial_state);
+	// Noise operation
+	if (NULL != g->gate_error_model)
+	{
+		gate_kernel_noise_t* noise_kernel = gate_kernel_noise_create(n_qubits, g, target_qubits);
+		if (NULL != noise_kernel)
+		{
+			gate_kernel_noise_apply(noise_kernel, *probabilities, *probabilities);
+			gate_kernel_noise_free(noise_kernel);
+			return;
+		}
 
-	return p_state_probabilities;
+		gate_noise_into(n_qubits, *scratch, *probabilities, g, target_qubits);
+		tmp = *probabilities;
+		*probabilities = *scratch;
+		*scratch = tmp;
+	}
+	return;
 }
 
 /* 
@@ -733,4 +692,163 @@ gate_result* gate_apply_noise(const sym* initial_state, const void* gate_data, c
 	return gr;
 }
 
+// PARAMETER BATCHES ----------------------------------------------------------------------------------------
+
+/* 
+    gate_apply_batch:
+	Applies a gate object to a batch table of error probabilities, see error_probabilities_batch_zeros
+	Each pauli string is pushed through the gate once, and the result is applied to every lane
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: const uint32_t n_lanes :: Number of lanes in the batch
+	:: double* probabilities :: The current batch of probabilities for each noise operator
+	:: const gate* g :: The gate to be applied, a batched error model gives each lane its own noise
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns a heap pointer to a new batch table
+*/
+double* gate_apply_batch(const unsigned n_qubits,
+	const uint32_t n_lanes,
+	double* probabilities,
+	const gate* g,
+	const unsigned* target_qubits)
+{
+	double* gate_operator_probabilities = gate_operator_batch(n_qubits, n_lanes, probabilities, g, target_qubits);
+	double* gate_noise_probabilities = gate_noise_batch(n_qubits, n_lanes, gate_operator_probabilities, g, target_qubits);
+	free(gate_operator_probabilities);
+	return gate_noise_probabilities;
+}
+
+/* 
+    gate_operator_batch:
+	Applies the operation of a gate object to a batch table of error probabilities
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: const uint32_t n_lanes :: Number of lanes in the batch
+	:: double* probabilities :: The current batch of probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns a heap pointer to a new batch table
+*/
+double* gate_operator_batch(const unsigned n_qubits,
+	const uint32_t n_lanes,
+	double* initial_probabilities,
+	const gate* applied_gate,
+	const unsigned* target_qubits)
+{
+	double* p_state_probabilities = error_probabilities_batch_zeros(n_qubits, n_lanes);
+
+	// Identity gate, no operation
+	if (NULL == applied_gate->operation)
+	{
+		memcpy(p_state_probabilities, initial_probabilities, error_probabilities_batch_bytes_in_table(n_qubits, n_lanes));
+		return p_state_probabilities;
+	}
+
+	// Each outcome is added to every lane as it is emitted
+	gate_operator_batch_emit_t ctx;
+	ctx.final_probabilities = p_state_probabilities;
+	ctx.n_lanes = n_lanes;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	for (uint64_t index = 0; index < n_entries; index++)
+	{
+		ctx.initial_prob = initial_probabilities + index * n_lanes;
+		if (!error_probabilities_batch_is_zero(ctx.initial_prob, n_lanes))
+		{
+			gate_emit(applied_gate, index, n_qubits, target_qubits, gate_operator_batch_emit, &ctx);
+		}
+	}
+
+	return p_state_probabilities;
+}
+
+// Emit callback for gate_operator_batch, adds the outcome to every lane of the output batch table
+void gate_operator_batch_emit(const uint64_t index, const double prob, void* ctx)
+{
+	gate_operator_batch_emit_t* emit_data = (gate_operator_batch_emit_t*)ctx;
+	double* final_prob = emit_data->final_probabilities + index * emit_data->n_lanes;
+	for (uint32_t lane = 0; lane < emit_data->n_lanes; lane++)
+	{
+		final_prob[lane] += prob * emit_data->initial_prob[lane];
+	}
+	return;
+}
+
+/* 
+    gate_noise_batch:
+	Applies the noise of a gate object to a batch table of error probabilities
+	:: const unsigned n_qubits :: Number of qubits in the gate
+	:: const uint32_t n_lanes :: Number of lanes in the batch
+	:: double* probabilities :: The current batch of probabilities for each noise operator
+	:: const gate* g :: The gate to be applied
+	:: const unsigned* target_qubits :: The qubits the gate acts on
+	Returns a heap pointer to a new batch table
+*/
+double* gate_noise_batch(const unsigned n_qubits,
+	const uint32_t n_lanes,
+	double* initial_probabilities,
+	const gate* applied_gate,
+	const unsigned* target_qubits)
+{
+	double* p_state_probabilities = error_probabilities_batch_zeros(n_qubits, n_lanes);
+
+	// Identity gate, no noise
+	if (NULL == applied_gate->gate_error_model)
+	{
+		memcpy(p_state_probabilities, initial_probabilities, error_probabilities_batch_bytes_in_table(n_qubits, n_lanes));
+		return p_state_probabilities;
+	}
+
+	// As gate_noise_into, noise only moves a string within the block of entries that share its other bits
+	// and applying a local error is an XOR of its offset, so no sym objects are needed for the strings
+	uint32_t n_positions = 2 * applied_gate->n_qubits;
+	uint64_t n_local = 1ull << n_positions;
+	uint32_t* positions = (uint32_t*)malloc(sizeof(uint32_t) * n_positions);
+	uint64_t* offsets = (uint64_t*)malloc(sizeof(uint64_t) * n_local);
+	gate_kernel_block_layout(n_qubits, applied_gate->n_qubits, target_qubits, positions, offsets);
+
+	// The error model is called once for each local error, giving its probability in every lane
+	double* error_probabilities = (double*)malloc(sizeof(double) * n_local * n_lanes);
+	for (uint64_t local = 0; local < n_local; local++)
+	{
+		sym* gate_error = ll_to_sym_n_qubits(local, 1, applied_gate->n_qubits);
+		error_model_batch_call(applied_gate->gate_error_model, gate_error, n_lanes, error_probabilities + local * n_lanes);
+		sym_free(gate_error);
+	}
+
+	uint64_t n_blocks = error_probabilities_entries_in_table(n_qubits) >> n_positions;
+	for (uint64_t block = 0; block < n_blocks; block++)
+	{
+		uint64_t base = gate_kernel_deposit_zeros(block, positions, n_positions);
+		for (uint64_t source = 0; source < n_local; source++)
+		{
+			const double* initial_prob = initial_probabilities + (base | offsets[source]) * n_lanes;
+			if (error_probabilities_batch_is_zero(initial_prob, n_lanes))
+			{
+				continue;
+			}
+
+			for (uint64_t local = 0; local < n_local; local++)
+			{
+				double* final_prob = p_state_probabilities + (base | offsets[source ^ local]) * n_lanes;
+				const double* error_prob = error_probabilities + local * n_lanes;
+				for (uint32_t lane = 0; lane < n_lanes; lane++)
+				{
+					final_prob[lane] += error_prob[lane] * initial_prob[lane];
+				}
+			}
+		}
+	}
+
+	free(positions);
+	free(offsets);
+	free(error_probabilities);
+
+	return p_state_probabilities;
+}
+
+// Definitions of the generators that the gate kernels are looked up by
+#include "clifford_generators.h"
+#include "pauli_generators.h"
+#include "fused_clifford.h"
+#include "measurement.h"
+#include "preparation.h"
+
 #endif
@@ -52,6 +52,57 @@ gate_result* gate_measure_Y(const sym* initial_state, const void* gate_data, con
  */
 gate_result* gate_measure_Z(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
 
+/*
+ * gate_measure_X_emit
+ * Measures the table index of a pauli string in the X basis, the outcome is emitted as the sym_to_ll value of the measured bits
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_measure_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_measure_Y_emit
+ * Measures the table index of a pauli string in the Y basis, the outcome is emitted as the sym_to_ll value of the measured bits
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_measure_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_measure_Z_emit
+ * Measures the table index of a pauli string in the Z basis, the outcome is emitted as the sym_to_ll value of the measured bits
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_measure_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_measure_marginals
+ * Splits a table by the outcome of a measurement in a single pass, giving the table over the unmeasured qubits for each outcome
+ * The unmeasured qubits keep their order, so for a recovery circuit each table is over the code block alone
+ * :: const error_probability_t* table :: The probability table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const gate* measure :: The measurement gate, its outcome should depend only on its targets
+ * :: const unsigned* target_qubits :: The qubits that are measured
+ * Returns a heap array of 2^measure->n_qubits tables, the table for outcome s starts at s * 4^(n_qubits - measure->n_qubits)
+ */
+double* gate_measure_marginals(const error_probability_t* table, const unsigned n_qubits, const gate* measure, const unsigned* target_qubits);
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DEFINITIONS
 // ----------------------------------------------------------------------------------------
@@ -125,4 +176,148 @@ gate_result* gate_measure_Z(const sym* initial_state, const void* gate_data, con
     return gate_result_create_single(1, measurement_outcome);
 }
 
+/*
+ * gate_measure_X_emit
+ * Measures the table index of a pauli string in the X basis, the outcome is emitted as the sym_to_ll value of the measured bits
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_measure_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint32_t n_bits = ((gate*)gate_data)->n_qubits;
+
+    // Bit i of the outcome sits at (n_bits - 1 - i), as with sym_to_ll
+    uint64_t measurement_outcome = 0;
+    for (uint32_t i = 0; i < n_bits; i++)
+    { // If the paulis anti-commute with X, then count it as a '1', else it's a '0'
+        uint64_t Z = !!(index & gate_emit_Z_bit(n_qubits, target_qubits[i]));
+        measurement_outcome |= Z << (n_bits - 1 - i);
+    }
+
+    emit(measurement_outcome, 1, ctx);
+    return;
+}
+
+/*
+ * gate_measure_Y_emit
+ * Measures the table index of a pauli string in the Y basis, the outcome is emitted as the sym_to_ll value of the measured bits
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_measure_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint32_t n_bits = ((gate*)gate_data)->n_qubits;
+
+    // Bit i of the outcome sits at (n_bits - 1 - i), as with sym_to_ll
+    uint64_t measurement_outcome = 0;
+    for (uint32_t i = 0; i < n_bits; i++)
+    { // If the paulis anti-commute with Y, then count it as a '1', else it's a '0'
+        uint64_t X = !!(index & gate_emit_X_bit(n_qubits, target_qubits[i]));
+        uint64_t Z = !!(index & gate_emit_Z_bit(n_qubits, target_qubits[i]));
+        measurement_outcome |= (X ^ Z) << (n_bits - 1 - i);
+    }
+
+    emit(measurement_outcome, 1, ctx);
+    return;
+}
+
+/*
+ * gate_measure_Z_emit
+ * Measures the table index of a pauli string in the Z basis, the outcome is emitted as the sym_to_ll value of the measured bits
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_measure_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint32_t n_bits = ((gate*)gate_data)->n_qubits;
+
+    // Bit i of the outcome sits at (n_bits - 1 - i), as with sym_to_ll
+    uint64_t measurement_outcome = 0;
+    for (uint32_t i = 0; i < n_bits; i++)
+    { // If the paulis anti-commute with Z, then count it as a '1', else it's a '0'
+        uint64_t X = !!(index & gate_emit_X_bit(n_qubits, target_qubits[i]));
+        measurement_outcome |= X << (n_bits - 1 - i);
+    }
+
+    emit(measurement_outcome, 1, ctx);
+    return;
+}
+
+/*
+ * gate_measure_marginals
+ * Splits a table by the outcome of a measurement in a single pass, giving the table over the unmeasured qubits for each outcome
+ * The unmeasured qubits keep their order, so for a recovery circuit each table is over the code block alone
+ * :: const error_probability_t* table :: The probability table
+ * :: const unsigned n_qubits :: The number of qubits covered by the table
+ * :: const gate* measure :: The measurement gate, its outcome should depend only on its targets
+ * :: const unsigned* target_qubits :: The qubits that are measured
+ * Returns a heap array of 2^measure->n_qubits tables, the table for outcome s starts at s * 4^(n_qubits - measure->n_qubits)
+ */
+double* gate_measure_marginals(const error_probability_t* table, const unsigned n_qubits, const gate* measure, const unsigned* target_qubits)
+{
+    uint32_t n_measured = measure->n_qubits;
+    uint64_t n_measured_entries = error_probabilities_entries_in_table(n_measured);
+    uint64_t n_kept_entries = error_probabilities_entries_in_table(n_qubits - n_measured);
+
+    // The X and Z bits of the measured qubits, every other bit of the index is kept
+    uint64_t measured_mask = 0;
+    for (uint32_t i = 0; i < n_measured; i++)
+    {
+        measured_mask |= gate_emit_X_bit(n_qubits, target_qubits[i]) | gate_emit_Z_bit(n_qubits, target_qubits[i]);
+    }
+    uint64_t kept_mask = (error_probabilities_entries_in_table(n_qubits) - 1) & ~measured_mask;
+
+    // The measured bits of an index, packed in order, are a table index over the measured qubits in ascending order
+    // Each target is renumbered by its rank so the outcome of every packed index is found once
+    unsigned* local_targets = (unsigned*)malloc(sizeof(unsigned) * n_measured);
+    for (uint32_t i = 0; i < n_measured; i++)
+    {
+        local_targets[i] = 0;
+        for (uint32_t j = 0; j < n_measured; j++)
+        {
+            local_targets[i] += (target_qubits[j] < target_qubits[i]);
+        }
+    }
+    uint64_t* outcomes = (uint64_t*)malloc(sizeof(uint64_t) * n_measured_entries);
+    for (uint64_t local = 0; local < n_measured_entries; local++)
+    {
+        gate_emit(measure, local, n_measured, local_targets, gate_emit_single, outcomes + local);
+    }
+
+    // Adding one through the bits outside a mask steps through the indices within the mask in order,
+    // so the kept and measured parts of each index are counted directly rather than extracted from it
+    // Measured qubits usually sit together, so the inner loop reads short contiguous runs of the table
+    double* marginals = (double*)calloc((1ull << n_measured) * n_kept_entries, sizeof(double));
+    uint64_t kept_index = 0;
+    for (uint64_t kept = 0; kept < n_kept_entries; kept++)
+    {
+        uint64_t measured_index = 0;
+        for (uint64_t local = 0; local < n_measured_entries; local++)
+        {
+            marginals[outcomes[local] * n_kept_entries + kept] += table[kept_index | measured_index];
+            measured_index = ((measured_index | ~measured_mask) + 1) & measured_mask;
+        }
+        kept_index = ((kept_index | ~kept_mask) + 1) & kept_mask;
+    }
+
+    free(outcomes);
+    free(local_targets);
+    return marginals;
+}
+
 #endif
\ No newline at end of file
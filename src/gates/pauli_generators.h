@@ -46,6 +46,45 @@ gate_result* gate_pauli_Z(const sym* initial_state, const void* gate_data, const
 gate_result* gate_pauli_y(const sym* initial_state, const void* gate_data, const unsigned* target_qubit);
 
 
+/*
+ * gate_pauli_X_emit
+ * Implements a pauli X gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_pauli_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_pauli_Z_emit
+ * Implements a pauli Z gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_pauli_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_pauli_Y_emit
+ * Implements a pauli Y gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_pauli_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DEFINITIONS
 // ----------------------------------------------------------------------------------------
@@ -105,4 +144,55 @@ gate_result* gate_pauli_Y(const sym* initial_state, const void* gate_data, const
     return gate_result_create_single(1, final_state);
 }
 
+/*
+ * gate_pauli_X_emit
+ * Implements a pauli X gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_pauli_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    emit(index ^ gate_emit_Z_bit(n_qubits, target_qubits[0]), 1, ctx);
+    return;
+}
+
+/*
+ * gate_pauli_Z_emit
+ * Implements a pauli Z gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_pauli_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    emit(index ^ gate_emit_X_bit(n_qubits, target_qubits[0]), 1, ctx);
+    return;
+}
+
+/*
+ * gate_pauli_Y_emit
+ * Implements a pauli Y gate on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on, [0] is the target qubit
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_pauli_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    emit(index ^ gate_emit_X_bit(n_qubits, target_qubits[0]) ^ gate_emit_Z_bit(n_qubits, target_qubits[0]), 1, ctx);
+    return;
+}
+
 #endif
\ No newline at end of file
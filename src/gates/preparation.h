@@ -91,6 +91,45 @@ gate_result* gate_prepare_Y(const sym* initial_state, const void* gate_data, con
  */
 gate_result* gate_prepare_Z(const sym* initial_state, const void* gate_data, const unsigned* target_qubits);
 
+/*
+ * gate_prepare_X_emit
+ * Prepares a state in the X basis on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_prepare_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_prepare_Y_emit
+ * Prepares a state in the Y basis on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_prepare_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
+/*
+ * gate_prepare_Z_emit
+ * Prepares a state in the Z basis on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_prepare_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx);
+
 // ----------------------------------------------------------------------------------------
 // FUNCTION DEFINITIONS
 // ----------------------------------------------------------------------------------------
@@ -242,4 +281,97 @@ gate_result* gate_prepare_Z(const sym* initial_state, const void* gate_data, con
     return gate_result_create_single(1, preparation_outcome);
 }
 
+/*
+ * gate_prepare_X_emit
+ * Prepares a state in the X basis on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_prepare_X_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint32_t n_targets = ((gate*)gate_data)->n_qubits;
+
+    uint8_t prepared_state = ((gate_preparation_t*)(((gate*)gate_data)->operation_data))->prepared_state;
+
+    // Applying an X operation is the same as flipping the state in the Z basis
+    uint64_t preparation_outcome = index;
+    for (uint32_t i = 0; i < n_targets; i++)
+    {
+        uint64_t target_X = gate_emit_X_bit(n_qubits, target_qubits[i]);
+        uint64_t target_Z = gate_emit_Z_bit(n_qubits, target_qubits[i]);
+        preparation_outcome &= ~(target_X | target_Z);
+        if (prepared_state) preparation_outcome |= target_Z;
+    }
+
+    emit(preparation_outcome, 1, ctx);
+    return;
+}
+
+/*
+ * gate_prepare_Y_emit
+ * Prepares a state in the Y basis on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_prepare_Y_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint32_t n_targets = ((gate*)gate_data)->n_qubits;
+
+    uint8_t prepared_state = ((gate_preparation_t*)(((gate*)gate_data)->operation_data))->prepared_state;
+
+    // Applying an XZ operation is the same as flipping the state in the Y basis
+    uint64_t preparation_outcome = index;
+    for (uint32_t i = 0; i < n_targets; i++)
+    {
+        uint64_t target_X = gate_emit_X_bit(n_qubits, target_qubits[i]);
+        uint64_t target_Z = gate_emit_Z_bit(n_qubits, target_qubits[i]);
+        preparation_outcome &= ~(target_X | target_Z);
+        if (prepared_state) preparation_outcome |= target_X | target_Z;
+    }
+
+    emit(preparation_outcome, 1, ctx);
+    return;
+}
+
+/*
+ * gate_prepare_Z_emit
+ * Prepares a state in the Z basis on the table index of a pauli string
+ * :: const uint64_t index :: The table index of the pauli string
+ * :: const unsigned n_qubits :: The number of qubits covered by the pauli string
+ * :: const void* gate_data :: The gate object
+ * :: const unsigned* target_qubits :: An array of qubits that this gate acts on
+ * :: gate_emit_f emit :: Called with the outcome
+ * :: void* ctx :: Passed to emit
+ * Returns nothing
+ */
+void gate_prepare_Z_emit(const uint64_t index, const unsigned n_qubits, const void* gate_data, const unsigned* target_qubits, gate_emit_f emit, void* ctx)
+{
+    uint32_t n_targets = ((gate*)gate_data)->n_qubits;
+
+    uint8_t prepared_state = ((gate_preparation_t*)(((gate*)gate_data)->operation_data))->prepared_state;
+
+    // Applying an X operation is the same as flipping a state in the Z basis
+    uint64_t preparation_outcome = index;
+    for (uint32_t i = 0; i < n_targets; i++)
+    {
+        uint64_t target_X = gate_emit_X_bit(n_qubits, target_qubits[i]);
+        uint64_t target_Z = gate_emit_Z_bit(n_qubits, target_qubits[i]);
+        preparation_outcome &= ~(target_X | target_Z);
+        if (prepared_state) preparation_outcome |= target_X;
+    }
+
+    emit(preparation_outcome, 1, ctx);
+    return;
+}
+
 #endif
\ No newline at end of file
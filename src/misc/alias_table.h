@@ -0,0 +1,160 @@
+#ifndef ALIAS_TABLE
+#define ALIAS_TABLE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "rng.h"
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+	alias_table:
+	Walker/Vose alias table for drawing from a discrete distribution in constant time
+	:: uint64_t n_entries :: Number of outcomes in the distribution
+	:: double* threshold :: Probability of keeping the drawn column rather than taking its alias
+	:: uint64_t* alias :: The alternate outcome for each column
+	This object should be freed using the 'alias_table_free' function
+*/
+typedef struct
+{
+	uint64_t n_entries;
+	double* threshold;
+	uint64_t* alias;
+} alias_table;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/* 
+    alias_table_create:
+	Builds an alias table using Vose's method
+	:: const double* weights :: Non-negative weights for each outcome, these do not need to be normalised
+	:: const uint64_t n_entries :: Number of outcomes
+	Returns a heap pointer to the new table, or NULL if the weights sum to zero
+*/
+alias_table* alias_table_create(const double* weights, const uint64_t n_entries);
+
+/* 
+    alias_table_sample:
+	Draws an outcome from the table
+	:: const alias_table* t :: The table
+	:: rng* r :: The random number generator
+	Returns the index of the drawn outcome
+*/
+uint64_t alias_table_sample(const alias_table* t, rng* r);
+
+/* 
+    alias_table_free:
+	Frees an alias table
+	:: alias_table* t :: The table to be freed
+	No object returned
+*/
+void alias_table_free(alias_table* t);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/* 
+    alias_table_create:
+	Builds an alias table using Vose's method
+	:: const double* weights :: Non-negative weights for each outcome, these do not need to be normalised
+	:: const uint64_t n_entries :: Number of outcomes
+	Returns a heap pointer to the new table, or NULL if the weights sum to zero
+*/
+alias_table* alias_table_create(const double* weights, const uint64_t n_entries)
+{
+	double total = 0;
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		total += weights[i];
+	}
+	if (total <= 0)
+	{
+		printf("Cannot build an alias table from weights that sum to zero\n");
+		return NULL;
+	}
+
+	alias_table* t = (alias_table*)malloc(sizeof(alias_table));
+	t->n_entries = n_entries;
+	t->threshold = (double*)malloc(sizeof(double) * n_entries);
+	t->alias = (uint64_t*)malloc(sizeof(uint64_t) * n_entries);
+
+	// Both work lists share one buffer, small entries fill from the front and large entries from the back
+	uint64_t* work = (uint64_t*)malloc(sizeof(uint64_t) * n_entries);
+	uint64_t n_small = 0;
+	uint64_t n_large = 0;
+
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		t->threshold[i] = weights[i] * n_entries / total;
+		t->alias[i] = i;
+		if (t->threshold[i] < 1.0)
+		{
+			work[n_small++] = i;
+		}
+		else
+		{
+			work[n_entries - 1 - n_large++] = i;
+		}
+	}
+
+	while (n_small > 0 && n_large > 0)
+	{
+		uint64_t small = work[--n_small];
+		uint64_t large = work[n_entries - n_large];
+
+		t->alias[small] = large;
+		t->threshold[large] -= 1.0 - t->threshold[small];
+
+		if (t->threshold[large] < 1.0)
+		{
+			// The large entry is now small, move it across
+			n_large--;
+			work[n_small++] = large;
+		}
+	}
+
+	// Anything left over is only off from one due to rounding
+	for (uint64_t i = 0; i < n_small; i++)
+	{
+		t->threshold[work[i]] = 1.0;
+	}
+	for (uint64_t i = 0; i < n_large; i++)
+	{
+		t->threshold[work[n_entries - 1 - i]] = 1.0;
+	}
+
+	free(work);
+	return t;
+}
+
+/* 
+    alias_table_sample:
+	Draws an outcome from the table
+	:: const alias_table* t :: The table
+	:: rng* r :: The random number generator
+	Returns the index of the drawn outcome
+*/
+uint64_t alias_table_sample(const alias_table* t, rng* r)
+{
+	uint64_t column = rng_below(r, t->n_entries);
+	return (rng_uniform(r) < t->threshold[column]) ? column : t->alias[column];
+}
+
+/* 
+    alias_table_free:
+	Frees an alias table
+	:: alias_table* t :: The table to be freed
+	No object returned
+*/
+void alias_table_free(alias_table* t)
+{
+	if (NULL != t)
+	{
+		free(t->threshold);
+		free(t->alias);
+		free(t);
+	}
+	return;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef RNG
+#define RNG
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+	rng:
+	State for a xoshiro256** pseudo random number generator
+	Each thread should own its own rng object, there is no shared state
+	:: uint64_t s[4] :: The generator state, this should never be all zeros
+*/
+typedef struct
+{
+	uint64_t s[4];
+} rng;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/* 
+    rng_create:
+	Creates a new generator
+	:: const uint64_t seed :: Seed for the generator, the state is expanded from this using splitmix64
+	Returns a seeded rng object
+*/
+rng rng_create(const uint64_t seed);
+
+/* 
+    rng_create_stream:
+	Creates one of many independent generators sharing a seed, such as one for each block of work
+	Nearby seeds and streams give unrelated states, unlike offsetting the seed by the stream
+	:: const uint64_t seed :: Seed shared by every stream
+	:: const uint64_t stream :: Index of the stream
+	Returns a seeded rng object
+*/
+rng rng_create_stream(const uint64_t seed, const uint64_t stream);
+
+/* 
+    rng_next:
+	Draws the next 64 random bits from the generator
+	:: rng* r :: The generator
+	Returns 64 random bits
+*/
+uint64_t rng_next(rng* r);
+
+/* 
+    rng_uniform:
+	Draws a uniform double from the generator
+	:: rng* r :: The generator
+	Returns a double in [0, 1)
+*/
+double rng_uniform(rng* r);
+
+/* 
+    rng_below:
+	Draws a uniform integer from the generator
+	:: rng* r :: The generator
+	:: const uint64_t bound :: Exclusive upper bound
+	Returns an integer in [0, bound)
+*/
+uint64_t rng_below(rng* r, const uint64_t bound);
+
+/* 
+    rng_geometric:
+	Draws the number of failed trials before the next success, for skipping over trials that mostly fail
+	:: rng* r :: The generator
+	:: const double log_failure :: log(1 - p) for a success probability p, see log1p
+	Returns the number of failures, UINT64_MAX if the next success is further away than that
+*/
+uint64_t rng_geometric(rng* r, const double log_failure);
+
+// A single step of splitmix64, used to expand seeds
+uint64_t rng_splitmix64(const uint64_t x);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/* 
+    rng_create:
+	Creates a new generator
+	:: const uint64_t seed :: Seed for the generator, the state is expanded from this using splitmix64
+	Returns a seeded rng object
+*/
+rng rng_create(const uint64_t seed)
+{
+	rng r;
+	uint64_t x = seed;
+	for (size_t i = 0; i < 4; i++)
+	{
+		r.s[i] = rng_splitmix64(x);
+		x += 0x9e3779b97f4a7c15ull;
+	}
+	return r;
+}
+
+/* 
+    rng_create_stream:
+	Creates one of many independent generators sharing a seed, such as one for each block of work
+	Nearby seeds and streams give unrelated states, unlike offsetting the seed by the stream
+	:: const uint64_t seed :: Seed shared by every stream
+	:: const uint64_t stream :: Index of the stream
+	Returns a seeded rng object
+*/
+rng rng_create_stream(const uint64_t seed, const uint64_t stream)
+{
+	// seed + stream would give stream 1 of seed 0 the same generator as stream 0 of seed 1
+	return rng_create(rng_splitmix64(seed ^ rng_splitmix64(stream)));
+}
+
+/* 
+    rng_next:
+	Draws the next 64 random bits from the generator
+	:: rng* r :: The generator
+	Returns 64 random bits
+*/
+uint64_t rng_next(rng* r)
+{
+	uint64_t* s = r->s;
+	uint64_t x = s[1] * 5;
+	uint64_t result = ((x << 7) | (x >> 57)) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = (s[3] << 45) | (s[3] >> 19);
+
+	return result;
+}
+
+/* 
+    rng_uniform:
+	Draws a uniform double from the generator
+	:: rng* r :: The generator
+	Returns a double in [0, 1)
+*/
+double rng_uniform(rng* r)
+{
+	// Top 53 bits fill the mantissa
+	return (rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* 
+    rng_below:
+	Draws a uniform integer from the generator
+	:: rng* r :: The generator
+	:: const uint64_t bound :: Exclusive upper bound
+	Returns an integer in [0, bound)
+*/
+uint64_t rng_below(rng* r, const uint64_t bound)
+{
+	// Multiply shift, the bias is negligible for the table sizes used here
+	return (uint64_t)(((unsigned __int128)rng_next(r) * bound) >> 64);
+}
+
+/* 
+    rng_geometric:
+	Draws the number of failed trials before the next success, for skipping over trials that mostly fail
+	:: rng* r :: The generator
+	:: const double log_failure :: log(1 - p) for a success probability p, see log1p
+	Returns the number of failures, UINT64_MAX if the next success is further away than that
+*/
+uint64_t rng_geometric(rng* r, const double log_failure)
+{
+	// Inversion, 1 - u is in (0, 1] so the log is finite
+	double skip = log(1.0 - rng_uniform(r)) / log_failure;
+	if (!(skip >= 0 && skip < 18446744073709551615.0))
+	{
+		return UINT64_MAX;
+	}
+	return (uint64_t)skip;
+}
+
+// A single step of splitmix64, used to expand seeds
+uint64_t rng_splitmix64(const uint64_t x)
+{
+	uint64_t z = x + 0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+#endif
@@ -0,0 +1,385 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* QECODE_N_THREADS (environment variable)
+ * Sets the number of threads in the default pool when the program starts
+ * This may be changed at runtime with thread_pool_set_default_n_threads
+ */
+
+/* GATE_MULTITHREADING, N_THREADS #
+ * If no environment variable is set, defining both of these sets the number of threads in the default pool
+ * Otherwise the default pool runs everything on the calling thread
+ */
+
+// STRUCT OBJECTS ----------------------------------------------------------------------------------------
+
+/*
+	thread_pool_task_f:
+	A task run by the pool over a range of items
+	:: void* data :: Data shared by every worker
+	:: const uint64_t start :: The first item for this worker
+	:: const uint64_t end :: One past the last item for this worker
+	:: const uint32_t worker :: The index of the worker, in [0, n_threads), for indexing per worker accumulators
+*/
+typedef void (*thread_pool_task_f)(void* data, const uint64_t start, const uint64_t end, const uint32_t worker);
+
+/*
+	thread_pool:
+	A set of worker threads that are created once and parked on a condition variable between tasks
+	The calling thread acts as worker 0, so a pool of n threads starts n - 1 workers
+	:: uint32_t n_threads :: Number of threads that share each task, including the caller
+	This object should be freed using the 'thread_pool_free' function
+*/
+typedef struct
+{
+	uint32_t n_threads;
+	pthread_t* threads;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work_ready;
+	pthread_cond_t work_done;
+
+	// The current task
+	uint64_t generation; // Incremented each time a task is released
+	uint32_t n_busy; // Workers that have not yet finished the current task
+	uint8_t running; // Set while a task is in flight, nested calls run on the calling thread
+	uint8_t shutdown;
+	thread_pool_task_f task;
+	void* data;
+	uint64_t n_items;
+} thread_pool;
+
+// Data handed to each worker thread
+typedef struct
+{
+	thread_pool* pool;
+	uint32_t worker;
+} thread_pool_worker_t;
+
+// The pool shared by the gate kernels, characterisation and decoder construction
+// The lock is held while the shared pool is created, replaced or freed
+thread_pool* thread_pool_default_pool = NULL;
+pthread_mutex_t thread_pool_default_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// FUNCTION DECLARATIONS ----------------------------------------------------------------------------------------
+
+/*
+    thread_pool_create:
+	Creates a pool and starts its workers
+	:: const uint32_t n_threads :: Number of threads that share each task, including the caller
+	Returns a heap pointer to the new pool
+*/
+thread_pool* thread_pool_create(const uint32_t n_threads);
+
+/*
+    thread_pool_parallel_for:
+	Splits [0, n_items) into one contiguous range per thread and runs the task on each range
+	Blocks until every range has completed
+	:: thread_pool* pool :: The pool, NULL runs the task on the calling thread
+	:: const uint64_t n_items :: The number of items
+	:: thread_pool_task_f task :: The task
+	:: void* data :: Data passed to every call of the task
+	No object returned
+*/
+void thread_pool_parallel_for(thread_pool* pool, const uint64_t n_items, thread_pool_task_f task, void* data);
+
+/*
+    thread_pool_n_threads:
+	The number of workers that a task is split between, this sizes per worker accumulators
+	:: const thread_pool* pool :: The pool, NULL counts as a single thread
+	Returns the number of threads
+*/
+uint32_t thread_pool_n_threads(const thread_pool* pool);
+
+/*
+    thread_pool_free:
+	Stops the workers and frees the pool
+	:: thread_pool* pool :: The pool to be freed
+	No object returned
+*/
+void thread_pool_free(thread_pool* pool);
+
+/*
+    thread_pool_default:
+	The shared pool, created on first use, see QECODE_N_THREADS
+	Creation is under a lock, so the first use may come from any number of threads at once
+	Returns the pool
+*/
+thread_pool* thread_pool_default();
+
+/*
+    thread_pool_set_default_n_threads:
+	Replaces the shared pool with one of a different size
+	This should not be called while a task is running on the shared pool
+	:: const uint32_t n_threads :: Number of threads, including the caller
+	No object returned
+*/
+void thread_pool_set_default_n_threads(const uint32_t n_threads);
+
+/*
+    thread_pool_default_free:
+	Stops the workers of the shared pool and frees it, a later call to thread_pool_default creates a new pool
+	This should not be called while a task is running on the shared pool
+	No object returned
+*/
+void thread_pool_default_free();
+
+// Worker thread loop
+void* thread_pool_worker(void* v_worker);
+
+// Range of items handled by a worker
+void thread_pool_range(const uint64_t n_items, const uint32_t n_threads, const uint32_t worker, uint64_t* start, uint64_t* end);
+
+// FUNCTION DEFINITIONS ----------------------------------------------------------------------------------------
+
+/*
+    thread_pool_create:
+	Creates a pool and starts its workers
+	:: const uint32_t n_threads :: Number of threads that share each task, including the caller
+	Returns a heap pointer to the new pool
+*/
+thread_pool* thread_pool_create(const uint32_t n_threads)
+{
+	thread_pool* pool = (thread_pool*)malloc(sizeof(thread_pool));
+	pool->n_threads = n_threads ? n_threads : 1;
+	pool->generation = 0;
+	pool->n_busy = 0;
+	pool->running = 0;
+	pool->shutdown = 0;
+	pool->task = NULL;
+	pool->data = NULL;
+	pool->n_items = 0;
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work_ready, NULL);
+	pthread_cond_init(&pool->work_done, NULL);
+
+	pool->threads = (pthread_t*)malloc(sizeof(pthread_t) * pool->n_threads);
+	for (uint32_t i = 1; i < pool->n_threads; i++)
+	{
+		thread_pool_worker_t* worker = (thread_pool_worker_t*)malloc(sizeof(thread_pool_worker_t));
+		worker->pool = pool;
+		worker->worker = i;
+		pthread_create(pool->threads + i, NULL, thread_pool_worker, worker);
+	}
+	return pool;
+}
+
+/*
+    thread_pool_parallel_for:
+	Splits [0, n_items) into one contiguous range per thread and runs the task on each range
+	Blocks until every range has completed
+	:: thread_pool* pool :: The pool, NULL runs the task on the calling thread
+	:: const uint64_t n_items :: The number of items
+	:: thread_pool_task_f task :: The task
+	:: void* data :: Data passed to every call of the task
+	No object returned
+*/
+void thread_pool_parallel_for(thread_pool* pool, const uint64_t n_items, thread_pool_task_f task, void* data)
+{
+	if (NULL == pool || 1 == pool->n_threads)
+	{
+		task(data, 0, n_items, 0);
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->running)
+	{
+		// The pool is busy with another task, possibly the one making this call
+		// The ranges are run in turn on the calling thread, each keeps its worker index so accumulators still line up
+		pthread_mutex_unlock(&pool->lock);
+		for (uint32_t i = 0; i < pool->n_threads; i++)
+		{
+			uint64_t start, end;
+			thread_pool_range(n_items, pool->n_threads, i, &start, &end);
+			task(data, start, end, i);
+		}
+		return;
+	}
+
+	pool->running = 1;
+	pool->task = task;
+	pool->data = data;
+	pool->n_items = n_items;
+	pool->n_busy = pool->n_threads - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->work_ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	// The calling thread takes the first range
+	uint64_t start, end;
+	thread_pool_range(n_items, pool->n_threads, 0, &start, &end);
+	task(data, start, end, 0);
+
+	pthread_mutex_lock(&pool->lock);
+	while (pool->n_busy > 0)
+	{
+		pthread_cond_wait(&pool->work_done, &pool->lock);
+	}
+	pool->running = 0;
+	pthread_mutex_unlock(&pool->lock);
+	return;
+}
+
+// Worker thread loop
+void* thread_pool_worker(void* v_worker)
+{
+	thread_pool_worker_t* worker = (thread_pool_worker_t*)v_worker;
+	thread_pool* pool = worker->pool;
+	uint64_t seen_generation = 0;
+
+	while (1)
+	{
+		// Park until a new task is released
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->shutdown && pool->generation == seen_generation)
+		{
+			pthread_cond_wait(&pool->work_ready, &pool->lock);
+		}
+		if (pool->shutdown)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		seen_generation = pool->generation;
+		thread_pool_task_f task = pool->task;
+		void* data = pool->data;
+		uint64_t n_items = pool->n_items;
+		pthread_mutex_unlock(&pool->lock);
+
+		uint64_t start, end;
+		thread_pool_range(n_items, pool->n_threads, worker->worker, &start, &end);
+		task(data, start, end, worker->worker);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->n_busy--;
+		if (0 == pool->n_busy)
+		{
+			pthread_cond_signal(&pool->work_done);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	free(worker);
+	return NULL;
+}
+
+// Range of items handled by a worker
+void thread_pool_range(const uint64_t n_items, const uint32_t n_threads, const uint32_t worker, uint64_t* start, uint64_t* end)
+{
+	uint64_t chunk = n_items / n_threads;
+	uint64_t remainder = n_items % n_threads;
+	*start = worker * chunk + (worker < remainder ? worker : remainder);
+	*end = *start + chunk + (worker < remainder);
+	return;
+}
+
+/*
+    thread_pool_n_threads:
+	The number of workers that a task is split between, this sizes per worker accumulators
+	:: const thread_pool* pool :: The pool, NULL counts as a single thread
+	Returns the number of threads
+*/
+uint32_t thread_pool_n_threads(const thread_pool* pool)
+{
+	return (NULL == pool) ? 1 : pool->n_threads;
+}
+
+/*
+    thread_pool_free:
+	Stops the workers and frees the pool
+	:: thread_pool* pool :: The pool to be freed
+	No object returned
+*/
+void thread_pool_free(thread_pool* pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&pool->work_ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (uint32_t i = 1; i < pool->n_threads; i++)
+	{
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->work_ready);
+	pthread_cond_destroy(&pool->work_done);
+	free(pool->threads);
+	free(pool);
+	return;
+}
+
+/*
+    thread_pool_default:
+	The shared pool, created on first use, see QECODE_N_THREADS
+	Creation is under a lock, so the first use may come from any number of threads at once
+	Returns the pool
+*/
+thread_pool* thread_pool_default()
+{
+	pthread_mutex_lock(&thread_pool_default_lock);
+	if (NULL == thread_pool_default_pool)
+	{
+		uint32_t n_threads = 1;
+		#if defined(GATE_MULTITHREADING) && defined(N_THREADS)
+			n_threads = N_THREADS;
+		#endif
+
+		const char* env_threads = getenv("QECODE_N_THREADS");
+		if (NULL != env_threads && atoi(env_threads) > 0)
+		{
+			n_threads = atoi(env_threads);
+		}
+		thread_pool_default_pool = thread_pool_create(n_threads);
+	}
+	thread_pool* pool = thread_pool_default_pool;
+	pthread_mutex_unlock(&thread_pool_default_lock);
+	return pool;
+}
+
+/*
+    thread_pool_set_default_n_threads:
+	Replaces the shared pool with one of a different size
+	This should not be called while a task is running on the shared pool
+	:: const uint32_t n_threads :: Number of threads, including the caller
+	No object returned
+*/
+void thread_pool_set_default_n_threads(const uint32_t n_threads)
+{
+	pthread_mutex_lock(&thread_pool_default_lock);
+	if (NULL != thread_pool_default_pool)
+	{
+		thread_pool_free(thread_pool_default_pool);
+	}
+	thread_pool_default_pool = thread_pool_create(n_threads);
+	pthread_mutex_unlock(&thread_pool_default_lock);
+	return;
+}
+
+/*
+    thread_pool_default_free:
+	Stops the workers of the shared pool and frees it, a later call to thread_pool_default creates a new pool
+	This should not be called while a task is running on the shared pool
+	No object returned
+*/
+void thread_pool_default_free()
+{
+	pthread_mutex_lock(&thread_pool_default_lock);
+	if (NULL != thread_pool_default_pool)
+	{
+		thread_pool_free(thread_pool_default_pool);
+		thread_pool_default_pool = NULL;
+	}
+	pthread_mutex_unlock(&thread_pool_default_lock);
+	return;
+}
+
+#endif
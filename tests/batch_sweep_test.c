@@ -0,0 +1,105 @@
+#include "sym.h"
+
+#include "codes/codes.h"
+#include "decoders/tailored.h"
+
+#include "gates/clifford_generators.h"
+#include "circuits/encoding.h"
+
+#include "error_models/iid.h"
+#include "error_models/lookup.h"
+#include "error_models/batch.h"
+#include "characterise.h"
+
+#define N_LANES 4
+
+int main()
+{
+	sym* code = code_five_qubit();
+	sym* logicals = code_five_qubit_logicals();
+	uint32_t n_qubits = 5;
+
+	double p_errors[N_LANES] = {0.0001, 0.001, 0.01, 0.1};
+
+	// Batched pass, every error rate in one traversal
+	error_model* gate_noise = error_model_create_iid_batch(1, N_LANES, p_errors);
+	error_model* cnot_noise = error_model_create_iid_batch(2, N_LANES, p_errors);
+	gate* iid_error_gate = gate_create_iid_noise(gate_noise);
+	gate* cnot = gate_create(2, gate_cnot, cnot_noise, NULL);
+	gate* hadamard = gate_create(1, gate_hadamard, gate_noise, NULL);
+	gate* phase = gate_create(1, gate_phase, gate_noise, NULL);
+
+	circuit* encode = encoding_circuit(code, logicals, cnot, hadamard, phase);
+
+	double* initial_error_probs = error_probabilities_batch_identity(n_qubits, N_LANES);
+	double* encoded_error_probs = circuit_run_batch(encode, N_LANES, initial_error_probs, iid_error_gate);
+
+	// Each lane of the encoded distribution becomes the noise seen by the decoder
+	error_model* lane_models[N_LANES];
+	for (uint32_t i = 0; i < N_LANES; i++)
+	{
+		double* lane_probs = error_probabilities_batch_lane(encoded_error_probs, n_qubits, N_LANES, i);
+		lane_models[i] = error_model_create_lookup(n_qubits, lane_probs);
+		free(lane_probs);
+	}
+	error_model* encoding_error = error_model_create_batch(N_LANES, lane_models);
+
+	decoder** tailored = decoder_create_tailored_batch(code, logicals, encoding_error, N_LANES);
+
+	printf("p\t\tBatched\t\tSingle\n");
+	for (uint32_t i = 0; i < N_LANES; i++)
+	{
+		// The batched decoder is only valid for its own lane
+		error_model* lane_error = lane_models[i];
+		double* batched = characterise_code(code, logicals, lane_error, tailored[i]);
+
+		// The same pipeline for a single error rate
+		error_model* single_gate_noise = error_model_create_iid(1, p_errors[i]);
+		error_model* single_cnot_noise = error_model_create_iid(2, p_errors[i]);
+		gate* single_iid_error_gate = gate_create_iid_noise(single_gate_noise);
+		gate* single_cnot = gate_create(2, gate_cnot, single_cnot_noise, NULL);
+		gate* single_hadamard = gate_create(1, gate_hadamard, single_gate_noise, NULL);
+		gate* single_phase = gate_create(1, gate_phase, single_gate_noise, NULL);
+
+		circuit* single_encode = encoding_circuit(code, logicals, single_cnot, single_hadamard, single_phase);
+		double* single_initial = error_probabilities_identity(n_qubits);
+		double* single_encoded = circuit_run(single_encode, single_initial, single_iid_error_gate);
+		error_model* single_encoding_error = error_model_create_lookup(n_qubits, single_encoded);
+		decoder* single_tailored = decoder_create_tailored(code, logicals, single_encoding_error);
+		double* single = characterise_code(code, logicals, single_encoding_error, single_tailored);
+
+		printf("%e\t%e\t%e\n", p_errors[i], batched[0], single[0]);
+
+		free(batched);
+		free(single);
+		free(single_initial);
+		free(single_encoded);
+		decoder_free(single_tailored);
+		error_model_free(single_encoding_error);
+		error_model_free(single_gate_noise);
+		error_model_free(single_cnot_noise);
+	}
+
+	// The lanes can also be characterised together against a shared decoder
+	double* shared = characterise_code_batch(code, logicals, encoding_error, tailored[0], N_LANES);
+	printf("Lane 0 decoder applied to every lane:");
+	for (uint32_t i = 0; i < N_LANES; i++)
+	{
+		printf(" %e", shared[i]);
+	}
+	printf("\n");
+
+	free(shared);
+	for (uint32_t i = 0; i < N_LANES; i++)
+	{
+		decoder_free(tailored[i]);
+		error_model_free(lane_models[i]);
+	}
+	free(tailored);
+	error_model_free(encoding_error);
+	free(initial_error_probs);
+	free(encoded_error_probs);
+	error_model_free(gate_noise);
+	error_model_free(cnot_noise);
+	return 0;
+}
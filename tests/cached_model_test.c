@@ -0,0 +1,74 @@
+#include "error_models/iid.h"
+#include "error_models/cached.h"
+#include "gates/clifford_generators.h"
+#include "circuits/error_probabilities.h"
+#include "characterise.h"
+
+int main()
+{
+	uint32_t n_qubits = 4;
+	double p_error = 0.01;
+
+	error_model* em = error_model_create_iid(2, p_error);
+	error_model* em_dense = error_model_create_cached(em, 2, ERROR_MODEL_CACHE_DENSE);
+	error_model* em_hashed = error_model_create_cached(em, 2, ERROR_MODEL_CACHE_HASHED);
+
+	gate* cnot = gate_create(2, gate_cnot, em, NULL);
+	gate* cnot_dense = gate_create(2, gate_cnot, em_dense, NULL);
+	gate* cnot_hashed = gate_create(2, gate_cnot, em_hashed, NULL);
+
+	// Spread the errors out so that many input states are non-zero
+	error_model* em_initial = error_model_create_iid(1, 0.1);
+	gate* initial_noise = gate_create_iid_noise(em_initial);
+	double* probs = error_probabilities_identity(n_qubits);
+	for (uint32_t i = 0; i < n_qubits; i++)
+	{
+		double* tmp = gate_apply(n_qubits, probs, initial_noise, &i);
+		free(probs);
+		probs = tmp;
+	}
+
+	// Each application only evaluates the model once per local error, so the cache is hit on later gates
+	double max_diff = 0;
+	for (uint32_t i = 0; i < n_qubits - 1; i++)
+	{
+		uint32_t target_qubits[2] = {i, i + 1};
+		double* probs_uncached = gate_apply(n_qubits, probs, cnot, target_qubits);
+		double* probs_dense = gate_apply(n_qubits, probs, cnot_dense, target_qubits);
+		double* probs_hashed = gate_apply(n_qubits, probs, cnot_hashed, target_qubits);
+
+		for (uint64_t j = 0; j < error_probabilities_entries_in_table(n_qubits); j++)
+		{
+			max_diff = fmax(max_diff, fabs(probs_uncached[j] - probs_dense[j]));
+			max_diff = fmax(max_diff, fabs(probs_uncached[j] - probs_hashed[j]));
+		}
+
+		free(probs_uncached);
+		free(probs_dense);
+		free(probs_hashed);
+	}
+	printf("Max difference from the uncached model: %e\n", max_diff);
+
+	uint64_t hits, misses;
+	error_model_cached_stats(em_dense, &hits, &misses);
+	printf("Dense cache: %lu hits, %lu misses\n", hits, misses);
+	error_model_cached_stats(em_hashed, &hits, &misses);
+	printf("Hashed cache: %lu hits, %lu misses\n", hits, misses);
+
+	// An error over more qubits than the cache is rejected rather than keyed outside it
+	sym* oversized = sym_create(1, 2 * n_qubits);
+	sym_set(oversized, 0, 0, 1);
+	printf("Oversized errors rejected: %d\n", 0 == error_model_call(em_dense, oversized) && 0 == error_model_call(em_hashed, oversized));
+	sym_free(oversized);
+
+	free(probs);
+	free(cnot);
+	free(cnot_dense);
+	free(cnot_hashed);
+	free(initial_noise);
+	error_model_free(em_dense);
+	error_model_free(em_hashed);
+	error_model_free(em);
+	error_model_free(em_initial);
+	return 0;
+}
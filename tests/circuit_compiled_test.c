@@ -0,0 +1,106 @@
+#include "test_utils.h"
+
+/*
+ *	A compiled circuit holds the same gates as the list it was made from, grouped into moments
+ *	Running it should match applying each gate of the list in turn
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+
+	circuit* c = f->encode;
+	circuit_add_gate_start(c, f->hadamard, 4);
+	circuit_compiled* cc = circuit_compile(c);
+
+	// The gates and targets are copied in program order
+	uint8_t same_gates = (cc->n_gates == c->n_gates);
+	uint32_t gate_idx = 0;
+	for (circuit_element* ce = c->start; NULL != ce; ce = ce->next, gate_idx++)
+	{
+		same_gates &= (cc->gates[gate_idx] == ce->gate_operation);
+		same_gates &= (0 == memcmp(circuit_compiled_targets(cc, gate_idx), ce->target_qubits, sizeof(unsigned) * ce->gate_operation->n_qubits));
+	}
+	printf("Gates: %u, moments: %u, same gates %d\n", cc->n_gates, cc->n_moments, same_gates);
+
+	// Each moment acts on disjoint qubits, and a gate comes after every earlier gate that shares a qubit
+	uint32_t* gate_moment = (uint32_t*)malloc(sizeof(uint32_t) * cc->n_gates);
+	uint8_t* busy = (uint8_t*)malloc(sizeof(uint8_t) * n_qubits);
+	uint8_t disjoint = (cc->moment_start[cc->n_moments] == cc->n_gates);
+	for (uint32_t moment = 0; moment < cc->n_moments; moment++)
+	{
+		memset(busy, 0, sizeof(uint8_t) * n_qubits);
+		for (uint32_t m = cc->moment_start[moment]; m < cc->moment_start[moment + 1]; m++)
+		{
+			const unsigned* targets = circuit_compiled_targets(cc, cc->moment_gates[m]);
+			for (uint32_t j = 0; j < cc->gates[cc->moment_gates[m]]->n_qubits; j++)
+			{
+				disjoint &= !busy[targets[j]];
+				busy[targets[j]] = 1;
+			}
+			gate_moment[cc->moment_gates[m]] = moment;
+		}
+	}
+	uint8_t ordered = 1;
+	for (uint32_t later = 0; later < cc->n_gates; later++)
+	{
+		for (uint32_t earlier = 0; earlier < later; earlier++)
+		{
+			memset(busy, 0, sizeof(uint8_t) * n_qubits);
+			circuit_compiled_mark_busy(cc, earlier, busy);
+			uint8_t shared = 0;
+			for (uint32_t j = 0; j < cc->gates[later]->n_qubits; j++)
+			{
+				shared |= busy[circuit_compiled_targets(cc, later)[j]];
+			}
+			ordered &= (!shared || gate_moment[earlier] < gate_moment[later]);
+		}
+	}
+	printf("Moments are disjoint %d, dependencies ordered %d\n", disjoint, ordered);
+
+	// Reference, each gate of the list and then the noise on every other qubit
+	error_probability_t* initial_error_probs = error_probabilities_identity(n_qubits);
+	error_probability_t* expected = error_probabilities_copy(n_qubits, initial_error_probs);
+	for (circuit_element* ce = c->start; NULL != ce; ce = ce->next)
+	{
+		error_probability_t* tmp = gate_apply(n_qubits, expected, ce->gate_operation, ce->target_qubits);
+		free(expected);
+		expected = tmp;
+		for (unsigned q = 0; q < n_qubits; q++)
+		{
+			uint8_t participant = 0;
+			for (uint32_t j = 0; j < ce->gate_operation->n_qubits; j++)
+			{
+				participant |= (q == ce->target_qubits[j]);
+			}
+			if (!participant)
+			{
+				tmp = gate_apply(n_qubits, expected, f->iid_error_gate, &q);
+				free(expected);
+				expected = tmp;
+			}
+		}
+	}
+
+	error_probability_t* error_probs = error_probabilities_copy(n_qubits, initial_error_probs);
+	error_probability_t* scratch = error_probabilities_zeros(n_qubits);
+	circuit_compiled_run_buffers(cc, &error_probs, &scratch, f->iid_error_gate);
+	error_probability_t* default_error_probs = circuit_run_default(c, initial_error_probs, f->iid_error_gate);
+
+	double tolerance = (sizeof(error_probability_t) == sizeof(float)) ? 1e-6 : 1e-12;
+	printf("Compiled run matches %d, default run matches %d\n",
+		max_table_diff(error_probs, expected, n_qubits) < tolerance,
+		max_table_diff(default_error_probs, expected, n_qubits) < tolerance);
+
+	free(default_error_probs);
+	free(scratch);
+	free(error_probs);
+	free(expected);
+	free(initial_error_probs);
+	free(busy);
+	free(gate_moment);
+	circuit_compiled_free(cc);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include "test_utils.h"
+
+#include "circuits/circuit_light_cone.h"
+
+/*
+ *	Measures each stabiliser of the five qubit code onto its own ancilla, one after another
+ *	A light cone run that only keeps the code block should hold a single ancilla at a time
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	sym* code = f->code;
+	gate* cnot = f->cnot;
+	gate* hadamard = f->hadamard;
+	uint32_t n_code_qubits = 5;
+	uint32_t n_qubits = n_code_qubits + code->height;
+
+	error_probability_t* encoded_error_probs = test_five_qubit_encoded(f);
+
+	// Inserting a qubit in the middle of the table, against moving each string through a sym object
+	error_probability_t* inserted = error_probabilities_insert_qubit(error_probabilities_copy(n_code_qubits, encoded_error_probs), n_code_qubits, 2);
+	sym* inserted_state = sym_create(1, 2 * (n_code_qubits + 1));
+	uint64_t mismatches = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_code_qubits); i++)
+	{
+		sym* state = ll_to_sym_n_qubits(i, 1, n_code_qubits);
+		for (uint32_t q = 0; q < n_code_qubits; q++)
+		{
+			sym_set_X(inserted_state, 0, q + (q >= 2), sym_get_X(state, 0, q));
+			sym_set_Z(inserted_state, 0, q + (q >= 2), sym_get_Z(state, 0, q));
+		}
+		mismatches += (inserted[sym_to_ll(inserted_state)] != encoded_error_probs[i]);
+		sym_free(state);
+	}
+	unsigned inserted_qubit = 2;
+	inserted = error_probabilities_trace_out(inserted, n_code_qubits + 1, &inserted_qubit, 1);
+	printf("Insert mismatches: %lu, trace out recovers the table: %d\n", mismatches, 0 == memcmp(inserted, encoded_error_probs, error_probabilities_bytes_in_table(n_code_qubits)));
+
+	// Each stabiliser onto its own ancilla
+	circuit* c = circuit_create(n_qubits);
+	for (uint32_t s = 0; s < code->height; s++)
+	{
+		unsigned ancilla = n_code_qubits + s;
+		circuit_add_gate(c, hadamard, ancilla);
+		for (uint32_t q = 0; q < n_code_qubits; q++)
+		{
+			if (sym_get_X(code, s, q))
+			{
+				circuit_add_gate(c, cnot, ancilla, q);
+			}
+			if (sym_get_Z(code, s, q))
+			{
+				circuit_add_gate(c, hadamard, q);
+				circuit_add_gate(c, cnot, q, ancilla);
+				circuit_add_gate(c, hadamard, q);
+			}
+		}
+		circuit_add_gate(c, hadamard, ancilla);
+	}
+
+	// Reference, the full table without environmental noise, whose placement differs between the two runs
+	error_probability_t* expanded_error_probs = error_probabilities_step_up(encoded_error_probs, n_code_qubits, n_qubits);
+	error_probability_t* full_error_probs = circuit_run_default(c, expanded_error_probs, NULL);
+
+	double tolerance = (sizeof(error_probability_t) == sizeof(float)) ? 1e-6 : 1e-12;
+	uint8_t* kept = (uint8_t*)calloc(n_qubits, sizeof(uint8_t));
+
+	// Keeping every qubit is the full run
+	memset(kept, 1, sizeof(uint8_t) * n_qubits);
+	error_probability_t* light_cone_error_probs = circuit_run_light_cone(c, encoded_error_probs, n_code_qubits, kept, NULL);
+	printf("All qubits kept, peak qubits: %u, matches %d\n", circuit_light_cone_peak(c, n_code_qubits, kept), max_table_diff(light_cone_error_probs, full_error_probs, n_qubits) < tolerance);
+	free(light_cone_error_probs);
+
+	// Keeping the code block is the full run with the ancillas traced out
+	memset(kept + n_code_qubits, 0, sizeof(uint8_t) * code->height);
+	uint32_t* ancillas = target_qubits_create_range(n_code_qubits, n_qubits);
+	full_error_probs = error_probabilities_trace_out(full_error_probs, n_qubits, ancillas, code->height);
+	light_cone_error_probs = circuit_run_light_cone(c, encoded_error_probs, n_code_qubits, kept, NULL);
+	printf("Code block kept, peak qubits: %u, matches %d\n", circuit_light_cone_peak(c, n_code_qubits, kept), max_table_diff(light_cone_error_probs, full_error_probs, n_code_qubits) < tolerance);
+	free(light_cone_error_probs);
+
+	// Environmental noise, every qubit is in the table for the whole of the encoding circuit
+	memset(kept, 1, sizeof(uint8_t) * n_code_qubits);
+	error_probability_t* default_error_probs = circuit_run_default(f->encode, encoded_error_probs, f->iid_error_gate);
+	light_cone_error_probs = circuit_run_light_cone(f->encode, encoded_error_probs, n_code_qubits, kept, f->iid_error_gate);
+	printf("Environmental noise matches %d\n", max_table_diff(light_cone_error_probs, default_error_probs, n_code_qubits) < tolerance);
+
+	free(light_cone_error_probs);
+	free(default_error_probs);
+	target_qubits_free(ancillas);
+	free(kept);
+	free(full_error_probs);
+	free(expanded_error_probs);
+	circuit_free(c);
+	sym_free(inserted_state);
+	free(inserted);
+	free(encoded_error_probs);
+	test_five_qubit_free(f);
+	return 0;
+}
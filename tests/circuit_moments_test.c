@@ -0,0 +1,56 @@
+#include "sym.h"
+
+#include "gates/clifford_generators.h"
+#include "circuits/circuit.h"
+
+#include "error_models/iid.h"
+
+int main()
+{
+	uint32_t n_qubits = 4;
+
+	error_model* gate_noise = error_model_create_iid(1, 0.01);
+	error_model* cnot_noise = error_model_create_iid(2, 0.01);
+	error_model* environmental_noise = error_model_create_iid(1, 0.001);
+
+	gate* cnot = gate_create(2, gate_cnot, cnot_noise, NULL);
+	gate* hadamard = gate_create(1, gate_hadamard, gate_noise, NULL);
+	gate* iid_error_gate = gate_create_iid_noise(environmental_noise);
+
+	// Two moments that keep every qubit busy
+	circuit* c = circuit_create(n_qubits);
+	circuit_add_gate(c, hadamard, 0);
+	circuit_add_gate(c, hadamard, 2);
+	circuit_add_gate(c, hadamard, 1);
+	circuit_add_gate(c, cnot, 0, 1);
+	circuit_add_gate(c, hadamard, 3);
+	circuit_add_gate(c, cnot, 2, 3);
+
+	double* initial_error_probs = error_probabilities_identity(n_qubits);
+	double* no_idle_error_probs = circuit_run_default(c, initial_error_probs, NULL);
+	double* moment_error_probs = circuit_run_moments(c, initial_error_probs, iid_error_gate);
+	double* default_error_probs = circuit_run_default(c, initial_error_probs, iid_error_gate);
+
+	// No qubit is ever idle within a moment, so the environmental noise should never be applied
+	double max_diff = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		max_diff = fmax(max_diff, fabs(no_idle_error_probs[i] - moment_error_probs[i]));
+	}
+	printf("Max difference from a run without idle noise: %e\n", max_diff);
+	printf("Probability of no error, per gate idle noise: %f\n", default_error_probs[0]);
+	printf("Probability of no error, per moment idle noise: %f\n", moment_error_probs[0]);
+
+	circuit_free(c);
+	free(initial_error_probs);
+	free(no_idle_error_probs);
+	free(moment_error_probs);
+	free(default_error_probs);
+	free(cnot);
+	free(hadamard);
+	free(iid_error_gate);
+	error_model_free(gate_noise);
+	error_model_free(cnot_noise);
+	error_model_free(environmental_noise);
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "test_utils.h"
+
+#include "circuits/circuit_transfer.h"
+
+/*
+ *	Repeated blocks applied through their transfer maps, against running the block gate by gate
+ *	Blocks with the same gates on shifted qubits share a single map
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	gate* cnot = f->cnot;
+	gate* hadamard = f->hadamard;
+	gate* phase = f->phase;
+	gate* iid_error_gate = f->iid_error_gate;
+	uint32_t n_qubits = 6;
+
+	// A non trivial starting table on six qubits
+	error_probability_t* encoded_error_probs = test_five_qubit_encoded(f);
+	error_probability_t* error_probs = error_probabilities_step_up(encoded_error_probs, 5, n_qubits);
+
+	// The targets are not given in order
+	circuit* block = circuit_create(n_qubits);
+	circuit_add_gate(block, hadamard, 4);
+	circuit_add_gate(block, cnot, 4, 1);
+	circuit_add_gate(block, phase, 2);
+	circuit_add_gate(block, cnot, 1, 2);
+
+	// The same block on qubits 5, 2 and 3
+	circuit* shifted_block = circuit_create(n_qubits);
+	circuit_add_gate(shifted_block, hadamard, 5);
+	circuit_add_gate(shifted_block, cnot, 5, 2);
+	circuit_add_gate(shifted_block, phase, 3);
+	circuit_add_gate(shifted_block, cnot, 2, 3);
+
+	double tolerance = (sizeof(error_probability_t) == sizeof(float)) ? 1e-6 : 1e-12;
+	circuit_transfer_cache* cache = circuit_transfer_cache_create();
+
+	// Three rounds of each block, gate by gate and through the cache
+	error_probability_t* expected = error_probabilities_copy(n_qubits, error_probs);
+	error_probability_t* cached = error_probabilities_copy(n_qubits, error_probs);
+	uint8_t applied = 1;
+	for (uint32_t round = 0; round < 3; round++)
+	{
+		circuit* blocks[2] = {block, shifted_block};
+		for (uint32_t b = 0; b < 2; b++)
+		{
+			error_probability_t* tmp = circuit_run_default(blocks[b], expected, NULL);
+			free(expected);
+			expected = tmp;
+			applied &= circuit_transfer_cache_run(cache, blocks[b], NULL, cached);
+		}
+	}
+	printf("Rounds applied %d, cached blocks: %u, matches %d\n", applied, cache->n_entries, max_table_diff(cached, expected, n_qubits) < tolerance);
+
+	// Environmental noise on a block that covers every qubit of its table
+	circuit* noisy_block = circuit_create(3);
+	circuit_add_gate(noisy_block, hadamard, 0);
+	circuit_add_gate(noisy_block, cnot, 0, 2);
+	circuit_add_gate(noisy_block, phase, 1);
+	circuit_add_gate(noisy_block, cnot, 2, 1);
+	error_probability_t* small_error_probs = error_probabilities_step_down(encoded_error_probs, 5, 3);
+	error_probability_t* small_expected = circuit_run_default(noisy_block, small_error_probs, iid_error_gate);
+	circuit_transfer_cache_run(cache, noisy_block, iid_error_gate, small_error_probs);
+	printf("Environmental noise matches %d, total probability %f\n", max_table_diff(small_error_probs, small_expected, 3) < tolerance, table_total(small_error_probs, 3));
+
+	// Environmental noise on a block that leaves qubits of its table idle
+	error_probability_t* noisy_expected = circuit_run_default(block, error_probs, iid_error_gate);
+	error_probability_t* noisy_cached = error_probabilities_copy(n_qubits, error_probs);
+	circuit_transfer_cache_run(cache, block, iid_error_gate, noisy_cached);
+	printf("Idle qubit noise matches %d\n", max_table_diff(noisy_cached, noisy_expected, n_qubits) < tolerance);
+
+	// A gate freed and replaced by another is not mistaken for the old gate, even at the same address
+	uint32_t n_entries = cache->n_entries;
+	gate* replaced = gate_create(1, gate_hadamard, f->gate_noise, NULL);
+	circuit* replaced_block = circuit_create(n_qubits);
+	circuit_add_gate(replaced_block, replaced, 0);
+	circuit_transfer_cache_run(cache, replaced_block, NULL, noisy_cached);
+	circuit_free(replaced_block);
+	free(replaced);
+	replaced = gate_create(1, gate_phase, f->gate_noise, NULL);
+	replaced_block = circuit_create(n_qubits);
+	circuit_add_gate(replaced_block, replaced, 0);
+	error_probability_t* replaced_expected = circuit_run_default(replaced_block, noisy_cached, NULL);
+	circuit_transfer_cache_run(cache, replaced_block, NULL, noisy_cached);
+	printf("Replaced gate matches %d, new blocks: %u\n", max_table_diff(noisy_cached, replaced_expected, n_qubits) < tolerance, cache->n_entries - n_entries);
+
+	// Blocks on too many qubits are left to the caller
+	circuit* large_block = circuit_create(n_qubits);
+	for (unsigned q = 0; q < n_qubits; q++)
+	{
+		circuit_add_gate(large_block, hadamard, q);
+	}
+	printf("Large block applied: %d, cached blocks: %u\n", circuit_transfer_cache_run(cache, large_block, NULL, cached), cache->n_entries);
+
+	circuit_free(large_block);
+	free(replaced_expected);
+	circuit_free(replaced_block);
+	free(replaced);
+	free(noisy_cached);
+	free(noisy_expected);
+	free(small_expected);
+	free(small_error_probs);
+	circuit_free(noisy_block);
+	circuit_transfer_cache_free(cache);
+	free(cached);
+	free(expected);
+	circuit_free(shifted_block);
+	circuit_free(block);
+	free(error_probs);
+	free(encoded_error_probs);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,34 @@
+#include "test_utils.h"
+
+#include "gates/pauli_generators.h"
+#include "gates/measurement.h"
+#include "circuits/circuit_wht.h"
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+
+	gate* pauli_Y = gate_create(1, gate_pauli_Y, f->gate_noise, NULL);
+	gate* measure = gate_create(1, gate_measure_Z, f->gate_noise, NULL);
+
+	// The encoding circuit only has transformed gates, the Y and measurement are added to check the fallbacks
+	circuit_add_gate(f->encode, pauli_Y, 2);
+	circuit_add_gate(f->encode, measure, 4);
+	circuit_add_gate(f->encode, f->cnot, 4, 1);
+
+	double* initial_error_probs = error_probabilities_identity(n_qubits);
+	double* default_error_probs = circuit_run_default(f->encode, initial_error_probs, f->iid_error_gate);
+	double* wht_error_probs = circuit_run_wht(f->encode, initial_error_probs, f->iid_error_gate);
+
+	printf("Max difference from circuit_run_default: %e\n", max_table_diff(default_error_probs, wht_error_probs, n_qubits));
+	printf("Total probability: %f\n", table_total(wht_error_probs, n_qubits));
+
+	free(initial_error_probs);
+	free(default_error_probs);
+	free(wht_error_probs);
+	free(pauli_Y);
+	free(measure);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include "sym.h"
+
+#include "gates/clifford_generators.h"
+#include "gates/pauli_generators.h"
+#include "circuits/circuit.h"
+
+#include "error_models/iid.h"
+
+// Builds the same circuit each time, one noisy gate splits it into two runs of noiseless gates
+circuit* build_circuit(const uint32_t n_qubits, gate* cnot, gate* hadamard, gate* phase, gate* pauli_X, gate* noisy_cnot)
+{
+	circuit* c = circuit_create(n_qubits);
+
+	// The Y basis mapping used by the flagged syndrome measurements
+	circuit_add_gate(c, phase, 0);
+	circuit_add_gate(c, phase, 0);
+	circuit_add_gate(c, phase, 0);
+	circuit_add_gate(c, hadamard, 0);
+	circuit_add_gate(c, cnot, 0, 1);
+	circuit_add_gate(c, pauli_X, 2);
+	circuit_add_gate(c, cnot, 2, 1);
+	circuit_add_gate(c, hadamard, 4);
+
+	circuit_add_gate(c, noisy_cnot, 1, 3);
+
+	circuit_add_gate(c, hadamard, 3);
+	circuit_add_gate(c, phase, 3);
+	circuit_add_gate(c, cnot, 3, 4);
+	circuit_add_gate(c, pauli_X, 4);
+	return c;
+}
+
+int main()
+{
+	uint32_t n_qubits = 5;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+
+	error_model* cnot_noise = error_model_create_iid(2, 0.01);
+
+	gate* cnot = gate_create_noiseless(2, gate_cnot);
+	gate* hadamard = gate_create_noiseless(1, gate_hadamard);
+	gate* phase = gate_create_noiseless(1, gate_phase);
+	gate* pauli_X = gate_create_noiseless(1, gate_pauli_X);
+	gate* noisy_cnot = gate_create(2, gate_cnot, cnot_noise, NULL);
+
+	double* initial_error_probs = error_probabilities_zeros(n_qubits);
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		initial_error_probs[i] = (double)rand() / RAND_MAX;
+	}
+
+	circuit* c = build_circuit(n_qubits, cnot, hadamard, phase, pauli_X, noisy_cnot);
+	circuit* fused = build_circuit(n_qubits, cnot, hadamard, phase, pauli_X, noisy_cnot);
+
+	unsigned n_removed = circuit_fuse_clifford(fused);
+	printf("Gates before fusion: %u, after fusion: %u, removed: %u\n", c->n_gates, fused->n_gates, n_removed);
+
+	double* error_probs = circuit_run_noiseless(c, initial_error_probs);
+	double* fused_error_probs = circuit_run_noiseless(fused, initial_error_probs);
+
+	double max_diff = 0;
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		max_diff = fmax(max_diff, fabs(error_probs[i] - fused_error_probs[i]));
+	}
+	printf("Max difference between the fused and unfused circuits: %e\n", max_diff);
+
+	// The fused gates also apply to single pauli strings
+	sym* error = sym_create(1, 2 * n_qubits);
+	sym_set_X(error, 0, 0, 1);
+	sym_set_Z(error, 0, 3, 1);
+	gate_result* result = gate_operation(fused->start->gate_operation, error, fused->start->target_qubits);
+	double* single_probs = error_probabilities_zeros(n_qubits);
+	single_probs[sym_to_ll(error)] = 1;
+	double* single_fused_probs = gate_operator(n_qubits, single_probs, fused->start->gate_operation, fused->start->target_qubits);
+	printf("Per string and table application agree: %d\n", single_fused_probs[sym_to_ll(result->state_results[0])] == 1);
+
+	gate_result_free(result);
+	sym_free(error);
+	free(single_probs);
+	free(single_fused_probs);
+
+	circuit_free(c);
+	circuit_free(fused);
+	free(initial_error_probs);
+	free(error_probs);
+	free(fused_error_probs);
+	free(cnot);
+	free(hadamard);
+	free(phase);
+	free(pauli_X);
+	free(noisy_cnot);
+	error_model_free(cnot_noise);
+	return 0;
+}
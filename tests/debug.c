@@ -1,9 +1,3 @@
-#define GATE_MAX_DEPTH 3
-#define GATE_MULTITHREADING
-#define N_THREADS 3
-
-#define CHARACTERISE_MAX_DEPTH 2
-
 #include "../gates/clifford_generators.h"
 #include "../error_models/iid.h"
 #include "../characterise.h"
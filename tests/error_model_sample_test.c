@@ -0,0 +1,62 @@
+#include "error_models/iid_biased.h"
+#include "error_models/lookup.h"
+#include "error_models/sample.h"
+#include "circuits/error_probabilities.h"
+
+int main()
+{
+	uint32_t n_qubits = 3;
+	uint32_t n_samples = 1000000;
+
+	error_model* em_biased = error_model_create_iid_biased_Z(n_qubits, 0.1, 10);
+
+	// The same distribution as a lookup table, this uses the global sampler rather than the per qubit sampler
+	double* table = error_probabilities_zeros(n_qubits);
+	sym_iter* siter = sym_iter_create_n_qubits(n_qubits);
+	while (sym_iter_next(siter))
+	{
+		table[sym_to_ll(siter->state)] = error_model_call(em_biased, siter->state);
+	}
+	sym_iter_free(siter);
+	error_model* em_lookup = error_model_create_lookup(n_qubits, table);
+
+	error_model_sampler_t* sampler_biased = error_model_sampler_create(em_biased, n_qubits);
+	error_model_sampler_t* sampler_lookup = error_model_sampler_create(em_lookup, n_qubits);
+
+	rng r = rng_create(1234);
+	sym* error = sym_create(1, 2 * n_qubits);
+
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	double* counts_biased = error_probabilities_zeros(n_qubits);
+	double* counts_lookup = error_probabilities_zeros(n_qubits);
+	for (uint32_t i = 0; i < n_samples; i++)
+	{
+		error_model_sampler_draw(sampler_biased, &r, error);
+		counts_biased[sym_to_ll(error)] += 1.0 / n_samples;
+
+		error_model_sampler_draw(sampler_lookup, &r, error);
+		counts_lookup[sym_to_ll(error)] += 1.0 / n_samples;
+	}
+
+	double max_diff_biased = 0;
+	double max_diff_lookup = 0;
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		max_diff_biased = fmax(max_diff_biased, fabs(counts_biased[i] - table[i]));
+		max_diff_lookup = fmax(max_diff_lookup, fabs(counts_lookup[i] - table[i]));
+	}
+
+	printf("Max deviation from the exact distribution over %u samples\n", n_samples);
+	printf("Factorised sampler: %e\n", max_diff_biased);
+	printf("Global sampler: %e\n", max_diff_lookup);
+
+	sym_free(error);
+	error_model_sampler_free(sampler_biased);
+	error_model_sampler_free(sampler_lookup);
+	error_model_free(em_biased);
+	error_model_free(em_lookup);
+	free(table);
+	free(counts_biased);
+	free(counts_lookup);
+	return 0;
+}
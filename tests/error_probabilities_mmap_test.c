@@ -0,0 +1,81 @@
+#include "test_utils.h"
+
+#include "circuits/error_probabilities_mmap.h"
+
+/*
+ *	Runs a circuit on tables held in files, against the same run on the heap
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	gate* iid_error_gate = f->iid_error_gate;
+	uint32_t n_code_qubits = 5;
+	uint32_t n_qubits = 7;
+
+	error_probability_t* encoded_error_probs = test_five_qubit_encoded(f);
+
+	// The code block and two more qubits
+	circuit* c = circuit_create(n_qubits);
+	circuit_add_gate(c, f->hadamard, 5);
+	circuit_add_gate(c, f->cnot, 5, 0);
+	circuit_add_gate(c, f->cnot, 3, 6);
+	circuit_add_gate(c, f->phase, 6);
+	circuit_add_gate(c, f->cnot, 6, 1);
+	circuit_add_gate(c, f->hadamard, 5);
+
+	error_probability_t* expanded_error_probs = error_probabilities_step_up(encoded_error_probs, n_code_qubits, n_qubits);
+	error_probability_t* expected = circuit_run_default(c, expanded_error_probs, iid_error_gate);
+
+	// The table is stepped up straight into its file
+	error_probability_t* error_probs = error_probabilities_mmap_step_up("error_probabilities_mmap_test.bin", encoded_error_probs, n_code_qubits, n_qubits);
+	error_probability_t* scratch = error_probabilities_mmap_scratch(".", n_qubits);
+	if (NULL == error_probs || NULL == scratch)
+	{
+		printf("Failed to map tables\n");
+		return 1;
+	}
+	printf("Step up matches: %d\n", 0 == memcmp(error_probs, expanded_error_probs, error_probabilities_bytes_in_table(n_qubits)));
+
+	// The result may end up in either table
+	error_probability_t* named_table = error_probs;
+	circuit_run_buffers(c, &error_probs, &scratch, iid_error_gate);
+	if (error_probs != named_table)
+	{
+		memcpy(named_table, error_probs, error_probabilities_bytes_in_table(n_qubits));
+	}
+	printf("Mapped run matches: %d\n", 0 == memcmp(error_probs, expected, error_probabilities_bytes_in_table(n_qubits)));
+	error_probabilities_mmap_free(error_probs, n_qubits);
+	error_probabilities_mmap_free(scratch, n_qubits);
+
+	// The file keeps the result, and a mapped table can be stepped down onto the heap
+	error_probability_t* reopened = error_probabilities_mmap_open("error_probabilities_mmap_test.bin", n_qubits);
+	error_probability_t* code_error_probs = error_probabilities_step_down(reopened, n_qubits, n_code_qubits);
+	error_probability_t* expected_code_error_probs = error_probabilities_step_down(expected, n_qubits, n_code_qubits);
+	printf("Reopened file matches: %d, step down matches: %d\n",
+		0 == memcmp(reopened, expected, error_probabilities_bytes_in_table(n_qubits)),
+		0 == memcmp(code_error_probs, expected_code_error_probs, error_probabilities_bytes_in_table(n_code_qubits)));
+	error_probabilities_mmap_free(reopened, n_qubits);
+
+	// Files are only opened as the table they hold
+	printf("Other sizes rejected: %d\n",
+		NULL == error_probabilities_mmap_open("error_probabilities_mmap_test.bin", n_qubits - 1)
+		&& NULL == error_probabilities_mmap_open("error_probabilities_mmap_test.bin", n_qubits + 1));
+
+	// A bare table without a header is rejected, even though it is large enough
+	FILE* bare = fopen("error_probabilities_mmap_test.bin", "wb");
+	fwrite(expected, 1, error_probabilities_bytes_in_table(n_qubits), bare);
+	fwrite(expected, 1, ERROR_PROBABILITIES_MMAP_HEADER_BYTES, bare);
+	fclose(bare);
+	printf("Headerless file rejected: %d\n", NULL == error_probabilities_mmap_open("error_probabilities_mmap_test.bin", n_qubits));
+
+	free(expected_code_error_probs);
+	free(code_error_probs);
+	free(expected);
+	free(expanded_error_probs);
+	circuit_free(c);
+	free(encoded_error_probs);
+	test_five_qubit_free(f);
+	remove("error_probabilities_mmap_test.bin");
+	return 0;
+}
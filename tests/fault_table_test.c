@@ -0,0 +1,211 @@
+#include "sym.h"
+
+#include "codes/codes.h"
+
+#include "gates/clifford_generators.h"
+#include "gates/pauli_generators.h"
+#include "gates/preparation.h"
+#include "gates/measurement.h"
+#include "circuits/encoding.h"
+#include "circuits/fault_table.h"
+
+#include "decoders/tailored.h"
+
+#include "error_models/iid.h"
+#include "error_models/iid_biased.h"
+
+// Probability of each logical error after decoding every string of a table, as pauli_frames_decode does for each shot
+double* exact_logical_probabilities(const error_probability_t* error_probs, const uint32_t n_qubits, const sym* code, const sym* logicals, decoder* d)
+{
+	double* logical_probs = (double*)calloc(1ull << logicals->length, sizeof(double));
+	sym* physical_error = sym_create(1, code->length);
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		if (0 == error_probs[i])
+		{
+			continue;
+		}
+		sym* full_error = ll_to_sym_n_qubits(i, 1, n_qubits);
+		for (uint32_t q = 0; q < code->length / 2; q++)
+		{
+			sym_set(physical_error, 0, q, sym_get_X(full_error, 0, q));
+			sym_set(physical_error, 0, q + code->length / 2, sym_get_Z(full_error, 0, q));
+		}
+		logical_probs[pauli_frames_logical_error(code, logicals, d, physical_error)] += error_probs[i];
+		sym_free(full_error);
+	}
+	sym_free(physical_error);
+	return logical_probs;
+}
+
+// Checks a sampled frequency against a probability, allowing five standard deviations
+uint8_t within_sampling_error(const uint64_t count, const uint64_t n_shots, const double p)
+{
+	double sigma = sqrt(p * (1 - p) / n_shots);
+	return fabs((double)count / n_shots - p) <= 5 * sigma + 1e-12;
+}
+
+// Sum of the probability of a fault at every location, the leading order terms are good to about its square
+double total_fault_probability(const fault_table* ft)
+{
+	double total = 0;
+	for (uint32_t loc = 0; loc < ft->n_locations; loc++)
+	{
+		total += ft->location_prob[loc];
+	}
+	return total;
+}
+
+int main()
+{
+	sym* code = code_five_qubit();
+	sym* logicals = code_five_qubit_logicals();
+	uint32_t n_qubits = 6; // The five qubit code and a single ancilla
+
+	// Weak noise so leading order terms are close to the full table
+	error_model* gate_noise = error_model_create_iid_biased_Z(1, 1e-7, 10);
+	error_model* cnot_noise = error_model_create_iid(2, 1e-7);
+	error_model* environmental_noise = error_model_create_iid(1, 1e-8);
+
+	gate* cnot = gate_create(2, gate_cnot, cnot_noise, NULL);
+	gate* hadamard = gate_create(1, gate_hadamard, gate_noise, NULL);
+	gate* phase = gate_create(1, gate_phase, gate_noise, NULL);
+	gate* pauli_Y = gate_create(1, gate_pauli_Y, gate_noise, NULL);
+	gate* prepare_X = gate_create_prepare_X(1, 1, NULL);
+	gate* iid_error_gate = gate_create_iid_noise(environmental_noise);
+	gate* measure_Z = gate_create_noiseless(1, gate_measure_Z);
+
+	// Encode, then measure the first stabiliser onto the ancilla
+	circuit* c = circuit_create(n_qubits);
+	circuit* encode = encoding_circuit(code, logicals, cnot, hadamard, phase);
+	for (circuit_element* ce = encode->start; NULL != ce; ce = ce->next)
+	{
+		circuit_add_non_varg(c, ce->gate_operation, ce->target_qubits);
+	}
+	circuit_add_gate(c, pauli_Y, 2);
+	circuit_add_gate(c, prepare_X, 5);
+	circuit_add_gate(c, hadamard, 5);
+	for (uint32_t q = 0; q < 5; q++)
+	{
+		if (sym_get_X(code, 0, q))
+		{
+			circuit_add_gate(c, cnot, 5, q);
+		}
+		if (sym_get_Z(code, 0, q))
+		{
+			circuit_add_gate(c, hadamard, q);
+			circuit_add_gate(c, cnot, q, 5);
+			circuit_add_gate(c, hadamard, q);
+		}
+	}
+	circuit_add_gate(c, hadamard, 5);
+
+	fault_table* ft = fault_table_create(c, iid_error_gate);
+	printf("Locations: %u, faults: %lu\n", ft->n_locations, ft->n_faults);
+
+	error_probability_t* initial_error_probs = error_probabilities_identity(n_qubits);
+	error_probability_t* error_probs = circuit_run_default(c, initial_error_probs, iid_error_gate);
+
+	// Single faults against the full table, each entry should agree to second order
+	// Single precision tables round the entries near one by far more than this, see float_tables_test.c
+	double total = total_fault_probability(ft);
+	double tolerance = 2 * total * total + ((sizeof(error_probability_t) == sizeof(float)) ? 1e-5 : 0);
+	double* first_order = (double*)calloc(error_probabilities_entries_in_table(n_qubits), sizeof(double));
+	first_order[ft->offset] = 1 - total;
+	for (uint64_t f = 0; f < ft->n_faults; f++)
+	{
+		first_order[ft->offset ^ ft->faults[f].index] += ft->faults[f].prob;
+	}
+	double max_diff = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		max_diff = fmax(max_diff, fabs(first_order[i] - error_probs[i]));
+	}
+	printf("Single faults agree with the table: %d\n", max_diff < tolerance);
+
+	// The ancilla flags the faults that anticommute with the stabiliser
+	unsigned ancilla = 5;
+	uint64_t* outcomes = fault_table_outcomes(ft, measure_Z, &ancilla);
+	double flagged = 0;
+	for (uint64_t f = 0; f < ft->n_faults; f++)
+	{
+		flagged += outcomes[f] * ft->faults[f].prob;
+	}
+	double flagged_table = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		flagged_table += (0 != (i & gate_emit_X_bit(n_qubits, ancilla))) * error_probs[i];
+	}
+	printf("Flagged probability agrees with the table: %d\n", fabs(flagged - flagged_table) < tolerance);
+
+	// Leading order logical error rates
+	decoder* d = decoder_create_tailored(code, logicals, gate_noise);
+	double* leading_order = fault_table_leading_order(ft, code, logicals, d);
+	double* logical_probs = exact_logical_probabilities(error_probs, n_qubits, code, logicals, d);
+	double max_logical_diff = 0;
+	for (uint64_t i = 0; i < (1ull << logicals->length); i++)
+	{
+		max_logical_diff = fmax(max_logical_diff, fabs(leading_order[i] - logical_probs[i]));
+	}
+	printf("Leading order logical error rates agree with the table: %d\n", max_logical_diff < tolerance);
+
+	// Sampled frames against the table at a higher error rate
+	error_model* strong_noise = error_model_create_iid(2, 0.01);
+	gate* noisy_cnot = gate_create(2, gate_cnot, strong_noise, NULL);
+	circuit* noisy = encoding_circuit(code, logicals, noisy_cnot, hadamard, phase);
+	error_probability_t* noisy_initial_probs = error_probabilities_identity(5);
+	error_probability_t* noisy_probs = circuit_run_default(noisy, noisy_initial_probs, iid_error_gate);
+
+	fault_table* noisy_ft = fault_table_create(noisy, iid_error_gate);
+	pauli_frames* frames = fault_table_sample(noisy_ft, 200000, 3);
+	uint64_t identity_count = 0;
+	for (uint64_t shot = 0; shot < frames->n_shots; shot++)
+	{
+		identity_count += (0 == pauli_frames_index(frames, shot));
+	}
+	printf("No error frequency matches the table: %d\n", within_sampling_error(identity_count, frames->n_shots, noisy_probs[0]));
+
+	uint64_t* logical_counts = pauli_frames_decode(frames, code, logicals, d);
+	double* noisy_logical_probs = exact_logical_probabilities(noisy_probs, 5, code, logicals, d);
+	uint8_t all_within = 1;
+	for (uint64_t i = 0; i < (1ull << logicals->length); i++)
+	{
+		all_within &= within_sampling_error(logical_counts[i], frames->n_shots, noisy_logical_probs[i]);
+	}
+	printf("Logical failure counts match the table: %d\n", all_within);
+
+	free(noisy_logical_probs);
+	free(logical_counts);
+	pauli_frames_free(frames);
+	fault_table_free(noisy_ft);
+	free(noisy_probs);
+	free(noisy_initial_probs);
+	circuit_free(noisy);
+	free(noisy_cnot);
+	error_model_free(strong_noise);
+
+	free(logical_probs);
+	free(leading_order);
+	decoder_free(d);
+	free(outcomes);
+	free(first_order);
+	free(error_probs);
+	free(initial_error_probs);
+	fault_table_free(ft);
+	circuit_free(encode);
+	circuit_free(c);
+	free(cnot);
+	free(hadamard);
+	free(phase);
+	free(pauli_Y);
+	free(prepare_X->operation_data);
+	free(prepare_X);
+	free(iid_error_gate);
+	free(measure_Z);
+	error_model_free(gate_noise);
+	error_model_free(cnot_noise);
+	error_model_free(environmental_noise);
+	sym_free(code);
+	sym_free(logicals);
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "test_utils.h"
+
+#include "circuits/circuit_sparse.h"
+
+#include "characterise.h"
+
+/*
+ *	Tables follow the precision selected at compile time, build with -DERROR_PROBABILITIES_FLOAT for single precision
+ *	The sparse engine always holds doubles, so it serves as the reference for either build
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+
+	error_probability_t* error_probs = test_five_qubit_encoded(f);
+
+	error_probabilities_sparse* initial_sparse = error_probabilities_sparse_identity(n_qubits, 0);
+	error_probabilities_sparse* reference_sparse = circuit_run_sparse(f->encode, initial_sparse, f->iid_error_gate);
+
+	// Each gate rounds every entry once, so the relative error grows with the depth of the circuit
+	double tolerance = (sizeof(error_probability_t) == sizeof(float)) ? 1e-5 : 1e-13;
+	double max_relative_diff = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		double reference = error_probabilities_sparse_get(reference_sparse, i);
+		if (reference > 0)
+		{
+			max_relative_diff = fmax(max_relative_diff, fabs(error_probs[i] - reference) / reference);
+		}
+	}
+	printf("Table entries within tolerance: %d\n", max_relative_diff < tolerance);
+	printf("Total probability: %f\n", characterise_test(error_probs, n_qubits));
+
+	// The logical error rates are summed in double precision from either table
+	error_probability_t* reference_probs = error_probabilities_sparse_to_dense(reference_sparse);
+	double* logical_probs = characterise_code_corrected(f->code, f->logicals, error_probs);
+	double* reference_logical_probs = characterise_code_corrected(f->code, f->logicals, reference_probs);
+	double max_logical_diff = 0;
+	for (uint64_t i = 0; i < (1ull << f->logicals->length); i++)
+	{
+		max_logical_diff = fmax(max_logical_diff, fabs(logical_probs[i] - reference_logical_probs[i]));
+	}
+	printf("No logical error: %f\n", logical_probs[0]);
+	printf("Logical error rates within tolerance: %d\n", max_logical_diff < tolerance);
+
+	// Tracing out qubits sums many entries into each one
+	error_probability_t* traced_probs = error_probabilities_step_down(error_probs, n_qubits, 2);
+	printf("Traced total probability: %f\n", characterise_test(traced_probs, 2));
+
+	free(traced_probs);
+	free(logical_probs);
+	free(reference_logical_probs);
+	free(reference_probs);
+	error_probabilities_sparse_free(initial_sparse);
+	error_probabilities_sparse_free(reference_sparse);
+	free(error_probs);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include "test_utils.h"
+
+#include "gates/pauli_generators.h"
+#include "gates/preparation.h"
+#include "circuits/frame_simulator.h"
+
+#include "decoders/tailored.h"
+
+// A gate without an emit form, it applies either an X or a Z with equal probability
+gate_result* gate_custom(const sym* initial_state, const void* gate_data, const unsigned* target_qubits)
+{
+	gate_result* gr = gate_result_create(2);
+	gr->state_results[0] = sym_copy(initial_state);
+	sym_set_Z(gr->state_results[0], 0, target_qubits[0], sym_get_Z(initial_state, 0, target_qubits[0]) ^ 1);
+	gr->prob_results[0] = 0.5;
+	gr->state_results[1] = sym_copy(initial_state);
+	sym_set_X(gr->state_results[1], 0, target_qubits[0], sym_get_X(initial_state, 0, target_qubits[0]) ^ 1);
+	gr->prob_results[1] = 0.5;
+	return gr;
+}
+
+// Probability of each logical error after decoding every string of a table, as pauli_frames_decode does for each shot
+double* exact_logical_probabilities(const error_probability_t* error_probs, const uint32_t n_qubits, const sym* code, const sym* logicals, decoder* d)
+{
+	double* logical_probs = (double*)calloc(1ull << logicals->length, sizeof(double));
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		if (0 == error_probs[i])
+		{
+			continue;
+		}
+		sym* physical_error = ll_to_sym_n_qubits(i, 1, n_qubits);
+		sym* syndrome = sym_syndrome(code, physical_error);
+		sym* recovery = decoder_call(d, syndrome);
+		sym* corrected = sym_add(recovery, physical_error);
+		sym* logical_state = logical_error(logicals, corrected);
+		logical_probs[sym_to_ll(logical_state)] += error_probs[i];
+		sym_free(logical_state);
+		sym_free(corrected);
+		sym_free(recovery);
+		sym_free(syndrome);
+		sym_free(physical_error);
+	}
+	return logical_probs;
+}
+
+// Checks a sampled frequency against a probability, allowing five standard deviations
+uint8_t within_sampling_error(const uint64_t count, const uint64_t n_shots, const double p)
+{
+	double sigma = sqrt(p * (1 - p) / n_shots);
+	return fabs((double)count / n_shots - p) <= 5 * sigma + 1e-12;
+}
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+
+	// Noiseless gates move every frame in the same way as the table
+	gate* noiseless_cnot = gate_create_noiseless(2, gate_cnot);
+	gate* noiseless_hadamard = gate_create_noiseless(1, gate_hadamard);
+	gate* noiseless_phase = gate_create_noiseless(1, gate_phase);
+	gate* pauli_Y = gate_create_noiseless(1, gate_pauli_Y);
+	gate* prepare_X = gate_create_prepare_X(1, 1, NULL);
+
+	circuit* deterministic = encoding_circuit(f->code, f->logicals, noiseless_cnot, noiseless_hadamard, noiseless_phase);
+	circuit_add_gate(deterministic, pauli_Y, 2);
+	circuit_add_gate(deterministic, noiseless_cnot, 2, 0);
+	circuit_add_gate(deterministic, prepare_X, 4);
+	circuit_add_gate(deterministic, noiseless_hadamard, 4);
+	circuit_add_gate(deterministic, noiseless_cnot, 4, 1);
+
+	error_probability_t* initial_error_probs = error_probabilities_identity(n_qubits);
+	error_probability_t* deterministic_probs = circuit_run_noiseless(deterministic, initial_error_probs);
+	uint64_t expected_index = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		if (deterministic_probs[i] > 0.5)
+		{
+			expected_index = i;
+		}
+	}
+
+	pauli_frames* deterministic_frames = circuit_run_frames(deterministic, NULL, 1000, 1);
+	uint64_t mismatches = 0;
+	for (uint64_t shot = 0; shot < deterministic_frames->n_shots; shot++)
+	{
+		mismatches += (pauli_frames_index(deterministic_frames, shot) != expected_index);
+	}
+	printf("Shots: %lu, noiseless mismatches against the table: %lu\n", deterministic_frames->n_shots, mismatches);
+
+	// Noisy frames are drawn from the distribution held by the table
+	error_probability_t* error_probs = test_five_qubit_encoded(f);
+
+	uint64_t n_shots = 200000;
+	pauli_frames* frames = circuit_run_frames(f->encode, f->iid_error_gate, n_shots, 7);
+	uint64_t identity_count = 0;
+	for (uint64_t shot = 0; shot < frames->n_shots; shot++)
+	{
+		identity_count += (0 == pauli_frames_index(frames, shot));
+	}
+	printf("No error frequency matches the table: %d\n", within_sampling_error(identity_count, frames->n_shots, error_probs[0]));
+
+	// Logical failure counts against the exact logical error rates
+	decoder* d = decoder_create_tailored(f->code, f->logicals, f->gate_noise);
+	uint64_t* logical_counts = pauli_frames_decode(frames, f->code, f->logicals, d);
+	double* logical_probs = exact_logical_probabilities(error_probs, n_qubits, f->code, f->logicals, d);
+	uint8_t all_within = 1;
+	uint64_t total_counts = 0;
+	for (uint64_t i = 0; i < (1ull << f->logicals->length); i++)
+	{
+		all_within &= within_sampling_error(logical_counts[i], frames->n_shots, logical_probs[i]);
+		total_counts += logical_counts[i];
+	}
+	printf("Logical failure counts match the table: %d, counted shots: %lu\n", all_within, total_counts);
+
+	// Gates with more than one outcome have no frame form
+	gate* custom = gate_create_noiseless(1, gate_custom);
+	circuit* unsupported = circuit_create(1);
+	circuit_add_gate(unsupported, custom, 0);
+	pauli_frames* unsupported_frames = circuit_run_frames(unsupported, NULL, 64, 1);
+	printf("Gate with two outcomes rejected: %d\n", NULL == unsupported_frames);
+
+	circuit_free(unsupported);
+	free(custom);
+	free(logical_probs);
+	free(logical_counts);
+	decoder_free(d);
+	pauli_frames_free(frames);
+	pauli_frames_free(deterministic_frames);
+	free(error_probs);
+	free(deterministic_probs);
+	free(initial_error_probs);
+	circuit_free(deterministic);
+	free(noiseless_cnot);
+	free(noiseless_hadamard);
+	free(noiseless_phase);
+	free(pauli_Y);
+	free(prepare_X->operation_data);
+	free(prepare_X);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include "sym.h"
+
+#include "gates/gates.h"
+#include "gates/clifford_generators.h"
+#include "gates/pauli_generators.h"
+#include "gates/measurement.h"
+#include "gates/preparation.h"
+
+// A gate without an emit form, it applies either an X or a Z with equal probability
+gate_result* gate_custom(const sym* initial_state, const void* gate_data, const unsigned* target_qubits)
+{
+	gate_result* gr = gate_result_create(2);
+	gr->state_results[0] = sym_copy(initial_state);
+	sym_set_Z(gr->state_results[0], 0, target_qubits[0], sym_get_Z(initial_state, 0, target_qubits[0]) ^ 1);
+	gr->prob_results[0] = 0.5;
+	gr->state_results[1] = sym_copy(initial_state);
+	sym_set_X(gr->state_results[1], 0, target_qubits[0], sym_get_X(initial_state, 0, target_qubits[0]) ^ 1);
+	gr->prob_results[1] = 0.5;
+	return gr;
+}
+
+// Emit callback that adds each outcome to a table
+void emit_into_table(const uint64_t index, const double prob, void* ctx)
+{
+	((double*)ctx)[index] += prob;
+	return;
+}
+
+// Counts the strings on which the emit form and the adapter disagree
+uint32_t compare_emit(const char* name, const gate* g, const unsigned n_qubits, const unsigned* target_qubits)
+{
+	uint32_t mismatches = 0;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+	for (uint64_t index = 0; index < n_entries; index++)
+	{
+		uint64_t emitted = 0, adapted = 0;
+		gate_emit(g, index, n_qubits, target_qubits, gate_emit_single, &emitted);
+		gate_emit_adapter(g, index, n_qubits, target_qubits, gate_emit_single, &adapted);
+		mismatches += (emitted != adapted);
+	}
+	printf("%s: has emit form %d, mismatches %u\n", name, NULL != g->emit_operation, mismatches);
+	return mismatches;
+}
+
+int main()
+{
+	uint32_t n_qubits = 4;
+	unsigned target_qubits[3] = {2, 0, 3};
+
+	gate* cnot = gate_create_noiseless(2, gate_cnot);
+	gate* hadamard = gate_create_noiseless(1, gate_hadamard);
+	gate* phase = gate_create_noiseless(1, gate_phase);
+	gate* identity = gate_create_noiseless(1, gate_identity);
+	gate* pauli_X = gate_create_noiseless(1, gate_pauli_X);
+	gate* pauli_Y = gate_create_noiseless(1, gate_pauli_Y);
+	gate* pauli_Z = gate_create_noiseless(1, gate_pauli_Z);
+	gate* measure_X = gate_create_noiseless(3, gate_measure_X);
+	gate* measure_Y = gate_create_noiseless(3, gate_measure_Y);
+	gate* measure_Z = gate_create_noiseless(3, gate_measure_Z);
+	gate* prepare_X = gate_create_prepare_X(2, 1, NULL);
+	gate* prepare_Y = gate_create_prepare_Y(2, 1, NULL);
+	gate* prepare_Z = gate_create_prepare_Z(2, 0, NULL);
+
+	gate* fused = gate_create_fused_clifford(3);
+	unsigned local_targets[2] = {2, 0};
+	gate_fused_clifford_append(fused, hadamard, local_targets);
+	gate_fused_clifford_append(fused, cnot, local_targets);
+	gate_fused_clifford_append(fused, phase, local_targets + 1);
+
+	uint32_t mismatches = 0;
+	mismatches += compare_emit("cnot", cnot, n_qubits, target_qubits);
+	mismatches += compare_emit("hadamard", hadamard, n_qubits, target_qubits);
+	mismatches += compare_emit("phase", phase, n_qubits, target_qubits);
+	mismatches += compare_emit("identity", identity, n_qubits, target_qubits);
+	mismatches += compare_emit("pauli X", pauli_X, n_qubits, target_qubits);
+	mismatches += compare_emit("pauli Y", pauli_Y, n_qubits, target_qubits);
+	mismatches += compare_emit("pauli Z", pauli_Z, n_qubits, target_qubits);
+	mismatches += compare_emit("measure X", measure_X, n_qubits, target_qubits);
+	mismatches += compare_emit("measure Y", measure_Y, n_qubits, target_qubits);
+	mismatches += compare_emit("measure Z", measure_Z, n_qubits, target_qubits);
+	mismatches += compare_emit("prepare X", prepare_X, n_qubits, target_qubits);
+	mismatches += compare_emit("prepare Y", prepare_Y, n_qubits, target_qubits);
+	mismatches += compare_emit("prepare Z", prepare_Z, n_qubits, target_qubits);
+	mismatches += compare_emit("fused clifford", fused, n_qubits, target_qubits);
+	printf("Total mismatches: %u\n", mismatches);
+
+	// Custom gates have no emit form and are called through the adapter, including from gate_operator
+	gate* custom = gate_create_noiseless(1, gate_custom);
+	double* probs = error_probabilities_zeros(n_qubits);
+	probs[0] = 1;
+	double* custom_probs = gate_operator(n_qubits, probs, custom, target_qubits);
+
+	double* emitted_probs = error_probabilities_zeros(n_qubits);
+	gate_emit(custom, 0, n_qubits, target_qubits, emit_into_table, emitted_probs);
+
+	uint32_t custom_mismatches = 0;
+	double total_probability = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		custom_mismatches += (custom_probs[i] != emitted_probs[i]);
+		total_probability += custom_probs[i];
+	}
+	printf("Custom gate: has emit form %d, mismatches %u, total probability %f\n", NULL != custom->emit_operation, custom_mismatches, total_probability);
+
+	free(probs);
+	free(custom_probs);
+	free(emitted_probs);
+
+	free(cnot);
+	free(hadamard);
+	free(phase);
+	free(identity);
+	free(pauli_X);
+	free(pauli_Y);
+	free(pauli_Z);
+	free(measure_X);
+	free(measure_Y);
+	free(measure_Z);
+	free(prepare_X->operation_data);
+	free(prepare_X);
+	free(prepare_Y->operation_data);
+	free(prepare_Y);
+	free(prepare_Z->operation_data);
+	free(prepare_Z);
+	free(custom);
+	gate_fused_clifford_free(fused);
+	return 0;
+}
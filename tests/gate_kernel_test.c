@@ -0,0 +1,61 @@
+#include "gates/gates.h"
+#include "gates/clifford_generators.h"
+#include "gates/pauli_generators.h"
+
+// Wrapping the gates hides them from gate_kernel_lookup, so gate_operator falls back to calling them per string
+gate_result* wrapped_cnot(const sym* s, const void* g, const unsigned* t) { return gate_cnot(s, g, t); }
+gate_result* wrapped_hadamard(const sym* s, const void* g, const unsigned* t) { return gate_hadamard(s, g, t); }
+gate_result* wrapped_phase(const sym* s, const void* g, const unsigned* t) { return gate_phase(s, g, t); }
+gate_result* wrapped_pauli_Y(const sym* s, const void* g, const unsigned* t) { return gate_pauli_Y(s, g, t); }
+
+int main()
+{
+	uint32_t n_qubits = 4;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+
+	double* probs = error_probabilities_zeros(n_qubits);
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		probs[i] = (double)rand() / RAND_MAX;
+	}
+
+	const char* names[4] = {"cnot", "hadamard", "phase", "pauli Y"};
+	gate_operation_f kernel_ops[4] = {gate_cnot, gate_hadamard, gate_phase, gate_pauli_Y};
+	gate_operation_f wrapped_ops[4] = {wrapped_cnot, wrapped_hadamard, wrapped_phase, wrapped_pauli_Y};
+	uint32_t n_gate_qubits[4] = {2, 1, 1, 1};
+
+	for (uint32_t g = 0; g < 4; g++)
+	{
+		double max_diff = 0;
+		for (uint32_t a = 0; a < n_qubits; a++)
+		{
+			for (uint32_t b = 0; b < n_qubits; b++)
+			{
+				if (a == b || (n_gate_qubits[g] == 1 && b > 0))
+				{
+					continue;
+				}
+				uint32_t target_qubits[2] = {a, b};
+
+				gate* kernel_gate = gate_create_noiseless(n_gate_qubits[g], kernel_ops[g]);
+				gate* wrapped_gate = gate_create_noiseless(n_gate_qubits[g], wrapped_ops[g]);
+
+				double* kernel_probs = gate_operator(n_qubits, probs, kernel_gate, target_qubits);
+				double* wrapped_probs = gate_operator(n_qubits, probs, wrapped_gate, target_qubits);
+				for (uint64_t i = 0; i < n_entries; i++)
+				{
+					max_diff = fmax(max_diff, fabs(kernel_probs[i] - wrapped_probs[i]));
+				}
+
+				free(kernel_probs);
+				free(wrapped_probs);
+				free(kernel_gate);
+				free(wrapped_gate);
+			}
+		}
+		printf("%s: max difference between kernel and per string operation %e\n", names[g], max_diff);
+	}
+
+	free(probs);
+	return 0;
+}
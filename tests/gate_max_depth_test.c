@@ -1,11 +1,10 @@
-#define GATE_MAX_DEPTH 4
-#define GATE_MULTITHREADING
-#define N_THREADS 4
-
-#include "../gates/clifford_generators.h"
-#include "../error_models/iid.h"
-#include "../characterise.h"
-#include "../circuits/error_probabilities.h"
+#include "sym.h"
+#include "codes/codes.h"
+#include "gates/clifford_generators.h"
+#include "error_models/iid.h"
+#include "decoders/tailored.h"
+#include "circuits/circuit.h"
+#include "characterise.h"
 
 int main()
 {
@@ -15,14 +14,11 @@ int main()
 
 	// Setup our error models
 	error_model* em_cnot = error_model_create_iid(2, p_gate_error);
-	error_model* em_gate = error_model_create_iid(1, p_gate_error);
 	error_model* em_noise = error_model_create_iid(n_qubits, p_wire_error);
 
 	// Setup our gates
 	gate* cnot = gate_create(2, gate_cnot, em_cnot, NULL);
-	gate* hadamard = gate_create(2, gate_hadamard, em_gate, NULL);
-	gate* phase = gate_create(2, gate_phase, em_gate, NULL);
-	gate* noise = gate_create(n_qubits, gate_iid, em_noise, NULL);
+	gate* noise = gate_create(n_qubits, NULL, em_noise, NULL);
 
 	uint32_t* target_qubits = (uint32_t*)malloc(sizeof(uint32_t) * n_qubits);
 	for (uint32_t i = 0; i < n_qubits; i++)
@@ -30,28 +26,103 @@ int main()
 		target_qubits[i] = i;
 	}
 
-	// Setup the probability distribution
+	circuit* c = circuit_create(n_qubits);
+	circuit_add_non_varg(c, noise, target_qubits);
+	for (uint32_t i = 0; i + 1 < n_qubits; i++)
+	{
+		circuit_add_gate(c, cnot, i, i + 1);
+	}
+	circuit_add_non_varg(c, noise, target_qubits);
+
 	double* initial_error_probabilities = error_probabilities_identity(n_qubits);
-	double* round_one_error_probabilities = gate_apply(n_qubits, initial_error_probabilities, noise, target_qubits);
-	double* final_error_probabilities = gate_apply(n_qubits, round_one_error_probabilities, noise, target_qubits);
+	double* full_error_probabilities = circuit_run_noiseless(c, initial_error_probabilities);
+
+	// Each limit in turn, the probability left in the table and the probability dropped should sum to one
+	// Dropping a string only removes probability, so no string of a truncated table is more likely than in the full table
+	truncation_policy* policies[3];
+	policies[0] = truncation_policy_create(4, TRUNCATION_NO_MIN_PROBABILITY, TRUNCATION_NO_MAX_SUPPORT);
+	policies[1] = truncation_policy_create(TRUNCATION_NO_MAX_WEIGHT, 1e-12, TRUNCATION_NO_MAX_SUPPORT);
+	policies[2] = truncation_policy_create(TRUNCATION_NO_MAX_WEIGHT, TRUNCATION_NO_MIN_PROBABILITY, 100);
+
+	double* gate_discarded = (double*)malloc(sizeof(double) * c->n_gates);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		double* truncated_error_probabilities = circuit_run_truncated(c, initial_error_probabilities, NULL, policies[i], gate_discarded);
+
+		double total = characterise_test(truncated_error_probabilities, n_qubits);
+		double max_excess = 0, gate_total = 0;
+		uint64_t n_support = 0;
+		for (uint64_t j = 0; j < error_probabilities_entries_in_table(n_qubits); j++)
+		{
+			if (0 != truncated_error_probabilities[j])
+			{
+				max_excess = fmax(max_excess, truncated_error_probabilities[j] - full_error_probabilities[j]);
+				n_support++;
+			}
+		}
+		for (uint32_t j = 0; j < c->n_gates; j++)
+		{
+			gate_total += gate_discarded[j];
+		}
+
+		printf("Policy %u: support %lu, discarded %.6e, bounded by the full table %d, per gate sum agrees %d, normalised with discarded %d\n",
+			i, n_support, policies[i]->discarded, max_excess < 1e-15, fabs(gate_total - policies[i]->discarded) < 1e-18, fabs(total + policies[i]->discarded - 1) < 1e-12);
+		error_probabilities_free(truncated_error_probabilities);
+	}
+
+	// Characterisation drops the same physical errors
+	sym* code = code_steane();
+	sym* logicals = code_steane_logicals();
+	error_model* code_noise = error_model_create_iid(7, 0.01);
+	decoder* d = decoder_create_tailored(code, logicals, code_noise);
+
+	double* logical_probabilities = characterise_code(code, logicals, code_noise, d);
+	truncation_policy* weight_policy = truncation_policy_create(2, TRUNCATION_NO_MIN_PROBABILITY, TRUNCATION_NO_MAX_SUPPORT);
+	double* truncated_logical_probabilities = characterise_code_truncated(code, logicals, code_noise, d, weight_policy);
+
+	double logical_total = 0;
+	for (uint64_t j = 0; j < (1ull << logicals->length); j++)
+	{
+		logical_total += truncated_logical_probabilities[j];
+	}
+	printf("Characterisation: no logical error %f of %f, discarded %.6e, normalised with discarded %d\n",
+		truncated_logical_probabilities[0], logical_probabilities[0], weight_policy->discarded, fabs(logical_total + weight_policy->discarded - 1) < 1e-12);
+
+	// Without a policy nothing is dropped
+	double* untruncated_logical_probabilities = characterise_code_truncated(code, logicals, code_noise, d, NULL);
+	double max_logical_diff = 0;
+	for (uint64_t j = 0; j < (1ull << logicals->length); j++)
+	{
+		max_logical_diff = fmax(max_logical_diff, fabs(untruncated_logical_probabilities[j] - logical_probabilities[j]));
+	}
+	printf("Characterisation without a policy matches characterise_code: %d\n", max_logical_diff < 1e-15);
 
-	//characterise_print(final_error_probabilities, n_qubits);
-	printf("Error: %.20e\n", 1 - characterise_test(final_error_probabilities, n_qubits));
 	// Cleanup
+	free(logical_probabilities);
+	free(truncated_logical_probabilities);
+	free(untruncated_logical_probabilities);
+	truncation_policy_free(weight_policy);
+	decoder_free(d);
+	error_model_free(code_noise);
+	sym_free(code);
+	sym_free(logicals);
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		truncation_policy_free(policies[i]);
+	}
+	free(gate_discarded);
 	free(target_qubits);
+	circuit_free(c);
 
-	error_probabilities_free(final_error_probabilities);
-	error_probabilities_free(round_one_error_probabilities);
+	error_probabilities_free(full_error_probabilities);
 	error_probabilities_free(initial_error_probabilities);
 
-	gate_free(noise);
-	gate_free(phase);
-	gate_free(hadamard);
-	gate_free(cnot);
+	free(noise);
+	free(cnot);
 
 	error_model_free(em_noise);
-	error_model_free(em_gate);
 	error_model_free(em_cnot);
-	
+
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,62 @@
+#include "gates/gates.h"
+#include "error_models/iid_biased.h"
+
+// The per string path that gate_noise used before the noise kernel
+double* gate_noise_per_string(const unsigned n_qubits, double* initial_probabilities, const gate* g, const unsigned* target_qubits)
+{
+	double* final_probabilities = error_probabilities_zeros(n_qubits);
+	sym_iter* initial_state = sym_iter_create_n_qubits(n_qubits);
+	while (sym_iter_next(initial_state))
+	{
+		double initial_prob = initial_probabilities[sym_iter_ll_from_state(initial_state)];
+		if (initial_prob > 0)
+		{
+			gate_result* operation_output = gate_apply_noise(initial_state->state, g, target_qubits);
+			for (unsigned i = 0; i < operation_output->n_results; i++)
+			{
+				final_probabilities[sym_to_ll(operation_output->state_results[i])] += operation_output->prob_results[i] * initial_prob;
+			}
+			gate_result_free(operation_output);
+		}
+	}
+	sym_iter_free(initial_state);
+	return final_probabilities;
+}
+
+int main()
+{
+	uint32_t n_qubits = 5;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+
+	// Leave some entries empty so that the empty block check is exercised
+	double* probs = error_probabilities_zeros(n_qubits);
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		probs[i] = (i % 3) ? (double)rand() / RAND_MAX : 0;
+	}
+
+	uint32_t target_qubits[3] = {3, 0, 4};
+	for (uint32_t gate_qubits = 1; gate_qubits <= 3; gate_qubits++)
+	{
+		error_model* em = error_model_create_iid_biased_X(gate_qubits, 0.1, 0.7);
+		gate* noisy_identity = gate_create(gate_qubits, gate_identity, em, NULL);
+
+		double* kernel_probs = gate_noise(n_qubits, probs, noisy_identity, target_qubits);
+		double* per_string_probs = gate_noise_per_string(n_qubits, probs, noisy_identity, target_qubits);
+
+		double max_diff = 0;
+		for (uint64_t i = 0; i < n_entries; i++)
+		{
+			max_diff = fmax(max_diff, fabs(kernel_probs[i] - per_string_probs[i]));
+		}
+		printf("%u qubit noise: max difference between kernel and per string noise %e\n", gate_qubits, max_diff);
+
+		free(kernel_probs);
+		free(per_string_probs);
+		free(noisy_identity);
+		error_model_free(em);
+	}
+
+	free(probs);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "error_models/iid.h"
+#include "error_models/lookup.h"
+#include "gates/clifford_generators.h"
+#include "characterise.h"
+#include "circuits/error_probabilities.h"
+
+int main()
+{
+	uint32_t n_qubits = 2;
+	double p_error = 0.01;
+
+	error_model* em = error_model_create_iid(2, p_error);
+	gate* cnot = gate_create(2, gate_cnot, em, NULL);
+
+	uint32_t target_qubits[2] = {0, 1};
+
+	double* initial_probs = error_probabilities_identity(n_qubits);
+	double* noisy_probs = gate_apply(n_qubits, initial_probs, cnot, target_qubits);
+
+	// Save the table once, then map it back in for each model
+	error_model_lookup_save("lookup_mmap_test.bin", n_qubits, noisy_probs);
+	error_model* em_heap = error_model_create_lookup(n_qubits, noisy_probs);
+	error_model* em_mmap = error_model_create_lookup_mmap("lookup_mmap_test.bin", 1);
+
+	if (NULL == em_mmap)
+	{
+		printf("Failed to map table\n");
+		return 1;
+	}
+
+	sym_iter* siter = sym_iter_create_n_qubits(n_qubits);
+	double max_diff = 0;
+	while (sym_iter_next(siter))
+	{
+		double diff = fabs(error_model_call(em_heap, siter->state) - error_model_call(em_mmap, siter->state));
+		max_diff = diff > max_diff ? diff : max_diff;
+	}
+	sym_iter_free(siter);
+
+	printf("Max difference between heap and mapped tables: %e\n", max_diff);
+
+	// Headers whose table could not fit in the file are rejected, including sizes that overflow
+	uint8_t rejected = 1;
+	uint32_t bad_n_qubits[3] = {3, 31, 40};
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		error_model_lookup_header_t header;
+		header.magic = ERROR_MODEL_LOOKUP_MAGIC;
+		header.n_qubits = bad_n_qubits[i];
+		header.dtype = ERROR_MODEL_LOOKUP_DTYPE;
+		header.header_bytes = sizeof(error_model_lookup_header_t);
+		header.checksum = 0;
+
+		FILE* f = fopen("lookup_mmap_test.bin", "r+b");
+		fwrite(&header, sizeof(error_model_lookup_header_t), 1, f);
+		fclose(f);
+
+		rejected &= (NULL == error_model_create_lookup_mmap("lookup_mmap_test.bin", 0));
+	}
+	printf("Oversized headers rejected: %d\n", rejected);
+
+	error_model_free(em_heap);
+	error_model_free(em_mmap);
+	free(cnot);
+	free(initial_probs);
+	free(noisy_probs);
+	remove("lookup_mmap_test.bin");
+	return 0;
+}
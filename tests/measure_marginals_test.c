@@ -0,0 +1,62 @@
+#include "test_utils.h"
+
+#include "gates/measurement.h"
+
+/*
+ *	Splits a table by measurement outcome, against measuring each string as a sym object
+ *	The measured qubits are not contiguous and are not given in order
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+	error_probability_t* error_probs = test_five_qubit_encoded(f);
+
+	gate_operation_f measurements[3] = {gate_measure_X, gate_measure_Y, gate_measure_Z};
+	const char* names[3] = {"X", "Y", "Z"};
+	unsigned target_qubits[2] = {3, 1};
+	unsigned kept_qubits[3] = {0, 2, 4};
+	uint64_t n_kept_entries = error_probabilities_entries_in_table(3);
+
+	for (uint32_t m = 0; m < 3; m++)
+	{
+		gate* measure = gate_create_noiseless(2, measurements[m]);
+		double* marginals = gate_measure_marginals(error_probs, n_qubits, measure, target_qubits);
+
+		// Reference, each string is measured and stripped of the measured qubits
+		double* expected = (double*)calloc(4 * n_kept_entries, sizeof(double));
+		sym* kept = sym_create(1, 6);
+		for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+		{
+			sym* state = ll_to_sym_n_qubits(i, 1, n_qubits);
+			gate_result* gr = gate_operation(measure, state, target_qubits);
+			uint64_t outcome = sym_to_ll(gr->state_results[0]);
+			for (uint32_t q = 0; q < 3; q++)
+			{
+				sym_set(kept, 0, q, sym_get_X(state, 0, kept_qubits[q]));
+				sym_set(kept, 0, q + 3, sym_get_Z(state, 0, kept_qubits[q]));
+			}
+			expected[outcome * n_kept_entries + sym_to_ll(kept)] += error_probs[i];
+			gate_result_free(gr);
+			sym_free(state);
+		}
+
+		double max_diff = 0, total = 0;
+		for (uint64_t i = 0; i < 4 * n_kept_entries; i++)
+		{
+			max_diff = fmax(max_diff, fabs(marginals[i] - expected[i]));
+			total += marginals[i];
+		}
+		printf("Measure %s: marginals match %d, total probability %f\n", names[m], max_diff < 1e-12, total);
+
+		sym_free(kept);
+		free(expected);
+		free(marginals);
+		free(measure);
+	}
+
+	free(error_probs);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include "sym.h"
+
+#include "codes/codes.h"
+#include "decoders/destabiliser.h"
+
+#include "error_models/iid.h"
+#include "error_models/iid_biased.h"
+
+#include "characterise.h"
+#include "tailored.h"
+
+int main()
+{
+	sym* code = code_five_qubit();
+	sym* logicals = code_five_qubit_logicals();
+	uint32_t n_qubits = 5;
+
+	double bias = 10;
+	error_model* poly_model = error_model_create_iid_biased_Z(n_qubits, 0, bias);
+	decoder* destabilisers = decoder_create_destabiliser(code, logicals);
+
+	// One pass for every error rate
+	double* polys = characterise_code_poly(code, logicals, poly_model, destabilisers, n_qubits);
+	tailored_poly_t* tp = tailored_prob_poly(code, logicals, poly_model, n_qubits);
+
+	printf("p\t\tDirect\t\tPolynomial\tTailored\tTailored Polynomial\n");
+	for (double p = 0.001; p < 0.5; p *= 4)
+	{
+		error_model* em = error_model_create_iid_biased_Z(n_qubits, p, bias);
+		double* direct = characterise_code(code, logicals, em, destabilisers);
+		double* from_poly = characterise_poly_eval(polys, code, logicals, p);
+
+		printf("%e\t%e\t%e\t%e\t%e\n", p, direct[0], from_poly[0], tailored_prob(code, logicals, em), tailored_poly_eval(tp, p));
+
+		free(direct);
+		free(from_poly);
+		error_model_free(em);
+	}
+
+	free(polys);
+	tailored_poly_free(tp);
+	decoder_free(destabilisers);
+	error_model_free(poly_model);
+	sym_free(code);
+	sym_free(logicals);
+	return 0;
+}
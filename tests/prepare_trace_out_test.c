@@ -0,0 +1,82 @@
+#include "test_utils.h"
+
+#include "gates/preparation.h"
+
+/*
+ *	Preparations and trace outs fold entries of the table together in place
+ *	Both are checked against following each string through the table
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+	error_probability_t* error_probs = test_five_qubit_encoded(f);
+
+	// The references below sum onto table entries, so single precision tables round them
+	double tolerance = (sizeof(error_probability_t) == sizeof(float)) ? 1e-6 : 1e-12;
+
+	// Preparations, the targets are not contiguous and are not given in order
+	unsigned target_qubits[2] = {3, 1};
+	gate* preparations[3];
+	preparations[0] = gate_create_prepare_X(2, 1, NULL);
+	preparations[1] = gate_create_prepare_Y(2, 1, NULL);
+	preparations[2] = gate_create_prepare_Z(2, 0, NULL);
+	const char* names[3] = {"X", "Y", "Z"};
+
+	for (uint32_t p = 0; p < 3; p++)
+	{
+		error_probability_t* prepared = error_probabilities_copy(n_qubits, error_probs);
+		gate_kernel_prepare(prepared, n_qubits, target_qubits, preparations[p]);
+
+		error_probability_t* expected = error_probabilities_zeros(n_qubits);
+		for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+		{
+			uint64_t outcome = 0;
+			gate_emit(preparations[p], i, n_qubits, target_qubits, gate_emit_single, &outcome);
+			expected[outcome] += error_probs[i];
+		}
+
+		printf("Prepare %s: kernel matches %d\n", names[p], max_table_diff(prepared, expected, n_qubits) < tolerance);
+		free(expected);
+		free(prepared);
+	}
+
+	// Tracing out the last qubits is the same as stepping down
+	unsigned last_qubits[2] = {4, 3};
+	error_probability_t* traced = error_probabilities_trace_out(error_probabilities_copy(n_qubits, error_probs), n_qubits, last_qubits, 2);
+	error_probability_t* stepped = error_probabilities_step_down(error_probs, n_qubits, 3);
+	printf("Trace out matches step down: %d\n", max_table_diff(traced, stepped, 3) < tolerance);
+	free(stepped);
+	free(traced);
+
+	// Tracing out qubits from the middle, the rest keep their order
+	unsigned kept_qubits[3] = {0, 2, 4};
+	traced = error_probabilities_trace_out(error_probabilities_copy(n_qubits, error_probs), n_qubits, target_qubits, 2);
+	error_probability_t* expected = error_probabilities_zeros(3);
+	sym* kept = sym_create(1, 6);
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		sym* state = ll_to_sym_n_qubits(i, 1, n_qubits);
+		for (uint32_t q = 0; q < 3; q++)
+		{
+			sym_set(kept, 0, q, sym_get_X(state, 0, kept_qubits[q]));
+			sym_set(kept, 0, q + 3, sym_get_Z(state, 0, kept_qubits[q]));
+		}
+		expected[sym_to_ll(kept)] += error_probs[i];
+		sym_free(state);
+	}
+	printf("Trace out matches: %d, total probability %f\n", max_table_diff(traced, expected, 3) < tolerance, table_total(traced, 3));
+
+	sym_free(kept);
+	free(expected);
+	free(traced);
+	for (uint32_t p = 0; p < 3; p++)
+	{
+		free(preparations[p]->operation_data);
+		free(preparations[p]);
+	}
+	free(error_probs);
+	test_five_qubit_free(f);
+	return 0;
+}
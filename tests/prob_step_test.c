@@ -0,0 +1,51 @@
+#include "test_utils.h"
+
+/*
+ *	Stepping a table up places the existing qubits first, stepping down traces out the last qubits
+ *	Step up is checked against copying each string through a sym object, step down against tracing out
+ */
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+	uint32_t n_expanded = 7;
+	error_probability_t* error_probs = test_five_qubit_encoded(f);
+
+	// Step up, every string keeps its probability and the new qubits are the identity
+	error_probability_t* expanded = error_probabilities_step_up(error_probs, n_qubits, n_expanded);
+	sym* expanded_state = sym_create(1, 2 * n_expanded);
+	uint64_t mismatches = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		sym* state = ll_to_sym_n_qubits(i, 1, n_qubits);
+		for (uint32_t q = 0; q < n_qubits; q++)
+		{
+			sym_set_X(expanded_state, 0, q, sym_get_X(state, 0, q));
+			sym_set_Z(expanded_state, 0, q, sym_get_Z(state, 0, q));
+		}
+		mismatches += (expanded[sym_to_ll(expanded_state)] != error_probs[i]);
+		sym_free(state);
+	}
+	printf("Step up mismatches: %lu, total probability %f\n", mismatches, table_total(expanded, n_expanded));
+
+	// Step down from the expanded table returns the original table exactly
+	error_probability_t* contracted = error_probabilities_step_down(expanded, n_expanded, n_qubits);
+	printf("Step down recovers the table: %d\n", 0 == memcmp(contracted, error_probs, error_probabilities_bytes_in_table(n_qubits)));
+
+	// Stepping further down matches tracing out the last qubits, both round when tables are single precision
+	double tolerance = (sizeof(error_probability_t) == sizeof(float)) ? 1e-6 : 1e-12;
+	unsigned traced_qubits[3] = {2, 3, 4};
+	error_probability_t* stepped = error_probabilities_step_down(error_probs, n_qubits, 2);
+	error_probability_t* traced = error_probabilities_trace_out(error_probabilities_copy(n_qubits, error_probs), n_qubits, traced_qubits, 3);
+	printf("Step down matches trace out: %d\n", max_table_diff(stepped, traced, 2) < tolerance);
+
+	free(traced);
+	free(stepped);
+	free(contracted);
+	sym_free(expanded_state);
+	free(expanded);
+	free(error_probs);
+	test_five_qubit_free(f);
+	return 0;
+}
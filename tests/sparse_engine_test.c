@@ -0,0 +1,81 @@
+#include "test_utils.h"
+
+#include "gates/pauli_generators.h"
+#include "gates/measurement.h"
+#include "circuits/circuit_sparse.h"
+
+int main()
+{
+	test_five_qubit_t* f = test_five_qubit_create();
+	uint32_t n_qubits = 5;
+
+	gate* pauli_Y = gate_create(1, gate_pauli_Y, f->gate_noise, NULL);
+	circuit_add_gate(f->encode, pauli_Y, 2);
+	circuit_add_gate(f->encode, f->cnot, 4, 1);
+
+	// With no threshold the sparse engine matches the dense tables
+	double* default_error_probs = test_five_qubit_encoded(f);
+
+	error_probabilities_sparse* initial_sparse = error_probabilities_sparse_identity(n_qubits, 0);
+	error_probabilities_sparse* exact_sparse = circuit_run_sparse(f->encode, initial_sparse, f->iid_error_gate);
+	double* exact_error_probs = error_probabilities_sparse_to_dense(exact_sparse);
+	printf("Matches circuit_run_default: %d\n", max_table_diff(default_error_probs, exact_error_probs, n_qubits) < 1e-15);
+	printf("Entries: %lu, discarded: %e\n", exact_sparse->n_entries, exact_sparse->discarded);
+
+	// Measurements only visit the support
+	unsigned measured[2] = {1, 3};
+	gate* measure = gate_create_noiseless(2, gate_measure_Z);
+	double* outcome_probs = gate_sparse_measure(exact_sparse, measure, measured);
+	double dense_outcome_probs[4] = {0, 0, 0, 0};
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		uint64_t outcome = 0;
+		gate_emit(measure, i, n_qubits, measured, gate_emit_single, &outcome);
+		dense_outcome_probs[outcome] += default_error_probs[i];
+	}
+	double max_diff = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		max_diff = fmax(max_diff, fabs(outcome_probs[i] - dense_outcome_probs[i]));
+	}
+	printf("Measurement matches the dense table: %d\n", max_diff < 1e-15);
+
+	// A threshold drops the unlikely strings, their mass is kept in discarded
+	error_probabilities_sparse* pruned_initial = error_probabilities_sparse_identity(n_qubits, 1e-4);
+	error_probabilities_sparse* pruned_sparse = circuit_run_sparse(f->encode, pruned_initial, f->iid_error_gate);
+	printf("Pruned entries: %lu of %lu\n", pruned_sparse->n_entries, exact_sparse->n_entries);
+	printf("Pruned total probability with discarded mass: %f\n", error_probabilities_sparse_sum(pruned_sparse) + pruned_sparse->discarded);
+
+	// Circuits far beyond the reach of the dense tables
+	uint32_t n_large_qubits = 26;
+	error_model* low_cnot_noise = error_model_create_iid(2, 0.001);
+	gate* low_noise_cnot = gate_create(2, gate_cnot, low_cnot_noise, NULL);
+	gate* noiseless_hadamard = gate_create_noiseless(1, gate_hadamard);
+	circuit* chain = circuit_create(n_large_qubits);
+	for (uint32_t i = 0; i + 1 < n_large_qubits; i++)
+	{
+		circuit_add_gate(chain, noiseless_hadamard, i);
+		circuit_add_gate(chain, low_noise_cnot, i, i + 1);
+	}
+	error_probabilities_sparse* large_initial = error_probabilities_sparse_identity(n_large_qubits, 1e-9);
+	error_probabilities_sparse* large_sparse = circuit_run_sparse(chain, large_initial, NULL);
+	printf("%u qubits: entries %lu, no error %f, total probability with discarded mass %f\n", n_large_qubits, large_sparse->n_entries, error_probabilities_sparse_get(large_sparse, 0), error_probabilities_sparse_sum(large_sparse) + large_sparse->discarded);
+
+	error_probabilities_sparse_free(initial_sparse);
+	error_probabilities_sparse_free(exact_sparse);
+	error_probabilities_sparse_free(pruned_initial);
+	error_probabilities_sparse_free(pruned_sparse);
+	error_probabilities_sparse_free(large_initial);
+	error_probabilities_sparse_free(large_sparse);
+	circuit_free(chain);
+	free(default_error_probs);
+	free(exact_error_probs);
+	free(outcome_probs);
+	free(pauli_Y);
+	free(measure);
+	free(low_noise_cnot);
+	free(noiseless_hadamard);
+	error_model_free(low_cnot_noise);
+	test_five_qubit_free(f);
+	return 0;
+}
@@ -0,0 +1,172 @@
+#ifndef TEST_UTILS
+#define TEST_UTILS
+
+#include "sym.h"
+
+#include "codes/codes.h"
+
+#include "gates/clifford_generators.h"
+#include "circuits/encoding.h"
+
+#include "error_models/iid.h"
+#include "error_models/iid_biased.h"
+
+// ----------------------------------------------------------------------------------------
+// TEST UTILITIES
+// Setup shared by the table tests, the five qubit code encoded by a noisy encoding circuit gives a table
+// with no symmetry for a mistake in the qubit order or a dropped string to hide behind
+// ----------------------------------------------------------------------------------------
+
+/*
+ * test_five_qubit_t
+ * The five qubit code, its noisy gates and its encoding circuit
+ * :: sym* code :: The stabilisers of the code
+ * :: sym* logicals :: The logical operators of the code
+ * :: error_model* gate_noise :: Z biased noise on the single qubit gates
+ * :: error_model* cnot_noise :: IID noise on the cnot
+ * :: error_model* environmental_noise :: IID noise on idle qubits
+ * :: gate* cnot :: A noisy cnot
+ * :: gate* hadamard :: A noisy hadamard
+ * :: gate* phase :: A noisy phase gate
+ * :: gate* iid_error_gate :: The environmental noise
+ * :: circuit* encode :: The encoding circuit built from the noisy gates
+ */
+typedef struct {
+	sym* code;
+	sym* logicals;
+	error_model* gate_noise;
+	error_model* cnot_noise;
+	error_model* environmental_noise;
+	gate* cnot;
+	gate* hadamard;
+	gate* phase;
+	gate* iid_error_gate;
+	circuit* encode;
+} test_five_qubit_t;
+
+/*
+ * test_five_qubit_create
+ * Creates the five qubit code with its noisy gates and encoding circuit
+ * Returns a heap pointer to the fixture
+ */
+test_five_qubit_t* test_five_qubit_create();
+
+/*
+ * test_five_qubit_encoded
+ * Runs the encoding circuit with environmental noise from a table with no error
+ * :: const test_five_qubit_t* f :: The fixture
+ * Returns a heap pointer to the table over the five qubits of the code
+ */
+error_probability_t* test_five_qubit_encoded(const test_five_qubit_t* f);
+
+void test_five_qubit_free(test_five_qubit_t* f);
+
+/*
+ * max_table_diff
+ * Finds the largest difference between two tables
+ * :: const error_probability_t* a :: The first table
+ * :: const error_probability_t* b :: The second table
+ * :: const uint32_t n_qubits :: The number of qubits covered by both tables
+ * Returns the largest absolute difference between two entries
+ */
+double max_table_diff(const error_probability_t* a, const error_probability_t* b, const uint32_t n_qubits);
+
+/*
+ * table_total
+ * Sums every entry of a table
+ * :: const error_probability_t* table :: The table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns the total probability
+ */
+double table_total(const error_probability_t* table, const uint32_t n_qubits);
+
+/*
+ * test_five_qubit_create
+ * Creates the five qubit code with its noisy gates and encoding circuit
+ * Returns a heap pointer to the fixture
+ */
+test_five_qubit_t* test_five_qubit_create()
+{
+	test_five_qubit_t* f = (test_five_qubit_t*)malloc(sizeof(test_five_qubit_t));
+	f->code = code_five_qubit();
+	f->logicals = code_five_qubit_logicals();
+
+	f->gate_noise = error_model_create_iid_biased_Z(1, 0.01, 10);
+	f->cnot_noise = error_model_create_iid(2, 0.02);
+	f->environmental_noise = error_model_create_iid(1, 0.005);
+
+	f->cnot = gate_create(2, gate_cnot, f->cnot_noise, NULL);
+	f->hadamard = gate_create(1, gate_hadamard, f->gate_noise, NULL);
+	f->phase = gate_create(1, gate_phase, f->gate_noise, NULL);
+	f->iid_error_gate = gate_create_iid_noise(f->environmental_noise);
+
+	f->encode = encoding_circuit(f->code, f->logicals, f->cnot, f->hadamard, f->phase);
+	return f;
+}
+
+/*
+ * test_five_qubit_encoded
+ * Runs the encoding circuit with environmental noise from a table with no error
+ * :: const test_five_qubit_t* f :: The fixture
+ * Returns a heap pointer to the table over the five qubits of the code
+ */
+error_probability_t* test_five_qubit_encoded(const test_five_qubit_t* f)
+{
+	error_probability_t* initial_error_probs = error_probabilities_identity(f->encode->n_qubits);
+	error_probability_t* encoded_error_probs = circuit_run_default(f->encode, initial_error_probs, f->iid_error_gate);
+	free(initial_error_probs);
+	return encoded_error_probs;
+}
+
+void test_five_qubit_free(test_five_qubit_t* f)
+{
+	circuit_free(f->encode);
+	free(f->cnot);
+	free(f->hadamard);
+	free(f->phase);
+	free(f->iid_error_gate);
+	error_model_free(f->gate_noise);
+	error_model_free(f->cnot_noise);
+	error_model_free(f->environmental_noise);
+	sym_free(f->code);
+	sym_free(f->logicals);
+	free(f);
+	return;
+}
+
+/*
+ * max_table_diff
+ * Finds the largest difference between two tables
+ * :: const error_probability_t* a :: The first table
+ * :: const error_probability_t* b :: The second table
+ * :: const uint32_t n_qubits :: The number of qubits covered by both tables
+ * Returns the largest absolute difference between two entries
+ */
+double max_table_diff(const error_probability_t* a, const error_probability_t* b, const uint32_t n_qubits)
+{
+	double max_diff = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		max_diff = fmax(max_diff, fabs(a[i] - b[i]));
+	}
+	return max_diff;
+}
+
+/*
+ * table_total
+ * Sums every entry of a table
+ * :: const error_probability_t* table :: The table
+ * :: const uint32_t n_qubits :: The number of qubits covered by the table
+ * Returns the total probability
+ */
+double table_total(const error_probability_t* table, const uint32_t n_qubits)
+{
+	double total = 0;
+	for (uint64_t i = 0; i < error_probabilities_entries_in_table(n_qubits); i++)
+	{
+		total += table[i];
+	}
+	return total;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "sym.h"
+#include "codes/codes.h"
+#include "gates/gates.h"
+#include "decoders/tailored.h"
+#include "error_models/iid.h"
+#include "error_models/iid_biased.h"
+#include "error_models/cached.h"
+#include "characterise.h"
+
+double max_difference(const double* a, const double* b, const uint64_t n_entries)
+{
+	double max_diff = 0;
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		max_diff = fmax(max_diff, fabs(a[i] - b[i]));
+	}
+	return max_diff;
+}
+
+// Thread entry, fetches the shared pool
+void* default_pool_fetch(void* v_pool)
+{
+	*(thread_pool**)v_pool = thread_pool_default();
+	return NULL;
+}
+
+int main()
+{
+	uint32_t n_qubits = 6;
+	uint64_t n_entries = error_probabilities_entries_in_table(n_qubits);
+
+	double* probs = error_probabilities_zeros(n_qubits);
+	for (uint64_t i = 0; i < n_entries; i++)
+	{
+		probs[i] = (i % 3) ? (double)rand() / RAND_MAX : 0;
+	}
+
+	// Two qubit gates use the noise kernel, four qubit gates apply their noise one string at a time
+	uint32_t target_qubits[4] = {5, 1, 3, 0};
+	for (uint32_t gate_qubits = 2; gate_qubits <= 4; gate_qubits += 2)
+	{
+		error_model* em = error_model_create_iid_biased_X(gate_qubits, 0.1, 0.7);
+		gate* noisy_identity = gate_create(gate_qubits, gate_identity, em, NULL);
+
+		thread_pool_set_default_n_threads(1);
+		double* serial_probs = gate_noise(n_qubits, probs, noisy_identity, target_qubits);
+		thread_pool_set_default_n_threads(4);
+		double* pool_probs = gate_noise(n_qubits, probs, noisy_identity, target_qubits);
+
+		printf("%u qubit noise: max difference between 1 and 4 threads %e\n", gate_qubits, max_difference(serial_probs, pool_probs, n_entries));
+
+		free(serial_probs);
+		free(pool_probs);
+		free(noisy_identity);
+		error_model_free(em);
+	}
+	free(probs);
+
+	// Decoder construction and characterisation
+	sym* code = code_steane();
+	sym* logicals = code_steane_logicals();
+	error_model* noise_model = error_model_create_iid(7, 0.01);
+
+	thread_pool_set_default_n_threads(1);
+	decoder* serial_decoder = decoder_create_tailored(code, logicals, noise_model);
+	double* serial_logical = characterise_code(code, logicals, noise_model, serial_decoder);
+
+	thread_pool_set_default_n_threads(4);
+	double* pool_logical = characterise_code(code, logicals, noise_model, serial_decoder);
+	printf("Characterisation: max difference between 1 and 4 threads %e\n", max_difference(serial_logical, pool_logical, 1ull << logicals->length));
+
+	// Syndromes whose logical corrections are equally likely may be broken differently by the summation order
+	// So the decoders are compared by the probability of no logical error
+	decoder* pool_decoder = decoder_create_tailored(code, logicals, noise_model);
+	double* pool_decoder_logical = characterise_code(code, logicals, noise_model, pool_decoder);
+	printf("Tailored decoder: difference in the probability of no logical error between 1 and 4 threads %e\n", fabs(serial_logical[0] - pool_decoder_logical[0]));
+
+	// A cached model writes to its cache on every call, so the workers take turns calling it
+	error_model* cached_model = error_model_create_cached(noise_model, 7, ERROR_MODEL_CACHE_HASHED);
+	double* cached_logical = characterise_code(code, logicals, cached_model, serial_decoder);
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	error_model_cached_stats(cached_model, &hits, &misses);
+	printf("Cached model: max difference between 1 and 4 threads %e, every error evaluated once: %d\n", max_difference(serial_logical, cached_logical, 1ull << logicals->length), (misses == 1ull << code->length) && (0 == hits));
+	free(cached_logical);
+	error_model_free(cached_model);
+
+	free(pool_decoder_logical);
+	free(serial_logical);
+	free(pool_logical);
+	decoder_free(serial_decoder);
+	decoder_free(pool_decoder);
+	error_model_free(noise_model);
+	sym_free(code);
+	sym_free(logicals);
+
+	// Threads that race to first use the shared pool all get the same one
+	thread_pool_default_free();
+	pthread_t fetchers[4];
+	thread_pool* fetched[4];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		pthread_create(&fetchers[i], NULL, default_pool_fetch, &fetched[i]);
+	}
+	uint8_t same_pool = 1;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		pthread_join(fetchers[i], NULL);
+		same_pool &= (fetched[i] == fetched[0]);
+	}
+	printf("Concurrent first use creates a single pool: %d\n", same_pool);
+
+	thread_pool_default_free();
+	return 0;
+}